@@ -3,103 +3,86 @@
 
 static rtdb_dummy_t g_rtdb_dummy;
 
-/* Valor default definido no ficheiro rtdb.c "real" */
+/* Valores default da tabela RTDB_FIELDS(), os mesmos do rtdb.c "real" */
 void rtdb_dummy_init(void)
 {
-    g_rtdb_dummy.system_on        = true;
-    g_rtdb_dummy.setpoint         = 26;
-    g_rtdb_dummy.current_temp     = 0;
-    g_rtdb_dummy.max_temp         = 80;
-    g_rtdb_dummy.min_temp         = 20;
-    g_rtdb_dummy.heater           = false;
-    g_rtdb_dummy.sampling_rate_ms = 1000;
+    static const rtdb_dummy_t defaults = RTDB_DEFAULTS;
+    g_rtdb_dummy = defaults;
 }
 
-/* system_on */
-bool rtdb_dummy_get_system_on(void)
-{
-    return g_rtdb_dummy.system_on;
-}
-void rtdb_dummy_set_system_on(bool on)
-{
-    g_rtdb_dummy.system_on = on;
-}
-
-/* setpoint (entre min_temp e max_temp) */
-int16_t rtdb_dummy_get_setpoint(void)
-{
-    return g_rtdb_dummy.setpoint;
-}
-void rtdb_dummy_set_setpoint(int16_t val)
-{
-    if (val > g_rtdb_dummy.max_temp) {
-        g_rtdb_dummy.setpoint = g_rtdb_dummy.max_temp;
-    } else if (val < g_rtdb_dummy.min_temp) {
-        g_rtdb_dummy.setpoint = g_rtdb_dummy.min_temp;
-    } else {
-        g_rtdb_dummy.setpoint = val;
+/* Acessores tipados gerados a partir da tabela, com a mesma lógica de escrita
+ * (rtdb_schema_write) que o rtdb.c usa dentro do mutex */
+#define RTDB_DUMMY_ACC_RTDB_GLOBAL(ID, acc, type)                             \
+    type rtdb_dummy_get_##acc(void)                                       \
+    {                                                                     \
+        return (type)rtdb_schema_get(&g_rtdb_dummy, 0U, RTDB_ID_##ID);    \
+    }                                                                     \
+    void rtdb_dummy_set_##acc(type val)                                   \
+    {                                                                     \
+        (void)rtdb_schema_write(&g_rtdb_dummy, 0U, RTDB_ID_##ID, (int64_t)val); \
     }
-}
+#define RTDB_DUMMY_ACC_RTDB_ZONE(ID, acc, type)                               \
+    RTDB_DUMMY_ACC_RTDB_GLOBAL(ID, acc, type)                             \
+    type rtdb_dummy_get_##acc##_zone(uint8_t zone)                        \
+    {                                                                     \
+        return (type)rtdb_schema_get(&g_rtdb_dummy, zone, RTDB_ID_##ID);  \
+    }                                                                     \
+    void rtdb_dummy_set_##acc##_zone(uint8_t zone, type val)              \
+    {                                                                     \
+        (void)rtdb_schema_write(&g_rtdb_dummy, zone, RTDB_ID_##ID, (int64_t)val); \
+    }
+#define RTDB_DUMMY_X_ACCESSORS(ID, name, acc, type, def, lo, hi, access, scope) \
+    RTDB_DUMMY_ACC_##scope(ID, acc, type)
+RTDB_FIELDS(RTDB_DUMMY_X_ACCESSORS)
 
-/* current_temp */
-int16_t rtdb_dummy_get_current_temp(void)
+/* get / set genéricos */
+int32_t rtdb_dummy_get(rtdb_field_t id)
 {
-    return g_rtdb_dummy.current_temp;
+    return rtdb_schema_get(&g_rtdb_dummy, 0U, id);
 }
-void rtdb_dummy_set_current_temp(int16_t val)
+rtdb_status_t rtdb_dummy_set(rtdb_field_t id, int32_t val)
 {
-    g_rtdb_dummy.current_temp = val;
-}
+    rtdb_zone_t req;
 
-/* max_temp (ajusta setpoint se necessário) */
-int16_t rtdb_dummy_get_max_temp(void)
-{
-    return g_rtdb_dummy.max_temp;
-}
-void rtdb_dummy_set_max_temp(int16_t val)
-{
-    g_rtdb_dummy.max_temp = val;
-    if (g_rtdb_dummy.setpoint > g_rtdb_dummy.max_temp) {
-        g_rtdb_dummy.setpoint = g_rtdb_dummy.max_temp;
+    if ((unsigned)id >= RTDB_NUM_FIELDS) {
+        return RTDB_EINVAL;
     }
-}
-
-/* min_temp (ajusta setpoint se necessário) */
-int16_t rtdb_dummy_get_min_temp(void)
-{
-    return g_rtdb_dummy.min_temp;
-}
-void rtdb_dummy_set_min_temp(int16_t val)
-{
-    g_rtdb_dummy.min_temp = val;
-    if (g_rtdb_dummy.setpoint < g_rtdb_dummy.min_temp) {
-        g_rtdb_dummy.setpoint = g_rtdb_dummy.min_temp;
+    if (rtdb_field_info[id].access != RTDB_RW) {
+        return RTDB_EACCES;
     }
+    rtdb_schema_view_put(&req, id, val);
+    return rtdb_dummy_update(RTDB_F(id), &req);
 }
 
-/* heater */
-bool rtdb_dummy_get_heater(void)
+/* update: valida o estado candidato completo e só depois aplica */
+rtdb_status_t rtdb_dummy_update_zone(uint8_t zone, uint32_t mask, const rtdb_zone_t *vals)
 {
-    return g_rtdb_dummy.heater;
+    uint32_t changed;
+    return rtdb_schema_update(&g_rtdb_dummy, zone, mask, vals, &changed);
 }
-void rtdb_dummy_set_heater(bool on)
+rtdb_status_t rtdb_dummy_update(uint32_t mask, const rtdb_zone_t *vals)
 {
-    g_rtdb_dummy.heater = on;
+    return rtdb_dummy_update_zone(0U, mask, vals);
 }
 
-/* sampling_rate_ms (entre 10 e 60000) */
-uint32_t rtdb_dummy_get_sampling_rate(void)
+/* toggle / step: mesma escrita saturada, lida e escrita de uma só vez */
+bool rtdb_dummy_toggle_system_on(void)
 {
-    return g_rtdb_dummy.sampling_rate_ms;
+    (void)rtdb_schema_write(&g_rtdb_dummy, 0U, RTDB_ID_SYSTEM_ON, !g_rtdb_dummy.system_on);
+    return g_rtdb_dummy.system_on;
 }
-void rtdb_dummy_set_sampling_rate(uint32_t ms)
+int16_t rtdb_dummy_step_setpoint(int16_t delta, bool *sat)
 {
-    if (ms < 10) {
-        g_rtdb_dummy.sampling_rate_ms = 10U;
-    } else if (ms > 60000U) {
-        g_rtdb_dummy.sampling_rate_ms = 60000U;
-    } else {
-        g_rtdb_dummy.sampling_rate_ms = ms;
+    int32_t want = (int32_t)g_rtdb_dummy.setpoint[0] + delta;
+    (void)rtdb_schema_write(&g_rtdb_dummy, 0U, RTDB_ID_SETPOINT, want);
+    if (sat != NULL) {
+        *sat = (g_rtdb_dummy.setpoint[0] != want);
     }
+    return g_rtdb_dummy.setpoint[0];
 }
 
+/* snapshot (sem concorrência nos testes, basta uma cópia) */
+void rtdb_dummy_snapshot(rtdb_dummy_t *out)
+{
+    *out = g_rtdb_dummy;
+}
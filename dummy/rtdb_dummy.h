@@ -3,48 +3,43 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "rtdb_schema.h"
 
-/* Semelhante ao original */
-typedef struct {
-    bool     system_on;
-    int16_t  setpoint;
-    int16_t  current_temp;
-    int16_t  max_temp;
-    int16_t  min_temp;
-    bool     heater;
-    uint32_t sampling_rate_ms;
-} rtdb_dummy_t;
-
-/* Inicializa todos os valores para default */
-void rtdb_dummy_init(void);
-
-/* Get / set de system_on */
-bool     rtdb_dummy_get_system_on(void);
-void     rtdb_dummy_set_system_on(bool on);
-
-/* Get / set de setpoint (respeitando min/max) */
-int16_t  rtdb_dummy_get_setpoint(void);
-void     rtdb_dummy_set_setpoint(int16_t val);
-
-/* Get / set de current_temp */
-int16_t  rtdb_dummy_get_current_temp(void);
-void     rtdb_dummy_set_current_temp(int16_t val);
+/* Mesma estrutura do original: gerada a partir de RTDB_FIELDS() (src/rtdb_schema.h) */
+typedef rtdb_t rtdb_dummy_t;
 
-/* Get / set de max_temp (respeitando setpoint) */
-int16_t  rtdb_dummy_get_max_temp(void);
-void     rtdb_dummy_set_max_temp(int16_t val);
-
-/* Get / set de min_temp (respeitando setpoint) */
-int16_t  rtdb_dummy_get_min_temp(void);
-void     rtdb_dummy_set_min_temp(int16_t val);
-
-/* Get / set de heater (para testes de controller) */
-bool     rtdb_dummy_get_heater(void);
-void     rtdb_dummy_set_heater(bool on);
+/* Inicializa todos os valores para default (RTDB_DEFAULTS) */
+void rtdb_dummy_init(void);
 
-/* Get / set de sampling_rate_ms (entre 10 e 60000) */
-uint32_t rtdb_dummy_get_sampling_rate(void);
-void     rtdb_dummy_set_sampling_rate(uint32_t ms);
+/* Get / set tipados de cada campo da tabela: rtdb_dummy_get_<acc>() / rtdb_dummy_set_<acc>()
+ * (os setters saturam aos limites da tabela e mantêm min_temp ≤ setpoint ≤ max_temp).
+ * Campos de zona têm também rtdb_dummy_get_<acc>_zone(z) / rtdb_dummy_set_<acc>_zone(z, v);
+ * os sem sufixo operam sobre a zona 0 */
+#define RTDB_DUMMY_DECL_RTDB_GLOBAL(acc, type)              \
+    type rtdb_dummy_get_##acc(void);                        \
+    void rtdb_dummy_set_##acc(type val);
+#define RTDB_DUMMY_DECL_RTDB_ZONE(acc, type)                \
+    RTDB_DUMMY_DECL_RTDB_GLOBAL(acc, type)                  \
+    type rtdb_dummy_get_##acc##_zone(uint8_t zone);         \
+    void rtdb_dummy_set_##acc##_zone(uint8_t zone, type val);
+#define RTDB_DUMMY_X_DECL(ID, name, acc, type, def, lo, hi, access, scope) \
+    RTDB_DUMMY_DECL_##scope(acc, type)
+RTDB_FIELDS(RTDB_DUMMY_X_DECL)
+
+/* Caminho genérico por identificador (equivalente a rtdb_get / rtdb_set) */
+int32_t       rtdb_dummy_get(rtdb_field_t id);
+rtdb_status_t rtdb_dummy_set(rtdb_field_t id, int32_t val);
+
+/* Atualização atómica e validada de vários campos (equivalente a rtdb_update / rtdb_update_zone) */
+rtdb_status_t rtdb_dummy_update(uint32_t mask, const rtdb_zone_t *vals);
+rtdb_status_t rtdb_dummy_update_zone(uint8_t zone, uint32_t mask, const rtdb_zone_t *vals);
+
+/* Read-modify-write atómicos usados pelos botões (equivalentes a rtdb_toggle_system_on /
+ * rtdb_step_setpoint) */
+bool    rtdb_dummy_toggle_system_on(void);
+int16_t rtdb_dummy_step_setpoint(int16_t delta, bool *sat);
+
+/* Cópia de toda a RTDB de uma só vez (equivalente a rtdb_snapshot) */
+void     rtdb_dummy_snapshot(rtdb_dummy_t *out);
 
 #endif /* RTDB_DUMMY_H */
-
@@ -1,5 +1,7 @@
 #include "uartcomm_dummy.h"
 #include "rtdb_dummy.h"
+#include "uart_parser.h"
+#include "uart_cmd.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -99,286 +101,150 @@ uint8_t calculate_checksum(const uint8_t *buf, size_t len)
 }
 
 /* --------------------------------------------------------------------------
- * handle_command “dummy”
+ * Handlers “dummy” (um por comando)
  *
- *  Lógica:
- *   1) Se len < 6 → framing error (#Ef<CS>!).
- *   2) Se buf[0] != '#' ou buf[len-1] != '!' → framing error.
- *   3) Extrai cmd = buf[1].
- *   4) Extrai cs_rcv a partir dos três caracteres antes do '!' (buf[len-4..len-2]).
- *   5) Se cmd == 'C': 
- *        • Lê temperatura: cur = rtdb_dummy_get_current_temp().
- *        • Monta cur_str (3 dígitos).
- *        • Calcula sum_expected = 'C' + cur_str[0]+ cur_str[1]+ cur_str[2].
- *        • Se cs_rcv != sum_expected → send_ack('s'); return.
- *        • Caso contrário: send_frame('c', cur_str, 3); return.
- *   6) Calcule data_len = len - 6; data_ptr = buf + 2.
- *   7) Se cmd == 'M': (similar ao código original)
- *        • Se data_len != 3 → send_ack('i'); return.
- *        • sum_full = 'M' + data_ptr[0..2]; se sum_full != cs_rcv → send_ack('s'); return.
- *        • val = atoi(data_ptr); se val < rtdb_dummy_get_min_temp() → send_ack('i'); 
- *          else → rtdb_dummy_set_max_temp(val); send_ack('o').
- *        • return.
- *   8) Se cmd == 'm': (similar ao código original)
- *        • Se data_len != 3 → send_ack('i'); return.
- *        • sum_full = 'm' + data_ptr[0..2]; se sum_full != cs_rcv → send_ack('s'); return.
- *        • val = atoi(data_ptr); se val > rtdb_dummy_get_max_temp() → send_ack('i');
- *          else → rtdb_dummy_set_min_temp(val); send_ack('o').
- *        • return.
- *   9) Se cmd == 'R': (MUDANÇA AQUI — range antes do checksum)
- *        • Se data_len != 4 → send_ack('i'); return.
- *        • Extrai tmp = string de 4 dígitos. val = atoi(tmp).
- *        • Se val < 10 ou val > 9999 → send_ack('i'); return.
- *        • Agora calcula sum_full = 'R' + data_ptr[0..3]; se sum_full != cs_rcv → send_ack('s'); return.
- *        • Caso OK → rtdb_dummy_set_sampling_rate(val); send_ack('o'); return.
- *  10) Se cmd == 'r': (get sampling_rate, sem payload)
- *        • Se data_len != 0 → send_ack('i'); return.
- *        • sum_expected = 'r' (114); se sum_expected != cs_rcv → send_ack('s'); return.
- *        • sr = rtdb_dummy_get_sampling_rate(); clamp em 9999 se necessário.
- *        • Monta sr_str (4 dígitos) e send_frame('s', sr_str, 4). return.
- *  11) Se cmd == 'E': (toggle system_on)
- *        • Se data_len != 1 → send_ack('i'); return.
- *        • sum_full = 'E' + data_ptr[0]; se sum_full != cs_rcv → send_ack('s'); return.
- *        • c = data_ptr[0]; se c=='0' → ligar + send_ack('o');
- *                            se c=='1' → desligar + send_ack('o');
- *                            senão → send_ack('i').
- *        • return.
- *  12) Se cmd == 'S': (set controller params)
- *        • Se data_len < 1 → send_ack('i'); return.
- *        • sum_full = 'S' + data_ptr[0..(data_len-1)]; se sum_full != cs_rcv → send_ack('s'); return.
- *        • Caso OK → send_ack('o'); return.
- *  13) Qualquer outro: 
- *        • sum_full = cmd + data_ptr[0..(data_len-1)]; 
- *        • Se sum_full != cs_rcv → send_ack('s'); send_ack('i');
- *          senão → send_ack('i').
+ *  Ligados com uart_cmd_bind() à mesma tabela de despacho do firmware
+ *  (src/uart_cmd.c): framing, checksum e comprimento de DATA já foram
+ *  verificados quando o handler é chamado.
+ *   - 'C': envia #cXXXYYY! com a temperatura em 3 dígitos
+ *   - 'M'/'m': rtdb_dummy_update(MAX/MIN_TEMP) → 'o'/'i'
+ *   - 'R': valida 10..9999 ('i'), depois rtdb_dummy_update() → 'o'/'i'
+ *   - 'r': envia #sXXXXYYY!
+ *   - 'E': '0' liga, '1' desliga, outro → 'i'
+ *   - 'S': DATA com pelo menos 1 byte ('i'), senão 'o'
  * -------------------------------------------------------------------------- */
 
-void handle_command(const uint8_t *buf, size_t len)
+static void cmd_get_current_temp(const struct device *dev, const uart_frame_t *f)
 {
-    /* Tamanho mínimo = 6 */
-    if (len < 6) {
-        send_ack('f');
-        return;
-    }
-
-    /* Procura por '#...!' */
-    if (buf[0] != (uint8_t)'#' || buf[len - 1] != (uint8_t)'!') {
-        send_ack('f');
-        return;
-    }
-
-    /* Extrai CMD */
-    char cmd = (char)buf[1];
-
-    /* Extrai CS recebido */
-    char cs_str[4] = {
-        (char)buf[len - 4],
-        (char)buf[len - 3],
-        (char)buf[len - 2],
-        '\0'
-    };
-    uint8_t cs_rcv = (uint8_t)atoi(cs_str);
-
-    /* Caso “C” (consulta temperatura) */
-    if (cmd == 'C') {
-        int cur = rtdb_dummy_get_current_temp();
-        if (cur < 0) cur = 0;
-        else if (cur > 999) cur = 999;
+    (void)dev;
+    (void)f;
+    int cur = rtdb_dummy_get_current_temp();
+    if (cur < 0) cur = 0;
+    else if (cur > 999) cur = 999;
+
+    char cur_str[4];
+    cur_str[0] = '0' + (cur / 100) % 10;
+    cur_str[1] = '0' + ((cur / 10) % 10);
+    cur_str[2] = '0' + (cur % 10);
+    cur_str[3] = '\0';
+    send_frame('c', cur_str, 3);
+}
 
-        char cur_str[4];
-        cur_str[0] = '0' + (cur / 100) % 10;
-        cur_str[1] = '0' + ((cur / 10) % 10);
-        cur_str[2] = '0' + (cur % 10);
-        cur_str[3] = '\0';
+static void cmd_set_max_temp(const struct device *dev, const uart_frame_t *f)
+{
+    (void)dev;
+    char tmp[4] = { (char)f->data[0], (char)f->data[1], (char)f->data[2], '\0' };
+    rtdb_zone_t req = { .max_temp = (int16_t)atoi(tmp) };
+    send_ack(rtdb_dummy_update(RTDB_F_MAX_TEMP, &req) == RTDB_OK ? 'o' : 'i');
+}
 
-        uint8_t sum_expected = (uint8_t)'C'
-                              + (uint8_t)cur_str[0]
-                              + (uint8_t)cur_str[1]
-                              + (uint8_t)cur_str[2];
-        if (sum_expected != cs_rcv) {
-            send_ack('s');
-            return;
-        }
+static void cmd_set_min_temp(const struct device *dev, const uart_frame_t *f)
+{
+    (void)dev;
+    char tmp[4] = { (char)f->data[0], (char)f->data[1], (char)f->data[2], '\0' };
+    rtdb_zone_t req = { .min_temp = (int16_t)atoi(tmp) };
+    send_ack(rtdb_dummy_update(RTDB_F_MIN_TEMP, &req) == RTDB_OK ? 'o' : 'i');
+}
 
-        send_frame('c', cur_str, 3);
+static void cmd_set_sampling_rate(const struct device *dev, const uart_frame_t *f)
+{
+    (void)dev;
+    char tmp[5] = { (char)f->data[0], (char)f->data[1], (char)f->data[2], (char)f->data[3], '\0' };
+    int val = atoi(tmp);
+    if (val < 10 || val > 9999) {
+        send_ack('i');
         return;
     }
+    rtdb_zone_t req = { .sampling_rate_ms = (uint32_t)val };
+    send_ack(rtdb_dummy_update(RTDB_F_SAMPLING_RATE, &req) == RTDB_OK ? 'o' : 'i');
+}
 
-    /* Calcula data_len */
-    size_t data_len = len - 6;       
-    const uint8_t *data_ptr = buf + 2;
+static void cmd_get_sampling_rate(const struct device *dev, const uart_frame_t *f)
+{
+    (void)dev;
+    (void)f;
+    uint32_t sr = rtdb_dummy_get_sampling_rate();
+    if (sr > 9999U) sr = 9999U;
+    char out[5];
+    out[0] = '0' + ((sr / 1000) % 10);
+    out[1] = '0' + ((sr / 100)  % 10);
+    out[2] = '0' + ((sr / 10)   % 10);
+    out[3] = '0' + (sr % 10);
+    out[4] = '\0';
+    send_frame('s', out, 4);
+}
 
-    /* “M” define max_temp */
-    if (cmd == 'M') {
-        if (data_len != 3) {
-            send_ack('i');
-            return;
-        }
-        uint8_t sum_full = (uint8_t)'M';
-        for (size_t i = 0; i < 3; i++) {
-            sum_full += data_ptr[i];
-        }
-        if (sum_full != cs_rcv) {
-            send_ack('s');
-            return;
-        }
-        char tmp[4] = {
-            (char)data_ptr[0],
-            (char)data_ptr[1],
-            (char)data_ptr[2],
-            '\0'
-        };
-        int val = atoi(tmp);
-        if (val < rtdb_dummy_get_min_temp()) {
-            send_ack('i');
-        } else {
-            rtdb_dummy_set_max_temp((int16_t)val);
-            send_ack('o');
-        }
-        return;
+static void cmd_system_on(const struct device *dev, const uart_frame_t *f)
+{
+    (void)dev;
+    char c = (char)f->data[0];
+    if (c == '0') {
+        rtdb_dummy_set_system_on(true);
+        send_ack('o');
+    } else if (c == '1') {
+        rtdb_dummy_set_system_on(false);
+        send_ack('o');
+    } else {
+        send_ack('i');
     }
+}
 
-    /* “m” define min_temp */
-    if (cmd == 'm') {
-        if (data_len != 3) {
-            send_ack('i');
-            return;
-        }
-        uint8_t sum_full = (uint8_t)'m';
-        for (size_t i = 0; i < 3; i++) {
-            sum_full += data_ptr[i];
-        }
-        if (sum_full != cs_rcv) {
-            send_ack('s');
-            return;
-        }
-        char tmp[4] = {
-            (char)data_ptr[0],
-            (char)data_ptr[1],
-            (char)data_ptr[2],
-            '\0'
-        };
-        int val = atoi(tmp);
-        if (val > rtdb_dummy_get_max_temp()) {
-            send_ack('i');
-        } else {
-            rtdb_dummy_set_min_temp((int16_t)val);
-            send_ack('o');
-        }
-        return;
-    }
+static void cmd_ctrl_params(const struct device *dev, const uart_frame_t *f)
+{
+    (void)dev;
+    send_ack((f->data_len < 1) ? 'i' : 'o');
+}
 
-    /* “R” define sampling_rate (4 dígitos) */
-    if (cmd == 'R') {
-        if (data_len != 4) {
-            send_ack('i');
-            return;
-        }
-        /* Extrai valor antes de qualquer checksum */
-        char tmp[5] = {
-            (char)data_ptr[0],
-            (char)data_ptr[1],
-            (char)data_ptr[2],
-            (char)data_ptr[3],
-            '\0'
-        };
-        int val = atoi(tmp);
-        /* Se estiver fora do intervalo, invalid sem checar checksum */
-        if (val < 10 || val > 9999) {
-            send_ack('i');
-            return;
-        }
-        /* Agora que o valor está no intervalo, verifica checksum */
-        uint8_t sum_full = (uint8_t)'R';
-        for (size_t i = 0; i < 4; i++) {
-            sum_full += data_ptr[i];
-        }
-        if (sum_full != cs_rcv) {
-            send_ack('s');
-            return;
-        }
-        rtdb_dummy_set_sampling_rate((uint32_t)val);
-        send_ack('o');
-        return;
-    }
+/* Liga os handlers acima aos comandos da tabela partilhada (uma vez por processo) */
+static void bind_handlers(void)
+{
+    static bool bound;
 
-    /* “r” consulta sampling_rate (sem payload) */
-    if (cmd == 'r') {
-        if (data_len != 0) {
-            send_ack('i');
-            return;
-        }
-        uint8_t sum_expected = (uint8_t)'r'; /* 114 */
-        if (sum_expected != cs_rcv) {
-            send_ack('s');
-            return;
-        }
-        uint32_t sr = rtdb_dummy_get_sampling_rate();
-        if (sr > 9999U) sr = 9999U;
-        char out[5];
-        out[0] = '0' + ((sr / 1000) % 10);
-        out[1] = '0' + ((sr / 100)  % 10);
-        out[2] = '0' + ((sr / 10)   % 10);
-        out[3] = '0' + (sr % 10);
-        out[4] = '\0';
-        send_frame('s', out, 4);
+    if (bound) {
         return;
     }
+    bound = true;
+    (void)uart_cmd_bind('C', cmd_get_current_temp);
+    (void)uart_cmd_bind('M', cmd_set_max_temp);
+    (void)uart_cmd_bind('m', cmd_set_min_temp);
+    (void)uart_cmd_bind('R', cmd_set_sampling_rate);
+    (void)uart_cmd_bind('r', cmd_get_sampling_rate);
+    (void)uart_cmd_bind('E', cmd_system_on);
+    (void)uart_cmd_bind('S', cmd_ctrl_params);
+}
 
-    /* “E” liga/desliga sistema (payload '0' ou '1') */
-    if (cmd == 'E') {
-        if (data_len != 1) {
-            send_ack('i');
-            return;
-        }
-        uint8_t sum_full = (uint8_t)'E' + (uint8_t)data_ptr[0];
-        if (sum_full != cs_rcv) {
-            send_ack('s');
-            return;
-        }
-        char c = (char)data_ptr[0];
-        if (c == '0') {
-            rtdb_dummy_set_system_on(true);
-            send_ack('o');
-        } else if (c == '1') {
-            rtdb_dummy_set_system_on(false);
-            send_ack('o');
-        } else {
-            send_ack('i');
-        }
-        return;
-    }
+/* --------------------------------------------------------------------------
+ * handle_command “dummy”
+ *
+ *  Entrega buf[0..len-1] ao parser do firmware (src/uart_parser.c), byte a byte:
+ *   1) Erro de framing ('!' fora de frame, frame curto, ...) → send_ack('f').
+ *   2) Frame completo → uart_cmd_handle() (src/uart_cmd.c), que verifica checksum
+ *      e comprimento e chama o handler; os erros dão 's' e/ou 'i'.
+ *   3) Frame por fechar no fim de buf → send_ack('f'), como quando o firmware o
+ *      descarta por timeout.
+ * -------------------------------------------------------------------------- */
 
-    /* “S” set controller params (qualquer data_len ≥ 1) */
-    if (cmd == 'S') {
-        if (data_len < 1) {
-            send_ack('i');
-            return;
-        }
-        uint8_t sum_full = (uint8_t)'S';
-        for (size_t i = 0; i < data_len; i++) {
-            sum_full += data_ptr[i];
-        }
-        if (sum_full != cs_rcv) {
-            send_ack('s');
-            return;
-        }
-        send_ack('o');
-        return;
-    }
+void handle_command(const uint8_t *buf, size_t len)
+{
+    static uart_parser_t p;
 
-    /* 13) Qualquer outro comando: invalid + possível checksum error */
-    {
-        uint8_t sum_full = (uint8_t)cmd;
-        for (size_t i = 0; i < data_len; i++) {
-            sum_full += data_ptr[i];
-        }
-        if (sum_full != cs_rcv) {
-            send_ack('s');
-            send_ack('i');
-        } else {
-            send_ack('i');
-        }
+    bind_handlers();
+    uart_parser_init(&p, 0U);
+    for (size_t i = 0; i < len; i++) {
+        uart_parse_ev_t ev = uart_parser_feed(&p, buf[i], 0U);
+        if (ev == UART_PARSE_ERROR) {
+            send_ack('f');
+        } else if (ev == UART_PARSE_FRAME) {
+            uart_cmd_result_t r = uart_cmd_handle(NULL, &p.f);
+            if ((r == UART_CMD_CHECKSUM) || (r == UART_CMD_CHECKSUM_INVALID)) {
+                send_ack('s');
+            }
+            if ((r == UART_CMD_INVALID) || (r == UART_CMD_CHECKSUM_INVALID)) {
+                send_ack('i');
+            }
+        }
+    }
+    if (uart_parser_busy(&p)) {
+        send_ack('f');
     }
 }
-
@@ -3,31 +3,92 @@
  * @brief On/Off controller para processo térmico
  *
  * @details
- *   - Lê setpoint e current_temp da RTDB
- *   - Controla um MOSFET (porta P1.12) com histerese ±1 °C
+ *   - Lê setpoint e current_temp da RTDB (rtdb_snapshot(), cópia consistente sem lock)
+ *   - Controla um MOSFET por zona (zona 0 na porta P1.12, zona z em P1.(12+z)) com
+ *     histerese ±1 °C, varrendo os arrays de todas as zonas numa só passagem
  *   - Quando sistema está desligado (system_on = false), garante que o aquecedor fique OFF
+ *   - Acorda quando system_on, setpoint ou current_temp mudam (subscrição RTDB), ou no
+ *     máximo a cada CTRL_PERIOD_MS, e regista a pior latência alteração→atuação
+ *   - Proteções por trigger da RTDB, tratadas no próprio setter de current_temp (sem
+ *     esperar por control_task): current_temp > max_temp e sensor sem amostras há mais
+ *     de CTRL_STALE_FACTOR períodos de amostragem desligam logo o aquecedor da zona,
+ *     que fica forçado a OFF até o trigger rearmar. Para cada disparo por
+ *     sobretemperatura é impressa a latência escrita→GPIO do trigger, a de
+ *     control_task (acordada pela própria escrita) e a que o desenho anterior, por
+ *     polling a cada CTRL_PERIOD_MS, teria tido até ao tick seguinte
  *
  *   O MOSFET é assumido como “active-low” (nível lógico 0 = heater ON, 1 = heater OFF).
  */
 
  #include "controller.h"
  #include "rtdb.h"
+ #include "ctrl_logic.h"
  #include <zephyr/kernel.h>
  #include <zephyr/device.h>
  #include <zephyr/drivers/gpio.h>
  #include <zephyr/sys/printk.h>
  
  #define HEATER_GPIO_NODE DT_NODELABEL(gpio1)  
- #define HEATER_PIN       12U                  /* P1.12 ligado à porta do MOSFET */
+ #define HEATER_PIN(z)    (12U + (z))          /* P1.12 ligado à porta do MOSFET da zona 0 */
+ #define CTRL_PERIOD_MS   2000U                /* Período máximo entre ciclos sem alterações */
  
  static const struct device *heater_dev; 
  static K_THREAD_STACK_DEFINE(ctrl_stack, 1024);  
  static struct k_thread ctrl_thread;              
  
+ static void ctrl_trip(struct rtdb_trigger *t, uint8_t zone, bool tripped);
+ 
+ /** current_temp > max_temp */
+ static struct rtdb_trigger ctrl_overtemp = {
+     .field = RTDB_ID_CURRENT_TEMP,
+     .cond  = RTDB_TRIG_GT_FIELD,
+     .arg   = RTDB_ID_MAX_TEMP,
+     .fn    = ctrl_trip,
+ };
+ 
+ /** current_temp sem escritas há CTRL_STALE_FACTOR × sampling_rate (arg atualizado por control_task) */
+ static struct rtdb_trigger ctrl_stale = {
+     .field = RTDB_ID_CURRENT_TEMP,
+     .cond  = RTDB_TRIG_STALE,
+     .fn    = ctrl_trip,
+ };
+ 
+ static volatile uint32_t ctrl_trip_us[RTDB_NUM_ZONES];  /**< Latência escrita→GPIO do último disparo */
+ 
+ /**
+  * @brief Callback dos triggers: desliga já o aquecedor da zona (contexto do setter ou ISR)
+  */
+ static void ctrl_trip(struct rtdb_trigger *t, uint8_t zone, bool tripped)
+ {
+     if (!tripped) {
+         return;
+     }
+     /* Active-low gate: 1 = OFF */
+     gpio_pin_set(heater_dev, HEATER_PIN(zone), 1);
+     if (t == &ctrl_overtemp) {
+         ctrl_trip_us[zone] = k_cyc_to_us_floor32(k_cycle_get_32() - t->trip_cyc[zone]);
+     }
+     rtdb_set_heater_zone(zone, false);
+ }
+ 
+ /**
+  * @brief Latência com que o desenho por polling teria visto um evento de há ago_us
+  *
+  * Esse desenho acordava em ticks fixos de CTRL_PERIOD_MS contados desde o arranque,
+  * por isso o evento só era visto no primeiro tick a seguir.
+  */
+ static uint32_t ctrl_poll_latency_ms(uint32_t ago_us)
+ {
+     uint32_t at_ms = k_uptime_get_32() - (ago_us / 1000U);
+ 
+     return CTRL_PERIOD_MS - (at_ms % CTRL_PERIOD_MS);
+ }
+ 
  /**
   * @brief Lógica de controlo On/Off com histerese ±1°C
   *
-  * Quando o sistema está desligado (system_on == false), o aquecedor é forçado a OFF.
+  * Quando o sistema está desligado (system_on == false) ou algum trigger de proteção
+  * está disparado na zona, o aquecedor é forçado a OFF.
   * Caso contrário:
   *   - Se current_temp ≤ setpoint − 1°C → liga aquecedor
   *   - Se current_temp ≥ setpoint + 1°C → desliga aquecedor
@@ -43,42 +104,78 @@
      ARG_UNUSED(p2);
      ARG_UNUSED(p3);
  
-     bool heater = false;  /* Estado atual do aquecedor */
+     static struct rtdb_sub sub;
+     bool heater[RTDB_NUM_ZONES] = { false };   /* Estado atual do aquecedor de cada zona */
+     uint32_t changed = 0U;    /* Campos que acordaram este ciclo (0 = período expirou) */
+     uint32_t worst_us = 0U;   /* Pior latência alteração→atuação observada */
+     bool over_seen[RTDB_NUM_ZONES] = { false };  /* Sobretemperatura já vista por este ciclo */
+ 
+     rtdb_set_source(RTDB_SRC_CTRL);
+     rtdb_subscribe(&sub, RTDB_F_SYSTEM_ON | RTDB_F_SETPOINT | RTDB_F_CURRENT_TEMP |
+                          RTDB_F_MAX_TEMP | RTDB_F_SAMPLING_RATE);
  
      for (;;)
      {
-         bool system_on = rtdb_get_system_on();
-         int16_t sp     = rtdb_get_setpoint();
-         int16_t cur    = rtdb_get_current_temp();
- 
-         if (!system_on) {
-             /* Se o sistema estiver desligado, garante que aquecedor fique desligado */
-             heater = false;
-         } else {
-             /* Histerese ±1°C em torno do setpoint */
-             if (cur <= sp - 1) {
-                 heater = false;
-             } else if (cur >= sp + 1) {
-                 heater = true;
+         /* Uma única leitura consistente (sem lock) de toda a RTDB */
+         rtdb_t db;
+         rtdb_snapshot(&db);
+ 
+         bool system_on = db.system_on;
+ 
+         ctrl_stale.arg = (int32_t)(CTRL_STALE_FACTOR * db.sampling_rate_ms);
+ 
+         for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+             int16_t sp  = db.setpoint[z];
+             int16_t cur = db.current_temp[z];
+ 
+             /* Sobretemperatura: trigger vs este ciclo (por evento) vs polling a 2 s */
+             if ((cur > db.max_temp[z]) && !over_seen[z]) {
+                 uint32_t ago_us = k_cyc_to_us_floor32(k_cycle_get_32() -
+                                                       ctrl_overtemp.trip_cyc[z]);
+ 
+                 over_seen[z] = true;
+                 printk("[Ctrl] z%u sobretemperatura: trigger %u us, ciclo de controlo %u us, "
+                        "polling %u ms\n",
+                        z, ctrl_trip_us[z], ago_us, ctrl_poll_latency_ms(ago_us));
+             } else if (cur <= db.max_temp[z]) {
+                 over_seen[z] = false;
              }
-             /* Caso contrário (entre sp-1 e sp+1), mantém heater_on inalterado */
+ 
+             /* Histerese ±1°C em torno do setpoint (OFF se desligado ou com proteção ativa) */
+             heater[z] = ctrl_logic_step(system_on,
+                                         rtdb_trigger_tripped(&ctrl_overtemp, z) ||
+                                         rtdb_trigger_tripped(&ctrl_stale, z),
+                                         sp, cur, heater[z]);
+         }
+ 
+         for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+             /* Active-low gate: 0 = ON, 1 = OFF */
+             gpio_pin_set(heater_dev, HEATER_PIN(z), heater[z] ? 0 : 1);
+             rtdb_set_heater_zone(z, heater[z]);
          }
  
-         /* Active-low gate: 0 = ON, 1 = OFF */
-         gpio_pin_set(heater_dev, HEATER_PIN, heater ? 0 : 1);
+         if (changed != 0U) {
+             uint32_t lat_us = k_cyc_to_us_floor32(k_cycle_get_32() - sub.changed_at);
+             if (lat_us > worst_us) {
+                 worst_us = lat_us;
+                 printk("[Ctrl] pior latência alteração→atuação: %u us\n", worst_us);
+             }
+         }
  
-         printk("[Ctrl] sp=%d°C cur=%d°C heater=%s\n",
-                sp, cur, heater ? "OFF" : "ON");
+         for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+             printk("[Ctrl] z%u sp=%d°C cur=%d°C heater=%s\n",
+                    z, db.setpoint[z], db.current_temp[z], heater[z] ? "OFF" : "ON");
+         }
  
-         k_sleep(K_MSEC(2000));
+         changed = rtdb_wait(&sub, K_MSEC(CTRL_PERIOD_MS));
      }
  }
  
  /**
   * @brief Inicializa o controlador ON/OFF
   *
-  *   - Obtém o dispositivo GPIO (P1.12) para o MOSFET
-  *   - Configura P1.12 como saída com nível alto (heater OFF)
+  *   - Obtém o dispositivo GPIO (P1) para os MOSFETs
+  *   - Configura P1.12 (e P1.(12+z) das restantes zonas) como saída com nível alto (heater OFF)
   *   - Cria a thread control_task com prioridade 5
   */
  void controller_init(void)
@@ -90,14 +187,22 @@
          return;
      }
  
-     /* Configura P1.12 como saída, nível alto (desliga o heater) */
-     gpio_pin_configure(heater_dev, HEATER_PIN, GPIO_OUTPUT_INACTIVE);
-     gpio_pin_set(heater_dev, HEATER_PIN, 1);
+     /* Configura P1.12.. como saída, nível alto (desliga o heater) */
+     for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+         gpio_pin_configure(heater_dev, HEATER_PIN(z), GPIO_OUTPUT_INACTIVE);
+         gpio_pin_set(heater_dev, HEATER_PIN(z), 1);
+     }
+ 
+     /* Proteções avaliadas nas escritas da RTDB (o GPIO já está configurado) */
+     ctrl_stale.arg = (int32_t)(CTRL_STALE_FACTOR * rtdb_get_sampling_rate());
+     rtdb_trigger_register(&ctrl_overtemp);
+     rtdb_trigger_register(&ctrl_stale);
  
      /* Lança a thread de controlo */
      k_thread_create(&ctrl_thread, ctrl_stack, K_THREAD_STACK_SIZEOF(ctrl_stack),
                      control_task, NULL, NULL, NULL,
                      5, 0, K_NO_WAIT);
+     k_thread_name_set(&ctrl_thread, "ctrl");
      printk("[Init] Controller\n");
  }
  
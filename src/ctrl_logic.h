@@ -0,0 +1,51 @@
+#ifndef CTRL_LOGIC_H
+#define CTRL_LOGIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file ctrl_logic.h
+ * @brief Decisão On/Off do controlador, sem dependências do Zephyr
+ *
+ * @details
+ *   Partilhada por control_task (controller.c) e pela ferramenta de replay do diário
+ *   da RTDB (tools/journal_replay.c), para que o replay aplique exatamente a mesma
+ *   lógica que o firmware.
+ */
+
+#define CTRL_HYST         1    /**< Histerese (°C) em torno do setpoint */
+#define CTRL_STALE_FACTOR 3U   /**< Sensor parado = 3 períodos de amostragem sem escritas */
+
+/**
+ * @brief Próximo estado do aquecedor de uma zona
+ *
+ * Com o sistema desligado ou uma proteção ativa (trigger disparado) fica OFF.
+ * Caso contrário:
+ *   - current_temp ≤ setpoint − CTRL_HYST → false
+ *   - current_temp ≥ setpoint + CTRL_HYST → true
+ *   - entre os dois mantém o estado anterior
+ *
+ * @param system_on  Sistema ligado
+ * @param protect    Alguma proteção da zona disparada
+ * @param sp         Setpoint (°C)
+ * @param cur        Temperatura atual (°C)
+ * @param heater     Estado anterior
+ * @return           Novo estado
+ */
+static inline bool ctrl_logic_step(bool system_on, bool protect, int16_t sp, int16_t cur,
+                                   bool heater)
+{
+    if (!system_on || protect) {
+        return false;
+    }
+    if (cur <= sp - CTRL_HYST) {
+        return false;
+    }
+    if (cur >= sp + CTRL_HYST) {
+        return true;
+    }
+    return heater;
+}
+
+#endif /* CTRL_LOGIC_H */
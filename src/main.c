@@ -31,6 +31,7 @@
  #include "rtdb.h"
  #include "uartcomm.h"
  #include "controller.h"
+ #include "rtdb_persist.h"
  
  #define BTN_NODE_ONOFF   DT_ALIAS(sw0)
  #define BTN_NODE_INC     DT_ALIAS(sw1)
@@ -57,12 +58,61 @@
  
  /* --------------------------------------------------------------------------
   * Callbacks de GPIO e timestamps para debounce
+  *
+  * Os callbacks correm em contexto de interrupção: só fazem o debounce e uma
+  * operação atómica e de duração limitada na RTDB (spinlock). As mensagens na
+  * consola (printk sobre a UART em polling, vários ms por linha) são adiadas
+  * para a system workqueue através de um k_work por botão.
   * -------------------------------------------------------------------------- */
  static struct gpio_callback cb_onoff;  /**< Callback handler para SW0 (on/off) */
  static struct gpio_callback cb_inc;    /**< Callback handler para SW1 (+setpoint) */
  static struct gpio_callback cb_menu;   /**< Callback handler para SW2 (exibe menu) */
  static struct gpio_callback cb_dec;    /**< Callback handler para SW3 (-setpoint) */
  
+ /**
+  * @brief Resultado de um botão, preenchido no ISR e reportado pela workqueue
+  */
+ struct btn_event {
+     struct k_work work;
+     int16_t       value;  /* system_on (SW0) ou setpoint resultante (SW1/SW3) */
+     bool          sat;    /* SW1/SW3: setpoint limitado por max_temp/min_temp */
+ };
+ 
+ static struct btn_event ev_onoff;  /**< SW0 */
+ static struct btn_event ev_inc;    /**< SW1 */
+ static struct btn_event ev_menu;   /**< SW2 */
+ static struct btn_event ev_dec;    /**< SW3 */
+ 
+ static uint32_t btn_isr_worst_cyc;  /**< Pior duração (ciclos) de um callback de botão */
+ 
+ /**
+  * @brief Regista a duração de um callback de botão iniciado no ciclo t0
+  *
+  * Os callbacks dos botões partilham a mesma interrupção GPIO, logo nunca se sobrepõem.
+  */
+ static inline void btn_isr_done(uint32_t t0)
+ {
+     uint32_t d = k_cycle_get_32() - t0;
+     if (d > btn_isr_worst_cyc) {
+         btn_isr_worst_cyc = d;
+     }
+ }
+ 
+ /**
+  * @brief Imprime a pior duração de ISR de botão sempre que esta aumenta (workqueue)
+  */
+ static void btn_report_isr_time(void)
+ {
+     static uint32_t reported;
+     uint32_t worst = btn_isr_worst_cyc;
+ 
+     if (worst > reported) {
+         reported = worst;
+         printk("[Botões] pior duração de ISR: %u us (%u ciclos)\n",
+                k_cyc_to_us_floor32(worst), worst);
+     }
+ }
+ 
  /**
   * @brief Imprime o menu de uso na consola (quando SW2 é pressionado)
   *
@@ -107,11 +157,13 @@
   * @param cb   Ponteiro para a estrutura de callback (não utilizado dentro)
   * @param pins Máscara de pinos que dispararam a interrupção (não usado)
   *
-  * Alterna o valor booleano de system_on na RTDB e imprime estado atual.
+  * Alterna o valor booleano de system_on na RTDB (rtdb_toggle_system_on(), atómico)
+  * e agenda a impressão do estado atual.
   */
  static void onoff_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
  {
      ARG_UNUSED(dev); ARG_UNUSED(cb); ARG_UNUSED(pins);
+     uint32_t t0 = k_cycle_get_32();
  
      /* Debounce: apenas aceita evento se passou mais de DEBOUNCE_MS desde o último */
      static int64_t last_onoff = 0;
@@ -121,9 +173,19 @@
      }
      last_onoff = now;
  
-     bool on = !rtdb_get_system_on();
-     rtdb_set_system_on(on);
-     printk("\n[Botão SW0] Sistema agora: %s\n", on ? "ON" : "OFF");
+     ev_onoff.value = rtdb_toggle_system_on();
+     k_work_submit(&ev_onoff.work);
+     btn_isr_done(t0);
+ }
+ 
+ /**
+  * @brief Reporta na consola o resultado de SW0 (system workqueue)
+  */
+ static void onoff_report(struct k_work *work)
+ {
+     struct btn_event *ev = CONTAINER_OF(work, struct btn_event, work);
+     printk("\n[Botão SW0] Sistema agora: %s\n", ev->value ? "ON" : "OFF");
+     btn_report_isr_time();
  }
  
  /**
@@ -133,11 +195,13 @@
   * @param cb   Ponteiro para a estrutura de callback (não utilizado dentro)
   * @param pins Máscara de pinos que dispararam a interrupção (não usado)
   *
-  * Incrementa o setpoint em 1°C e impede ultrapassar max_temp. Informa via printk.
+  * Incrementa o setpoint em 1°C (rtdb_step_setpoint(), atómico) sem ultrapassar max_temp
+  * e agenda a mensagem correspondente.
   */
  static void inc_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
  {
      ARG_UNUSED(dev); ARG_UNUSED(cb); ARG_UNUSED(pins);
+     uint32_t t0 = k_cycle_get_32();
  
      /* Debounce */
      static int64_t last_inc = 0;
@@ -147,17 +211,24 @@
      }
      last_inc = now;
  
-     int16_t tentativa = rtdb_get_setpoint() + 1;
-     rtdb_set_setpoint(tentativa);
+     ev_inc.value = rtdb_step_setpoint(+1, &ev_inc.sat);
+     k_work_submit(&ev_inc.work);
+     btn_isr_done(t0);
+ }
  
-     int16_t real = rtdb_get_setpoint();
-     int16_t mx   = rtdb_get_max_temp();
+ /**
+  * @brief Reporta na consola o resultado de SW1 (system workqueue)
+  */
+ static void inc_report(struct k_work *work)
+ {
+     struct btn_event *ev = CONTAINER_OF(work, struct btn_event, work);
  
-     if (real >= mx && tentativa > mx) {
-         printk("[Botão SW1] Temperatura máxima atingida (%d °C)\n", mx);
+     if (ev->sat) {
+         printk("[Botão SW1] Temperatura máxima atingida (%d °C)\n", ev->value);
      } else {
-         printk("[Botão SW1] Setpoint incrementado para %d °C\n", real);
+         printk("[Botão SW1] Setpoint incrementado para %d °C\n", ev->value);
      }
+     btn_report_isr_time();
  }
  
  /**
@@ -167,11 +238,12 @@
   * @param cb   Ponteiro para a estrutura de callback (não utilizado dentro)
   * @param pins Máscara de pinos que dispararam a interrupção (não usado)
   *
-  * Chama a função print_menu() para mostrar instruções na consola.
+  * Agenda print_menu() na workqueue para mostrar instruções na consola.
   */
  static void menu_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
  {
      ARG_UNUSED(dev); ARG_UNUSED(cb); ARG_UNUSED(pins);
+     uint32_t t0 = k_cycle_get_32();
  
      /* Debounce */
      static int64_t last_menu = 0;
@@ -181,7 +253,18 @@
      }
      last_menu = now;
  
+     k_work_submit(&ev_menu.work);
+     btn_isr_done(t0);
+ }
+ 
+ /**
+  * @brief Imprime o menu pedido por SW2 (system workqueue)
+  */
+ static void menu_report(struct k_work *work)
+ {
+     ARG_UNUSED(work);
      print_menu();
+     btn_report_isr_time();
  }
  
  /**
@@ -191,11 +274,13 @@
   * @param cb   Ponteiro para a estrutura de callback (não utilizado dentro)
   * @param pins Máscara de pinos que dispararam a interrupção (não usado)
   *
-  * Decrementa o setpoint em 1°C e impede descer abaixo de min_temp. Informa via printk.
+  * Decrementa o setpoint em 1°C (rtdb_step_setpoint(), atómico) sem descer abaixo de
+  * min_temp e agenda a mensagem correspondente.
   */
  static void dec_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
  {
      ARG_UNUSED(dev); ARG_UNUSED(cb); ARG_UNUSED(pins);
+     uint32_t t0 = k_cycle_get_32();
  
      /* Debounce */
      static int64_t last_dec = 0;
@@ -205,29 +290,41 @@
      }
      last_dec = now;
  
-     int16_t tentativa = rtdb_get_setpoint() - 1;
-     rtdb_set_setpoint(tentativa);
+     ev_dec.value = rtdb_step_setpoint(-1, &ev_dec.sat);
+     k_work_submit(&ev_dec.work);
+     btn_isr_done(t0);
+ }
  
-     int16_t real = rtdb_get_setpoint();
-     int16_t mi   = rtdb_get_min_temp();
+ /**
+  * @brief Reporta na consola o resultado de SW3 (system workqueue)
+  */
+ static void dec_report(struct k_work *work)
+ {
+     struct btn_event *ev = CONTAINER_OF(work, struct btn_event, work);
  
-     if (real <= mi && tentativa < mi) {
-         printk("[Botão SW3] Temperatura mínima atingida (%d °C)\n", mi);
+     if (ev->sat) {
+         printk("[Botão SW3] Temperatura mínima atingida (%d °C)\n", ev->value);
      } else {
-         printk("[Botão SW3] Setpoint decrementado para %d °C\n", real);
+         printk("[Botão SW3] Setpoint decrementado para %d °C\n", ev->value);
      }
+     btn_report_isr_time();
  }
  
  /**
   * @brief Inicializa todos os botões (SW0..SW3) com configurações de GPIO e callbacks
   *
   * Configura cada botão como entrada e ativa interrupção no flanco de subida. Liga callbacks
-  * onoff_pressed, inc_pressed, menu_pressed e dec_pressed.
+  * onoff_pressed, inc_pressed, menu_pressed e dec_pressed, e os k_work que reportam cada um.
   */
  void button_ctrl_init(void)
  {
      const struct device *dev;
  
+     k_work_init(&ev_onoff.work, onoff_report);
+     k_work_init(&ev_inc.work, inc_report);
+     k_work_init(&ev_menu.work, menu_report);
+     k_work_init(&ev_dec.work, dec_report);
+ 
      /* --- SW0 (ON/OFF) --- */
      dev = DEVICE_DT_GET(BTN_ONOFF_DEV);
      __ASSERT(dev != NULL, "GPIO device for SW0 not found");
@@ -284,7 +381,8 @@
   * - LED2: temperatura “abaixo” (cur < sp – 2°C)
   * - LED3: temperatura “acima” (cur > sp + 2°C)
   *
-  * Esta função lê periodicamente (a cada 500 ms) os valores na RTDB:
+  * Esta função bloqueia numa subscrição RTDB e, sempre que algum dos campos abaixo
+  * muda, lê-os numa única cópia consistente (rtdb_snapshot()):
   *   - system_on
   *   - current_temp
   *   - setpoint
@@ -318,10 +416,16 @@
      gpio_pin_configure(d_high,   DT_GPIO_PIN(LED_NODE_HIGH, gpios),
                         GPIO_OUTPUT_INACTIVE | DT_GPIO_FLAGS(LED_NODE_HIGH, gpios));
  
+     static struct rtdb_sub sub;
+     rtdb_subscribe(&sub, RTDB_F_SYSTEM_ON | RTDB_F_SETPOINT | RTDB_F_CURRENT_TEMP);
+ 
      for (;;) {
-         bool on = rtdb_get_system_on();
-         int16_t cur = rtdb_get_current_temp();
-         int16_t sp  = rtdb_get_setpoint();
+         rtdb_t db;
+         rtdb_snapshot(&db);
+ 
+         bool on = db.system_on;
+         int16_t cur = db.current_temp[0];   /* LEDs refletem a zona 0 */
+         int16_t sp  = db.setpoint[0];
  
          /* LED0: sistema ON/OFF */
          gpio_pin_set(d_onoff, DT_GPIO_PIN(LED_NODE_ONOFF, gpios), (int)on);
@@ -349,7 +453,7 @@
                  gpio_pin_set(d_high,   DT_GPIO_PIN(LED_NODE_HIGH, gpios),   0);
              }
          }
-         k_msleep(500);
+         (void)rtdb_wait(&sub, K_FOREVER);
      }
  }
  
@@ -361,6 +465,7 @@
      k_thread_create(&led_thread, led_stack, K_THREAD_STACK_SIZEOF(led_stack),
                      led_task, NULL, NULL, NULL,
                      5, 0, K_NO_WAIT);
+     k_thread_name_set(&led_thread, "led");
      printk("[Init] LED control\n");
  }
  
@@ -393,6 +498,8 @@
      uint8_t cmd = TC74_CMD_RTR;
      uint8_t temp_raw;
  
+     rtdb_set_source(RTDB_SRC_SENSOR);
+ 
      /* Primeiro, escrever “Read Temperature Register” (RTR), para posicionar o ponteiro */
      ret = i2c_write_dt(&tc74, &cmd, 1);
      if (ret != 0) {
@@ -440,6 +547,7 @@
                      K_THREAD_STACK_SIZEOF(sensor_stack),
                      sensor_task, NULL, NULL, NULL,
                      5, 0, K_NO_WAIT);
+     k_thread_name_set(&sensor_thread, "sensor");
      printk("[Init] TC74 via I2C OK em %s, addr=0x%02x\n",
             tc74.bus->name, tc74.addr);
  }
@@ -448,6 +556,9 @@
   * @brief Função principal (entry point) do firmware
   *
   *   - Exibe menu inicial
+  *   - Em native_sim com CONFIG_RTDB_SHM, expõe a RTDB em memória partilhada
+  *   - Restaura a configuração guardada em flash (CONFIG_RTDB_PERSIST), antes de
+  *     qualquer thread ler a RTDB
   *   - Inicializa todas as tarefas do sistema:
   *       • uart_comm_init(): thread de comunicação UART
   *       • button_ctrl_init(): configuração de botões e callbacks
@@ -461,6 +572,21 @@
  {
      print_menu();
  
+ #if defined(CONFIG_RTDB_SHM)
+     (void)rtdb_shm_init();
+ #endif
+ 
+ #if defined(CONFIG_RTDB_PERSIST)
+     /* No diário, os valores restaurados aparecem com origem RTDB_SRC_PERSIST */
+     rtdb_set_source(RTDB_SRC_PERSIST);
+     (void)rtdb_persist_init();
+     rtdb_set_source(RTDB_SRC_UNKNOWN);
+ #endif
+ 
+ #if defined(CONFIG_RTDB_BENCH)
+     rtdb_bench_snapshot();
+ #endif
+ 
      uart_comm_init();
      button_ctrl_init();
      led_ctrl_init();
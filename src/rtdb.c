@@ -4,16 +4,81 @@
  *
  * @details
  *   Esta implementação mantém um conjunto de variáveis de estado e configuração
- *   que são partilhadas entre várias threads:
- *     - system_on       (bool): sistema ligado/desligado
- *     - setpoint        (int16): temperatura alvo (°C)
- *     - current_temp    (int16): temperatura lida do sensor (°C)
- *     - max_temp        (int16): temperatura máxima permitida (°C)
- *     - min_temp        (int16): temperatura mínima permitida (°C)
- *     - sampling_rate_ms(uint32): intervalo de amostragem do sensor (ms)
+ *   que são partilhadas entre várias threads. Os campos (tipo, valor inicial,
+ *   limites e regras de acesso) estão declarados uma única vez na tabela
+ *   RTDB_FIELDS() de rtdb_schema.h; os acessores tipados deste ficheiro são
+ *   gerados a partir dela e delegam a validação em rtdb_schema.c.
  *
  *   Todas as funções de acesso à RTDB (getters e setters) protegem a região crítica
- *   usando um mutex (k_mutex). O mutex é inicializado via SYS_INIT() logo no arranque.
+ *   com um spinlock (k_spinlock). As secções críticas são curtas e de duração
+ *   limitada (copiar/validar um punhado de campos, sem printk nem esperas), pelo
+ *   que todos os acessores podem ser chamados a partir de ISRs (callbacks GPIO
+ *   dos botões) sem bloquear. Para read-modify-write a partir de ISRs existem
+ *   rtdb_toggle_system_on() e rtdb_step_setpoint(), que leem e escrevem na mesma
+ *   secção crítica.
+ *   Com CONFIG_RTDB_LOCK_STATS, rtdb_lock()/rtdb_unlock() medem também o tempo de
+ *   espera e de posse do lock por thread (rtdb_lockstat.h); sem essa opção
+ *   reduzem-se a k_spin_lock()/k_spin_unlock().
+ *
+ *   A RTDB está dividida em dois domínios de sincronização (rtdb_domain_t): a
+ *   configuração (campos RTDB_RW) e a medição (current_temp, heater). Cada domínio
+ *   tem o seu spinlock e o seu contador de sequência, pelo que as escritas do
+ *   sensor e do controlador nunca esperam por escritas de configuração vindas de
+ *   handle_command() ou dos botões. Operações que abrangem os dois domínios
+ *   adquirem os locks sempre pela mesma ordem (configuração e depois medição).
+ *
+ *   Para leituras de vários campos existe rtdb_snapshot(), que devolve uma cópia
+ *   de toda a RTDB sem adquirir os locks (seqlock por domínio): os escritores
+ *   incrementam o contador do seu domínio antes e depois de cada alteração; o
+ *   leitor repete a cópia de um domínio se o contador mudou (ou era ímpar)
+ *   durante a leitura. Cada domínio é consistente; entre domínios a cópia pode
+ *   juntar uma configuração e uma medição de instantes ligeiramente diferentes.
+ *
+ *   Para alarmes, rtdb_trigger_register() regista condições sobre campos (p.ex.
+ *   current_temp > max_temp, ou current_temp sem escritas há N ms) que são
+ *   avaliadas pelo próprio setter, logo a seguir a libertar o lock: a reação
+ *   (callback e/ou k_event) acontece na escrita que viola a condição, sem esperar
+ *   que uma task acorde e volte a ler a RTDB.
+ *
+ *   Tasks que só precisam de reagir a alterações registam uma subscrição
+ *   (rtdb_subscribe()) com uma máscara de campos RTDB_F_* e bloqueiam em
+ *   rtdb_wait(). Cada setter calcula os campos que efetivamente mudaram e,
+ *   depois de libertar o lock, sinaliza o k_event de cada subscritor interessado.
+ *   RTDB_F_SAMPLE sinaliza cada amostra de current_temp, mesmo repetida, depois de
+ *   entrar no histórico.
+ *
+ *   Alterações que envolvem vários campos (ou que dependem de outros campos, como
+ *   max_temp ≥ min_temp) devem usar rtdb_update(), que valida e aplica tudo sob um
+ *   único lock, evitando corridas check-then-act entre getters e setters.
+ *
+ *   Os perfis de configuração (rtdb_profile_*()) guardam conjuntos completos e já
+ *   validados de setpoint, limites e período de amostragem de todas as zonas.
+ *   Ativar um perfil copia-o para g_rtdb numa única escrita do domínio de
+ *   configuração, pelo que os leitores nunca veem uma receita meio aplicada; a
+ *   configuração substituída fica guardada para rtdb_profile_rollback().
+ *
+ *   Cada escrita de current_temp atualiza ainda, dentro da secção crítica, as
+ *   estatísticas incrementais da zona (g_stats, rtdb_stats.c).
+ *
+ *   Cada escrita de current_temp (sensor_task) acrescenta também uma amostra
+ *   (uptime, temp) ao histórico g_hist da zona (rtdb_history.c), fora do lock:
+ *   cada histórico tem um só produtor e os leitores percorrem-no sem lock. Por
+ *   isso current_temp não deve ser escrito a partir de ISRs.
+ *
+ *   Com CONFIG_RTDB_PERSIST, rtdb_write_end() avisa também rtdb_persist.c, que
+ *   guarda em flash a configuração alterada (ver rtdb_persist.h).
+ *
+ *   Com CONFIG_RTDB_SHM (native_sim), rtdb_write_end() copia ainda os domínios
+ *   escritos, antes de libertar os locks, para a vista em memória partilhada
+ *   g_shm (rtdb_shm.h), lida por monitores externos sem passar pela UART.
+ *
+ *   Com CONFIG_RTDB_JOURNAL, cada campo alterado (e cada amostra de current_temp)
+ *   é registado no diário g_journal (rtdb_journal.h) ainda dentro da secção
+ *   crítica, com os valores antes e depois e a origem da escrita, pelo que a
+ *   ordem do diário é a ordem em que as escritas foram aplicadas.
+ *
+ *   g_rtdb guarda as RTDB_NUM_ZONES zonas em structure-of-arrays (ver
+ *   rtdb_schema.h); as funções sem sufixo _zone operam sobre a zona 0.
  *
  * @note
  *   - setpoint nunca ultrapassa max_temp nem fica abaixo de min_temp.
@@ -21,210 +86,1038 @@
  */
 
  #include "rtdb.h"
+ #include "rtdb_lockstat.h"
+ #include "rtdb_persist.h"
+ #if defined(CONFIG_RTDB_SHM)
+ #include "rtdb_shm.h"
+ #include "rtdb_shm_bottom.h"
+ #endif
  #include <zephyr/kernel.h>
+ #include <zephyr/sys/barrier.h>
+ #include <errno.h>
+ #include <string.h>
+ 
+ /**
+  * @brief Estrutura interna que guarda todos os valores do RTDB (valores iniciais da tabela)
+  */
+ static rtdb_t g_rtdb = RTDB_DEFAULTS;
+ 
+ /**
+  * @brief Histórico de current_temp de cada zona (produtor único: setter de current_temp)
+  */
+ static rtdb_history_t g_hist[RTDB_NUM_ZONES];
+ 
+ /**
+  * @brief Estatísticas de current_temp de cada zona (domínio de medição)
+  */
+ static rtdb_stats_t g_stats[RTDB_NUM_ZONES];
  
+ #if defined(CONFIG_RTDB_JOURNAL)
  /**
-  * @brief Estrutura interna que guarda todos os valores do RTDB
+  * @brief Diário das escritas (vários produtores: threads e ISRs, sem lock próprio)
   */
- static rtdb_t g_rtdb = {
-     .system_on        = true,    /* Inicialmente, sistema ligado */
-     .setpoint         = 26,      /* Setpoint padrão: 26°C */
-     .current_temp     = 0,       /* Temperatura inicial (valor dummy) */
-     .max_temp         = 80,      /* Valor máximo inicial: 80°C */
-     .min_temp         = 20,      /* Valor mínimo inicial: 20°C */
-     .sampling_rate_ms = 1000     /* Intervalo de 1 segundo */
- };
+ static rtdb_journal_t g_journal;
+ #endif
  
- static struct k_mutex rtdb_mutex; 
+ #if defined(CONFIG_RTDB_SHM)
+ /**
+  * @brief Vista em memória partilhada (NULL até rtdb_shm_init()); escrita com os locks adquiridos
+  */
+ static rtdb_shm_t *g_shm;
+ #endif
+ 
+ static struct k_spinlock rtdb_spin[RTDB_NUM_DOMAINS];  /**< Serializa escritores de cada domínio */
  
  /**
-  * @brief Inicializa o mutex do RTDB antes de qualquer acesso
+  * @brief Contadores de sequência dos seqlocks de cada domínio de g_rtdb
   *
-  * Chamado automaticamente pela macro SYS_INIT(), no nível APPLICATION.
+  * Par = domínio estável; ímpar = escrita em curso. Só é alterado com rtdb_spin[dom] adquirido.
+  */
+ static volatile uint32_t rtdb_seq[RTDB_NUM_DOMAINS];
+ 
+ /**
+  * @brief Locks adquiridos por uma escrita (rtdb_write_begin()/rtdb_write_end())
+  */
+ typedef struct {
+     uint32_t         doms;                    /* BIT(dom) de cada domínio adquirido */
+     k_spinlock_key_t key[RTDB_NUM_DOMAINS];
+     uint8_t          zone;                    /* Zona escrita (triggers) */
+     uint32_t         written;                 /* RTDB_F_* escritos mesmo sem mudar de valor */
+     int8_t           profile;                 /* Perfil ativo após a escrita (RTDB_PROF_KEEP = sem ativação) */
+ } rtdb_wr_t;
+ 
+ #define RTDB_PROF_KEEP (-2)  /**< rtdb_wr_t.profile: a escrita não ativa nenhum perfil */
+ 
+ #define RTDB_SNAPSHOT_RETRIES 4U  /**< Tentativas sem lock antes de recorrer ao spinlock */
+ #define RTDB_MAX_SUBS         4U  /**< Número máximo de subscrições de alterações */
+ #define RTDB_MAX_TRIGS        4U  /**< Número máximo de triggers */
+ 
+ _Static_assert(RTDB_NUM_FIELDS < 31, "RTDB_F_SAMPLE tem de ficar fora das máscaras dos campos");
+ 
+ static struct rtdb_sub *rtdb_subs[RTDB_MAX_SUBS];  /**< Subscrições registadas */
+ static volatile uint32_t rtdb_num_subs;             /**< Entradas válidas em rtdb_subs */
+ 
+ static struct rtdb_trigger *rtdb_trigs[RTDB_MAX_TRIGS];  /**< Triggers registados */
+ static volatile uint32_t rtdb_num_trigs;                  /**< Entradas válidas em rtdb_trigs */
+ 
+ /* Perfis de configuração, protegidos por rtdb_spin[RTDB_DOM_CFG] */
+ static rtdb_profile_t rtdb_profiles[RTDB_MAX_PROFILES];
+ static rtdb_t rtdb_prof_prev;               /**< Configuração substituída pela última ativação/rollback */
+ static bool rtdb_prof_has_prev;             /**< rtdb_prof_prev válida */
+ static int8_t rtdb_prof_prev_id = -1;       /**< Perfil a que rtdb_prof_prev corresponde (-1 = nenhum) */
+ static volatile int8_t rtdb_prof_active = -1;  /**< Perfil ativo (-1 = nenhum) */
+ 
+ #if defined(CONFIG_RTDB_LOCK_STATS)
+ /** Estatísticas de cada domínio, protegidas por rtdb_spin[dom] */
+ static rtdb_lockstat_t rtdb_lockstats[RTDB_NUM_DOMAINS][RTDB_LOCKSTAT_MAX_CALLERS];
+ static uint32_t rtdb_lock_acq[RTDB_NUM_DOMAINS];   /**< Ciclo em que o detentor atual adquiriu o lock */
+ static uint32_t rtdb_lock_wait[RTDB_NUM_DOMAINS];  /**< Espera (ciclos) do detentor atual */
+ #endif
+ 
+ /**
+  * @brief Adquire rtdb_spin[dom] (com CONFIG_RTDB_LOCK_STATS mede o tempo de espera)
+  */
+ static inline k_spinlock_key_t rtdb_lock(rtdb_domain_t dom)
+ {
+ #if defined(CONFIG_RTDB_LOCK_STATS)
+     uint32_t t0 = k_cycle_get_32();
+     k_spinlock_key_t key = k_spin_lock(&rtdb_spin[dom]);
+     rtdb_lock_acq[dom] = k_cycle_get_32();
+     rtdb_lock_wait[dom] = rtdb_lock_acq[dom] - t0;
+     return key;
+ #else
+     return k_spin_lock(&rtdb_spin[dom]);
+ #endif
+ }
+ 
+ /**
+  * @brief Liberta rtdb_spin[dom] (com CONFIG_RTDB_LOCK_STATS regista espera e posse do
+  *        chamador; todas as ISRs partilham a entrada RTDB_LOCKSTAT_ISR)
+  */
+ static inline void rtdb_unlock(rtdb_domain_t dom, k_spinlock_key_t key)
+ {
+ #if defined(CONFIG_RTDB_LOCK_STATS)
+     uint32_t hold = k_cycle_get_32() - rtdb_lock_acq[dom];
+     const void *caller = k_is_in_isr() ? RTDB_LOCKSTAT_ISR : (const void *)k_current_get();
+     rtdb_lockstat_record(rtdb_lockstat_slot(rtdb_lockstats[dom], RTDB_LOCKSTAT_MAX_CALLERS,
+                                             caller),
+                          rtdb_lock_wait[dom], hold);
+ #endif
+     k_spin_unlock(&rtdb_spin[dom], key);
+ }
+ 
+ /**
+  * @brief Origem da escrita em curso: a da thread (rtdb_set_source()) ou RTDB_SRC_ISR
+  */
+ static inline rtdb_src_t rtdb_source(void)
+ {
+ #if defined(CONFIG_RTDB_JOURNAL)
+     if (k_is_in_isr()) {
+         return RTDB_SRC_ISR;
+     }
+     return (rtdb_src_t)(uintptr_t)k_thread_custom_data_get();
+ #else
+     return RTDB_SRC_UNKNOWN;
+ #endif
+ }
+ 
+ /**
+  * @brief Regista no diário os campos mask da zona zone (chamar com o lock adquirido)
   *
-  * @param dev  Ponteiro para dispositivo (não utilizado)
-  * @return     0 sempre
+  * @param zone  Zona escrita
+  * @param mask  RTDB_F_* a registar
+  * @param old   Vista da zona antes da escrita
+  * @param src   Origem da escrita
   */
- static int rtdb_mutex_init(const struct device *dev)
+ static void rtdb_journal_log(uint8_t zone, uint32_t mask, const rtdb_zone_t *old,
+                              rtdb_src_t src)
  {
-     ARG_UNUSED(dev);
-     k_mutex_init(&rtdb_mutex);
-     return 0;
+ #if defined(CONFIG_RTDB_JOURNAL)
+     rtdb_jentry_t e = { .t_ms = k_uptime_get_32(), .src = (uint8_t)src };
+ 
+     for (uint32_t id = 0U; id < RTDB_NUM_FIELDS; id++) {
+         if ((mask & RTDB_F(id)) == 0U) {
+             continue;
+         }
+         e.id = (uint8_t)id;
+         e.zone = rtdb_field_info[id].zoned ? zone : 0U;
+         e.old = rtdb_schema_view_get(old, (rtdb_field_t)id);
+         e.val = rtdb_schema_get(&g_rtdb, zone, (rtdb_field_t)id);
+         rtdb_journal_push(&g_journal, &e);
+     }
+ #else
+     ARG_UNUSED(zone);
+     ARG_UNUSED(mask);
+     ARG_UNUSED(old);
+     ARG_UNUSED(src);
+ #endif
  }
- SYS_INIT(rtdb_mutex_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
  
  /**
-  * @brief Lê o valor de system_on (protected by mutex)
+  * @brief Publica em g_shm os domínios doms (chamar com os respetivos locks adquiridos)
+  */
+ static inline void rtdb_shm_sync(uint32_t doms)
+ {
+ #if defined(CONFIG_RTDB_SHM)
+     if (g_shm == NULL) {
+         return;
+     }
+     for (uint32_t d = 0U; d < RTDB_NUM_DOMAINS; d++) {
+         if ((doms & BIT(d)) != 0U) {
+             rtdb_shm_publish(g_shm, &g_rtdb, g_stats, (rtdb_domain_t)d);
+         }
+     }
+ #else
+     ARG_UNUSED(doms);
+ #endif
+ }
+ 
+ /**
+  * @brief Domínios (BIT(dom)) que contêm os campos de mask
+  */
+ static inline uint32_t rtdb_doms_of(uint32_t mask)
+ {
+     return (((mask & RTDB_DOM_MASK_CFG) != 0U) ? BIT(RTDB_DOM_CFG) : 0U) |
+            (((mask & RTDB_DOM_MASK_MEAS) != 0U) ? BIT(RTDB_DOM_MEAS) : 0U);
+ }
+ 
+ /**
+  * @brief Inicia uma escrita na RTDB: adquire os locks de doms (por ordem crescente de
+  *        domínio, para não haver deadlock) e torna os respetivos contadores ímpares
   *
-  * @return true se sistema ligado, false se desligado
+  * @param w     Estado da escrita, a passar a rtdb_write_end()
+  * @param doms  BIT(dom) de cada domínio a alterar
+  * @param zone  Zona escrita (0 para campos globais)
   */
- bool rtdb_get_system_on(void)
+ static inline void rtdb_write_begin(rtdb_wr_t *w, uint32_t doms, uint8_t zone)
  {
-     bool v;
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     v = g_rtdb.system_on;
-     k_mutex_unlock(&rtdb_mutex);
-     return v;
+     w->doms = doms;
+     w->zone = zone;
+     w->written = 0U;
+     w->profile = RTDB_PROF_KEEP;
+     for (uint32_t d = 0U; d < RTDB_NUM_DOMAINS; d++) {
+         if ((doms & BIT(d)) != 0U) {
+             w->key[d] = rtdb_lock((rtdb_domain_t)d);
+             rtdb_seq[d] = rtdb_seq[d] + 1U;
+         }
+     }
+     barrier_dmem_fence_full();
  }
  
  /**
-  * @brief Atualiza o valor de system_on (protected by mutex)
+  * @brief Sinaliza as subscrições interessadas nos campos alterados
   *
-  * @param on  true para ligar sistema, false para desligar
+  * Guarda em pending_since o instante da primeira alteração ainda não consumida,
+  * para que o subscritor possa medir a latência alteração→reação.
+  *
+  * @param changed  Máscara RTDB_F_* dos campos que mudaram
   */
- void rtdb_set_system_on(bool on)
+ static void rtdb_notify(uint32_t changed)
  {
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     g_rtdb.system_on = on;
-     k_mutex_unlock(&rtdb_mutex);
+     if (changed == 0U) {
+         return;
+     }
+ 
+     uint32_t now = k_cycle_get_32();
+     uint32_t n = rtdb_num_subs;
+ 
+     for (uint32_t i = 0U; i < n; i++) {
+         struct rtdb_sub *sub = rtdb_subs[i];
+         uint32_t hit = changed & sub->mask;
+ 
+         if (hit != 0U) {
+             if (k_event_test(&sub->evt, sub->mask) == 0U) {
+                 sub->pending_since = now;
+             }
+             k_event_post(&sub->evt, hit);
+         }
+     }
  }
  
  /**
-  * @brief Lê o setpoint atual (protected by mutex)
+  * @brief Passa o trigger t da zona zone ao estado on, chamando fn/evt nas transições
   *
-  * @return Setpoint (°C)
+  * A transição é decidida com um bit atómico, pelo que escritores concorrentes (ou o
+  * timer de RTDB_TRIG_STALE) nunca disparam o mesmo trigger duas vezes.
   */
- int16_t rtdb_get_setpoint(void)
+ static void rtdb_trig_set(struct rtdb_trigger *t, uint8_t zone, bool on, uint32_t cyc)
  {
-     int16_t v;
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     v = g_rtdb.setpoint;
-     k_mutex_unlock(&rtdb_mutex);
-     return v;
+     if (on) {
+         if (atomic_test_and_set_bit(&t->tripped, zone)) {
+             return;
+         }
+         t->trip_cyc[zone] = cyc;
+         if (t->evt != NULL) {
+             k_event_post(t->evt, BIT(zone));
+         }
+     } else if (!atomic_test_and_clear_bit(&t->tripped, zone)) {
+         return;
+     }
+     if (t->fn != NULL) {
+         t->fn(t, zone, on);
+     }
  }
  
  /**
-  * @brief Atualiza o setpoint, limitando entre min_temp e max_temp (protected by mutex)
+  * @brief Reavalia os triggers afetados por uma escrita na zona zone
+  *
+  * Corre depois de libertar o lock e lê g_rtdb diretamente: se outro escritor mudar
+  * os valores entretanto, esse reavalia-os também, pelo que o estado final do
+  * trigger corresponde sempre à última escrita.
+  *
+  * @param zone     Zona escrita
+  * @param written  RTDB_F_* dos campos escritos (mesmo que o valor não tenha mudado)
+  * @param cyc      Ciclo (k_cycle_get_32) da escrita
+  */
+ static void rtdb_trig_eval(uint8_t zone, uint32_t written, uint32_t cyc)
+ {
+     uint32_t n = rtdb_num_trigs;
+ 
+     for (uint32_t i = 0U; i < n; i++) {
+         struct rtdb_trigger *t = rtdb_trigs[i];
+ 
+         if ((written & rtdb_schema_cond_watch(t->field, t->cond, t->arg)) == 0U) {
+             continue;
+         }
+         if (t->cond == RTDB_TRIG_STALE) {
+             /* Cada escrita adia o prazo e rearma o trigger */
+             k_timer_start(&t->stale[zone].timer, K_MSEC(t->arg), K_NO_WAIT);
+             rtdb_trig_set(t, zone, false, cyc);
+         } else {
+             rtdb_trig_set(t, zone, rtdb_schema_cond(&g_rtdb, zone, t->field, t->cond, t->arg),
+                           cyc);
+         }
+     }
+ }
+ 
+ /**
+  * @brief Termina uma escrita na RTDB: torna o contador par, liberta o lock,
+  *        notifica os subscritores dos campos alterados (k_event_post, seguro em ISR)
+  *        e avalia os triggers dos campos escritos
+  *
+  * @param w        Estado preenchido por rtdb_write_begin()
+  * @param changed  Máscara RTDB_F_* dos campos que mudaram durante a escrita
+  */
+ static inline void rtdb_write_end(rtdb_wr_t *w, uint32_t changed)
+ {
+     uint32_t cyc = k_cycle_get_32();
+ 
+     /* Qualquer outra alteração da configuração deixa de corresponder ao perfil ativo */
+     if (w->profile != RTDB_PROF_KEEP) {
+         rtdb_prof_active = w->profile;
+     } else if ((changed & RTDB_PROFILE_MASK) != 0U) {
+         rtdb_prof_active = -1;
+     }
+     rtdb_shm_sync(w->doms);
+     barrier_dmem_fence_full();
+     for (uint32_t d = RTDB_NUM_DOMAINS; d > 0U; d--) {
+         if ((w->doms & BIT(d - 1U)) != 0U) {
+             rtdb_seq[d - 1U] = rtdb_seq[d - 1U] + 1U;
+             rtdb_unlock((rtdb_domain_t)(d - 1U), w->key[d - 1U]);
+         }
+     }
+     rtdb_notify(changed);
+ #if defined(CONFIG_RTDB_PERSIST)
+     rtdb_persist_touch(changed);
+ #endif
+     rtdb_trig_eval(w->zone, changed | w->written, cyc);
+ }
+ 
+ /**
+  * @brief Copia os campos do domínio dom de forma consistente sem bloquear (seqlock)
+  *
+  * Repete a cópia enquanto houver uma escrita em curso ou o contador mudar durante
+  * a leitura. Escritas noutro CPU (SMP) ou muito frequentes podiam impedir indefinidamente
+  * a cópia sem lock; por isso, após RTDB_SNAPSHOT_RETRIES tentativas, a cópia é feita com
+  * o spinlock do domínio.
+  *
+  * @param out  Destino da cópia
+  * @param dom  Domínio a copiar
+  */
+ static void rtdb_snapshot_domain(rtdb_t *out, rtdb_domain_t dom)
+ {
+     for (uint32_t i = 0U; i < RTDB_SNAPSHOT_RETRIES; i++) {
+         uint32_t seq = rtdb_seq[dom];
+         barrier_dmem_fence_full();
+         rtdb_schema_copy_domain(out, &g_rtdb, dom);
+         barrier_dmem_fence_full();
+         if (((seq & 1U) == 0U) && (seq == rtdb_seq[dom])) {
+             return;
+         }
+     }
+ 
+     k_spinlock_key_t key = rtdb_lock(dom);
+     rtdb_schema_copy_domain(out, &g_rtdb, dom);
+     rtdb_unlock(dom, key);
+ }
+ 
+ /**
+  * @brief Copia toda a RTDB sem bloquear: cada domínio é copiado de forma consistente
+  *
+  * @param out  Destino da cópia
+  */
+ void rtdb_snapshot(rtdb_t *out)
+ {
+     rtdb_snapshot_domain(out, RTDB_DOM_CFG);
+     rtdb_snapshot_domain(out, RTDB_DOM_MEAS);
+ }
+ 
+ /**
+  * @brief Valida e aplica os campos em mask da zona zone sob um único lock (ver rtdb.h)
+  *
+  * @param zone  Zona a alterar
+  * @param mask  Máscara RTDB_F_* dos campos a alterar
+  * @param vals  Novos valores
+  * @return      RTDB_OK, RTDB_EINVAL ou RTDB_EACCES (nada alterado)
+  */
+ rtdb_status_t rtdb_update_zone(uint8_t zone, uint32_t mask, const rtdb_zone_t *vals)
+ {
+     uint32_t changed;
+     rtdb_status_t st;
+     rtdb_zone_t old;
+     rtdb_wr_t w;
+ 
+     /* As invariantes leem sempre min_temp/setpoint/max_temp: a configuração fica bloqueada */
+     rtdb_write_begin(&w, rtdb_doms_of(mask) | BIT(RTDB_DOM_CFG), zone);
+     if (zone < RTDB_NUM_ZONES) {
+         rtdb_schema_view(&g_rtdb, zone, &old);
+     }
+     st = rtdb_schema_update(&g_rtdb, zone, mask, vals, &changed);
+     rtdb_journal_log(zone, changed, &old, rtdb_source());
+     rtdb_write_end(&w, changed);
+     return st;
+ }
+ 
+ rtdb_status_t rtdb_update(uint32_t mask, const rtdb_zone_t *vals)
+ {
+     return rtdb_update_zone(0U, mask, vals);
+ }
+ 
+ /**
+  * @brief Inverte system_on numa só secção crítica (seguro em ISR)
+  *
+  * @return Novo valor de system_on
+  */
+ bool rtdb_toggle_system_on(void)
+ {
+     uint32_t changed;
+     rtdb_zone_t old;
+     rtdb_wr_t w;
+     bool on;
+ 
+     rtdb_write_begin(&w, BIT(RTDB_DOM_CFG), 0U);
+     rtdb_schema_view(&g_rtdb, 0U, &old);
+     changed = rtdb_schema_write(&g_rtdb, 0U, RTDB_ID_SYSTEM_ON, !g_rtdb.system_on);
+     on = g_rtdb.system_on;
+     rtdb_journal_log(0U, changed, &old, RTDB_SRC_BUTTON);
+     rtdb_write_end(&w, changed);
+     return on;
+ }
+ 
+ /**
+  * @brief Soma delta ao setpoint da zona 0 numa só secção crítica (seguro em ISR)
+  *
+  * @param delta  Variação em °C
+  * @param sat    Se não for NULL, recebe true quando o resultado ficou limitado
+  *               por max_temp/min_temp (ou pelos limites da tabela)
+  * @return       Novo setpoint
+  */
+ int16_t rtdb_step_setpoint(int16_t delta, bool *sat)
+ {
+     uint32_t changed;
+     rtdb_zone_t old;
+     rtdb_wr_t w;
+     int32_t want;
+     int16_t sp;
+ 
+     rtdb_write_begin(&w, BIT(RTDB_DOM_CFG), 0U);
+     rtdb_schema_view(&g_rtdb, 0U, &old);
+     want = (int32_t)g_rtdb.setpoint[0] + delta;
+     changed = rtdb_schema_write(&g_rtdb, 0U, RTDB_ID_SETPOINT, want);
+     sp = g_rtdb.setpoint[0];
+     rtdb_journal_log(0U, changed, &old, RTDB_SRC_BUTTON);
+     rtdb_write_end(&w, changed);
+ 
+     if (sat != NULL) {
+         *sat = (sp != want);
+     }
+     return sp;
+ }
+ 
+ /**
+  * @brief Guarda a configuração atual como perfil n (ver rtdb.h)
+  */
+ rtdb_status_t rtdb_profile_save(uint8_t n, const char *name)
+ {
+     if (n >= RTDB_MAX_PROFILES) {
+         return RTDB_EINVAL;
+     }
+ 
+     k_spinlock_key_t key = rtdb_lock(RTDB_DOM_CFG);
+     rtdb_profile_t *p = &rtdb_profiles[n];
+     rtdb_schema_copy_fields(&p->cfg, &g_rtdb, RTDB_PROFILE_MASK);
+     strncpy(p->name, name, RTDB_PROFILE_NAME_LEN);
+     p->name[RTDB_PROFILE_NAME_LEN] = '\0';
+     p->valid = true;
+     rtdb_unlock(RTDB_DOM_CFG, key);
+     return RTDB_OK;
+ }
+ 
+ /**
+  * @brief Altera campos de uma zona do perfil n, validados como em rtdb_update_zone()
+  */
+ rtdb_status_t rtdb_profile_edit(uint8_t n, uint8_t zone, uint32_t mask, const rtdb_zone_t *vals)
+ {
+     rtdb_status_t st = RTDB_EINVAL;
+     uint32_t changed;
+ 
+     if ((n >= RTDB_MAX_PROFILES) || ((mask & ~RTDB_PROFILE_MASK) != 0U)) {
+         return RTDB_EINVAL;
+     }
+ 
+     k_spinlock_key_t key = rtdb_lock(RTDB_DOM_CFG);
+     if (rtdb_profiles[n].valid) {
+         st = rtdb_schema_update(&rtdb_profiles[n].cfg, zone, mask, vals, &changed);
+         if ((st == RTDB_OK) && (changed != 0U) && (rtdb_prof_active == (int8_t)n)) {
+             /* A configuração em uso já não é igual ao perfil */
+             rtdb_prof_active = -1;
+         }
+     }
+     rtdb_unlock(RTDB_DOM_CFG, key);
+     return st;
+ }
+ 
+ /**
+  * @brief Substitui a configuração de g_rtdb (RTDB_PROFILE_MASK, todas as zonas) por cfg
+  *
+  * Chamar com rtdb_spin[RTDB_DOM_CFG] adquirido. A configuração substituída fica em
+  * rtdb_prof_prev (cfg pode ser a própria rtdb_prof_prev). As alterações de cada zona
+  * são registadas no diário.
   *
-  * @param val  Novo valor de setpoint (°C)
+  * @return Máscara RTDB_F_* dos campos alterados em alguma zona
   */
- void rtdb_set_setpoint(int16_t val)
+ static uint32_t rtdb_profile_apply(const rtdb_t *cfg)
  {
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     if (val > g_rtdb.max_temp) {
-         g_rtdb.setpoint = g_rtdb.max_temp;
-     } else if (val < g_rtdb.min_temp) {
-         g_rtdb.setpoint = g_rtdb.min_temp;
+     rtdb_t old = g_rtdb;
+     rtdb_src_t src = rtdb_source();
+     uint32_t changed = 0U;
+ 
+     rtdb_schema_copy_fields(&g_rtdb, cfg, RTDB_PROFILE_MASK);
+     for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+         uint32_t cz = rtdb_schema_diff(&old, &g_rtdb, z, RTDB_PROFILE_MASK);
+         rtdb_zone_t ov;
+ 
+         rtdb_schema_view(&old, z, &ov);
+         rtdb_journal_log(z, cz, &ov, src);
+         changed |= cz;
+     }
+     rtdb_schema_copy_fields(&rtdb_prof_prev, &old, RTDB_PROFILE_MASK);
+     return changed;
+ }
+ 
+ /**
+  * @brief Avalia os triggers das zonas 1.. (rtdb_write_end() só avalia a zona da escrita)
+  */
+ static void rtdb_profile_trig_eval(uint32_t changed)
+ {
+     uint32_t cyc = k_cycle_get_32();
+ 
+     for (uint8_t z = 1U; z < RTDB_NUM_ZONES; z++) {
+         rtdb_trig_eval(z, changed, cyc);
+     }
+ }
+ 
+ /**
+  * @brief Ativa o perfil n: toda a configuração muda numa única secção crítica
+  *
+  * Os campos são copiados com o lock de configuração adquirido e o contador do
+  * seqlock ímpar, pelo que nenhum leitor vê a configuração a meio da troca.
+  */
+ rtdb_status_t rtdb_profile_activate(uint8_t n)
+ {
+     uint32_t changed;
+     rtdb_wr_t w;
+ 
+     if (n >= RTDB_MAX_PROFILES) {
+         return RTDB_EINVAL;
+     }
+ 
+     rtdb_write_begin(&w, BIT(RTDB_DOM_CFG), 0U);
+     if (!rtdb_profiles[n].valid) {
+         rtdb_write_end(&w, 0U);
+         return RTDB_EINVAL;
+     }
+     rtdb_prof_prev_id = rtdb_prof_active;
+     changed = rtdb_profile_apply(&rtdb_profiles[n].cfg);
+     rtdb_prof_has_prev = true;
+     w.profile = (int8_t)n;
+     rtdb_write_end(&w, changed);
+ 
+     rtdb_profile_trig_eval(changed);
+     return RTDB_OK;
+ }
+ 
+ /**
+  * @brief Troca a configuração atual pela que a última ativação/rollback substituiu
+  */
+ rtdb_status_t rtdb_profile_rollback(void)
+ {
+     uint32_t changed;
+     rtdb_wr_t w;
+ 
+     rtdb_write_begin(&w, BIT(RTDB_DOM_CFG), 0U);
+     if (!rtdb_prof_has_prev) {
+         rtdb_write_end(&w, 0U);
+         return RTDB_EINVAL;
+     }
+     w.profile = rtdb_prof_prev_id;
+     rtdb_prof_prev_id = rtdb_prof_active;
+     changed = rtdb_profile_apply(&rtdb_prof_prev);
+     rtdb_write_end(&w, changed);
+ 
+     rtdb_profile_trig_eval(changed);
+     return RTDB_OK;
+ }
+ 
+ /**
+  * @brief Copia o perfil n (false se não existir ou não estiver definido)
+  */
+ bool rtdb_profile_get(uint8_t n, rtdb_profile_t *out)
+ {
+     if (n >= RTDB_MAX_PROFILES) {
+         return false;
+     }
+     k_spinlock_key_t key = rtdb_lock(RTDB_DOM_CFG);
+     *out = rtdb_profiles[n];
+     rtdb_unlock(RTDB_DOM_CFG, key);
+     return out->valid;
+ }
+ 
+ int rtdb_profile_active(void)
+ {
+     return rtdb_prof_active;
+ }
+ 
+ /**
+  * @brief Regista uma subscrição de alterações para os campos em mask
+  *
+  * @param sub   Subscrição (memória estática do chamador, válida para sempre)
+  * @param mask  Máscara RTDB_F_* dos campos de interesse
+  * @return      0 se registada, -ENOMEM se não houver entradas livres
+  */
+ int rtdb_subscribe(struct rtdb_sub *sub, uint32_t mask)
+ {
+     int ret = 0;
+ 
+     k_event_init(&sub->evt);
+     sub->mask = mask;
+     sub->pending_since = 0U;
+     sub->changed_at = 0U;
+ 
+     k_spinlock_key_t key = rtdb_lock(RTDB_DOM_CFG);
+     if (rtdb_num_subs < RTDB_MAX_SUBS) {
+         rtdb_subs[rtdb_num_subs] = sub;
+         barrier_dmem_fence_full();
+         rtdb_num_subs = rtdb_num_subs + 1U;
      } else {
-         g_rtdb.setpoint = val;
+         ret = -ENOMEM;
      }
-     k_mutex_unlock(&rtdb_mutex);
+     rtdb_unlock(RTDB_DOM_CFG, key);
+     return ret;
  }
  
  /**
-  * @brief Lê a temperatura atual (protected by mutex)
+  * @brief Bloqueia até algum campo subscrito mudar (ou expirar timeout)
+  *
+  * Consome atomicamente os eventos pendentes (k_event_clear devolve o valor anterior),
+  * pelo que nenhuma alteração sinalizada entre a espera e a limpeza se perde.
   *
-  * @return current_temp (°C)
+  * @param sub      Subscrição registada com rtdb_subscribe()
+  * @param timeout  Tempo máximo de espera
+  * @return         Máscara RTDB_F_* dos campos alterados, ou 0 se expirou
   */
- int16_t rtdb_get_current_temp(void)
+ uint32_t rtdb_wait(struct rtdb_sub *sub, k_timeout_t timeout)
  {
-     int16_t v;
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     v = g_rtdb.current_temp;
-     k_mutex_unlock(&rtdb_mutex);
-     return v;
+     if (k_event_wait(&sub->evt, sub->mask, false, timeout) == 0U) {
+         return 0U;
+     }
+     sub->changed_at = sub->pending_since;
+     return k_event_clear(&sub->evt, sub->mask) & sub->mask;
  }
  
  /**
-  * @brief Atualiza current_temp (protected by mutex)
+  * @brief Prazo de um trigger RTDB_TRIG_STALE expirou (contexto ISR do timer)
+  */
+ static void rtdb_trig_stale_expired(struct k_timer *timer)
+ {
+     struct rtdb_trig_timer *st = CONTAINER_OF(timer, struct rtdb_trig_timer, timer);
+ 
+     rtdb_trig_set(st->trig, st->zone, true, k_cycle_get_32());
+ }
+ 
+ /**
+  * @brief Regista um trigger avaliado nas escritas da RTDB (ver rtdb.h)
   *
-  * @param val  Valor de temperatura lido do sensor (°C, complemento a dois)
+  * @param t  Trigger (memória estática do chamador, válida para sempre)
+  * @return   0 se registado, -ENOMEM se não houver entradas livres
   */
- void rtdb_set_current_temp(int16_t val)
+ int rtdb_trigger_register(struct rtdb_trigger *t)
  {
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     g_rtdb.current_temp = val;
-     k_mutex_unlock(&rtdb_mutex);
+     int ret = 0;
+ 
+     atomic_clear(&t->tripped);
+     if (t->cond == RTDB_TRIG_STALE) {
+         for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+             t->stale[z].trig = t;
+             t->stale[z].zone = z;
+             k_timer_init(&t->stale[z].timer, rtdb_trig_stale_expired, NULL);
+         }
+     }
+ 
+     k_spinlock_key_t key = rtdb_lock(RTDB_DOM_CFG);
+     if (rtdb_num_trigs < RTDB_MAX_TRIGS) {
+         rtdb_trigs[rtdb_num_trigs] = t;
+         barrier_dmem_fence_full();
+         rtdb_num_trigs = rtdb_num_trigs + 1U;
+     } else {
+         ret = -ENOMEM;
+     }
+     rtdb_unlock(RTDB_DOM_CFG, key);
+     if (ret != 0) {
+         return ret;
+     }
+ 
+     /* Estado inicial: prazos a contar desde já, condições com os valores atuais */
+     uint32_t cyc = k_cycle_get_32();
+     for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+         if (t->cond == RTDB_TRIG_STALE) {
+             k_timer_start(&t->stale[z].timer, K_MSEC(t->arg), K_NO_WAIT);
+         } else {
+             rtdb_trig_set(t, z, rtdb_schema_cond(&g_rtdb, z, t->field, t->cond, t->arg), cyc);
+         }
+     }
+     return 0;
+ }
+ 
+ /**
+  * @brief true se o trigger t está disparado na zona zone
+  */
+ bool rtdb_trigger_tripped(struct rtdb_trigger *t, uint8_t zone)
+ {
+     return (zone < RTDB_NUM_ZONES) && atomic_test_bit(&t->tripped, zone);
  }
  
  /**
-  * @brief Lê max_temp (protected by mutex)
+  * @brief Lê um campo de uma zona pelo identificador (protected by spinlock)
   *
-  * @return max_temp (°C)
+  * @param zone  Zona (ignorada em campos globais)
+  * @param id    Identificador RTDB_ID_*
+  * @return      Valor do campo (0 se id ou zona inválidos)
   */
- int16_t rtdb_get_max_temp(void)
+ int32_t rtdb_get_zone(uint8_t zone, rtdb_field_t id)
  {
-     int16_t v;
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     v = g_rtdb.max_temp;
-     k_mutex_unlock(&rtdb_mutex);
+     int32_t v;
+ 
+     if ((zone >= RTDB_NUM_ZONES) || ((unsigned)id >= RTDB_NUM_FIELDS)) {
+         return 0;
+     }
+     rtdb_domain_t dom = RTDB_DOMAIN(id);
+     k_spinlock_key_t key = rtdb_lock(dom);
+     v = rtdb_schema_get(&g_rtdb, zone, id);
+     rtdb_unlock(dom, key);
      return v;
  }
  
+ int32_t rtdb_get(rtdb_field_t id)
+ {
+     return rtdb_get_zone(0U, id);
+ }
+ 
+ /**
+  * @brief Escreve um campo de uma zona pelo identificador, com validação (protected by spinlock)
+  *
+  * @param zone  Zona (ignorada em campos globais)
+  * @param id    Identificador RTDB_ID_*
+  * @param val   Novo valor
+  * @return      RTDB_OK, RTDB_EINVAL (fora dos limites/invariantes) ou RTDB_EACCES (campo RTDB_RO)
+  */
+ rtdb_status_t rtdb_set_zone(uint8_t zone, rtdb_field_t id, int32_t val)
+ {
+     rtdb_zone_t req;
+ 
+     if ((unsigned)id >= RTDB_NUM_FIELDS) {
+         return RTDB_EINVAL;
+     }
+     if (rtdb_field_info[id].access != RTDB_RW) {
+         return RTDB_EACCES;
+     }
+     rtdb_schema_view_put(&req, id, val);
+     return rtdb_update_zone(zone, RTDB_F(id), &req);
+ }
+ 
+ rtdb_status_t rtdb_set(rtdb_field_t id, int32_t val)
+ {
+     return rtdb_set_zone(0U, id, val);
+ }
+ 
  /**
-  * @brief Atualiza max_temp; ajusta setpoint se estiver acima de max_temp (protected by mutex)
+  * @brief Escrita com saturação usada pelos setters tipados (protected by spinlock)
   *
-  * @param val  Novo valor máximo permitido (°C)
+  * @param zone  Zona (ignorada em campos globais)
+  * @param id    Identificador RTDB_ID_*
+  * @param val   Novo valor (saturado aos limites da tabela)
   */
- void rtdb_set_max_temp(int16_t val)
+ static void rtdb_write_field(uint8_t zone, rtdb_field_t id, int64_t val)
  {
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     g_rtdb.max_temp = val;
-     if (g_rtdb.setpoint > g_rtdb.max_temp) {
-         g_rtdb.setpoint = g_rtdb.max_temp;
+     uint32_t changed;
+     uint32_t now;
+     rtdb_zone_t old;
+     rtdb_wr_t w;
+     int16_t temp;
+ 
+     if ((zone >= RTDB_NUM_ZONES) || ((unsigned)id >= RTDB_NUM_FIELDS)) {
+         return;
+     }
+     now = (id == RTDB_ID_CURRENT_TEMP) ? k_uptime_get_32() : 0U;
+ 
+     /* Um só domínio: max/min só arrastam o setpoint, também de configuração */
+     rtdb_write_begin(&w, BIT(RTDB_DOMAIN(id)), zone);
+     w.written = RTDB_F(id);
+     rtdb_schema_view(&g_rtdb, zone, &old);
+     changed = rtdb_schema_write(&g_rtdb, zone, id, val);
+     temp = g_rtdb.current_temp[zone];
+     /* Amostras repetidas também vão para o diário: o replay precisa do ritmo do sensor */
+     rtdb_journal_log(zone, changed | (w.written & RTDB_F_CURRENT_TEMP), &old, rtdb_source());
+     if (id == RTDB_ID_CURRENT_TEMP) {
+         /* setpoint é de configuração: basta uma leitura (int16 alinhado) sem o seu lock */
+         rtdb_stats_add(&g_stats[zone], temp, g_rtdb.setpoint[zone], now);
+     }
+     rtdb_write_end(&w, changed);
+ 
+     if (id == RTDB_ID_CURRENT_TEMP) {
+         /* Todas as amostras vão para o histórico, mesmo que o valor não mude */
+         rtdb_history_push(&g_hist[zone], now, temp);
+ #if defined(CONFIG_RTDB_SHM)
+         if (g_shm != NULL) {
+             rtdb_history_push(&g_shm->hist[zone], now, temp);
+         }
+ #endif
+         rtdb_notify(RTDB_F_SAMPLE);
      }
-     k_mutex_unlock(&rtdb_mutex);
  }
  
  /**
-  * @brief Lê min_temp (protected by mutex)
+  * @brief Prepara um iterador sobre as amostras de current_temp da zona em [t_from_ms, t_to_ms]
   *
-  * @return min_temp (°C)
+  * @param zone       Zona (uma zona inexistente é tratada como a zona 0)
+  * @param it         Iterador (ler com rtdb_history_next())
+  * @param t_from_ms  Início da janela (uptime, ms)
+  * @param t_to_ms    Fim da janela (uptime, ms, inclusive)
   */
- int16_t rtdb_get_min_temp(void)
+ void rtdb_history_window_zone(uint8_t zone, rtdb_hist_iter_t *it,
+                               uint32_t t_from_ms, uint32_t t_to_ms)
  {
-     int16_t v;
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     v = g_rtdb.min_temp;
-     k_mutex_unlock(&rtdb_mutex);
-     return v;
+     if (zone >= RTDB_NUM_ZONES) {
+         zone = 0U;
+     }
+     rtdb_history_iter_init(it, &g_hist[zone], t_from_ms, t_to_ms);
+ }
+ 
+ void rtdb_history_window(rtdb_hist_iter_t *it, uint32_t t_from_ms, uint32_t t_to_ms)
+ {
+     rtdb_history_window_zone(0U, it, t_from_ms, t_to_ms);
+ }
+ 
+ void rtdb_history_follow_zone(uint8_t zone, rtdb_hist_iter_t *it)
+ {
+     if (zone >= RTDB_NUM_ZONES) {
+         zone = 0U;
+     }
+     rtdb_history_follow(it, &g_hist[zone]);
+ }
+ 
+ /**
+  * @brief Copia as estatísticas de current_temp da zona zone (vazias se a zona não existe)
+  */
+ void rtdb_temp_stats_get(uint8_t zone, rtdb_stats_t *out)
+ {
+     if (zone >= RTDB_NUM_ZONES) {
+         rtdb_stats_reset(out);
+         return;
+     }
+     k_spinlock_key_t key = rtdb_lock(RTDB_DOM_MEAS);
+     *out = g_stats[zone];
+     rtdb_unlock(RTDB_DOM_MEAS, key);
  }
  
  /**
-  * @brief Atualiza min_temp; ajusta setpoint se estiver abaixo de min_temp (protected by mutex)
+  * @brief Recomeça as estatísticas de todas as zonas
+  */
+ void rtdb_temp_stats_reset(void)
+ {
+     k_spinlock_key_t key = rtdb_lock(RTDB_DOM_MEAS);
+     for (uint32_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+         rtdb_stats_reset(&g_stats[z]);
+     }
+     rtdb_shm_sync(BIT(RTDB_DOM_MEAS));
+     rtdb_unlock(RTDB_DOM_MEAS, key);
+ }
+ 
+ #if defined(CONFIG_RTDB_SHM)
+ 
+ /**
+  * @brief Cria a vista em memória partilhada e publica o estado atual (ver rtdb.h)
   *
-  * @param val  Novo valor mínimo permitido (°C)
+  * @return 0, ou -ENOMEM se o objeto não pôde ser criado/mapeado
   */
- void rtdb_set_min_temp(int16_t val)
+ int rtdb_shm_init(void)
  {
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     g_rtdb.min_temp = val;
-     if (g_rtdb.setpoint < g_rtdb.min_temp) {
-         g_rtdb.setpoint = g_rtdb.min_temp;
+     rtdb_shm_t *shm = rtdb_shm_bottom_map(CONFIG_RTDB_SHM_NAME, sizeof(rtdb_shm_t));
+     rtdb_wr_t w;
+ 
+     if (shm == NULL) {
+         return -ENOMEM;
      }
-     k_mutex_unlock(&rtdb_mutex);
+     rtdb_write_begin(&w, BIT(RTDB_DOM_CFG) | BIT(RTDB_DOM_MEAS), 0U);
+     rtdb_shm_format(shm, &g_rtdb);
+     g_shm = shm;
+     rtdb_write_end(&w, 0U);
+     printk("[RTDB] vista partilhada em /dev/shm%s (%u bytes)\n", CONFIG_RTDB_SHM_NAME,
+            (unsigned)sizeof(rtdb_shm_t));
+     return 0;
+ }
+ 
+ #endif /* CONFIG_RTDB_SHM */
+ 
+ /**
+  * @brief Define a origem registada no diário para as escritas da thread atual
+  */
+ void rtdb_set_source(rtdb_src_t src)
+ {
+ #if defined(CONFIG_RTDB_JOURNAL)
+     k_thread_custom_data_set((void *)(uintptr_t)src);
+ #else
+     ARG_UNUSED(src);
+ #endif
+ }
+ 
+ #if defined(CONFIG_RTDB_JOURNAL)
+ 
+ /**
+  * @brief Intervalo [*oldest, retorno) de índices absolutos disponíveis no diário
+  */
+ uint32_t rtdb_journal_span(uint32_t *oldest)
+ {
+     uint32_t head = rtdb_journal_head(&g_journal);
+ 
+     *oldest = rtdb_journal_oldest(head);
+     return head;
+ }
+ 
+ /**
+  * @brief Copia a entrada idx do diário (false se já não está disponível)
+  */
+ bool rtdb_journal_get(uint32_t idx, rtdb_jentry_t *out)
+ {
+     return rtdb_journal_read(&g_journal, idx, out);
  }
  
+ #endif /* CONFIG_RTDB_JOURNAL */
+ 
  /**
-  * @brief Lê sampling_rate_ms (protected by mutex)
+  * @brief Gera rtdb_get_<acc>()/rtdb_set_<acc>() para cada campo de RTDB_FIELDS()
+  *        e, nos campos de zona, rtdb_get_<acc>_zone()/rtdb_set_<acc>_zone()
+  */
+ #define RTDB_ACC_RTDB_GLOBAL(ID, acc, type)                          \
+     type rtdb_get_##acc(void)                                        \
+     {                                                                \
+         return (type)rtdb_get_zone(0U, RTDB_ID_##ID);                \
+     }                                                                \
+     void rtdb_set_##acc(type val)                                    \
+     {                                                                \
+         rtdb_write_field(0U, RTDB_ID_##ID, (int64_t)val);            \
+     }
+ #define RTDB_ACC_RTDB_ZONE(ID, acc, type)                            \
+     RTDB_ACC_RTDB_GLOBAL(ID, acc, type)                              \
+     type rtdb_get_##acc##_zone(uint8_t zone)                         \
+     {                                                                \
+         return (type)rtdb_get_zone(zone, RTDB_ID_##ID);              \
+     }                                                                \
+     void rtdb_set_##acc##_zone(uint8_t zone, type val)               \
+     {                                                                \
+         rtdb_write_field(zone, RTDB_ID_##ID, (int64_t)val);          \
+     }
+ #define RTDB_X_ACCESSORS(ID, name, acc, type, def, lo, hi, access, scope) \
+     RTDB_ACC_##scope(ID, acc, type)
+ RTDB_FIELDS(RTDB_X_ACCESSORS)
+ 
+ #if defined(CONFIG_RTDB_LOCK_STATS)
+ 
+ /**
+  * @brief Copia as estatísticas do chamador idx no domínio dom (sem entrar nas próprias
+  *        estatísticas)
   *
-  * @return Intervalo de amostragem em milissegundos
+  * @param dom  Domínio
+  * @param idx  Índice da entrada (0..RTDB_LOCKSTAT_MAX_CALLERS-1)
+  * @param out  Destino da cópia
+  * @return     0, ou -ENOENT se a entrada não existe ou ainda não foi usada
   */
- uint32_t rtdb_get_sampling_rate(void)
+ int rtdb_lock_stats_get(rtdb_domain_t dom, uint8_t idx, rtdb_lockstat_t *out)
  {
-     uint32_t v;
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
-     v = g_rtdb.sampling_rate_ms;
-     k_mutex_unlock(&rtdb_mutex);
-     return v;
+     if (((unsigned)dom >= RTDB_NUM_DOMAINS) || (idx >= RTDB_LOCKSTAT_MAX_CALLERS)) {
+         return -ENOENT;
+     }
+     k_spinlock_key_t key = k_spin_lock(&rtdb_spin[dom]);
+     *out = rtdb_lockstats[dom][idx];
+     k_spin_unlock(&rtdb_spin[dom], key);
+     return (out->caller != NULL) ? 0 : -ENOENT;
  }
  
  /**
-  * @brief Atualiza sampling_rate_ms, limitando entre 10 ms e 60000 ms (protected by mutex)
+  * @brief Apaga todas as estatísticas de contenção
+  */
+ void rtdb_lock_stats_reset(void)
+ {
+     for (uint32_t d = 0U; d < RTDB_NUM_DOMAINS; d++) {
+         k_spinlock_key_t key = k_spin_lock(&rtdb_spin[d]);
+         memset(rtdb_lockstats[d], 0, sizeof(rtdb_lockstats[d]));
+         k_spin_unlock(&rtdb_spin[d], key);
+     }
+ }
+ 
+ #endif /* CONFIG_RTDB_LOCK_STATS */
+ 
+ #if defined(CONFIG_RTDB_BENCH)
+ 
+ #define RTDB_BENCH_ITER 1000U  /**< Número de leituras por medição */
+ 
+ /**
+  * @brief Compara o custo (ciclos) de ler system_on/setpoint/current_temp com os três
+  *        getters protegidos por spinlock e com um único rtdb_snapshot()
   *
-  * @param ms  Novo intervalo de amostragem em milissegundos
+  * Imprime a média de ciclos por leitura completa de cada método.
   */
- void rtdb_set_sampling_rate(uint32_t ms)
+ void rtdb_bench_snapshot(void)
  {
-     k_mutex_lock(&rtdb_mutex, K_FOREVER);
+     volatile int32_t sink = 0;
+     rtdb_t snap;
  
-     if (ms < 10) {
-         g_rtdb.sampling_rate_ms = 10;
-     } else if (ms > 60000) {
-         g_rtdb.sampling_rate_ms = 60000;
-     } else {
-         g_rtdb.sampling_rate_ms = ms;
+     uint32_t t0 = k_cycle_get_32();
+     for (uint32_t i = 0U; i < RTDB_BENCH_ITER; i++) {
+         sink += rtdb_get_system_on();
+         sink += rtdb_get_setpoint();
+         sink += rtdb_get_current_temp();
      }
-     k_mutex_unlock(&rtdb_mutex);
+     uint32_t t1 = k_cycle_get_32();
+     for (uint32_t i = 0U; i < RTDB_BENCH_ITER; i++) {
+         rtdb_snapshot(&snap);
+         sink += snap.system_on + snap.setpoint[0] + snap.current_temp[0];
+     }
+     uint32_t t2 = k_cycle_get_32();
+     ARG_UNUSED(sink);
+ 
+     printk("[RTDB] bench: 3x getter(spinlock) = %u ciclos, snapshot(seqlock) = %u ciclos\n",
+            (t1 - t0) / RTDB_BENCH_ITER, (t2 - t1) / RTDB_BENCH_ITER);
  }
-
+ 
+ #endif /* CONFIG_RTDB_BENCH */
@@ -3,99 +3,415 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <zephyr/kernel.h>
+
+#include "rtdb_schema.h"
+#include "rtdb_history.h"
+#include "rtdb_lockstat.h"
+#include "rtdb_stats.h"
+#include "rtdb_journal.h"
 
 /**
  * @file rtdb.h
  * @brief Protótipos do Real-Time Database (RTDB) para o controlador térmico
  *
  * @details
- *   Este ficheiro define a estrutura rtdb_t e as funções de acesso (getters/setters)
- *   protegidas por mutex, de modo a permitir comunicação segura entre várias tasks.
+ *   A estrutura rtdb_t, os identificadores RTDB_ID_*, as máscaras RTDB_F_* e os
+ *   limites de cada campo são gerados a partir da tabela RTDB_FIELDS()
+ *   (rtdb_schema.h). Este ficheiro declara as funções de acesso protegidas por
+ *   spinlocks (um por domínio: configuração e medição, ver rtdb_domain_t), de
+ *   modo a permitir comunicação segura entre várias tasks e ISRs:
+ *     - rtdb_get_<acc>()/rtdb_set_<acc>(): um acessor tipado por campo da tabela
+ *       (p.ex. rtdb_get_setpoint(), rtdb_set_sampling_rate()); os setters saturam
+ *       ao intervalo da tabela e mantêm min_temp ≤ setpoint ≤ max_temp
+ *     - rtdb_get()/rtdb_set(): caminho genérico por identificador
+ *
+ *   Campos de zona (setpoint, current_temp, max_temp, min_temp, heater) existem
+ *   RTDB_NUM_ZONES vezes (CONFIG_RTDB_NUM_ZONES). Cada um tem também acessores
+ *   rtdb_get_<acc>_zone(z)/rtdb_set_<acc>_zone(z, v); os acessores sem sufixo
+ *   operam sobre a zona 0, tal como rtdb_get(), rtdb_set(), rtdb_update() e
+ *   rtdb_history_window().
+ */
+
+/**
+ * @brief Subscrição de alterações de campos da RTDB
+ *
+ * Cada consumidor tem a sua (memória estática), registada com rtdb_subscribe().
+ */
+struct rtdb_sub {
+    struct k_event evt;              /* Bits RTDB_F_* alterados e ainda não consumidos */
+    uint32_t       mask;             /* Campos de interesse */
+    uint32_t       pending_since;    /* Ciclo da 1.ª alteração pendente (uso interno) */
+    uint32_t       changed_at;       /* Ciclo (k_cycle_get_32) da alteração que acordou o último rtdb_wait() */
+};
+
+/**
+ * @brief Pseudo-campo das subscrições: cada amostra de current_temp (de qualquer zona)
+ *
+ * Ao contrário de RTDB_F_CURRENT_TEMP, é sinalizado mesmo que o valor se repita, e
+ * só depois de a amostra estar no histórico (rtdb_history_follow_zone()).
+ */
+#define RTDB_F_SAMPLE (1U << 31)
+
+/** @cond INTERNAL */
+#define RTDB_DECL_RTDB_GLOBAL(acc, type)                  \
+    type rtdb_get_##acc(void);                            \
+    void rtdb_set_##acc(type val);
+#define RTDB_DECL_RTDB_ZONE(acc, type)                    \
+    RTDB_DECL_RTDB_GLOBAL(acc, type)                      \
+    type rtdb_get_##acc##_zone(uint8_t zone);             \
+    void rtdb_set_##acc##_zone(uint8_t zone, type val);
+#define RTDB_X_DECL(ID, name, acc, type, def, lo, hi, access, scope) \
+    RTDB_DECL_##scope(acc, type)
+/** @endcond */
+
+/**
+ * @brief Acessores tipados rtdb_get_<acc>()/rtdb_set_<acc>() de cada campo da tabela
+ *        (e rtdb_get_<acc>_zone()/rtdb_set_<acc>_zone() nos campos de zona)
  */
+RTDB_FIELDS(RTDB_X_DECL)
 
 /**
- * @brief Estrutura que contém todas as variáveis compartilhadas no sistema
+ * @brief Lê um campo pelo identificador (caminho genérico)
+ *
+ * @param id  Identificador RTDB_ID_*
+ * @return    Valor do campo convertido para int32_t (0 se id inválido)
+ */
+int32_t  rtdb_get(rtdb_field_t id);
+
+/**
+ * @brief Lê um campo de uma zona pelo identificador
+ *
+ * @param zone  Zona (ignorada em campos globais)
+ * @param id    Identificador RTDB_ID_*
+ * @return      Valor do campo (0 se id ou zona inválidos)
+ */
+int32_t  rtdb_get_zone(uint8_t zone, rtdb_field_t id);
+
+/**
+ * @brief Escreve um campo pelo identificador (caminho genérico, validado)
+ *
+ * Equivalente a rtdb_update(RTDB_F(id), ...): valores fora dos limites da tabela ou
+ * que violem as invariantes são rejeitados. Campos RTDB_RO não são aceites.
+ *
+ * @param id   Identificador RTDB_ID_*
+ * @param val  Novo valor
+ * @return     RTDB_OK, RTDB_EINVAL ou RTDB_EACCES
+ */
+rtdb_status_t rtdb_set(rtdb_field_t id, int32_t val);
+
+/**
+ * @brief Como rtdb_set(), numa zona específica
+ */
+rtdb_status_t rtdb_set_zone(uint8_t zone, rtdb_field_t id, int32_t val);
+
+/**
+ * @brief Copia toda a RTDB de uma só vez, de forma consistente e sem bloquear (seqlock)
+ *
+ * Os campos de cada domínio pertencem ao mesmo instante (nenhuma escrita a meio);
+ * a configuração e a medição são copiadas uma após a outra e podem vir de instantes
+ * ligeiramente diferentes.
+ * Preferir a vários getters seguidos quando uma task precisa de mais de um campo.
+ * Os campos de zona vêm como arrays (p.ex. out->setpoint[z]).
+ *
+ * @param out  Estrutura onde é escrita a cópia
+ */
+void     rtdb_snapshot(rtdb_t *out);
+
+/**
+ * @brief Atualiza vários campos de uma só vez, de forma atómica e validada
+ *
+ * Os campos indicados em mask são lidos de vals e aplicados todos sob os mesmos locks,
+ * depois de validados em conjunto contra os restantes valores atuais. Se setpoint não
+ * estiver em mask e ficar fora dos novos limites, é ajustado ao limite (como em
+ * rtdb_set_max_temp()/rtdb_set_min_temp()). Se alguma invariante falhar, nada é alterado.
+ * Campos RTDB_RO (medições) não são aceites: mask com algum deles devolve RTDB_EACCES.
+ *
+ * @param mask  Máscara RTDB_F_* dos campos a alterar
+ * @param vals  Novos valores (só os campos em mask são lidos)
+ * @return      RTDB_OK se aplicado, RTDB_EINVAL se rejeitado, RTDB_EACCES se mask tiver
+ *              campos RTDB_RO
+ */
+rtdb_status_t rtdb_update(uint32_t mask, const rtdb_zone_t *vals);
+
+/**
+ * @brief Como rtdb_update(), numa zona específica (campos globais são partilhados)
+ *
+ * @return RTDB_OK, RTDB_EACCES, ou RTDB_EINVAL se rejeitado ou zone ≥ RTDB_NUM_ZONES
+ */
+rtdb_status_t rtdb_update_zone(uint8_t zone, uint32_t mask, const rtdb_zone_t *vals);
+
+/**
+ * @brief Inverte system_on de forma atómica (pode ser chamada a partir de ISRs)
+ *
+ * @return Novo valor de system_on
+ */
+bool     rtdb_toggle_system_on(void);
+
+/**
+ * @brief Soma delta ao setpoint (zona 0) de forma atómica (pode ser chamada a partir de ISRs)
+ *
+ * O resultado satura em [min_temp, max_temp], tal como rtdb_set_setpoint().
+ *
+ * @param delta  Variação em °C
+ * @param sat    Se não for NULL, recebe true quando o resultado ficou limitado
+ * @return       Novo setpoint
+ */
+int16_t  rtdb_step_setpoint(int16_t delta, bool *sat);
+
+#define RTDB_MAX_PROFILES     4U  /**< Número de perfis de configuração */
+#define RTDB_PROFILE_NAME_LEN 8U  /**< Carateres do nome de um perfil */
+
+/** Campos de um perfil: toda a configuração exceto system_on (ligar/desligar não é uma receita) */
+#define RTDB_PROFILE_MASK (RTDB_DOM_MASK_CFG & ~RTDB_F_SYSTEM_ON)
+
+/**
+ * @brief Perfil de configuração (receita): conjunto completo e já validado de campos
  */
 typedef struct {
-    bool    system_on;         /* Sistema ligado/desligado */
-    int16_t setpoint;          /* Temperatura alvo (°C) */
-    int16_t current_temp;      /* Temperatura lida do sensor (°C) */
-    int16_t max_temp;          /* Temperatura máxima permitida (°C) */
-    int16_t min_temp;          /* Temperatura mínima permitida (°C) */
-    uint32_t sampling_rate_ms; /* Intervalo de amostragem em ms */
-} rtdb_t;
+    bool   valid;                              /* Perfil definido */
+    char   name[RTDB_PROFILE_NAME_LEN + 1U];   /* Nome ('\0' no fim) */
+    rtdb_t cfg;                                /* Só os campos de RTDB_PROFILE_MASK contam */
+} rtdb_profile_t;
+
+/**
+ * @brief Guarda a configuração atual (todas as zonas) como perfil n
+ *
+ * @param n     Perfil (0..RTDB_MAX_PROFILES-1)
+ * @param name  Nome (truncado a RTDB_PROFILE_NAME_LEN carateres)
+ * @return      RTDB_OK ou RTDB_EINVAL se n não existir
+ */
+rtdb_status_t rtdb_profile_save(uint8_t n, const char *name);
+
+/**
+ * @brief Altera campos de uma zona de um perfil já definido, sem tocar na configuração ativa
+ *
+ * Valida com as mesmas regras de rtdb_update_zone(), aplicadas ao perfil.
+ *
+ * @return RTDB_OK, ou RTDB_EINVAL (perfil indefinido, campo fora de
+ *         RTDB_PROFILE_MASK ou valores inválidos; o perfil fica inalterado)
+ */
+rtdb_status_t rtdb_profile_edit(uint8_t n, uint8_t zone, uint32_t mask, const rtdb_zone_t *vals);
 
 /**
- * @brief Lê se o sistema está ligado ou não
- * @return true se ligado, false se desligado
+ * @brief Ativa o perfil n numa única secção crítica
+ *
+ * Os leitores (rtdb_snapshot(), getters) veem a configuração anterior ou a do
+ * perfil completa, nunca uma mistura. A configuração substituída fica guardada
+ * para rtdb_profile_rollback().
+ *
+ * @return RTDB_OK ou RTDB_EINVAL se o perfil não estiver definido
  */
-bool    rtdb_get_system_on(void);
+rtdb_status_t rtdb_profile_activate(uint8_t n);
 
 /**
- * @brief Altera o estado do sistema (ligado/desligado)
- * @param on  true para ligar, false para desligar
+ * @brief Repõe a configuração que estava ativa antes da última ativação (ou rollback)
+ *
+ * Dois rollbacks seguidos voltam ao perfil ativado.
+ *
+ * @return RTDB_OK ou RTDB_EINVAL se ainda não houve nenhuma ativação
  */
-void    rtdb_set_system_on(bool on);
+rtdb_status_t rtdb_profile_rollback(void);
 
 /**
- * @brief Lê o setpoint atual (°C)
- * @return Valor do setpoint (°C)
+ * @brief Copia o perfil n
+ *
+ * @return false se n não existir ou o perfil não estiver definido
  */
-int16_t rtdb_get_setpoint(void);
+bool     rtdb_profile_get(uint8_t n, rtdb_profile_t *out);
 
 /**
- * @brief Define um novo setpoint, validando entre min_temp e max_temp
- * @param val  Valor de setpoint desejado (°C)
+ * @brief Perfil ativo, ou -1 se a configuração não corresponde a uma ativação
+ *
+ * Qualquer escrita posterior de um campo de RTDB_PROFILE_MASK (UART, botões)
+ * deixa de contar como perfil ativo.
  */
-void    rtdb_set_setpoint(int16_t val);
+int      rtdb_profile_active(void);
 
 /**
- * @brief Lê a temperatura atual lida do sensor (°C)
- * @return Valor de current_temp (°C)
+ * @brief Prepara a leitura das amostras de current_temp numa janela temporal
+ *
+ * Cada rtdb_set_current_temp() acrescenta uma amostra (uptime, temp) a um buffer
+ * circular de RTDB_HIST_LEN entradas. A leitura não bloqueia o sensor nem copia o
+ * buffer: percorre-se amostra a amostra com rtdb_history_next().
+ *
+ * @param it         Iterador a inicializar
+ * @param t_from_ms  Início da janela (k_uptime_get_32(), ms)
+ * @param t_to_ms    Fim da janela (ms, inclusive)
  */
-int16_t rtdb_get_current_temp(void);
+void     rtdb_history_window(rtdb_hist_iter_t *it, uint32_t t_from_ms, uint32_t t_to_ms);
 
 /**
- * @brief Atualiza a temperatura atual (°C)
- * @param val  Valor lido do sensor (°C)
+ * @brief Como rtdb_history_window(), sobre o histórico da zona zone
  */
-void    rtdb_set_current_temp(int16_t val);
+void     rtdb_history_window_zone(uint8_t zone, rtdb_hist_iter_t *it,
+                                  uint32_t t_from_ms, uint32_t t_to_ms);
 
 /**
- * @brief Lê o valor de temperatura máxima permitida (°C)
- * @return max_temp (°C)
+ * @brief Prepara a leitura das amostras de current_temp da zona zone à medida que chegam
+ *
+ * O iterador começa na amostra mais recente e não tem fim (rtdb_history_follow()):
+ * com uma subscrição de RTDB_F_SAMPLE, cada rtdb_wait() é seguido de
+ * rtdb_history_next() até devolver false. Um leitor atrasado nunca atrasa o sensor;
+ * perde as amostras mais antigas, contadas em it->lost.
  */
-int16_t rtdb_get_max_temp(void);
+void     rtdb_history_follow_zone(uint8_t zone, rtdb_hist_iter_t *it);
 
 /**
- * @brief Define um novo valor de temperatura máxima, ajustando setpoint se necessário
- * @param val  Valor máximo permitido (°C)
+ * @brief Copia as estatísticas de current_temp da zona zone (rtdb_stats.h)
+ *
+ * Atualizadas em cada rtdb_set_current_temp_zone(), desde o último
+ * rtdb_temp_stats_reset(). Uma zona inexistente devolve estatísticas vazias.
+ *
+ * @param zone  Zona
+ * @param out   Recebe a cópia
  */
-void    rtdb_set_max_temp(int16_t val);
+void     rtdb_temp_stats_get(uint8_t zone, rtdb_stats_t *out);
 
 /**
- * @brief Lê o valor de temperatura mínima permitida (°C)
- * @return min_temp (°C)
+ * @brief Recomeça as estatísticas de current_temp de todas as zonas
  */
-int16_t rtdb_get_min_temp(void);
+void     rtdb_temp_stats_reset(void);
 
 /**
- * @brief Define um novo valor de temperatura mínima, ajustando setpoint se necessário
- * @param val  Valor mínimo permitido (°C)
+ * @brief Regista uma subscrição de alterações
+ *
+ * @param sub   Subscrição (deve existir durante toda a execução)
+ * @param mask  Máscara RTDB_F_* dos campos de interesse
+ * @return      0 em caso de sucesso, -ENOMEM se a tabela de subscrições estiver cheia
  */
-void    rtdb_set_min_temp(int16_t val);
+int      rtdb_subscribe(struct rtdb_sub *sub, uint32_t mask);
 
 /**
- * @brief Lê o intervalo de amostragem do sensor (ms)
- * @return sampling_rate_ms
+ * @brief Bloqueia até que algum campo subscrito mude de valor
+ *
+ * @param sub      Subscrição registada
+ * @param timeout  Tempo máximo de espera (K_FOREVER para esperar indefinidamente)
+ * @return         Máscara RTDB_F_* dos campos alterados desde a última chamada, 0 se expirou
  */
-uint32_t rtdb_get_sampling_rate(void);
+uint32_t rtdb_wait(struct rtdb_sub *sub, k_timeout_t timeout);
+
+struct rtdb_trigger;
 
 /**
- * @brief Define o intervalo de amostragem do sensor (limitado a 10..60000 ms)
- * @param ms  Novo intervalo em milissegundos
+ * @brief Callback de um trigger: tripped = true ao disparar, false ao rearmar
+ *
+ * Corre no contexto de quem escreveu o campo (thread ou ISR dos botões), logo
+ * depois de libertar o lock, ou na ISR do timer em RTDB_TRIG_STALE: tem de ser
+ * curto e não pode bloquear. Pode escrever na RTDB.
  */
-void     rtdb_set_sampling_rate(uint32_t ms);
+typedef void (*rtdb_trig_fn_t)(struct rtdb_trigger *t, uint8_t zone, bool tripped);
 
-#endif /* RTDB_H */
+/** @cond INTERNAL */
+struct rtdb_trig_timer {
+    struct k_timer       timer;
+    struct rtdb_trigger *trig;
+    uint8_t              zone;
+};
+/** @endcond */
+
+/**
+ * @brief Trigger avaliado no próprio setter (memória estática do chamador)
+ *
+ * Preencher field, cond, arg e fn/evt antes de rtdb_trigger_register().
+ */
+struct rtdb_trigger {
+    rtdb_field_t      field;      /* Campo vigiado */
+    rtdb_trig_cond_t  cond;       /* Condição (rtdb_schema.h) */
+    int32_t           arg;        /* Limiar, RTDB_ID_* de referência ou timeout (ms); lido em cada avaliação */
+    rtdb_trig_fn_t    fn;         /* Callback, ou NULL */
+    struct k_event   *evt;        /* Recebe BIT(zona) ao disparar, ou NULL */
+    atomic_t          tripped;    /* BIT(zona) das zonas em disparo (uso interno) */
+    uint32_t          trip_cyc[RTDB_NUM_ZONES];    /* Ciclo (k_cycle_get_32) da escrita que disparou */
+    struct rtdb_trig_timer stale[RTDB_NUM_ZONES];  /* Só RTDB_TRIG_STALE (uso interno) */
+};
+
+/**
+ * @brief Regista um trigger
+ *
+ * A condição é avaliada em cada escrita de field (ou do campo de referência) e o
+ * trigger dispara uma vez na transição falso→verdadeiro, rearmando na transição
+ * inversa. Em RTDB_TRIG_STALE o prazo de cada zona conta a partir do registo e é
+ * reiniciado em cada escrita de field, mesmo com o mesmo valor.
+ *
+ * @param t  Trigger (deve existir durante toda a execução)
+ * @return   0 em caso de sucesso, -ENOMEM se a tabela de triggers estiver cheia
+ */
+int      rtdb_trigger_register(struct rtdb_trigger *t);
+
+/**
+ * @brief true se o trigger está disparado na zona zone
+ */
+bool     rtdb_trigger_tripped(struct rtdb_trigger *t, uint8_t zone);
 
+/**
+ * @brief Define a origem das escritas feitas pela thread atual (diário da RTDB)
+ *
+ * Chamada uma vez no início de cada thread que escreve na RTDB. Escritas feitas em
+ * ISRs são registadas como RTDB_SRC_ISR, exceto rtdb_toggle_system_on() e
+ * rtdb_step_setpoint() (botões), que são sempre RTDB_SRC_BUTTON. Sem
+ * CONFIG_RTDB_JOURNAL não faz nada.
+ *
+ * @param src  Origem (rtdb_journal.h)
+ */
+void     rtdb_set_source(rtdb_src_t src);
+
+#if defined(CONFIG_RTDB_SHM)
+/**
+ * @brief Expõe g_rtdb, as estatísticas e o histórico em memória partilhada (native_sim)
+ *
+ * Cria o objeto POSIX CONFIG_RTDB_SHM_NAME (rtdb_shm.h) e, a partir daqui, cada
+ * escrita é também copiada para lá. Chamar em main() antes de criar as threads.
+ *
+ * @return 0, ou -ENOMEM se o objeto não pôde ser criado
+ */
+int      rtdb_shm_init(void);
+#endif
+
+#if defined(CONFIG_RTDB_JOURNAL)
+/**
+ * @brief Intervalo de índices absolutos ainda disponível no diário
+ *
+ * @param oldest  Recebe o índice da entrada mais antiga que ainda pode ser lida
+ * @return        Índice da próxima entrada a escrever (entradas em [*oldest, retorno))
+ */
+uint32_t rtdb_journal_span(uint32_t *oldest);
+
+/**
+ * @brief Copia a entrada idx do diário (sem lock)
+ *
+ * @param idx  Índice absoluto
+ * @param out  Recebe a entrada
+ * @return     false se a entrada já foi reescrita, ainda não existe ou está em escrita
+ */
+bool     rtdb_journal_get(uint32_t idx, rtdb_jentry_t *out);
+#endif
+
+#if defined(CONFIG_RTDB_LOCK_STATS)
+/**
+ * @brief Lê as estatísticas de contenção do lock de um domínio da RTDB de uma thread chamadora
+ *
+ * Cada domínio tem a sua tabela; as entradas são atribuídas por ordem de primeira
+ * utilização do lock; out->caller é o k_tid_t da thread, ou RTDB_LOCKSTAT_ISR para as ISRs.
+ *
+ * @param dom  Domínio (RTDB_DOM_CFG ou RTDB_DOM_MEAS)
+ * @param idx  Índice da entrada (0..RTDB_LOCKSTAT_MAX_CALLERS-1)
+ * @param out  Recebe uma cópia da entrada
+ * @return     0, ou -ENOENT se a entrada não existe ou está livre
+ */
+int      rtdb_lock_stats_get(rtdb_domain_t dom, uint8_t idx, rtdb_lockstat_t *out);
+
+/**
+ * @brief Apaga as estatísticas de contenção de todas as threads, em todos os domínios
+ */
+void     rtdb_lock_stats_reset(void);
+#endif
+
+#if defined(CONFIG_RTDB_BENCH)
+/**
+ * @brief Mede e imprime o custo em ciclos de getters com spinlock vs rtdb_snapshot()
+ */
+void     rtdb_bench_snapshot(void);
+#endif
+
+#endif /* RTDB_H */
@@ -0,0 +1,129 @@
+/**
+ * @file rtdb_history.c
+ * @brief Buffer circular SPMC de amostras de temperatura (ver rtdb_history.h)
+ */
+
+ #include "rtdb_history.h"
+ 
+ #if defined(UNIT_TEST)
+ #define RTDB_HIST_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+ #else
+ #include <zephyr/sys/barrier.h>
+ #define RTDB_HIST_BARRIER() barrier_dmem_fence_full()
+ #endif
+ 
+ #define RTDB_HIST_MASK (RTDB_HIST_LEN - 1U)
+ 
+ _Static_assert((RTDB_HIST_LEN & RTDB_HIST_MASK) == 0U, "RTDB_HIST_LEN tem de ser potência de 2");
+ 
+ /**
+  * @brief true se o instante a não é anterior a b (tolera a volta do contador de 32 bits)
+  */
+ static inline bool t_after_eq(uint32_t a, uint32_t b)
+ {
+     return (int32_t)(a - b) >= 0;
+ }
+ 
+ void rtdb_history_push(rtdb_history_t *h, uint32_t t_ms, int16_t temp)
+ {
+     uint32_t idx = h->head;
+     rtdb_hist_slot_t *slot = &h->slot[idx & RTDB_HIST_MASK];
+ 
+     slot->seq = 0U;
+     RTDB_HIST_BARRIER();
+     slot->s.t_ms = t_ms;
+     slot->s.temp = temp;
+     RTDB_HIST_BARRIER();
+     slot->seq = idx + 1U;
+     RTDB_HIST_BARRIER();
+     h->head = idx + 1U;
+ }
+ 
+ /**
+  * @brief Copia a amostra de índice absoluto idx, se ainda estiver no buffer
+  *
+  * @return true se a cópia é consistente e pertence a idx
+  */
+ static bool rtdb_history_read(const rtdb_history_t *h, uint32_t idx, rtdb_sample_t *out)
+ {
+     const rtdb_hist_slot_t *slot = &h->slot[idx & RTDB_HIST_MASK];
+ 
+     uint32_t seq = slot->seq;
+     RTDB_HIST_BARRIER();
+     out->t_ms = slot->s.t_ms;
+     out->temp = slot->s.temp;
+     RTDB_HIST_BARRIER();
+     return (seq == idx + 1U) && (slot->seq == seq);
+ }
+ 
+ /**
+  * @brief Índice absoluto da amostra mais antiga ainda disponível
+  */
+ static uint32_t rtdb_history_oldest(uint32_t head)
+ {
+     return (head > RTDB_HIST_LEN) ? (head - RTDB_HIST_LEN) : 0U;
+ }
+ 
+ void rtdb_history_iter_init(rtdb_hist_iter_t *it, const rtdb_history_t *h,
+                             uint32_t t_from, uint32_t t_to)
+ {
+     uint32_t hi = h->head;
+     uint32_t lo = rtdb_history_oldest(hi);
+     rtdb_sample_t s;
+ 
+     RTDB_HIST_BARRIER();
+ 
+     /* Primeira amostra com t_ms ≥ t_from; slots já reescritos contam como antigos */
+     while (lo < hi) {
+         uint32_t mid = lo + ((hi - lo) / 2U);
+         if (!rtdb_history_read(h, mid, &s) || !t_after_eq(s.t_ms, t_from)) {
+             lo = mid + 1U;
+         } else {
+             hi = mid;
+         }
+     }
+ 
+     it->h = h;
+     it->next = lo;
+     it->t_to = t_to;
+     it->open = false;
+     it->lost = 0U;
+ }
+ 
+ void rtdb_history_follow(rtdb_hist_iter_t *it, const rtdb_history_t *h)
+ {
+     uint32_t head = h->head;
+ 
+     it->h = h;
+     it->next = (head > 0U) ? (head - 1U) : 0U;
+     it->t_to = 0U;
+     it->open = true;
+     it->lost = 0U;
+ }
+ 
+ bool rtdb_history_next(rtdb_hist_iter_t *it, rtdb_sample_t *out)
+ {
+     for (;;) {
+         uint32_t head = it->h->head;
+         RTDB_HIST_BARRIER();
+ 
+         if (it->next >= head) {
+             return false;
+         }
+         if (it->next < rtdb_history_oldest(head)) {
+             /* o produtor ultrapassou o leitor */
+             it->lost += rtdb_history_oldest(head) - it->next;
+             it->next = rtdb_history_oldest(head);
+         }
+         if (!rtdb_history_read(it->h, it->next, out)) {
+             it->next++;
+             it->lost++;
+             continue;
+         }
+         if (!it->open && !t_after_eq(it->t_to, out->t_ms)) {
+             return false;
+         }
+         it->next++;
+         return true;
+     }
+ }
@@ -0,0 +1,104 @@
+#ifndef RTDB_HISTORY_H
+#define RTDB_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file rtdb_history.h
+ * @brief Histórico de temperatura (uptime, temp) da RTDB em buffer circular
+ *
+ * @details
+ *   Buffer circular de capacidade fixa com um único produtor (setter de
+ *   current_temp, chamado pela sensor_task) e vários consumidores sem lock:
+ *     - o produtor escreve a amostra no slot e só depois publica o seu número
+ *       de sequência (índice absoluto + 1) e avança head;
+ *     - o leitor copia um slot e confirma que a sequência não mudou durante a
+ *       cópia; se o slot foi reescrito, a amostra é descartada (já é antiga).
+ *
+ *   O produtor nunca espera pelos leitores e os leitores nunca bloqueiam o
+ *   produtor. Os iteradores percorrem uma janela temporal amostra a amostra,
+ *   sem copiar o buffer inteiro.
+ *
+ *   Não depende do Zephyr (é testado no host); no firmware as barreiras de
+ *   memória são barrier_dmem_fence_full().
+ */
+
+#if defined(CONFIG_RTDB_HISTORY_LEN)
+#define RTDB_HIST_LEN CONFIG_RTDB_HISTORY_LEN
+#else
+#define RTDB_HIST_LEN 256U   /**< Capacidade (potência de 2) */
+#endif
+
+/**
+ * @brief Uma amostra do histórico
+ */
+typedef struct {
+    uint32_t t_ms;   /* Uptime da amostra (ms, k_uptime_get_32) */
+    int16_t  temp;   /* Temperatura (°C) */
+} rtdb_sample_t;
+
+/**
+ * @brief Slot do buffer circular
+ */
+typedef struct {
+    volatile uint32_t seq;   /* Índice absoluto + 1 da amostra no slot (0 = em escrita) */
+    rtdb_sample_t     s;
+} rtdb_hist_slot_t;
+
+/**
+ * @brief Buffer circular de amostras
+ */
+typedef struct {
+    volatile uint32_t head;                  /* Número total de amostras publicadas */
+    rtdb_hist_slot_t  slot[RTDB_HIST_LEN];
+} rtdb_history_t;
+
+/**
+ * @brief Iterador sobre uma janela temporal [t_from, t_to] do histórico
+ */
+typedef struct {
+    const rtdb_history_t *h;
+    uint32_t next;   /* Índice absoluto da próxima amostra a ler */
+    uint32_t t_to;   /* Fim da janela (ms, inclusive) */
+    bool     open;   /* Sem fim: segue o produtor (rtdb_history_follow()) */
+    uint32_t lost;   /* Amostras saltadas por terem sido reescritas antes de lidas */
+} rtdb_hist_iter_t;
+
+/**
+ * @brief Acrescenta uma amostra (só pode haver um produtor)
+ */
+void rtdb_history_push(rtdb_history_t *h, uint32_t t_ms, int16_t temp);
+
+/**
+ * @brief Posiciona it na primeira amostra com t_ms ≥ t_from (pesquisa binária)
+ *
+ * @param it      Iterador a inicializar
+ * @param h       Histórico
+ * @param t_from  Início da janela (ms)
+ * @param t_to    Fim da janela (ms, inclusive)
+ */
+void rtdb_history_iter_init(rtdb_hist_iter_t *it, const rtdb_history_t *h,
+                            uint32_t t_from, uint32_t t_to);
+
+/**
+ * @brief Posiciona it na amostra mais recente, sem fim de janela
+ *
+ * rtdb_history_next() devolve essa amostra e depois cada uma que o produtor
+ * publicar, à medida que chegam; as que forem reescritas antes de lidas (leitor
+ * atrasado mais de RTDB_HIST_LEN amostras) são saltadas e contadas em it->lost.
+ */
+void rtdb_history_follow(rtdb_hist_iter_t *it, const rtdb_history_t *h);
+
+/**
+ * @brief Lê a próxima amostra da janela
+ *
+ * Amostras reescritas pelo produtor entretanto são saltadas.
+ *
+ * @param it   Iterador
+ * @param out  Recebe a amostra
+ * @return     true se out foi preenchida, false no fim da janela
+ */
+bool rtdb_history_next(rtdb_hist_iter_t *it, rtdb_sample_t *out);
+
+#endif /* RTDB_HISTORY_H */
@@ -0,0 +1,144 @@
+/**
+ * @file rtdb_journal.c
+ * @brief Diário MPMC das escritas da RTDB (ver rtdb_journal.h)
+ */
+
+ #include "rtdb_journal.h"
+ 
+ #if defined(UNIT_TEST)
+ #define RTDB_JOURNAL_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+ #else
+ #include <zephyr/sys/barrier.h>
+ #define RTDB_JOURNAL_BARRIER() barrier_dmem_fence_full()
+ #endif
+ 
+ #define RTDB_JOURNAL_MASK (RTDB_JOURNAL_LEN - 1U)
+ 
+ _Static_assert((RTDB_JOURNAL_LEN & RTDB_JOURNAL_MASK) == 0U,
+                "RTDB_JOURNAL_LEN tem de ser potência de 2");
+ 
+ void rtdb_journal_push(rtdb_journal_t *j, const rtdb_jentry_t *e)
+ {
+     /* Vários produtores: cada um reserva o seu índice */
+     uint32_t idx = __atomic_fetch_add(&j->head, 1U, __ATOMIC_SEQ_CST);
+     rtdb_jslot_t *slot = &j->slot[idx & RTDB_JOURNAL_MASK];
+ 
+     slot->seq = 0U;
+     RTDB_JOURNAL_BARRIER();
+     slot->e = *e;
+     RTDB_JOURNAL_BARRIER();
+     slot->seq = idx + 1U;
+ }
+ 
+ uint32_t rtdb_journal_head(const rtdb_journal_t *j)
+ {
+     uint32_t head = j->head;
+ 
+     RTDB_JOURNAL_BARRIER();
+     return head;
+ }
+ 
+ uint32_t rtdb_journal_oldest(uint32_t head)
+ {
+     return (head > RTDB_JOURNAL_LEN) ? (head - RTDB_JOURNAL_LEN) : 0U;
+ }
+ 
+ bool rtdb_journal_read(const rtdb_journal_t *j, uint32_t idx, rtdb_jentry_t *out)
+ {
+     const rtdb_jslot_t *slot = &j->slot[idx & RTDB_JOURNAL_MASK];
+ 
+     uint32_t seq = slot->seq;
+     RTDB_JOURNAL_BARRIER();
+     *out = slot->e;
+     RTDB_JOURNAL_BARRIER();
+     return (seq == idx + 1U) && (slot->seq == seq);
+ }
+ 
+ /**
+  * Formato: t_ms(4) id(1) zone(1) src(1) old(3) val(3) rsv(1). old e val são
+  * guardados em 24 bits com sinal (chegam para temperaturas, limites e períodos
+  * de amostragem até ~8.3e6 ms).
+  */
+ void rtdb_journal_pack(const rtdb_jentry_t *e, uint8_t *b)
+ {
+     uint32_t old = (uint32_t)e->old;
+     uint32_t val = (uint32_t)e->val;
+ 
+     for (uint32_t i = 0U; i < 4U; i++) {
+         b[i] = (uint8_t)(e->t_ms >> (8U * i));
+     }
+     b[4] = e->id;
+     b[5] = e->zone;
+     b[6] = e->src;
+     for (uint32_t i = 0U; i < 3U; i++) {
+         b[7U + i]  = (uint8_t)(old >> (8U * i));
+         b[10U + i] = (uint8_t)(val >> (8U * i));
+     }
+     b[13] = e->rsv;
+ }
+ 
+ /**
+  * @brief Estende um valor de 24 bits com sinal para 32 bits
+  */
+ static int32_t sext24(uint32_t v)
+ {
+     return (int32_t)((v ^ 0x800000U) - 0x800000U);
+ }
+ 
+ static int hexval(char c)
+ {
+     if ((c >= '0') && (c <= '9')) {
+         return c - '0';
+     }
+     if ((c >= 'A') && (c <= 'F')) {
+         return c - 'A' + 10;
+     }
+     if ((c >= 'a') && (c <= 'f')) {
+         return c - 'a' + 10;
+     }
+     return -1;
+ }
+ 
+ void rtdb_journal_encode(const rtdb_jentry_t *e, char *hex)
+ {
+     static const char digits[] = "0123456789ABCDEF";
+     uint8_t b[RTDB_JOURNAL_WIRE_LEN];
+ 
+     rtdb_journal_pack(e, b);
+     for (uint32_t i = 0U; i < RTDB_JOURNAL_WIRE_LEN; i++) {
+         hex[2U * i]      = digits[b[i] >> 4];
+         hex[2U * i + 1U] = digits[b[i] & 0x0FU];
+     }
+ }
+ 
+ bool rtdb_journal_decode(const char *hex, rtdb_jentry_t *e)
+ {
+     uint8_t b[RTDB_JOURNAL_WIRE_LEN];
+     uint32_t old = 0U;
+     uint32_t val = 0U;
+ 
+     for (uint32_t i = 0U; i < RTDB_JOURNAL_WIRE_LEN; i++) {
+         int hi = hexval(hex[2U * i]);
+         int lo = hexval(hex[2U * i + 1U]);
+         if ((hi < 0) || (lo < 0)) {
+             return false;
+         }
+         b[i] = (uint8_t)((hi << 4) | lo);
+     }
+ 
+     e->t_ms = 0U;
+     for (uint32_t i = 0U; i < 4U; i++) {
+         e->t_ms |= (uint32_t)b[i] << (8U * i);
+     }
+     e->id = b[4];
+     e->zone = b[5];
+     e->src = b[6];
+     for (uint32_t i = 0U; i < 3U; i++) {
+         old |= (uint32_t)b[7U + i] << (8U * i);
+         val |= (uint32_t)b[10U + i] << (8U * i);
+     }
+     e->old = sext24(old);
+     e->val = sext24(val);
+     e->rsv = b[13];
+     return true;
+ }
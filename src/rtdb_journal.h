@@ -0,0 +1,127 @@
+#ifndef RTDB_JOURNAL_H
+#define RTDB_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file rtdb_journal.h
+ * @brief Diário binário das escritas da RTDB (para reconstituir e reproduzir incidentes)
+ *
+ * @details
+ *   Cada escrita da RTDB que muda um valor (e cada amostra de current_temp, mesmo
+ *   repetida) gera uma entrada de 16 bytes: instante, campo, zona, origem e valores
+ *   antigo/novo. As entradas vão para um buffer circular sem lock com vários
+ *   produtores (threads e ISRs):
+ *     - o produtor reserva um índice absoluto com um fetch-add atómico sobre head,
+ *       invalida o slot, escreve a entrada e só depois publica a sequência
+ *       (índice + 1);
+ *     - o leitor copia um slot e aceita-o só se a sequência corresponde ao índice
+ *       pedido e não mudou durante a cópia (entradas reescritas ou ainda em escrita
+ *       são saltadas).
+ *   Um produtor só pode estragar o slot de outro se der a volta completa ao buffer
+ *   enquanto o outro escreve, o que com RTDB_JOURNAL_LEN entradas não acontece.
+ *
+ *   Pela UART as entradas seguem em hexadecimal (RTDB_JOURNAL_HEX_LEN carateres,
+ *   little-endian), codificadas com rtdb_journal_encode(); tools/journal_replay.c
+ *   descodifica-as com rtdb_journal_decode().
+ *
+ *   Não depende do Zephyr (é testado no host e usado pela ferramenta de replay).
+ */
+
+#if defined(CONFIG_RTDB_JOURNAL_LEN)
+#define RTDB_JOURNAL_LEN CONFIG_RTDB_JOURNAL_LEN
+#else
+#define RTDB_JOURNAL_LEN 256U   /**< Capacidade (potência de 2) */
+#endif
+
+#define RTDB_JOURNAL_HEX_LEN 28U  /**< Carateres hexadecimais de uma entrada codificada */
+#define RTDB_JOURNAL_WIRE_LEN (RTDB_JOURNAL_HEX_LEN / 2U)  /**< Bytes de uma entrada serializada */
+
+/**
+ * @brief Origem de uma escrita
+ */
+typedef enum {
+    RTDB_SRC_UNKNOWN = 0,  /* Thread sem origem atribuída */
+    RTDB_SRC_UART,         /* Comando recebido pela UART */
+    RTDB_SRC_BUTTON,       /* Botões (ISR) */
+    RTDB_SRC_SENSOR,       /* sensor_task (e triggers disparados pelas suas escritas) */
+    RTDB_SRC_CTRL,         /* control_task */
+    RTDB_SRC_PERSIST,      /* Configuração restaurada da flash */
+    RTDB_SRC_ISR,          /* Outras ISRs (p.ex. timers dos triggers) */
+    RTDB_NUM_SRCS
+} rtdb_src_t;
+
+/**
+ * @brief Uma entrada do diário
+ */
+typedef struct {
+    uint32_t t_ms;   /* Uptime da escrita (ms, k_uptime_get_32) */
+    uint8_t  id;     /* Campo (rtdb_field_t) */
+    uint8_t  zone;   /* Zona (0 nos campos globais) */
+    uint8_t  src;    /* Origem (rtdb_src_t) */
+    uint8_t  rsv;
+    int32_t  old;    /* Valor antes da escrita */
+    int32_t  val;    /* Valor depois da escrita */
+} rtdb_jentry_t;
+
+/**
+ * @brief Slot do buffer circular
+ */
+typedef struct {
+    volatile uint32_t seq;   /* Índice absoluto + 1 da entrada no slot (0 = em escrita) */
+    rtdb_jentry_t     e;
+} rtdb_jslot_t;
+
+/**
+ * @brief Buffer circular de entradas
+ */
+typedef struct {
+    volatile uint32_t head;                     /* Número total de entradas reservadas */
+    rtdb_jslot_t      slot[RTDB_JOURNAL_LEN];
+} rtdb_journal_t;
+
+/**
+ * @brief Acrescenta uma entrada (pode ser chamada de várias threads e ISRs em simultâneo)
+ */
+void rtdb_journal_push(rtdb_journal_t *j, const rtdb_jentry_t *e);
+
+/**
+ * @brief Índice absoluto da próxima entrada a reservar
+ */
+uint32_t rtdb_journal_head(const rtdb_journal_t *j);
+
+/**
+ * @brief Índice absoluto da entrada mais antiga que ainda pode estar no buffer
+ */
+uint32_t rtdb_journal_oldest(uint32_t head);
+
+/**
+ * @brief Copia a entrada de índice absoluto idx
+ *
+ * @return true se a cópia é consistente e pertence a idx (false se já foi
+ *         reescrita ou ainda está a ser escrita)
+ */
+bool rtdb_journal_read(const rtdb_journal_t *j, uint32_t idx, rtdb_jentry_t *out);
+
+/**
+ * @brief Serializa e em RTDB_JOURNAL_WIRE_LEN bytes little-endian (modo binário da UART)
+ */
+void rtdb_journal_pack(const rtdb_jentry_t *e, uint8_t *b);
+
+/**
+ * @brief Codifica e em RTDB_JOURNAL_HEX_LEN carateres hexadecimais (sem '\0')
+ *
+ * old e val seguem com 24 bits com sinal (suficiente para todos os campos da RTDB).
+ */
+void rtdb_journal_encode(const rtdb_jentry_t *e, char *hex);
+
+/**
+ * @brief Descodifica RTDB_JOURNAL_HEX_LEN carateres hexadecimais
+ *
+ * @return false se algum caráter não for hexadecimal
+ */
+bool rtdb_journal_decode(const char *hex, rtdb_jentry_t *e);
+
+#endif /* RTDB_JOURNAL_H */
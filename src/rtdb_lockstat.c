@@ -0,0 +1,45 @@
+/**
+ * @file rtdb_lockstat.c
+ * @brief Histogramas de espera/posse do mutex da RTDB (ver rtdb_lockstat.h)
+ */
+
+ #include "rtdb_lockstat.h"
+ 
+ uint8_t rtdb_lockstat_bucket(uint32_t cycles)
+ {
+     uint32_t v = cycles >> RTDB_LOCKSTAT_SHIFT;
+     uint8_t b = 0U;
+ 
+     while ((v != 0U) && (b < (RTDB_LOCKSTAT_BUCKETS - 1U))) {
+         v >>= 1;
+         b++;
+     }
+     return b;
+ }
+ 
+ rtdb_lockstat_t *rtdb_lockstat_slot(rtdb_lockstat_t *tab, size_t n, const void *caller)
+ {
+     for (size_t i = 0U; i < n; i++) {
+         if (tab[i].caller == caller) {
+             return &tab[i];
+         }
+         if (tab[i].caller == NULL) {
+             tab[i].caller = caller;
+             return &tab[i];
+         }
+     }
+     return &tab[n - 1U];
+ }
+ 
+ void rtdb_lockstat_record(rtdb_lockstat_t *s, uint32_t wait, uint32_t hold)
+ {
+     s->count++;
+     if (wait > s->wait_max) {
+         s->wait_max = wait;
+     }
+     if (hold > s->hold_max) {
+         s->hold_max = hold;
+     }
+     s->wait_hist[rtdb_lockstat_bucket(wait)]++;
+     s->hold_hist[rtdb_lockstat_bucket(hold)]++;
+ }
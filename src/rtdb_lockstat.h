@@ -0,0 +1,66 @@
+#ifndef RTDB_LOCKSTAT_H
+#define RTDB_LOCKSTAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file rtdb_lockstat.h
+ * @brief Estatísticas de contenção do lock da RTDB (tempo de espera e de posse)
+ *
+ * @details
+ *   Com CONFIG_RTDB_LOCK_STATS, cada aquisição do lock da RTDB em rtdb.c mede em
+ *   ciclos (k_cycle_get_32) quanto tempo o chamador esperou pelo lock e quanto
+ *   tempo o manteve (com o spinlock, o tempo de posse é também o tempo com as
+ *   interrupções desligadas). As medições vão para uma entrada por thread
+ *   chamadora (as ISRs partilham a entrada RTDB_LOCKSTAT_ISR), com
+ *   histogramas logarítmicos:
+ *     - bucket 0            → menos de 2^RTDB_LOCKSTAT_SHIFT ciclos
+ *     - bucket b (1..N-2)   → [2^(b+SHIFT-1), 2^(b+SHIFT)) ciclos
+ *     - bucket N-1          → 2^(N+SHIFT-2) ciclos ou mais
+ *
+ *   As entradas só são alteradas com o lock adquirido (no fim de cada secção
+ *   crítica), pelo que não precisam de sincronização própria.
+ *
+ *   Não depende do Zephyr (é testado no host).
+ */
+
+#define RTDB_LOCKSTAT_BUCKETS     12U  /**< Buckets de cada histograma */
+#define RTDB_LOCKSTAT_SHIFT       6U   /**< Bucket 0 = menos de 64 ciclos */
+#define RTDB_LOCKSTAT_MAX_CALLERS 8U   /**< Entradas (a última agrupa as threads excedentes) */
+#define RTDB_LOCKSTAT_ISR ((const void *)1)  /**< Chamador usado para acessos a partir de ISRs */
+
+/**
+ * @brief Estatísticas de um chamador
+ */
+typedef struct {
+    const void *caller;                            /* Identificador (k_tid_t), NULL = entrada livre */
+    uint32_t    count;                             /* Número de aquisições */
+    uint32_t    wait_max;                          /* Maior espera (ciclos) */
+    uint32_t    hold_max;                          /* Maior posse (ciclos) */
+    uint32_t    wait_hist[RTDB_LOCKSTAT_BUCKETS];  /* Histograma do tempo de espera */
+    uint32_t    hold_hist[RTDB_LOCKSTAT_BUCKETS];  /* Histograma do tempo de posse */
+} rtdb_lockstat_t;
+
+/**
+ * @brief Bucket do histograma correspondente a cycles
+ */
+uint8_t rtdb_lockstat_bucket(uint32_t cycles);
+
+/**
+ * @brief Entrada de caller em tab (reserva uma livre na primeira utilização)
+ *
+ * Se a tabela estiver cheia devolve a última entrada, partilhada pelas restantes threads.
+ *
+ * @param tab     Tabela de n entradas
+ * @param n       Número de entradas (≥ 1)
+ * @param caller  Identificador do chamador (não NULL)
+ */
+rtdb_lockstat_t *rtdb_lockstat_slot(rtdb_lockstat_t *tab, size_t n, const void *caller);
+
+/**
+ * @brief Regista uma aquisição com os tempos de espera e de posse (ciclos)
+ */
+void rtdb_lockstat_record(rtdb_lockstat_t *s, uint32_t wait, uint32_t hold);
+
+#endif /* RTDB_LOCKSTAT_H */
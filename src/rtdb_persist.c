@@ -0,0 +1,151 @@
+/**
+ * @file rtdb_persist.c
+ * @brief Guarda e restaura a configuração da RTDB com o subsistema settings (NVS)
+ *
+ * @details
+ *   Ver rtdb_persist.h. rtdb_persist_saved espelha o conteúdo da flash: durante
+ *   settings_load_subtree() recebe os registos lidos e, depois disso, cada flush
+ *   compara uma rtdb_snapshot() com ele e só grava os campos diferentes. Campos sem
+ *   registo ficam com o valor por omissão, que por isso nunca precisa de ser gravado.
+ *
+ *   O flush corre na system workqueue (pode bloquear na escrita da flash), nunca
+ *   dentro das secções críticas da RTDB; rtdb_persist_touch() apenas agenda o
+ *   trabalho e pode por isso ser chamada a partir de ISRs.
+ */
+
+ #include "rtdb_persist.h"
+ #include "rtdb.h"
+ #include <zephyr/kernel.h>
+ #include <zephyr/settings/settings.h>
+ #include <zephyr/sys/printk.h>
+ #include <errno.h>
+ #include <string.h>
+ 
+ #define RTDB_PERSIST_TREE "rtdb"  /**< Subárvore do settings com os campos da RTDB */
+ 
+ static rtdb_t rtdb_persist_saved = RTDB_DEFAULTS;  /**< Conteúdo atual da flash */
+ static uint32_t rtdb_persist_loaded;               /**< Campos lidos da flash no arranque */
+ static bool rtdb_persist_ready;                    /**< rtdb_persist_init() concluída */
+ static K_MUTEX_DEFINE(rtdb_persist_lock);          /**< Serializa flushes (workqueue vs chamador) */
+ 
+ static void rtdb_persist_work_fn(struct k_work *work);
+ static K_WORK_DELAYABLE_DEFINE(rtdb_persist_work, rtdb_persist_work_fn);
+ 
+ /**
+  * @brief Handler de settings: recebe o registo "rtdb/<key>" durante o arranque
+  */
+ static int rtdb_persist_set(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg)
+ {
+     static rtdb_t scratch;  /* Só usado em settings_load_subtree(), antes das threads */
+     rtdb_field_t id = rtdb_schema_find(key);
+     size_t size;
+     void *dst;
+ 
+     if ((id >= RTDB_NUM_FIELDS) || ((RTDB_F(id) & RTDB_PERSIST_MASK) == 0U)) {
+         return -ENOENT;
+     }
+     dst = rtdb_schema_raw(&scratch, id, &size);
+     if (len != size) {
+         /* Gravado com outro número de zonas: fica o valor por omissão */
+         return -EINVAL;
+     }
+     if (read_cb(cb_arg, dst, size) != (ssize_t)size) {
+         return -EIO;
+     }
+     memcpy(rtdb_schema_raw(&rtdb_persist_saved, id, &size), dst, size);
+     rtdb_persist_loaded |= RTDB_F(id);
+     return 0;
+ }
+ 
+ SETTINGS_STATIC_HANDLER_DEFINE(rtdb, RTDB_PERSIST_TREE, NULL, rtdb_persist_set, NULL, NULL);
+ 
+ int rtdb_persist_flush(void)
+ {
+     rtdb_t now;
+     int ret = 0;
+ 
+     rtdb_snapshot(&now);
+ 
+     k_mutex_lock(&rtdb_persist_lock, K_FOREVER);
+     for (uint32_t id = 0U; id < RTDB_NUM_FIELDS; id++) {
+         char key[SETTINGS_MAX_NAME_LEN];
+         size_t size;
+ 
+         if ((RTDB_F(id) & RTDB_PERSIST_MASK) == 0U) {
+             continue;
+         }
+         const void *cur = rtdb_schema_raw(&now, (rtdb_field_t)id, &size);
+         void *old = rtdb_schema_raw(&rtdb_persist_saved, (rtdb_field_t)id, &size);
+         if (memcmp(cur, old, size) == 0) {
+             continue;
+         }
+ 
+         snprintk(key, sizeof(key), RTDB_PERSIST_TREE "/%s", rtdb_field_info[id].name);
+         int err = settings_save_one(key, cur, size);
+         if (err == 0) {
+             memcpy(old, cur, size);
+         } else if (ret == 0) {
+             /* Fica pendente: volta a ser tentado no próximo flush */
+             ret = err;
+         }
+     }
+     k_mutex_unlock(&rtdb_persist_lock);
+     return ret;
+ }
+ 
+ /**
+  * @brief Fim da janela de agregação: grava os campos alterados
+  */
+ static void rtdb_persist_work_fn(struct k_work *work)
+ {
+     ARG_UNUSED(work);
+ 
+     int err = rtdb_persist_flush();
+     if (err != 0) {
+         printk("[RTDB] erro %d a gravar a configuração\n", err);
+     }
+ }
+ 
+ void rtdb_persist_touch(uint32_t changed)
+ {
+     /* k_work_schedule() não adia um flush já agendado: a janela começa na 1.ª alteração */
+     if (rtdb_persist_ready && ((changed & RTDB_PERSIST_MASK) != 0U)) {
+         (void)k_work_schedule(&rtdb_persist_work, K_MSEC(CONFIG_RTDB_PERSIST_DELAY_MS));
+     }
+ }
+ 
+ int rtdb_persist_init(void)
+ {
+     struct k_work_sync sync;
+     int err;
+ 
+     /* Numa reinicialização, um flush pendente não pode correr durante o load */
+     (void)k_work_cancel_delayable_sync(&rtdb_persist_work, &sync);
+ 
+     err = settings_subsys_init();
+     if (err == 0) {
+         err = settings_load_subtree(RTDB_PERSIST_TREE);
+     }
+     if (err != 0) {
+         printk("[RTDB] settings indisponível (%d): configuração por omissão\n", err);
+         return err;
+     }
+ 
+     /* Os valores lidos passam pelas mesmas validações que um comando UART */
+     for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+         rtdb_zone_t v;
+ 
+         rtdb_schema_view(&rtdb_persist_saved, z, &v);
+         if (rtdb_update_zone(z, rtdb_persist_loaded & RTDB_PERSIST_MASK, &v) != RTDB_OK) {
+             printk("[RTDB] configuração guardada da zona %u inválida: ignorada\n", z);
+         }
+     }
+     rtdb_persist_ready = true;
+ 
+     /* Regrava os registos rejeitados (a flash passa a coincidir com a RTDB) */
+     if (rtdb_persist_loaded != 0U) {
+         (void)k_work_schedule(&rtdb_persist_work, K_NO_WAIT);
+     }
+     printk("[RTDB] configuração restaurada (campos 0x%02x)\n", (unsigned)rtdb_persist_loaded);
+     return 0;
+ }
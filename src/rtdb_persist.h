@@ -0,0 +1,55 @@
+#ifndef RTDB_PERSIST_H
+#define RTDB_PERSIST_H
+
+#include <stdint.h>
+#include "rtdb_schema.h"
+
+/**
+ * @file rtdb_persist.h
+ * @brief Persistência da configuração da RTDB em flash (settings/NVS)
+ *
+ * @details
+ *   Com CONFIG_RTDB_PERSIST, os campos de RTDB_PERSIST_MASK (setpoint, limites e
+ *   período de amostragem, de todas as zonas) são guardados no subsistema settings
+ *   do Zephyr, um registo por campo ("rtdb/<membro de rtdb_t>", com o array de
+ *   todas as zonas como blob). rtdb_persist_init() restaura-os antes de as threads
+ *   arrancarem, validando-os com rtdb_update_zone(); registos com tamanho
+ *   diferente (p.ex. outro CONFIG_RTDB_NUM_ZONES) ou que violem as invariantes são
+ *   ignorados e ficam os valores por omissão.
+ *
+ *   As escritas não vão logo para a flash: cada alteração de um campo persistente
+ *   agenda um flush CONFIG_RTDB_PERSIST_DELAY_MS mais tarde (k_work_delayable) e
+ *   as alterações seguintes dentro dessa janela juntam-se ao mesmo flush. O flush
+ *   só regrava os campos que diferem do que já está em flash.
+ */
+
+/** Campos guardados em flash */
+#define RTDB_PERSIST_MASK \
+    (RTDB_F_SETPOINT | RTDB_F_MAX_TEMP | RTDB_F_MIN_TEMP | RTDB_F_SAMPLING_RATE)
+
+/**
+ * @brief Inicializa o settings e restaura a configuração guardada para a RTDB
+ *
+ * Deve ser chamada em main() antes de criar as threads. A partir daqui as
+ * alterações dos campos persistentes passam a ser guardadas.
+ *
+ * @return 0, ou o erro negativo do subsistema settings (a RTDB fica com os
+ *         valores por omissão e as alterações não são guardadas)
+ */
+int  rtdb_persist_init(void);
+
+/**
+ * @brief Assinala que os campos changed mudaram (chamada por rtdb.c em cada escrita)
+ *
+ * Agenda o flush se algum campo persistente mudou. Pode ser chamada a partir de ISRs.
+ */
+void rtdb_persist_touch(uint32_t changed);
+
+/**
+ * @brief Grava já os campos pendentes, sem esperar pelo fim da janela
+ *
+ * @return 0, ou o primeiro erro de settings_save_one()
+ */
+int  rtdb_persist_flush(void);
+
+#endif /* RTDB_PERSIST_H */
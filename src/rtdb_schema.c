@@ -0,0 +1,284 @@
+/**
+ * @file rtdb_schema.c
+ * @brief Lógica de validação e escrita da RTDB gerada a partir de RTDB_FIELDS()
+ *
+ * @details
+ *   Funções puras sobre um rtdb_t (sem locks nem Zephyr). rtdb.c chama-as dentro
+ *   das suas secções de escrita; os testes no host chamam-nas diretamente através
+ *   de dummy/rtdb_dummy.c, pelo que ambos partilham exatamente as mesmas regras.
+ */
+
+ #include "rtdb_schema.h"
+ #include <string.h>
+ 
+ #define RTDB_ZONED_RTDB_GLOBAL false
+ #define RTDB_ZONED_RTDB_ZONE   true
+ 
+ /**
+  * @brief Metadados de cada campo, indexados por rtdb_field_t
+  */
+ const rtdb_field_info_t rtdb_field_info[RTDB_NUM_FIELDS] = {
+ #define RTDB_X_INFO(ID, name, acc, type, def, lo, hi, access, scope) \
+     [RTDB_ID_##ID] = { #name, (lo), (hi), (access), RTDB_ZONED_##scope },
+     RTDB_FIELDS(RTDB_X_INFO)
+ #undef RTDB_X_INFO
+ };
+ 
+ int32_t rtdb_schema_get(const rtdb_t *db, uint8_t zone, rtdb_field_t id)
+ {
+     (void)zone;
+     switch (id) {
+ #define RTDB_X_GET(ID, name, acc, type, def, lo, hi, access, scope) \
+     case RTDB_ID_##ID: return (int32_t)db->name RTDB_IDX_##scope(zone);
+     RTDB_FIELDS(RTDB_X_GET)
+ #undef RTDB_X_GET
+     default:
+         return 0;
+     }
+ }
+ 
+ void rtdb_schema_put(rtdb_t *db, uint8_t zone, rtdb_field_t id, int32_t val)
+ {
+     (void)zone;
+     switch (id) {
+ #define RTDB_X_PUT(ID, name, acc, type, def, lo, hi, access, scope) \
+     case RTDB_ID_##ID: db->name RTDB_IDX_##scope(zone) = (type)val; break;
+     RTDB_FIELDS(RTDB_X_PUT)
+ #undef RTDB_X_PUT
+     default:
+         break;
+     }
+ }
+ 
+ int32_t rtdb_schema_view_get(const rtdb_zone_t *v, rtdb_field_t id)
+ {
+     switch (id) {
+ #define RTDB_X_VGET(ID, name, acc, type, def, lo, hi, access, scope) \
+     case RTDB_ID_##ID: return (int32_t)v->name;
+     RTDB_FIELDS(RTDB_X_VGET)
+ #undef RTDB_X_VGET
+     default:
+         return 0;
+     }
+ }
+ 
+ void rtdb_schema_view_put(rtdb_zone_t *v, rtdb_field_t id, int32_t val)
+ {
+     switch (id) {
+ #define RTDB_X_VPUT(ID, name, acc, type, def, lo, hi, access, scope) \
+     case RTDB_ID_##ID: v->name = (type)val; break;
+     RTDB_FIELDS(RTDB_X_VPUT)
+ #undef RTDB_X_VPUT
+     default:
+         break;
+     }
+ }
+ 
+ void rtdb_schema_copy_domain(rtdb_t *dst, const rtdb_t *src, rtdb_domain_t dom)
+ {
+ #define RTDB_X_CPDOM(ID, name, acc, type, def, lo, hi, access, scope)      \
+     if (RTDB_DOM_OF_##access == dom) {                                   \
+         memcpy(&dst->name, &src->name, sizeof(dst->name));               \
+     }
+     RTDB_FIELDS(RTDB_X_CPDOM)
+ #undef RTDB_X_CPDOM
+ }
+ 
+ void rtdb_schema_copy_fields(rtdb_t *dst, const rtdb_t *src, uint32_t mask)
+ {
+ #define RTDB_X_CPMASK(ID, name, acc, type, def, lo, hi, access, scope)    \
+     if ((mask & RTDB_F_##ID) != 0U) {                                    \
+         memcpy(&dst->name, &src->name, sizeof(dst->name));               \
+     }
+     RTDB_FIELDS(RTDB_X_CPMASK)
+ #undef RTDB_X_CPMASK
+ }
+ 
+ uint32_t rtdb_schema_diff(const rtdb_t *a, const rtdb_t *b, uint8_t zone, uint32_t mask)
+ {
+     uint32_t diff = 0U;
+ 
+     for (uint32_t id = 0U; id < RTDB_NUM_FIELDS; id++) {
+         if (((mask & RTDB_F(id)) == 0U) || (!rtdb_field_info[id].zoned && (zone != 0U))) {
+             continue;
+         }
+         if (rtdb_schema_get(a, zone, (rtdb_field_t)id) != rtdb_schema_get(b, zone, (rtdb_field_t)id)) {
+             diff |= RTDB_F(id);
+         }
+     }
+     return diff;
+ }
+ 
+ rtdb_field_t rtdb_schema_find(const char *name)
+ {
+     for (uint32_t id = 0U; id < RTDB_NUM_FIELDS; id++) {
+         if (strcmp(rtdb_field_info[id].name, name) == 0) {
+             return (rtdb_field_t)id;
+         }
+     }
+     return RTDB_NUM_FIELDS;
+ }
+ 
+ void *rtdb_schema_raw(rtdb_t *db, rtdb_field_t id, size_t *size)
+ {
+     switch (id) {
+ #define RTDB_X_RAW(ID, name, acc, type, def, lo, hi, access, scope) \
+     case RTDB_ID_##ID: *size = sizeof(db->name); return &db->name;
+     RTDB_FIELDS(RTDB_X_RAW)
+ #undef RTDB_X_RAW
+     default:
+         *size = 0U;
+         return NULL;
+     }
+ }
+ 
+ void rtdb_schema_view(const rtdb_t *db, uint8_t zone, rtdb_zone_t *out)
+ {
+     (void)zone;
+ #define RTDB_X_COPY(ID, name, acc, type, def, lo, hi, access, scope) \
+     out->name = db->name RTDB_IDX_##scope(zone);
+     RTDB_FIELDS(RTDB_X_COPY)
+ #undef RTDB_X_COPY
+ }
+ 
+ /**
+  * @brief Satura val aos limites estáticos do campo
+  */
+ static int32_t rtdb_schema_clamp(rtdb_field_t id, int64_t val)
+ {
+     if (val < rtdb_field_info[id].lo) {
+         return rtdb_field_info[id].lo;
+     }
+     if (val > rtdb_field_info[id].hi) {
+         return rtdb_field_info[id].hi;
+     }
+     return (int32_t)val;
+ }
+ 
+ /**
+  * @brief Escreve val em db se for diferente do atual
+  *
+  * @return RTDB_F(id) se o valor mudou, 0 caso contrário
+  */
+ static uint32_t rtdb_schema_assign(rtdb_t *db, uint8_t zone, rtdb_field_t id, int32_t val)
+ {
+     if (rtdb_schema_get(db, zone, id) == val) {
+         return 0U;
+     }
+     rtdb_schema_put(db, zone, id, val);
+     return RTDB_F(id);
+ }
+ 
+ uint32_t rtdb_schema_write(rtdb_t *db, uint8_t zone, rtdb_field_t id, int64_t val)
+ {
+     if (((unsigned)id >= RTDB_NUM_FIELDS) || (zone >= RTDB_NUM_ZONES)) {
+         return 0U;
+     }
+ 
+     int32_t v = rtdb_schema_clamp(id, val);
+     uint32_t changed;
+ 
+     if (id == RTDB_ID_SETPOINT) {
+         /* setpoint nunca sai de [min_temp, max_temp] */
+         if (v > db->max_temp[zone]) {
+             v = db->max_temp[zone];
+         } else if (v < db->min_temp[zone]) {
+             v = db->min_temp[zone];
+         }
+     }
+ 
+     changed = rtdb_schema_assign(db, zone, id, v);
+ 
+     /* min_temp e max_temp arrastam o setpoint para dentro dos novos limites */
+     if ((id == RTDB_ID_MAX_TEMP) && (db->setpoint[zone] > db->max_temp[zone])) {
+         changed |= rtdb_schema_assign(db, zone, RTDB_ID_SETPOINT, db->max_temp[zone]);
+     } else if ((id == RTDB_ID_MIN_TEMP) && (db->setpoint[zone] < db->min_temp[zone])) {
+         changed |= rtdb_schema_assign(db, zone, RTDB_ID_SETPOINT, db->min_temp[zone]);
+     }
+     return changed;
+ }
+ 
+ bool rtdb_schema_cond(const rtdb_t *db, uint8_t zone, rtdb_field_t id,
+                       rtdb_trig_cond_t cond, int32_t arg)
+ {
+     if (((unsigned)id >= RTDB_NUM_FIELDS) || (zone >= RTDB_NUM_ZONES)) {
+         return false;
+     }
+     int32_t v = rtdb_schema_get(db, zone, id);
+ 
+     switch (cond) {
+     case RTDB_TRIG_GT:
+         return v > arg;
+     case RTDB_TRIG_LT:
+         return v < arg;
+     case RTDB_TRIG_GT_FIELD:
+         return ((uint32_t)arg < RTDB_NUM_FIELDS) &&
+                (v > rtdb_schema_get(db, zone, (rtdb_field_t)arg));
+     case RTDB_TRIG_LT_FIELD:
+         return ((uint32_t)arg < RTDB_NUM_FIELDS) &&
+                (v < rtdb_schema_get(db, zone, (rtdb_field_t)arg));
+     default:
+         return false;
+     }
+ }
+ 
+ uint32_t rtdb_schema_cond_watch(rtdb_field_t id, rtdb_trig_cond_t cond, int32_t arg)
+ {
+     uint32_t watch = RTDB_F(id);
+ 
+     if (((cond == RTDB_TRIG_GT_FIELD) || (cond == RTDB_TRIG_LT_FIELD)) &&
+         ((uint32_t)arg < RTDB_NUM_FIELDS)) {
+         watch |= RTDB_F(arg);
+     }
+     return watch;
+ }
+ 
+ rtdb_status_t rtdb_schema_update(rtdb_t *db, uint8_t zone, uint32_t mask,
+                                  const rtdb_zone_t *vals, uint32_t *changed)
+ {
+     rtdb_zone_t next;
+ 
+     *changed = 0U;
+     if (zone >= RTDB_NUM_ZONES) {
+         return RTDB_EINVAL;
+     }
+     if ((mask & ~(uint32_t)RTDB_DOM_MASK_CFG) != 0U) {
+         return RTDB_EACCES;
+     }
+     rtdb_schema_view(db, zone, &next);
+ 
+     for (uint32_t id = 0U; id < RTDB_NUM_FIELDS; id++) {
+         if ((mask & RTDB_F(id)) == 0U) {
+             continue;
+         }
+         int32_t v = rtdb_schema_view_get(vals, (rtdb_field_t)id);
+         if ((v < rtdb_field_info[id].lo) || (v > rtdb_field_info[id].hi)) {
+             return RTDB_EINVAL;
+         }
+         rtdb_schema_view_put(&next, (rtdb_field_t)id, v);
+     }
+ 
+     /* Setpoint implícito acompanha os novos limites */
+     if (((mask & RTDB_F_SETPOINT) == 0U) && (next.min_temp <= next.max_temp)) {
+         if (next.setpoint > next.max_temp) {
+             next.setpoint = next.max_temp;
+         } else if (next.setpoint < next.min_temp) {
+             next.setpoint = next.min_temp;
+         }
+     }
+ 
+     if ((next.min_temp > next.setpoint) || (next.setpoint > next.max_temp)) {
+         return RTDB_EINVAL;
+     }
+ 
+     /* Só os campos pedidos e os de configuração: os restantes podem estar a ser
+      * escritos por quem detém apenas o lock de medição (ver rtdb.c) */
+     for (uint32_t id = 0U; id < RTDB_NUM_FIELDS; id++) {
+         if (((mask | RTDB_DOM_MASK_CFG) & RTDB_F(id)) == 0U) {
+             continue;
+         }
+         *changed |= rtdb_schema_assign(db, zone, (rtdb_field_t)id,
+                                        rtdb_schema_view_get(&next, (rtdb_field_t)id));
+     }
+     return RTDB_OK;
+ }
@@ -0,0 +1,286 @@
+#ifndef RTDB_SCHEMA_H
+#define RTDB_SCHEMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file rtdb_schema.h
+ * @brief Tabela única de campos da RTDB (X-macro) e tipos gerados a partir dela
+ *
+ * @details
+ *   RTDB_FIELDS() é o único sítio onde os campos da RTDB são declarados. A partir
+ *   dela são gerados em tempo de compilação:
+ *     - a estrutura rtdb_t e o inicializador RTDB_DEFAULTS
+ *     - a vista de uma zona rtdb_zone_t (usada em pedidos de atualização)
+ *     - os identificadores RTDB_ID_* (rtdb_field_t) e as máscaras RTDB_F_*
+ *     - a tabela de metadados rtdb_field_info[] (nome, limites, acesso)
+ *     - os acessores tipados rtdb_get_<acc>()/rtdb_set_<acc>() (rtdb.h)
+ *     - o espelho usado nos testes no host (dummy/rtdb_dummy.h)
+ *
+ *   A RTDB tem RTDB_NUM_ZONES zonas (sensor + aquecedor cada). Os campos de zona
+ *   (scope RTDB_ZONE) são guardados em structure-of-arrays: todos os setpoints
+ *   contíguos, todas as temperaturas contíguas, etc., para o controlador varrer
+ *   todas as zonas numa só passagem. Os campos RTDB_GLOBAL existem uma vez.
+ *
+ *   Cada campo pertence a um domínio de sincronização, dado pela coluna access:
+ *   os campos RTDB_RW formam o domínio de configuração (RTDB_DOM_CFG, escritas
+ *   raras vindas da UART e dos botões) e os RTDB_RO o domínio de medição
+ *   (RTDB_DOM_MEAS, escritos a cada amostra). rtdb.c tem um lock e um contador
+ *   de sequência por domínio, para que as escritas de medição nunca esperem por
+ *   tráfego de configuração.
+ *
+ *   Este ficheiro e rtdb_schema.c não dependem do Zephyr: a mesma lógica de
+ *   validação/escrita é compilada no firmware e nos testes Unity.
+ *
+ *   Para acrescentar um campo basta uma linha em RTDB_FIELDS().
+ */
+
+#if defined(CONFIG_RTDB_NUM_ZONES)
+#define RTDB_NUM_ZONES CONFIG_RTDB_NUM_ZONES
+#elif !defined(RTDB_NUM_ZONES)
+#define RTDB_NUM_ZONES 1   /**< Número de zonas (sensor + aquecedor) */
+#endif
+
+/**
+ * @brief Regras de acesso pelo caminho genérico rtdb_set()
+ */
+typedef enum {
+    RTDB_RW,   /* Configuração: pode ser escrita por rtdb_set()/rtdb_update() */
+    RTDB_RO,   /* Medição: só o produtor escreve, pelo setter tipado */
+} rtdb_access_t;
+
+/**
+ * @brief Domínios de sincronização (um lock + um seqlock cada)
+ */
+typedef enum {
+    RTDB_DOM_CFG,    /* Campos RTDB_RW */
+    RTDB_DOM_MEAS,   /* Campos RTDB_RO */
+    RTDB_NUM_DOMAINS
+} rtdb_domain_t;
+
+/**
+ * @brief Tabela de campos: X(ID, name, acc, type, def, lo, hi, access, scope)
+ *
+ *   - ID      sufixo de RTDB_ID_* / RTDB_F_*
+ *   - name    membro de rtdb_t
+ *   - acc     sufixo dos acessores rtdb_get_<acc>() / rtdb_set_<acc>()
+ *   - type    tipo C do campo
+ *   - def     valor por omissão (arranque)
+ *   - lo, hi  limites estáticos (os setters tipados saturam, rtdb_update() rejeita)
+ *   - access  RTDB_RW ou RTDB_RO
+ *   - scope   RTDB_GLOBAL (um valor) ou RTDB_ZONE (um valor por zona)
+ *
+ * A ordem define o bit de cada campo em RTDB_F_*.
+ */
+#define RTDB_FIELDS(X)                                                                                   \
+    X(SYSTEM_ON,     system_on,        system_on,     bool,     true,  0,    1,     RTDB_RW, RTDB_GLOBAL) \
+    X(SETPOINT,      setpoint,         setpoint,      int16_t,  26,    -128, 999,   RTDB_RW, RTDB_ZONE)   \
+    X(CURRENT_TEMP,  current_temp,     current_temp,  int16_t,  0,     -128, 999,   RTDB_RO, RTDB_ZONE)   \
+    X(MAX_TEMP,      max_temp,         max_temp,      int16_t,  80,    -128, 999,   RTDB_RW, RTDB_ZONE)   \
+    X(MIN_TEMP,      min_temp,         min_temp,      int16_t,  20,    -128, 999,   RTDB_RW, RTDB_ZONE)   \
+    X(SAMPLING_RATE, sampling_rate_ms, sampling_rate, uint32_t, 1000,  10,   60000, RTDB_RW, RTDB_GLOBAL) \
+    X(HEATER,        heater,           heater,        bool,     false, 0,    1,     RTDB_RO, RTDB_ZONE)
+
+/** @cond INTERNAL */
+#define RTDB_DIM_RTDB_GLOBAL
+#define RTDB_DIM_RTDB_ZONE            [RTDB_NUM_ZONES]
+#define RTDB_IDX_RTDB_GLOBAL(z)
+#define RTDB_IDX_RTDB_ZONE(z)         [(z)]
+#define RTDB_INIT_RTDB_GLOBAL(def)    (def)
+#define RTDB_INIT_RTDB_ZONE(def)      { [0 ... (RTDB_NUM_ZONES - 1)] = (def) }
+#define RTDB_DOM_OF_RTDB_RW           RTDB_DOM_CFG
+#define RTDB_DOM_OF_RTDB_RO           RTDB_DOM_MEAS
+
+#define RTDB_X_ID(ID, name, acc, type, def, lo, hi, access, scope)      RTDB_ID_##ID,
+#define RTDB_X_MASK(ID, name, acc, type, def, lo, hi, access, scope)    RTDB_F_##ID = (1U << RTDB_ID_##ID),
+#define RTDB_X_MEMBER(ID, name, acc, type, def, lo, hi, access, scope)  type name RTDB_DIM_##scope;
+#define RTDB_X_VIEW(ID, name, acc, type, def, lo, hi, access, scope)    type name;
+#define RTDB_X_DEFAULT(ID, name, acc, type, def, lo, hi, access, scope) .name = RTDB_INIT_##scope(def),
+#define RTDB_X_MEAS(ID, name, acc, type, def, lo, hi, access, scope)    \
+    | ((RTDB_DOM_OF_##access == RTDB_DOM_MEAS) ? RTDB_F_##ID : 0U)
+/** @endcond */
+
+/**
+ * @brief Identificador de cada campo (índice em rtdb_field_info[])
+ */
+typedef enum {
+    RTDB_FIELDS(RTDB_X_ID)
+    RTDB_NUM_FIELDS
+} rtdb_field_t;
+
+/**
+ * @brief Máscaras de campos (subscrições, rtdb_update())
+ *
+ * Os bits identificam o campo, não a zona: RTDB_F_SETPOINT indica que o
+ * setpoint de pelo menos uma zona mudou.
+ */
+enum {
+    RTDB_FIELDS(RTDB_X_MASK)
+};
+
+/** Máscara de um campo a partir do identificador */
+#define RTDB_F(id) (1U << (id))
+
+/**
+ * @brief Máscaras dos campos de cada domínio
+ */
+enum {
+    RTDB_DOM_MASK_MEAS = 0U RTDB_FIELDS(RTDB_X_MEAS),
+    RTDB_DOM_MASK_CFG  = ((1U << RTDB_NUM_FIELDS) - 1U) & ~RTDB_DOM_MASK_MEAS,
+};
+
+/** Domínio de um campo a partir do identificador */
+#define RTDB_DOMAIN(id) (((RTDB_F(id) & RTDB_DOM_MASK_MEAS) != 0U) ? RTDB_DOM_MEAS : RTDB_DOM_CFG)
+
+/**
+ * @brief Estrutura que contém todas as variáveis compartilhadas no sistema
+ *
+ * Campos de zona são arrays [RTDB_NUM_ZONES] (structure-of-arrays).
+ */
+typedef struct {
+    RTDB_FIELDS(RTDB_X_MEMBER)
+} rtdb_t;
+
+/**
+ * @brief Vista de uma zona: os campos globais e os dessa zona, todos escalares
+ */
+typedef struct {
+    RTDB_FIELDS(RTDB_X_VIEW)
+} rtdb_zone_t;
+
+/** Inicializador de rtdb_t com os valores por omissão da tabela (todas as zonas) */
+#define RTDB_DEFAULTS { RTDB_FIELDS(RTDB_X_DEFAULT) }
+
+/**
+ * @brief Resultado de rtdb_update() / rtdb_set()
+ */
+typedef enum {
+    RTDB_OK = 0,   /* Alterações aplicadas */
+    RTDB_EINVAL,   /* Fora dos limites da tabela, zona inexistente ou violaria min_temp ≤ setpoint ≤ max_temp */
+    RTDB_EACCES,   /* Campo RTDB_RO escrito pelo caminho genérico */
+} rtdb_status_t;
+
+/**
+ * @brief Condição de um trigger da RTDB (ver rtdb_trigger_register())
+ */
+typedef enum {
+    RTDB_TRIG_GT,        /* campo > arg */
+    RTDB_TRIG_LT,        /* campo < arg */
+    RTDB_TRIG_GT_FIELD,  /* campo > campo arg (RTDB_ID_*) da mesma zona */
+    RTDB_TRIG_LT_FIELD,  /* campo < campo arg (RTDB_ID_*) da mesma zona */
+    RTDB_TRIG_STALE,     /* campo sem escritas há mais de arg ms (avaliado por timer) */
+} rtdb_trig_cond_t;
+
+/**
+ * @brief Metadados de um campo, gerados a partir de RTDB_FIELDS()
+ */
+typedef struct {
+    const char    *name;   /* Nome do membro em rtdb_t */
+    int32_t        lo;     /* Limite inferior */
+    int32_t        hi;     /* Limite superior */
+    rtdb_access_t  access; /* Regra de acesso */
+    bool           zoned;  /* true se existe um valor por zona */
+} rtdb_field_info_t;
+
+extern const rtdb_field_info_t rtdb_field_info[RTDB_NUM_FIELDS];
+
+/**
+ * @brief Lê um campo da zona zone de db como inteiro (zone é ignorada em campos globais)
+ */
+int32_t rtdb_schema_get(const rtdb_t *db, uint8_t zone, rtdb_field_t id);
+
+/**
+ * @brief Escreve um campo da zona zone de db sem qualquer validação
+ */
+void rtdb_schema_put(rtdb_t *db, uint8_t zone, rtdb_field_t id, int32_t val);
+
+/**
+ * @brief Lê um campo de uma vista de zona
+ */
+int32_t rtdb_schema_view_get(const rtdb_zone_t *v, rtdb_field_t id);
+
+/**
+ * @brief Escreve um campo de uma vista de zona
+ */
+void rtdb_schema_view_put(rtdb_zone_t *v, rtdb_field_t id, int32_t val);
+
+/**
+ * @brief Copia de src para dst os campos (todas as zonas) do domínio dom
+ */
+void rtdb_schema_copy_domain(rtdb_t *dst, const rtdb_t *src, rtdb_domain_t dom);
+
+/**
+ * @brief Copia de src para dst os campos de mask (todas as zonas)
+ */
+void rtdb_schema_copy_fields(rtdb_t *dst, const rtdb_t *src, uint32_t mask);
+
+/**
+ * @brief Campos de mask que diferem entre a e b na zona zone
+ *
+ * Campos globais só são comparados na zona 0, para que cada alteração seja
+ * contada uma única vez ao percorrer todas as zonas.
+ */
+uint32_t rtdb_schema_diff(const rtdb_t *a, const rtdb_t *b, uint8_t zone, uint32_t mask);
+
+/**
+ * @brief Identificador do campo cujo membro em rtdb_t se chama name
+ *
+ * @return RTDB_ID_*, ou RTDB_NUM_FIELDS se não existir
+ */
+rtdb_field_t rtdb_schema_find(const char *name);
+
+/**
+ * @brief Endereço e tamanho em bytes do membro de db (todas as zonas) do campo id
+ *
+ * Usado para guardar/restaurar campos inteiros como blobs (rtdb_persist.c).
+ *
+ * @return Endereço do membro, ou NULL se id não existir
+ */
+void *rtdb_schema_raw(rtdb_t *db, rtdb_field_t id, size_t *size);
+
+/**
+ * @brief Extrai a vista da zona zone (globais + campos dessa zona)
+ */
+void rtdb_schema_view(const rtdb_t *db, uint8_t zone, rtdb_zone_t *out);
+
+/**
+ * @brief Escrita com a semântica dos setters tipados (saturação)
+ *
+ * Satura val aos limites da tabela; setpoint fica dentro de [min_temp, max_temp];
+ * alterar max_temp/min_temp arrasta o setpoint para dentro dos novos limites.
+ *
+ * @return Máscara RTDB_F_* dos campos que efetivamente mudaram
+ */
+uint32_t rtdb_schema_write(rtdb_t *db, uint8_t zone, rtdb_field_t id, int64_t val);
+
+/**
+ * @brief Atualização validada de vários campos de uma zona (semântica de rtdb_update())
+ *
+ * Só altera db se o resultado completo respeitar todas as invariantes.
+ *
+ * @param db       Estado a alterar
+ * @param zone     Zona (0..RTDB_NUM_ZONES-1); campos globais são partilhados
+ * @param mask     Campos RTDB_F_* a copiar de vals (só campos RTDB_RW)
+ * @param vals     Novos valores
+ * @param changed  Recebe a máscara dos campos que mudaram (0 se rejeitado)
+ * @return         RTDB_OK, RTDB_EINVAL, ou RTDB_EACCES se mask tiver campos RTDB_RO
+ */
+rtdb_status_t rtdb_schema_update(rtdb_t *db, uint8_t zone, uint32_t mask,
+                                 const rtdb_zone_t *vals, uint32_t *changed);
+
+/**
+ * @brief Avalia a condição cond sobre o campo id da zona zone de db
+ *
+ * RTDB_TRIG_STALE (e campos inexistentes) são sempre falsos: não dependem dos valores.
+ */
+bool rtdb_schema_cond(const rtdb_t *db, uint8_t zone, rtdb_field_t id,
+                      rtdb_trig_cond_t cond, int32_t arg);
+
+/**
+ * @brief Campos RTDB_F_* cuja escrita pode mudar o resultado de rtdb_schema_cond()
+ */
+uint32_t rtdb_schema_cond_watch(rtdb_field_t id, rtdb_trig_cond_t cond, int32_t arg);
+
+#endif /* RTDB_SCHEMA_H */
@@ -0,0 +1,80 @@
+/**
+ * @file rtdb_shm.c
+ * @brief Formato e seqlock da vista da RTDB em memória partilhada (ver rtdb_shm.h)
+ */
+
+ #include "rtdb_shm.h"
+ #include <string.h>
+ 
+ #if defined(UNIT_TEST)
+ #define RTDB_SHM_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+ #else
+ #include <zephyr/sys/barrier.h>
+ #define RTDB_SHM_BARRIER() barrier_dmem_fence_full()
+ #endif
+ 
+ #define RTDB_SHM_RETRIES 1000U  /**< Tentativas do leitor por domínio */
+ 
+ void rtdb_shm_format(rtdb_shm_t *shm, const rtdb_t *db)
+ {
+     memset(shm, 0, sizeof(*shm));
+     shm->version = RTDB_SHM_VERSION;
+     shm->size = sizeof(*shm);
+     shm->num_zones = RTDB_NUM_ZONES;
+     shm->hist_len = RTDB_HIST_LEN;
+     shm->db = *db;
+     for (uint32_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+         rtdb_stats_reset(&shm->stats[z]);
+     }
+     RTDB_SHM_BARRIER();
+     /* Por último: um monitor que veja o magic vê o resto já preenchido */
+     shm->magic = RTDB_SHM_MAGIC;
+ }
+ 
+ void rtdb_shm_publish(rtdb_shm_t *shm, const rtdb_t *db, const rtdb_stats_t *stats,
+                       rtdb_domain_t dom)
+ {
+     shm->seq[dom] = shm->seq[dom] + 1U;
+     RTDB_SHM_BARRIER();
+     rtdb_schema_copy_domain(&shm->db, db, dom);
+     if (dom == RTDB_DOM_MEAS) {
+         memcpy(shm->stats, stats, sizeof(shm->stats));
+     }
+     RTDB_SHM_BARRIER();
+     shm->seq[dom] = shm->seq[dom] + 1U;
+     shm->writes = shm->writes + 1U;
+ }
+ 
+ bool rtdb_shm_valid(const rtdb_shm_t *shm, size_t size)
+ {
+     return (size >= sizeof(*shm)) && (shm->magic == RTDB_SHM_MAGIC) &&
+            (shm->version == RTDB_SHM_VERSION) && (shm->size == sizeof(*shm)) &&
+            (shm->num_zones == RTDB_NUM_ZONES) && (shm->hist_len == RTDB_HIST_LEN);
+ }
+ 
+ /**
+  * @brief Copia o domínio dom de forma consistente (seqlock)
+  */
+ static bool rtdb_shm_read_domain(const rtdb_shm_t *shm, rtdb_t *db, rtdb_stats_t *stats,
+                                  rtdb_domain_t dom)
+ {
+     for (uint32_t i = 0U; i < RTDB_SHM_RETRIES; i++) {
+         uint32_t seq = shm->seq[dom];
+         RTDB_SHM_BARRIER();
+         rtdb_schema_copy_domain(db, &shm->db, dom);
+         if ((dom == RTDB_DOM_MEAS) && (stats != NULL)) {
+             memcpy(stats, shm->stats, sizeof(shm->stats));
+         }
+         RTDB_SHM_BARRIER();
+         if (((seq & 1U) == 0U) && (seq == shm->seq[dom])) {
+             return true;
+         }
+     }
+     return false;
+ }
+ 
+ bool rtdb_shm_read(const rtdb_shm_t *shm, rtdb_t *db, rtdb_stats_t *stats)
+ {
+     return rtdb_shm_read_domain(shm, db, stats, RTDB_DOM_CFG) &&
+            rtdb_shm_read_domain(shm, db, stats, RTDB_DOM_MEAS);
+ }
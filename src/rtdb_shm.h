@@ -0,0 +1,86 @@
+#ifndef RTDB_SHM_H
+#define RTDB_SHM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "rtdb_schema.h"
+#include "rtdb_history.h"
+#include "rtdb_stats.h"
+
+/**
+ * @file rtdb_shm.h
+ * @brief Vista da RTDB em memória partilhada POSIX (native_sim) para monitores externos
+ *
+ * @details
+ *   Com CONFIG_RTDB_SHM (só native_sim), rtdb.c mantém uma cópia de g_rtdb, das
+ *   estatísticas e do histórico de cada zona num objeto de memória partilhada
+ *   (CONFIG_RTDB_SHM_NAME, em /dev/shm). Um processo no anfitrião (tools/rtdb_monitor.c)
+ *   mapeia-o só para leitura e lê o estado ao ritmo que quiser, sem passar pela UART
+ *   nem interferir com as threads do firmware.
+ *
+ *   A cópia usa o mesmo protocolo que rtdb_snapshot(): um contador de sequência por
+ *   domínio, tornado ímpar pelo escritor (com o lock do domínio adquirido) antes de
+ *   copiar os campos do domínio e par depois; o leitor repete a cópia se o contador
+ *   era ímpar ou mudou. As estatísticas pertencem ao domínio de medição. O histórico
+ *   é um rtdb_history_t normal (sequência por slot) e lê-se com rtdb_history_iter_init().
+ *
+ *   O cabeçalho identifica o formato: um monitor compilado com outro
+ *   RTDB_NUM_ZONES ou RTDB_HIST_LEN é recusado por rtdb_shm_valid().
+ *
+ *   Não depende do Zephyr (é testado no host e usado pelo monitor).
+ */
+
+#define RTDB_SHM_MAGIC   0x42445452U  /**< "RTDB" em little-endian */
+#define RTDB_SHM_VERSION 1U
+
+/**
+ * @brief Conteúdo do objeto de memória partilhada
+ */
+typedef struct {
+    uint32_t          magic;                       /* RTDB_SHM_MAGIC */
+    uint32_t          version;                     /* RTDB_SHM_VERSION */
+    uint32_t          size;                        /* sizeof(rtdb_shm_t) */
+    uint32_t          num_zones;                   /* RTDB_NUM_ZONES */
+    uint32_t          hist_len;                    /* RTDB_HIST_LEN */
+    volatile uint32_t seq[RTDB_NUM_DOMAINS];       /* Seqlock de cada domínio (ímpar = em escrita) */
+    volatile uint32_t writes;                      /* Publicações desde o arranque */
+    rtdb_t            db;                          /* Cópia de g_rtdb */
+    rtdb_stats_t      stats[RTDB_NUM_ZONES];       /* Estatísticas (domínio de medição) */
+    rtdb_history_t    hist[RTDB_NUM_ZONES];        /* Histórico de current_temp */
+} rtdb_shm_t;
+
+/**
+ * @brief Preenche o cabeçalho e os valores iniciais (antes de haver leitores ou escritores)
+ */
+void rtdb_shm_format(rtdb_shm_t *shm, const rtdb_t *db);
+
+/**
+ * @brief Copia para shm os campos do domínio dom (e, no de medição, as estatísticas)
+ *
+ * Chamar com o lock do domínio adquirido: só pode haver um escritor por domínio.
+ *
+ * @param shm    Vista partilhada
+ * @param db     RTDB de origem
+ * @param stats  Estatísticas de origem (RTDB_NUM_ZONES entradas)
+ * @param dom    Domínio a publicar
+ */
+void rtdb_shm_publish(rtdb_shm_t *shm, const rtdb_t *db, const rtdb_stats_t *stats,
+                      rtdb_domain_t dom);
+
+/**
+ * @brief true se shm (com size bytes mapeados) tem o formato deste binário
+ */
+bool rtdb_shm_valid(const rtdb_shm_t *shm, size_t size);
+
+/**
+ * @brief Lê uma cópia consistente (por domínio) da RTDB e das estatísticas
+ *
+ * @param shm    Vista partilhada
+ * @param db     Recebe a RTDB
+ * @param stats  Recebe as estatísticas (RTDB_NUM_ZONES entradas), ou NULL
+ * @return       false se um domínio esteve sempre em escrita durante as tentativas
+ */
+bool rtdb_shm_read(const rtdb_shm_t *shm, rtdb_t *db, rtdb_stats_t *stats);
+
+#endif /* RTDB_SHM_H */
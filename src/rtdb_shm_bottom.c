@@ -0,0 +1,33 @@
+/**
+ * @file rtdb_shm_bottom.c
+ * @brief Mapeia o objeto de memória partilhada da RTDB (código do anfitrião, native_sim)
+ */
+
+ #include "rtdb_shm_bottom.h"
+ #include <fcntl.h>
+ #include <stdio.h>
+ #include <sys/mman.h>
+ #include <unistd.h>
+ 
+ void *rtdb_shm_bottom_map(const char *name, size_t size)
+ {
+     int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+     void *p;
+ 
+     if (fd < 0) {
+         perror("[RTDB] shm_open");
+         return NULL;
+     }
+     if (ftruncate(fd, (off_t)size) != 0) {
+         perror("[RTDB] ftruncate");
+         (void)close(fd);
+         return NULL;
+     }
+     p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+     (void)close(fd);
+     if (p == MAP_FAILED) {
+         perror("[RTDB] mmap");
+         return NULL;
+     }
+     return p;
+ }
@@ -0,0 +1,22 @@
+#ifndef RTDB_SHM_BOTTOM_H
+#define RTDB_SHM_BOTTOM_H
+
+#include <stddef.h>
+
+/**
+ * @file rtdb_shm_bottom.h
+ * @brief Lado do anfitrião (native_simulator) da vista da RTDB em memória partilhada
+ *
+ * @details
+ *   rtdb_shm_bottom.c é compilado com a libc do anfitrião (shm_open/mmap), fora do
+ *   Zephyr; daqui só passam tipos C simples.
+ */
+
+/**
+ * @brief Cria (ou reutiliza) o objeto POSIX name com size bytes e mapeia-o
+ *
+ * @return Endereço do mapeamento, ou NULL em caso de erro (já impresso no stderr)
+ */
+void *rtdb_shm_bottom_map(const char *name, size_t size);
+
+#endif /* RTDB_SHM_BOTTOM_H */
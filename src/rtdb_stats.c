@@ -0,0 +1,74 @@
+/**
+ * @file rtdb_stats.c
+ * @brief Estatísticas incrementais de current_temp (ver rtdb_stats.h)
+ */
+
+ #include "rtdb_stats.h"
+ #include <string.h>
+ 
+ /** Divisão com arredondamento ao mais próximo (d > 0) */
+ static int64_t div_round(int64_t v, int64_t d)
+ {
+     return (v >= 0) ? ((v + (d / 2)) / d) : -((-v + (d / 2)) / d);
+ }
+ 
+ void rtdb_stats_reset(rtdb_stats_t *s)
+ {
+     memset(s, 0, sizeof(*s));
+ }
+ 
+ uint8_t rtdb_stats_bin(int32_t err)
+ {
+     if (err < -RTDB_STATS_BAND_HALF) {
+         err = -RTDB_STATS_BAND_HALF;
+     } else if (err > RTDB_STATS_BAND_HALF) {
+         err = RTDB_STATS_BAND_HALF;
+     }
+     return (uint8_t)(err + RTDB_STATS_BAND_HALF);
+ }
+ 
+ void rtdb_stats_add(rtdb_stats_t *s, int16_t temp, int16_t setpoint, uint32_t now_ms)
+ {
+     int64_t x_q = (int64_t)temp << RTDB_STATS_Q;
+ 
+     if (s->n == 0U) {
+         s->min = temp;
+         s->max = temp;
+     } else {
+         uint32_t dt = now_ms - s->last_ms;
+         uint32_t *acc = &s->band_ms[s->last_bin];
+         *acc = (*acc > (UINT32_MAX - dt)) ? UINT32_MAX : (*acc + dt);
+         if (temp < s->min) {
+             s->min = temp;
+         }
+         if (temp > s->max) {
+             s->max = temp;
+         }
+     }
+     if (s->n < UINT32_MAX) {
+         s->n++;
+     }
+ 
+     /* Welford: mean += d / n; M2 += d * (x - mean') */
+     int64_t d_q = x_q - s->mean_q;
+     s->mean_q += div_round(d_q, (int64_t)s->n);
+     s->m2_q += (d_q * (x_q - s->mean_q)) >> RTDB_STATS_Q;
+ 
+     s->last_ms = now_ms;
+     s->last_bin = rtdb_stats_bin((int32_t)temp - setpoint);
+ }
+ 
+ int32_t rtdb_stats_mean_centi(const rtdb_stats_t *s)
+ {
+     return (int32_t)div_round(s->mean_q * 100, (int64_t)1 << RTDB_STATS_Q);
+ }
+ 
+ uint32_t rtdb_stats_var_centi(const rtdb_stats_t *s)
+ {
+     if ((s->n < 2U) || (s->m2_q <= 0)) {
+         return 0U;
+     }
+     int64_t var_q = div_round(s->m2_q, (int64_t)s->n - 1);
+     int64_t v = div_round(var_q * 100, (int64_t)1 << RTDB_STATS_Q);
+     return (v > (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)v;
+ }
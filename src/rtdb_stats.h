@@ -0,0 +1,74 @@
+#ifndef RTDB_STATS_H
+#define RTDB_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file rtdb_stats.h
+ * @brief Estatísticas incrementais de current_temp (mín., máx., média, variância e
+ *        tempo em cada banda em torno do setpoint)
+ *
+ * @details
+ *   Atualizadas em O(1) a cada amostra (algoritmo de Welford), sem guardar as
+ *   amostras: a média e a soma dos quadrados dos desvios (M2) são mantidas em
+ *   vírgula fixa Q16 (sem FPU nem divisões de 64 bits no caminho do sensor além
+ *   de uma por amostra). Cada amostra conta, mesmo que o valor não mude.
+ *
+ *   O histograma de bandas acumula tempo, não amostras: o intervalo entre duas
+ *   amostras é atribuído à banda do erro (temp - setpoint) da primeira. As
+ *   bandas têm 1 °C; as extremas agrupam erros ≤ -RTDB_STATS_BAND_HALF e
+ *   ≥ +RTDB_STATS_BAND_HALF.
+ *
+ *   Não depende do Zephyr (é testado no host).
+ */
+
+#define RTDB_STATS_BAND_HALF 3                              /**< Bandas de -3..+3 °C */
+#define RTDB_STATS_BINS      ((2U * RTDB_STATS_BAND_HALF) + 1U)
+#define RTDB_STATS_Q         16                             /**< Bits fracionários de mean_q/m2_q */
+
+/**
+ * @brief Estatísticas de uma zona desde o último reset
+ */
+typedef struct {
+    uint32_t n;                        /* Número de amostras */
+    int16_t  min;                      /* Menor temperatura (°C) */
+    int16_t  max;                      /* Maior temperatura (°C) */
+    int64_t  mean_q;                   /* Média (°C, Q16) */
+    int64_t  m2_q;                     /* Σ (x - média)² (°C², Q16) */
+    uint32_t last_ms;                  /* Uptime da última amostra */
+    uint8_t  last_bin;                 /* Banda da última amostra */
+    uint32_t band_ms[RTDB_STATS_BINS]; /* Tempo (ms) em cada banda; [BAND_HALF] = no setpoint */
+} rtdb_stats_t;
+
+/**
+ * @brief Esvazia s (n = 0)
+ */
+void rtdb_stats_reset(rtdb_stats_t *s);
+
+/**
+ * @brief Banda do histograma correspondente ao erro err = temp - setpoint (°C)
+ */
+uint8_t rtdb_stats_bin(int32_t err);
+
+/**
+ * @brief Acrescenta uma amostra
+ *
+ * @param s         Estatísticas
+ * @param temp      Temperatura medida (°C)
+ * @param setpoint  Setpoint em vigor (°C)
+ * @param now_ms    Uptime da amostra (ms, com wrap-around a 32 bits)
+ */
+void rtdb_stats_add(rtdb_stats_t *s, int16_t temp, int16_t setpoint, uint32_t now_ms);
+
+/**
+ * @brief Média em centésimas de °C (0 sem amostras)
+ */
+int32_t rtdb_stats_mean_centi(const rtdb_stats_t *s);
+
+/**
+ * @brief Variância amostral (n - 1) em centésimas de °C² (0 com menos de 2 amostras)
+ */
+uint32_t rtdb_stats_var_centi(const rtdb_stats_t *s);
+
+#endif /* RTDB_STATS_H */
@@ -0,0 +1,241 @@
+/**
+ * @file uart_bin.c
+ * @brief Modo binário da UART: COBS, CRC-16 e receptor de frames (ver uart_bin.h)
+ */
+
+ #include "uart_bin.h"
+ 
+ /** CRC-16/CCITT-FALSE de cada valor do byte mais significativo (polinómio 0x1021) */
+ static const uint16_t uart_crc16_tab[256] = {
+     0x0000U, 0x1021U, 0x2042U, 0x3063U, 0x4084U, 0x50A5U, 0x60C6U, 0x70E7U,
+     0x8108U, 0x9129U, 0xA14AU, 0xB16BU, 0xC18CU, 0xD1ADU, 0xE1CEU, 0xF1EFU,
+     0x1231U, 0x0210U, 0x3273U, 0x2252U, 0x52B5U, 0x4294U, 0x72F7U, 0x62D6U,
+     0x9339U, 0x8318U, 0xB37BU, 0xA35AU, 0xD3BDU, 0xC39CU, 0xF3FFU, 0xE3DEU,
+     0x2462U, 0x3443U, 0x0420U, 0x1401U, 0x64E6U, 0x74C7U, 0x44A4U, 0x5485U,
+     0xA56AU, 0xB54BU, 0x8528U, 0x9509U, 0xE5EEU, 0xF5CFU, 0xC5ACU, 0xD58DU,
+     0x3653U, 0x2672U, 0x1611U, 0x0630U, 0x76D7U, 0x66F6U, 0x5695U, 0x46B4U,
+     0xB75BU, 0xA77AU, 0x9719U, 0x8738U, 0xF7DFU, 0xE7FEU, 0xD79DU, 0xC7BCU,
+     0x48C4U, 0x58E5U, 0x6886U, 0x78A7U, 0x0840U, 0x1861U, 0x2802U, 0x3823U,
+     0xC9CCU, 0xD9EDU, 0xE98EU, 0xF9AFU, 0x8948U, 0x9969U, 0xA90AU, 0xB92BU,
+     0x5AF5U, 0x4AD4U, 0x7AB7U, 0x6A96U, 0x1A71U, 0x0A50U, 0x3A33U, 0x2A12U,
+     0xDBFDU, 0xCBDCU, 0xFBBFU, 0xEB9EU, 0x9B79U, 0x8B58U, 0xBB3BU, 0xAB1AU,
+     0x6CA6U, 0x7C87U, 0x4CE4U, 0x5CC5U, 0x2C22U, 0x3C03U, 0x0C60U, 0x1C41U,
+     0xEDAEU, 0xFD8FU, 0xCDECU, 0xDDCDU, 0xAD2AU, 0xBD0BU, 0x8D68U, 0x9D49U,
+     0x7E97U, 0x6EB6U, 0x5ED5U, 0x4EF4U, 0x3E13U, 0x2E32U, 0x1E51U, 0x0E70U,
+     0xFF9FU, 0xEFBEU, 0xDFDDU, 0xCFFCU, 0xBF1BU, 0xAF3AU, 0x9F59U, 0x8F78U,
+     0x9188U, 0x81A9U, 0xB1CAU, 0xA1EBU, 0xD10CU, 0xC12DU, 0xF14EU, 0xE16FU,
+     0x1080U, 0x00A1U, 0x30C2U, 0x20E3U, 0x5004U, 0x4025U, 0x7046U, 0x6067U,
+     0x83B9U, 0x9398U, 0xA3FBU, 0xB3DAU, 0xC33DU, 0xD31CU, 0xE37FU, 0xF35EU,
+     0x02B1U, 0x1290U, 0x22F3U, 0x32D2U, 0x4235U, 0x5214U, 0x6277U, 0x7256U,
+     0xB5EAU, 0xA5CBU, 0x95A8U, 0x8589U, 0xF56EU, 0xE54FU, 0xD52CU, 0xC50DU,
+     0x34E2U, 0x24C3U, 0x14A0U, 0x0481U, 0x7466U, 0x6447U, 0x5424U, 0x4405U,
+     0xA7DBU, 0xB7FAU, 0x8799U, 0x97B8U, 0xE75FU, 0xF77EU, 0xC71DU, 0xD73CU,
+     0x26D3U, 0x36F2U, 0x0691U, 0x16B0U, 0x6657U, 0x7676U, 0x4615U, 0x5634U,
+     0xD94CU, 0xC96DU, 0xF90EU, 0xE92FU, 0x99C8U, 0x89E9U, 0xB98AU, 0xA9ABU,
+     0x5844U, 0x4865U, 0x7806U, 0x6827U, 0x18C0U, 0x08E1U, 0x3882U, 0x28A3U,
+     0xCB7DU, 0xDB5CU, 0xEB3FU, 0xFB1EU, 0x8BF9U, 0x9BD8U, 0xABBBU, 0xBB9AU,
+     0x4A75U, 0x5A54U, 0x6A37U, 0x7A16U, 0x0AF1U, 0x1AD0U, 0x2AB3U, 0x3A92U,
+     0xFD2EU, 0xED0FU, 0xDD6CU, 0xCD4DU, 0xBDAAU, 0xAD8BU, 0x9DE8U, 0x8DC9U,
+     0x7C26U, 0x6C07U, 0x5C64U, 0x4C45U, 0x3CA2U, 0x2C83U, 0x1CE0U, 0x0CC1U,
+     0xEF1FU, 0xFF3EU, 0xCF5DU, 0xDF7CU, 0xAF9BU, 0xBFBAU, 0x8FD9U, 0x9FF8U,
+     0x6E17U, 0x7E36U, 0x4E55U, 0x5E74U, 0x2E93U, 0x3EB2U, 0x0ED1U, 0x1EF0U,
+ };
+ 
+ /**
+  * @brief Escritor COBS incremental: code é a posição do byte de código do bloco aberto
+  */
+ typedef struct {
+     uint8_t *out;
+     size_t   pos;
+     size_t   code;
+ } uart_cobs_w_t;
+ 
+ static void uart_cobs_start(uart_cobs_w_t *w, uint8_t *out)
+ {
+     w->out = out;
+     w->code = 0U;
+     w->pos = 1U;
+ }
+ 
+ static void uart_cobs_put(uart_cobs_w_t *w, uint8_t byte)
+ {
+     if (byte == 0U) {
+         w->out[w->code] = (uint8_t)(w->pos - w->code);
+         w->code = w->pos++;
+         return;
+     }
+     w->out[w->pos++] = byte;
+     if ((w->pos - w->code) == 0xFFU) {
+         /* Bloco de 254 bytes sem zeros: fecha-o sem zero implícito */
+         w->out[w->code] = 0xFFU;
+         w->code = w->pos++;
+     }
+ }
+ 
+ static size_t uart_cobs_end(uart_cobs_w_t *w)
+ {
+     w->out[w->code] = (uint8_t)(w->pos - w->code);
+     return w->pos;
+ }
+ 
+ uint16_t uart_crc16(uint16_t crc, const uint8_t *buf, size_t len)
+ {
+     for (size_t i = 0U; i < len; i++) {
+         crc = (uint16_t)((crc << 8) ^ uart_crc16_tab[(uint8_t)(crc >> 8) ^ buf[i]]);
+     }
+     return crc;
+ }
+ 
+ size_t uart_cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+ {
+     uart_cobs_w_t w;
+ 
+     uart_cobs_start(&w, out);
+     for (size_t i = 0U; i < len; i++) {
+         uart_cobs_put(&w, in[i]);
+     }
+     return uart_cobs_end(&w);
+ }
+ 
+ bool uart_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t *out_len)
+ {
+     size_t i = 0U;
+     size_t n = 0U;
+ 
+     /* n < i em todo o ciclo: descodificar no próprio buffer é seguro */
+     while (i < len) {
+         uint8_t code = in[i++];
+         if ((code == 0U) || ((size_t)(code - 1U) > (len - i))) {
+             return false;
+         }
+         for (uint8_t k = 1U; k < code; k++) {
+             if (in[i] == 0U) {
+                 return false;
+             }
+             out[n++] = in[i++];
+         }
+         if ((code != 0xFFU) && (i < len)) {
+             out[n++] = 0U;
+         }
+     }
+     *out_len = n;
+     return true;
+ }
+ 
+ size_t uart_bin_frame(uint8_t *out, char cmd, const uint8_t *data, size_t data_len)
+ {
+     return uart_bin_frame_seq(out, UART_SEQ_NONE, cmd, data, data_len);
+ }
+ 
+ size_t uart_bin_frame_seq(uint8_t *out, int seq, char cmd, const uint8_t *data, size_t data_len)
+ {
+     uint8_t hdr[UART_BIN_SEQ_LEN + 1U] = { (uint8_t)UART_SEQ_MARK, (uint8_t)seq, (uint8_t)cmd };
+     size_t h = (seq == UART_SEQ_NONE) ? UART_BIN_SEQ_LEN : 0U;   /* Primeiro byte de hdr a enviar */
+     uint16_t crc = uart_crc16(uart_crc16(UART_CRC16_INIT, &hdr[h], sizeof(hdr) - h), data, data_len);
+     uart_cobs_w_t w;
+     size_t n;
+ 
+     out[0] = 0U;
+     uart_cobs_start(&w, &out[1]);
+     for (size_t i = h; i < sizeof(hdr); i++) {
+         uart_cobs_put(&w, hdr[i]);
+     }
+     for (size_t i = 0U; i < data_len; i++) {
+         uart_cobs_put(&w, data[i]);
+     }
+     uart_cobs_put(&w, (uint8_t)(crc & 0xFFU));
+     uart_cobs_put(&w, (uint8_t)(crc >> 8));
+     n = 1U + uart_cobs_end(&w);
+     out[n++] = 0U;
+     return n;
+ }
+ 
+ void uart_bin_init(uart_bin_rx_t *r, uint32_t timeout_ms)
+ {
+     r->len = 0U;
+     r->overflow = false;
+     r->timeout_ms = timeout_ms;
+ }
+ 
+ /**
+  * @brief Valida o frame em r->buf (já sem o delimitador) e decompõe-o em r->f
+  */
+ static uart_parse_ev_t uart_bin_close(uart_bin_rx_t *r)
+ {
+     uart_frame_t *f = &r->f;
+     size_t n;
+     size_t h;   /* Bytes da etiqueta antes de CMD */
+ 
+     if (!uart_cobs_decode(r->buf, r->len, r->buf, &n) || (n < (1U + UART_BIN_CRC_LEN))) {
+         return UART_PARSE_ERROR;
+     }
+     /* Etiqueta lida antes do CRC: o ACK 's' leva-a, tal como chegou */
+     f->tagged = (r->buf[0] == (uint8_t)UART_SEQ_MARK);
+     f->seq = f->tagged ? r->buf[1] : 0U;
+     h = f->tagged ? UART_BIN_SEQ_LEN : 0U;
+     if ((n < (h + 1U + UART_BIN_CRC_LEN)) ||
+         ((n - h - 1U - UART_BIN_CRC_LEN) > UART_PARSER_DATA_MAX)) {
+         return UART_PARSE_ERROR;
+     }
+     n -= UART_BIN_CRC_LEN;
+     if (uart_crc16(UART_CRC16_INIT, r->buf, n) !=
+         (uint16_t)(r->buf[n] | ((uint16_t)r->buf[n + 1U] << 8))) {
+         return UART_PARSE_CHECKSUM;
+     }
+ 
+     f->cmd = (char)r->buf[h];
+     f->data_len = n - h - 1U;
+     f->sum = r->buf[h];
+     f->num = 0U;
+     for (size_t i = 0U; i < f->data_len; i++) {
+         f->data[i] = r->buf[h + 1U + i];
+         f->sum = (uint8_t)(f->sum + f->data[i]);
+         if (i < 4U) {
+             f->num |= (uint32_t)f->data[i] << (8U * i);
+         }
+     }
+     /* O CRC já foi verificado: cs só espelha sum para quem compara os dois */
+     f->cs = f->sum;
+     f->num_ok = (f->data_len >= 1U) && (f->data_len <= 4U);
+     f->bin = true;
+     return UART_PARSE_FRAME;
+ }
+ 
+ uart_parse_ev_t uart_bin_feed(uart_bin_rx_t *r, uint8_t byte, uint32_t now_ms)
+ {
+     if (byte != 0U) {
+         if (r->len < sizeof(r->buf)) {
+             r->buf[r->len++] = byte;
+         } else {
+             r->overflow = true;
+         }
+         r->t_last = now_ms;
+         return UART_PARSE_NONE;
+     }
+ 
+     /* Delimitador: 0x00 seguidos (ou o primeiro, para sincronizar) não são frames */
+     uart_parse_ev_t ev = UART_PARSE_NONE;
+     if (r->overflow) {
+         ev = UART_PARSE_ERROR;
+     } else if (r->len > 0U) {
+         ev = uart_bin_close(r);
+     }
+     r->len = 0U;
+     r->overflow = false;
+     return ev;
+ }
+ 
+ bool uart_bin_expire(uart_bin_rx_t *r, uint32_t now_ms)
+ {
+     if (!uart_bin_busy(r) || (r->timeout_ms == 0U) || ((now_ms - r->t_last) <= r->timeout_ms)) {
+         return false;
+     }
+     r->len = 0U;
+     r->overflow = false;
+     return true;
+ }
+ 
+ bool uart_bin_busy(const uart_bin_rx_t *r)
+ {
+     return (r->len > 0U) || r->overflow;
+ }
@@ -0,0 +1,138 @@
+#ifndef UART_BIN_H
+#define UART_BIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "uart_parser.h"
+
+/**
+ * @file uart_bin.h
+ * @brief Modo binário da UART: frames COBS com CRC-16
+ *
+ * @details
+ *   Negociado com #N1! (e desligado com N0 já em binário). Cada frame é
+ *
+ *       0x00 COBS( [ '@' <seq> ] <CMD> <DATA> <CRC-16 LE> ) 0x00
+ *
+ *   (a etiqueta opcional '@' + seq tem o mesmo papel que no modo ASCII, ver
+ *   uart_parser.h, e é coberta pelo CRC) com os mesmos comandos e respostas do modo ASCII, mas com os campos numéricos
+ *   de DATA em binário little-endian de largura fixa em vez de dígitos decimais.
+ *   O COBS (Consistent Overhead Byte Stuffing) tira todos os 0x00 do frame, que
+ *   fica assim delimitado por 0x00: custa 1 byte por cada 254 e o receptor volta
+ *   a sincronizar no delimitador seguinte, qualquer que seja o lixo recebido. O
+ *   firmware envia também um 0x00 antes de cada frame, para que o texto do printk()
+ *   (a consola é a mesma UART) fique num frame à parte, descartado pelo anfitrião.
+ *
+ *   O CRC é o CRC-16/CCITT-FALSE (polinómio 0x1021, início 0xFFFF, sem reflexão),
+ *   calculado com uma tabela de 256 entradas sobre [etiqueta +] CMD + DATA. Ao contrário da
+ *   soma módulo 256 do modo ASCII, deteta todos os erros de 1 e 2 bits e todas
+ *   as rajadas até 16 bits.
+ *
+ *   O receptor entrega o frame no mesmo uart_frame_t do parser ASCII (bin = true,
+ *   num = DATA em little-endian se tiver 1 a 4 bytes), pelo que os handlers e a
+ *   tabela de despacho são os mesmos nos dois modos.
+ *
+ *   Não depende do Zephyr (é testado no host e usado por tools/uart_bin_bench.c).
+ */
+
+#define UART_CRC16_INIT   0xFFFFU   /**< Valor inicial do CRC-16/CCITT-FALSE */
+#define UART_BIN_CRC_LEN  2U        /**< Bytes do CRC no fim do frame */
+#define UART_BIN_SEQ_LEN  2U        /**< Bytes da etiqueta ('@' + seq) */
+
+/** Bytes de n bytes depois de codificados em COBS (sem o delimitador) */
+#define UART_BIN_COBS_MAX(n)   ((n) + ((n) / 254U) + 1U)
+
+/** Bytes de um frame binário com data_len bytes de DATA, incluindo os dois delimitadores */
+#define UART_BIN_FRAME_MAX(data_len) \
+    (1U + UART_BIN_COBS_MAX(1U + (data_len) + UART_BIN_CRC_LEN) + 1U)
+
+/** O mesmo com etiqueta */
+#define UART_BIN_FRAME_SEQ_MAX(data_len) UART_BIN_FRAME_MAX(UART_BIN_SEQ_LEN + (data_len))
+
+/** Bytes codificados que o receptor aceita (DATA até UART_PARSER_DATA_MAX, com etiqueta) */
+#define UART_BIN_RX_MAX \
+    UART_BIN_COBS_MAX(UART_BIN_SEQ_LEN + 1U + UART_PARSER_DATA_MAX + UART_BIN_CRC_LEN)
+
+/**
+ * @brief Estado do receptor de frames binários
+ */
+typedef struct {
+    uart_frame_t f;
+    uint8_t  buf[UART_BIN_RX_MAX];   /* Bytes COBS desde o último 0x00 */
+    size_t   len;
+    bool     overflow;     /* Frame maior do que buf: descartado no delimitador */
+    uint32_t t_last;       /* Instante (ms) do último byte do frame */
+    uint32_t timeout_ms;   /* 0 = sem timeout */
+} uart_bin_rx_t;
+
+/**
+ * @brief Continua o CRC-16/CCITT-FALSE crc sobre len bytes de buf
+ *
+ * @param crc  UART_CRC16_INIT no primeiro bloco, o resultado anterior nos seguintes
+ */
+uint16_t uart_crc16(uint16_t crc, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Codifica len bytes de in em COBS (sem o 0x00 final)
+ *
+ * @param out  Pelo menos UART_BIN_COBS_MAX(len) bytes
+ * @return Bytes escritos em out
+ */
+size_t uart_cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @brief Descodifica len bytes COBS (sem o 0x00 final); out pode ser igual a in
+ *
+ * @param[out] out_len  Bytes descodificados (no máximo len − 1)
+ * @return false se in não é COBS válido (um 0x00 ou um bloco que passa do fim)
+ */
+bool uart_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t *out_len);
+
+/**
+ * @brief Monta o frame binário 0x00 COBS(<cmd><data><CRC>) 0x00
+ *
+ * @param out  Pelo menos UART_BIN_FRAME_MAX(data_len) bytes
+ * @return Bytes do frame, incluindo os delimitadores
+ */
+size_t uart_bin_frame(uint8_t *out, char cmd, const uint8_t *data, size_t data_len);
+
+/**
+ * @brief Monta o frame binário com etiqueta 0x00 COBS('@'<seq><cmd><data><CRC>) 0x00
+ *
+ * @param seq  0..255, ou UART_SEQ_NONE para um frame sem etiqueta (uart_bin_frame())
+ * @param out  Pelo menos UART_BIN_FRAME_SEQ_MAX(data_len) bytes
+ * @return Bytes do frame, incluindo os delimitadores
+ */
+size_t uart_bin_frame_seq(uint8_t *out, int seq, char cmd, const uint8_t *data, size_t data_len);
+
+/**
+ * @brief Inicializa o receptor
+ *
+ * @param timeout_ms  Pausa máxima entre bytes de um frame (0 = sem limite)
+ */
+void uart_bin_init(uart_bin_rx_t *r, uint32_t timeout_ms);
+
+/**
+ * @brief Entrega um byte recebido no instante now_ms
+ *
+ * @return UART_PARSE_FRAME (frame em r->f até à chamada seguinte), UART_PARSE_ERROR
+ *         (COBS inválido, frame curto ou longo demais), UART_PARSE_CHECKSUM (CRC
+ *         errado; só r->f.tagged e r->f.seq são válidos, tal como chegaram) ou
+ *         UART_PARSE_NONE
+ */
+uart_parse_ev_t uart_bin_feed(uart_bin_rx_t *r, uint8_t byte, uint32_t now_ms);
+
+/**
+ * @brief Descarta o frame a meio se o último byte chegou há mais de timeout_ms
+ *
+ * @return true se descartou um frame (responder com 'f')
+ */
+bool uart_bin_expire(uart_bin_rx_t *r, uint32_t now_ms);
+
+/**
+ * @brief true se há um frame a meio (uart_bin_expire() tem de ser chamado)
+ */
+bool uart_bin_busy(const uart_bin_rx_t *r);
+
+#endif /* UART_BIN_H */
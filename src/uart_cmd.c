@@ -0,0 +1,117 @@
+/**
+ * @file uart_cmd.c
+ * @brief Tabela de despacho dos comandos da UART (ver uart_cmd.h)
+ */
+
+ #include "uart_cmd.h"
+ #include <errno.h>
+ #include <stddef.h>
+ 
+ /**
+  * @brief Entrada da tabela de despacho
+  */
+ typedef struct {
+     uart_cmd_handler_t handler;    /* NULL = sem handler (→ 'i') */
+     uint8_t            data_len;   /* Bytes de DATA exigidos, ou UART_CMD_ANY_LEN */
+     uint8_t            bin_len;    /* O mesmo no modo binário */
+     bool               proto;      /* Comando do protocolo (handler por uart_cmd_bind()) */
+ } uart_cmd_t;
+ 
+ /** Entrada de um comando do protocolo, ainda sem handler */
+ #define UART_CMD_PROTO(data_len, bin_len) { NULL, (data_len), (bin_len), true }
+ 
+ /**
+  * @brief Tabela de despacho indexada pelo byte CMD
+  *
+  * Comprimentos fixos são verificados antes de chamar o handler; com
+  * UART_CMD_ANY_LEN é o handler que valida DATA. As letras de funcionalidades
+  * opcionais (H, U/u, L, J) ficam reservadas mesmo sem elas.
+  */
+ static uart_cmd_t uart_cmds[256] = {
+     ['M'] = UART_CMD_PROTO(3U, 2U),
+     ['m'] = UART_CMD_PROTO(3U, 2U),
+     ['C'] = UART_CMD_PROTO(0U, 0U),
+     ['R'] = UART_CMD_PROTO(4U, 4U),
+     ['r'] = UART_CMD_PROTO(0U, 0U),
+     ['E'] = UART_CMD_PROTO(1U, 1U),
+     ['S'] = UART_CMD_PROTO(UART_CMD_ANY_LEN, UART_CMD_ANY_LEN),
+     ['T'] = UART_CMD_PROTO(UART_CMD_ANY_LEN, UART_CMD_ANY_LEN),
+     ['Q'] = UART_CMD_PROTO(UART_CMD_ANY_LEN, UART_CMD_ANY_LEN),
+     ['Z'] = UART_CMD_PROTO(0U, 0U),
+     ['P'] = UART_CMD_PROTO(UART_CMD_ANY_LEN, UART_CMD_ANY_LEN),
+     ['B'] = UART_CMD_PROTO(0U, 0U),
+     ['N'] = UART_CMD_PROTO(1U, 1U),
+     ['K'] = UART_CMD_PROTO(UART_CMD_ANY_LEN, UART_CMD_ANY_LEN),
+     ['H'] = UART_CMD_PROTO(UART_CMD_ANY_LEN, UART_CMD_ANY_LEN),
+     ['U'] = UART_CMD_PROTO(3U, 2U),
+     ['u'] = UART_CMD_PROTO(0U, 0U),
+     ['L'] = UART_CMD_PROTO(UART_CMD_ANY_LEN, UART_CMD_ANY_LEN),
+     ['J'] = UART_CMD_PROTO(UART_CMD_ANY_LEN, UART_CMD_ANY_LEN),
+ };
+ 
+ int uart_cmd_bind(char cmd, uart_cmd_handler_t handler)
+ {
+     uart_cmd_t *c = &uart_cmds[(uint8_t)cmd];
+ 
+     if ((handler == NULL) || !c->proto) {
+         return -EINVAL;
+     }
+     if (c->handler != NULL) {
+         return -EEXIST;
+     }
+     c->handler = handler;
+     return 0;
+ }
+ 
+ int uart_cmd_register(char cmd, uint8_t data_len, uint8_t bin_len, uart_cmd_handler_t handler)
+ {
+     uart_cmd_t *c = &uart_cmds[(uint8_t)cmd];
+ 
+     if ((handler == NULL) ||
+         ((data_len != UART_CMD_ANY_LEN) && (data_len > UART_PARSER_DATA_MAX)) ||
+         ((bin_len != UART_CMD_ANY_LEN) && (bin_len > UART_PARSER_DATA_MAX))) {
+         return -EINVAL;
+     }
+     if (c->proto || (c->handler != NULL)) {
+         return -EEXIST;
+     }
+     c->data_len = data_len;
+     c->bin_len = bin_len;
+     c->handler = handler;
+     return 0;
+ }
+ 
+ uart_cmd_result_t uart_cmd_handle(const struct device *dev, const uart_frame_t *f)
+ {
+     /* Framing (tamanho, '#', '!') já validado pelo parser; um acesso à tabela */
+     const uart_cmd_t *c = &uart_cmds[(uint8_t)f->cmd];
+ 
+     if (c->handler == NULL) {
+         /* Comando desconhecido: compara checksum isolado de [etiqueta +] CMD */
+         uint8_t head = (uint8_t)f->cmd;
+         if (f->tagged) {
+             head = (uint8_t)(head + UART_SEQ_MARK + (3U * '0') + (f->seq / 100U) +
+                              ((f->seq / 10U) % 10U) + (f->seq % 10U));
+         }
+         return (!f->bin && ((uint16_t)head != f->cs)) ? UART_CMD_CHECKSUM_INVALID
+                                                       : UART_CMD_INVALID;
+     }
+ 
+     /* Verifica checksum completo [CMD + DATA], somado pelo parser */
+     if ((uint16_t)f->sum != f->cs) {
+         return UART_CMD_CHECKSUM;
+     }
+     return uart_cmd_dispatch(dev, f);
+ }
+ 
+ uart_cmd_result_t uart_cmd_dispatch(const struct device *dev, const uart_frame_t *f)
+ {
+     const uart_cmd_t *c = &uart_cmds[(uint8_t)f->cmd];
+     uint8_t len = f->bin ? c->bin_len : c->data_len;
+ 
+     if ((c->handler == NULL) || ((len != UART_CMD_ANY_LEN) && (f->data_len != len))) {
+         return UART_CMD_INVALID;
+     }
+     c->handler(dev, f);
+     return UART_CMD_DONE;
+ }
@@ -0,0 +1,97 @@
+#ifndef UART_CMD_H
+#define UART_CMD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart_parser.h"
+
+/**
+ * @file uart_cmd.h
+ * @brief Tabela de despacho dos comandos da UART (CMD → handler e comprimento de DATA)
+ *
+ * @details
+ *   Uma entrada por valor do byte CMD, pelo que o custo do despacho não depende do
+ *   número de comandos. Os comandos do protocolo vêm já na tabela, com o
+ *   comprimento de DATA de cada modo: quem os trata (uartcomm.c no firmware,
+ *   dummy/uartcomm_dummy.c no host) só lhes liga o handler com uart_cmd_bind().
+ *   Outros módulos acrescentam comandos novos com uart_cmd_register().
+ *
+ *   uart_cmd_handle() aplica ao frame as regras de checksum e de comprimento e diz
+ *   que ACK de erro enviar; quem chama é que o envia.
+ *
+ *   Não depende do Zephyr (é testado no host).
+ */
+
+struct device;
+
+/** Comprimento de DATA variável: o handler valida-o */
+#define UART_CMD_ANY_LEN 0xFFU
+
+/**
+ * @brief Handler de um comando
+ *
+ * Chamado na thread da UART com o frame já validado (framing, checksum e, se
+ * fixo, comprimento de DATA). Tem de responder com uart_comm_send_frame() ou
+ * uart_comm_send_ack().
+ *
+ * @param dev  Dispositivo UART (para a resposta)
+ * @param f    Frame recebido
+ */
+typedef void (*uart_cmd_handler_t)(const struct device *dev, const uart_frame_t *f);
+
+/**
+ * @brief Resultado de uart_cmd_handle()/uart_cmd_dispatch()
+ */
+typedef enum {
+    UART_CMD_DONE = 0,           /* Handler chamado (a resposta é dele) */
+    UART_CMD_INVALID,            /* Comando sem handler ou comprimento errado: ACK 'i' */
+    UART_CMD_CHECKSUM,           /* Checksum errado: ACK 's' */
+    UART_CMD_CHECKSUM_INVALID    /* Comando sem handler e checksum errado: 's' e depois 'i' */
+} uart_cmd_result_t;
+
+/**
+ * @brief Liga o handler de um comando do protocolo
+ *
+ * Os comprimentos de DATA são os da tabela; comandos de funcionalidades não
+ * compiladas ficam sem handler e respondem 'i'.
+ *
+ * @return 0, -EINVAL (handler NULL ou cmd fora do protocolo) ou -EEXIST (já ligado)
+ */
+int uart_cmd_bind(char cmd, uart_cmd_handler_t handler);
+
+/**
+ * @brief Regista o handler de um comando novo cmd
+ *
+ * Deve ser chamado na inicialização (antes de uart_comm_init() ou da thread que
+ * trata os comandos receber frames); a tabela não é protegida contra escritas
+ * concorrentes com o despacho.
+ *
+ * @param cmd       Byte CMD do frame
+ * @param data_len  Bytes de DATA exigidos (frames com outro comprimento → ACK 'i'),
+ *                  ou UART_CMD_ANY_LEN
+ * @param bin_len   O mesmo para frames do modo binário
+ * @param handler   Função a chamar
+ * @return 0, -EINVAL (handler NULL ou comprimento impossível) ou -EEXIST (cmd já
+ *         usado, incluindo os comandos do protocolo)
+ */
+int uart_cmd_register(char cmd, uint8_t data_len, uint8_t bin_len, uart_cmd_handler_t handler);
+
+/**
+ * @brief Trata um frame recebido: checksum, comprimento de DATA e handler
+ *
+ * Comando sem handler: só [etiqueta +] CMD conta para o checksum (DATA de um
+ * comando desconhecido não tem significado), e no modo binário o CRC já foi
+ * verificado pelo receptor.
+ */
+uart_cmd_result_t uart_cmd_handle(const struct device *dev, const uart_frame_t *f);
+
+/**
+ * @brief Chama o handler de f->cmd depois de verificar o comprimento de DATA
+ *
+ * Para frames cujo checksum já está visto (p.ex. os sub-comandos de um lote K).
+ *
+ * @return UART_CMD_DONE ou UART_CMD_INVALID
+ */
+uart_cmd_result_t uart_cmd_dispatch(const struct device *dev, const uart_frame_t *f);
+
+#endif /* UART_CMD_H */
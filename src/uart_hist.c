@@ -0,0 +1,119 @@
+/**
+ * @file uart_hist.c
+ * @brief Histórico de temperatura em chunks comprimidos (ver uart_hist.h)
+ */
+
+ #include "uart_hist.h"
+ #include <string.h>
+
+ void uart_hist_init(uart_hist_t *d, const rtdb_hist_iter_t *it, uart_hist_compress_t compress)
+ {
+     d->it = *it;
+     d->compress = compress;
+     d->n_pend = 0U;
+     d->seq = 0U;
+     d->done = false;
+ }
+
+ uint32_t uart_hist_skip(uart_hist_t *d, uint32_t n)
+ {
+     rtdb_sample_t s;
+     uint32_t k = 0U;
+
+     while ((k < n) && rtdb_history_next(&d->it, &s)) {
+         k++;
+     }
+     return k;
+ }
+
+ size_t uart_hist_pack(const rtdb_sample_t *s, size_t n, uint8_t *raw)
+ {
+     size_t pos = 0U;
+
+     for (size_t i = 0U; i < n; i++) {
+         uint32_t dt = (i == 0U) ? 0U : (s[i].t_ms - s[i - 1U].t_ms);
+         uint16_t temp = (uint16_t)s[i].temp;
+
+         dt = (dt > 0xFFFFU) ? 0xFFFFU : dt;   /* Pausa de mais de 65 s: satura */
+         raw[pos++] = (uint8_t)dt;
+         raw[pos++] = (uint8_t)(dt >> 8);
+         raw[pos++] = (uint8_t)temp;
+         raw[pos++] = (uint8_t)(temp >> 8);
+     }
+     return pos;
+ }
+
+ void uart_hist_unpack(const uint8_t *raw, size_t n, uint32_t t0, rtdb_sample_t *out)
+ {
+     uint32_t t = t0;
+
+     for (size_t i = 0U; i < n; i++) {
+         const uint8_t *r = &raw[i * UART_HIST_REC_LEN];
+
+         t += (uint32_t)r[0] | ((uint32_t)r[1] << 8);
+         out[i].t_ms = t;
+         out[i].temp = (int16_t)(uint16_t)((uint16_t)r[2] | ((uint16_t)r[3] << 8));
+     }
+ }
+
+ /**
+  * @brief Comprime as n primeiras amostras pendentes em out (0 se não cabem em cap)
+  */
+ static size_t uart_hist_try(uart_hist_t *d, size_t n, uint8_t *out, size_t cap)
+ {
+     size_t len = uart_hist_pack(d->pend, n, d->raw);
+     int r = d->compress(d->raw, (int)len, out, (int)cap);
+
+     return (r > 0) ? (size_t)r : 0U;
+ }
+
+ bool uart_hist_next(uart_hist_t *d, uint8_t *out, size_t cap, uart_hist_chunk_t *c)
+ {
+     if (d->done) {
+         return false;
+     }
+     while ((d->n_pend < UART_HIST_MAX_N) && rtdb_history_next(&d->it, &d->pend[d->n_pend])) {
+         d->n_pend++;
+     }
+
+     c->seq = d->seq;
+     c->t0 = 0U;
+     c->n = 0U;
+     c->len = 0U;
+     if (d->n_pend == 0U) {
+         d->done = true;
+         return true;
+     }
+
+     /* Maior n que cabe: todas as pendentes, ou pesquisa binária (lo confirmado no fim) */
+     size_t lo = 1U;
+     size_t hi = d->n_pend;
+     size_t len = uart_hist_try(d, hi, out, cap);
+     if (len > 0U) {
+         lo = hi;
+     } else {
+         while ((hi - lo) > 1U) {
+             size_t mid = lo + ((hi - lo) / 2U);
+             if (uart_hist_try(d, mid, out, cap) > 0U) {
+                 lo = mid;
+             } else {
+                 hi = mid;
+             }
+         }
+         len = uart_hist_try(d, lo, out, cap);
+         if (len == 0U) {
+             /* Nem uma amostra cabe: termina a janela em vez de ficar preso */
+             d->n_pend = 0U;
+             d->done = true;
+             return true;
+         }
+     }
+
+     c->t0 = d->pend[0].t_ms;
+     c->n = (uint32_t)lo;
+     c->len = len;
+     d->n_pend -= lo;
+     memmove(&d->pend[0], &d->pend[lo], d->n_pend * sizeof(d->pend[0]));
+     d->seq++;
+     return true;
+ }
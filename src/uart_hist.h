@@ -0,0 +1,103 @@
+#ifndef UART_HIST_H
+#define UART_HIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "rtdb_history.h"
+
+/**
+ * @file uart_hist.h
+ * @brief Leitura do histórico de temperatura em chunks comprimidos (comando H)
+ *
+ * @details
+ *   As amostras de uma janela do histórico (rtdb_history.h) são agrupadas em
+ *   chunks que cabem cada um num frame. Cada amostra ocupa UART_HIST_REC_LEN bytes
+ *   antes da compressão:
+ *
+ *       <dt (uint16 LE, ms desde a amostra anterior)> <temp (int16 LE, °C)>
+ *
+ *   com dt = 0 na primeira amostra do chunk, cujo instante segue no cabeçalho (t0).
+ *   Com a amostragem regular e a temperatura quase sempre igual à anterior, os
+ *   registos repetem-se e o LZ4 reduz cada chunk a poucos bytes.
+ *
+ *   Cada chunk leva o maior número de amostras (até UART_HIST_MAX_N) cuja forma
+ *   comprimida cabe no espaço dado, encontrado por pesquisa binária. A numeração
+ *   (seq) começa em 0 e o último chunk, com n = 0, marca o fim da janela. Para
+ *   retomar depois de um seq em falta, o anfitrião soma o n dos chunks que recebeu
+ *   em ordem e pede a mesma janela a saltar esse número de amostras
+ *   (uart_hist_skip()): as saltadas só são lidas do histórico, sem compressão.
+ *
+ *   O compressor é passado pelo chamador (LZ4 no firmware), para que o módulo não
+ *   dependa do Zephyr nem do LZ4 (é testado no host).
+ */
+
+#define UART_HIST_REC_LEN 4U     /**< Bytes de uma amostra antes da compressão */
+#define UART_HIST_MAX_N   128U   /**< Amostras por chunk, no máximo */
+
+/**
+ * @brief Comprime src_len bytes de src em dst
+ *
+ * @return Bytes escritos em dst, ou 0 se não cabem em cap
+ */
+typedef int (*uart_hist_compress_t)(const uint8_t *src, int src_len, uint8_t *dst, int cap);
+
+/**
+ * @brief Cabeçalho de um chunk
+ */
+typedef struct {
+    uint32_t seq;   /* Número do chunk na janela (0, 1, …) */
+    uint32_t t0;    /* Instante da primeira amostra (ms) */
+    uint32_t n;     /* Amostras no chunk (0 = fim da janela) */
+    size_t   len;   /* Bytes comprimidos */
+} uart_hist_chunk_t;
+
+/**
+ * @brief Estado da divisão de uma janela em chunks
+ */
+typedef struct {
+    rtdb_hist_iter_t     it;
+    uart_hist_compress_t compress;
+    rtdb_sample_t        pend[UART_HIST_MAX_N];   /* Lidas de it e ainda não enviadas */
+    size_t               n_pend;
+    uint32_t             seq;
+    bool                 done;                    /* Chunk de fim já entregue */
+    uint8_t              raw[UART_HIST_MAX_N * UART_HIST_REC_LEN];
+} uart_hist_t;
+
+/**
+ * @brief Começa a dividir a janela de it (rtdb_history_window_zone())
+ */
+void uart_hist_init(uart_hist_t *d, const rtdb_hist_iter_t *it, uart_hist_compress_t compress);
+
+/**
+ * @brief Salta as n primeiras amostras da janela (antes do primeiro uart_hist_next())
+ *
+ * @return Amostras saltadas (menos de n se a janela acabar antes)
+ */
+uint32_t uart_hist_skip(uart_hist_t *d, uint32_t n);
+
+/**
+ * @brief Monta o chunk seguinte em out
+ *
+ * @param out  Recebe os bytes comprimidos
+ * @param cap  Espaço em out (pelo menos UART_HIST_REC_LEN + 1)
+ * @param c    Cabeçalho do chunk
+ * @return false depois do chunk de fim (n = 0), que é sempre o último entregue
+ */
+bool uart_hist_next(uart_hist_t *d, uint8_t *out, size_t cap, uart_hist_chunk_t *c);
+
+/**
+ * @brief Converte n amostras no formato de um chunk antes da compressão
+ *
+ * @param raw  Pelo menos n × UART_HIST_REC_LEN bytes
+ * @return Bytes escritos
+ */
+size_t uart_hist_pack(const rtdb_sample_t *s, size_t n, uint8_t *raw);
+
+/**
+ * @brief Inverso de uart_hist_pack() (lado do anfitrião), com t0 do cabeçalho
+ */
+void uart_hist_unpack(const uint8_t *raw, size_t n, uint32_t t0, rtdb_sample_t *out);
+
+#endif /* UART_HIST_H */
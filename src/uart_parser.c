@@ -0,0 +1,183 @@
+/**
+ * @file uart_parser.c
+ * @brief Parser incremental dos frames da UART (ver uart_parser.h)
+ */
+
+ #include "uart_parser.h"
+ 
+ /** Dígitos decimais que cabem em uart_frame_t.num */
+ #define UART_PARSER_NUM_DIGITS 9U
+ 
+ static void uart_parser_start(uart_parser_t *p, uint32_t now_ms)
+ {
+     p->in_frame = true;
+     p->have_cmd = false;
+     p->tag_n = 0U;
+     p->tag = 0U;
+     p->win_n = 0U;
+     p->len = 1U;
+     p->t_last = now_ms;
+     p->f.data_len = 0U;
+     p->f.sum = 0U;
+     p->f.num = 0U;
+     p->f.num_ok = true;
+     p->f.bin = false;
+     p->f.tagged = false;
+     p->f.seq = 0U;
+ }
+ 
+ /**
+  * @brief Acrescenta a DATA um byte que saiu da janela (já não pode ser checksum)
+  */
+ static void uart_parser_commit(uart_frame_t *f, uint8_t byte)
+ {
+     f->data[f->data_len++] = byte;
+     f->sum = (uint8_t)(f->sum + byte);
+     if ((byte >= '0') && (byte <= '9') && (f->data_len <= UART_PARSER_NUM_DIGITS)) {
+         f->num = (f->num * 10U) + (uint32_t)(byte - '0');
+     } else {
+         f->num_ok = false;
+     }
+ }
+ 
+ static uint16_t uart_parser_cs(const uint8_t *w)
+ {
+     uint16_t cs = 0U;
+ 
+     for (uint32_t i = 0U; i < 3U; i++) {
+         if ((w[i] < '0') || (w[i] > '9')) {
+             return UART_PARSER_CS_BAD;
+         }
+         cs = (uint16_t)((cs * 10U) + (uint16_t)(w[i] - '0'));
+     }
+     return cs;
+ }
+ 
+ void uart_parser_init(uart_parser_t *p, uint32_t timeout_ms)
+ {
+     p->in_frame = false;
+     p->timeout_ms = timeout_ms;
+ }
+ 
+ uart_parse_ev_t uart_parser_feed(uart_parser_t *p, uint8_t byte, uint32_t now_ms)
+ {
+     if ((byte == '\r') || (byte == '\n')) {
+         return UART_PARSE_NONE;
+     }
+     if (byte == '#') {
+         /* '#' a meio de outro frame: erro nesse frame, mas este começa já */
+         bool broken = p->in_frame;
+         uart_parser_start(p, now_ms);
+         return broken ? UART_PARSE_ERROR : UART_PARSE_NONE;
+     }
+     if (!p->in_frame) {
+         return (byte == '!') ? UART_PARSE_ERROR : UART_PARSE_NONE;
+     }
+ 
+     p->t_last = now_ms;
+     p->len++;
+     if (byte == '!') {
+         p->in_frame = false;
+         if (!p->have_cmd || (p->win_n < 3U)) {
+             return UART_PARSE_ERROR;   /* Menos de '#' + CMD + CS(3) + '!' */
+         }
+         p->f.cs = uart_parser_cs(p->win);
+         p->f.num_ok = p->f.num_ok && (p->f.data_len > 0U);
+         return UART_PARSE_FRAME;
+     }
+     if (p->len >= UART_PARSER_FRAME_MAX) {
+         p->in_frame = false;
+         return UART_PARSE_ERROR;
+     }
+ 
+     if (!p->have_cmd) {
+         /* A etiqueta, se houver, conta para o checksum como CMD */
+         p->f.sum = (uint8_t)(p->f.sum + byte);
+         if (p->f.tagged && (p->tag_n < UART_SEQ_DIGITS)) {
+             p->tag = (uint16_t)((p->tag * 10U) + (uint16_t)(byte - '0'));
+             p->tag_n++;
+             if ((byte < '0') || (byte > '9') || (p->tag > 0xFFU)) {
+                 p->in_frame = false;
+                 return UART_PARSE_ERROR;
+             }
+             p->f.seq = (uint8_t)p->tag;
+         } else if (!p->f.tagged && (byte == (uint8_t)UART_SEQ_MARK)) {
+             p->f.tagged = true;
+         } else {
+             p->f.cmd = (char)byte;
+             p->have_cmd = true;
+         }
+     } else if (p->win_n < 3U) {
+         p->win[p->win_n++] = byte;
+     } else {
+         uart_parser_commit(&p->f, p->win[0]);
+         p->win[0] = p->win[1];
+         p->win[1] = p->win[2];
+         p->win[2] = byte;
+     }
+     return UART_PARSE_NONE;
+ }
+ 
+ bool uart_parser_expire(uart_parser_t *p, uint32_t now_ms)
+ {
+     if (!p->in_frame || (p->timeout_ms == 0U) || ((now_ms - p->t_last) <= p->timeout_ms)) {
+         return false;
+     }
+     p->in_frame = false;
+     return true;
+ }
+ 
+ bool uart_parser_busy(const uart_parser_t *p)
+ {
+     return p->in_frame;
+ }
+ 
+ int uart_parser_sub(const uart_frame_t *batch, size_t *pos, uart_frame_t *sub)
+ {
+     const uint8_t *p = &batch->data[*pos];
+     size_t left = batch->data_len - *pos;
+     size_t hdr = batch->bin ? 1U : 2U;
+     size_t len;
+ 
+     if (left == 0U) {
+         return 0;
+     }
+     if (left < hdr) {
+         return -1;
+     }
+     if (batch->bin) {
+         len = p[0];
+     } else if ((p[0] >= '0') && (p[0] <= '9') && (p[1] >= '0') && (p[1] <= '9')) {
+         len = ((size_t)(p[0] - '0') * 10U) + (size_t)(p[1] - '0');
+     } else {
+         return -1;
+     }
+     if ((len == 0U) || (len > (left - hdr))) {
+         return -1;
+     }
+ 
+     sub->cmd = (char)p[hdr];
+     sub->data_len = len - 1U;
+     sub->sum = p[hdr];
+     sub->num = 0U;
+     sub->num_ok = (sub->data_len >= 1U) &&
+                   (sub->data_len <= (batch->bin ? 4U : UART_PARSER_NUM_DIGITS));
+     for (size_t i = 0U; i < sub->data_len; i++) {
+         uint8_t b = p[hdr + 1U + i];
+         sub->data[i] = b;
+         sub->sum = (uint8_t)(sub->sum + b);
+         if (batch->bin) {
+             sub->num |= (i < 4U) ? ((uint32_t)b << (8U * i)) : 0U;
+         } else if ((b >= '0') && (b <= '9')) {
+             sub->num = (sub->num * 10U) + (uint32_t)(b - '0');
+         } else {
+             sub->num_ok = false;
+         }
+     }
+     sub->cs = sub->sum;
+     sub->bin = batch->bin;
+     sub->tagged = false;
+     sub->seq = 0U;
+     *pos += hdr + len;
+     return 1;
+ }
@@ -0,0 +1,130 @@
+#ifndef UART_PARSER_H
+#define UART_PARSER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file uart_parser.h
+ * @brief Parser incremental dos frames “#<CMD><DATA><CS(3)>!” recebidos pela UART
+ *
+ * @details
+ *   Máquina de estados alimentada byte a byte: valida o framing, soma o checksum
+ *   (módulo 256 de CMD + DATA) e converte DATA para decimal à medida que os bytes
+ *   chegam. Como só no '!' se sabe onde DATA acaba, os três últimos bytes ficam
+ *   numa janela de atraso: um byte só conta para DATA (e para a soma) quando é
+ *   empurrado para fora da janela por outro; no '!' a janela tem os três dígitos
+ *   do checksum. O trabalho no '!' é assim constante, qualquer que seja DATA.
+ *
+ *   Etiqueta opcional: um pedido “#@<seq(3)><CMD><DATA><CS(3)>!” leva um número
+ *   de sequência (000..255) que o firmware repete em todas as respostas a esse
+ *   pedido (incluindo os ACK, o de checksum errado também). Assim o anfitrião pode
+ *   ter vários pedidos em curso e saber a que pedido pertence cada resposta. O
+ *   checksum cobre a etiqueta ('@' e os três dígitos); etiqueta mal formada ou
+ *   acima de 255 é erro de framing. No modo binário a etiqueta é '@' seguido de um
+ *   byte (uart_bin.h).
+ *
+ *   Regras (as de uart_task()):
+ *     - CR/LF são ignorados em qualquer ponto;
+ *     - bytes fora de um frame são ignorados, exceto '!' (erro de framing);
+ *     - '#' a meio de um frame é erro de framing e começa logo um frame novo;
+ *     - um frame com mais de UART_PARSER_FRAME_MAX bytes sem '!' é erro de framing;
+ *     - um frame a meio sem bytes novos durante timeout_ms é descartado
+ *       (uart_parser_expire()).
+ *
+ *   Não depende do Zephyr (é testado no host).
+ */
+
+#define UART_PARSER_FRAME_MAX 64U   /**< Bytes de um frame, de '#' a '!' inclusive */
+#define UART_PARSER_DATA_MAX  (UART_PARSER_FRAME_MAX - 6U)  /**< '#' + CMD + CS(3) + '!' */
+#define UART_PARSER_CS_BAD    0xFFFFU   /**< cs quando os três carateres não são dígitos */
+#define UART_SEQ_MARK         '@'       /**< Início da etiqueta de sequência (antes de CMD) */
+#define UART_SEQ_DIGITS       3U        /**< Dígitos da etiqueta no modo ASCII */
+#define UART_SEQ_NONE         (-1)      /**< Resposta sem etiqueta (pedido sem etiqueta ou telemetria) */
+
+/**
+ * @brief Resultado de entregar um byte ao parser
+ */
+typedef enum {
+    UART_PARSE_NONE = 0,   /* Nada a fazer (byte consumido) */
+    UART_PARSE_FRAME,      /* Frame completo em uart_parser_t.f */
+    UART_PARSE_ERROR,      /* Erro de framing (responder com 'f') */
+    UART_PARSE_CHECKSUM    /* Frame binário com CRC errado (responder com 's'; uart_bin.h) */
+} uart_parse_ev_t;
+
+/**
+ * @brief Frame recebido, já decomposto
+ */
+typedef struct {
+    char     cmd;
+    uint8_t  data[UART_PARSER_DATA_MAX];
+    size_t   data_len;
+    uint8_t  sum;      /* Checksum calculado: (CMD + DATA) & 0xFF */
+    uint16_t cs;       /* Checksum recebido (0..999) ou UART_PARSER_CS_BAD */
+    uint32_t num;      /* DATA como número decimal (válido se num_ok) */
+    bool     num_ok;   /* DATA tem entre 1 e 9 carateres, todos dígitos */
+    bool     bin;      /* Frame binário (uart_bin.h): CRC verificado, campos em little-endian */
+    bool     tagged;   /* Pedido com etiqueta “@<seq>” */
+    uint8_t  seq;      /* Número de sequência (válido se tagged) */
+} uart_frame_t;
+
+/**
+ * @brief Estado do parser
+ */
+typedef struct {
+    uart_frame_t f;
+    bool     in_frame;     /* Já recebeu '#' */
+    bool     have_cmd;     /* Já recebeu CMD */
+    uint8_t  tag_n;        /* Dígitos da etiqueta já recebidos */
+    uint16_t tag;          /* Valor da etiqueta até agora */
+    uint8_t  win[3];       /* Janela de atraso (candidatos a checksum) */
+    uint8_t  win_n;
+    size_t   len;          /* Bytes do frame até agora, incluindo '#' */
+    uint32_t t_last;       /* Instante (ms) do último byte do frame */
+    uint32_t timeout_ms;   /* 0 = sem timeout */
+} uart_parser_t;
+
+/**
+ * @brief Inicializa o parser
+ *
+ * @param timeout_ms  Pausa máxima entre bytes de um frame (0 = sem limite)
+ */
+void uart_parser_init(uart_parser_t *p, uint32_t timeout_ms);
+
+/**
+ * @brief Entrega um byte recebido no instante now_ms
+ *
+ * Com UART_PARSE_FRAME, p->f descreve o frame até à chamada seguinte.
+ */
+uart_parse_ev_t uart_parser_feed(uart_parser_t *p, uint8_t byte, uint32_t now_ms);
+
+/**
+ * @brief Descarta o frame a meio se o último byte chegou há mais de timeout_ms
+ *
+ * @return true se descartou um frame (responder com 'f')
+ */
+bool uart_parser_expire(uart_parser_t *p, uint32_t now_ms);
+
+/**
+ * @brief true se há um frame a meio (uart_parser_expire() tem de ser chamado)
+ */
+bool uart_parser_busy(const uart_parser_t *p);
+
+/**
+ * @brief Extrai o sub-comando seguinte de DATA de um lote (comando K)
+ *
+ * DATA do lote é uma sequência de <len><CMD><DATA'>, com len = 1 + bytes de DATA'
+ * em 2 dígitos decimais (ASCII) ou num byte (binário). O sub-comando sai em *sub
+ * decomposto como um frame recebido no mesmo modo (num/num_ok preenchidos); o
+ * checksum do lote já cobre os sub-comandos, pelo que sub->cs = sub->sum. Os
+ * sub-comandos não têm etiqueta: as suas respostas seguem na do lote.
+ *
+ * @param batch  Frame do lote
+ * @param pos    Posição em batch->data: 0 no primeiro sub-comando, avançada a cada um
+ * @param sub    Sub-comando extraído
+ * @return 1 se extraiu um sub-comando, 0 no fim de DATA, -1 se DATA está mal formada
+ */
+int uart_parser_sub(const uart_frame_t *batch, size_t *pos, uart_frame_t *sub);
+
+#endif /* UART_PARSER_H */
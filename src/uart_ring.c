@@ -0,0 +1,50 @@
+/**
+ * @file uart_ring.c
+ * @brief Buffer circular SPSC da receção da UART (ver uart_ring.h)
+ */
+
+ #include "uart_ring.h"
+ 
+ #if defined(UNIT_TEST)
+ #define UART_RING_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+ #else
+ #include <zephyr/sys/barrier.h>
+ #define UART_RING_BARRIER() barrier_dmem_fence_full()
+ #endif
+ 
+ #define UART_RING_MASK (UART_RING_LEN - 1U)
+ 
+ _Static_assert((UART_RING_LEN & UART_RING_MASK) == 0U,
+                "UART_RING_LEN tem de ser potência de 2");
+ 
+ size_t uart_ring_put(uart_ring_t *r, const uint8_t *data, size_t len)
+ {
+     uint32_t head = r->head;
+     uint32_t room = UART_RING_LEN - (head - r->tail);
+     size_t n = (len < room) ? len : room;
+ 
+     for (size_t i = 0U; i < n; i++) {
+         r->buf[(head + i) & UART_RING_MASK] = data[i];
+     }
+     /* Os bytes têm de estar no buffer antes de o consumidor ver o novo head */
+     UART_RING_BARRIER();
+     r->head = head + (uint32_t)n;
+     r->dropped += (uint32_t)(len - n);
+     return n;
+ }
+ 
+ size_t uart_ring_get(uart_ring_t *r, uint8_t *out, size_t max)
+ {
+     uint32_t tail = r->tail;
+     uint32_t avail = r->head - tail;
+     size_t n = (max < avail) ? max : avail;
+ 
+     UART_RING_BARRIER();
+     for (size_t i = 0U; i < n; i++) {
+         out[i] = r->buf[(tail + i) & UART_RING_MASK];
+     }
+     /* Só depois de copiados os bytes é que o produtor pode reutilizar os slots */
+     UART_RING_BARRIER();
+     r->tail = tail + (uint32_t)n;
+     return n;
+ }
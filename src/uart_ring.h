@@ -0,0 +1,51 @@
+#ifndef UART_RING_H
+#define UART_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file uart_ring.h
+ * @brief Buffer circular de bytes sem lock entre a ISR de receção da UART e a thread
+ *
+ * @details
+ *   Um só produtor (a ISR, que esvazia a FIFO da UART) e um só consumidor
+ *   (uart_task). Cada lado só escreve o seu índice (head pela ISR, tail pela
+ *   thread); os índices são absolutos e só são reduzidos à capacidade no acesso,
+ *   pelo que head - tail é sempre o número de bytes pendentes. Bytes que chegam
+ *   com o buffer cheio são descartados e contados em dropped.
+ *
+ *   Não depende do Zephyr (é testado no host e usado por tools/uart_rx_bench.c).
+ */
+
+#if defined(CONFIG_UARTCOMM_RX_RING_LEN)
+#define UART_RING_LEN CONFIG_UARTCOMM_RX_RING_LEN
+#else
+#define UART_RING_LEN 256U   /**< Capacidade em bytes (potência de 2) */
+#endif
+
+/**
+ * @brief Buffer circular de receção
+ */
+typedef struct {
+    volatile uint32_t head;      /* Bytes escritos (só a ISR altera) */
+    volatile uint32_t tail;      /* Bytes lidos (só a thread altera) */
+    volatile uint32_t dropped;   /* Bytes descartados por falta de espaço */
+    uint8_t           buf[UART_RING_LEN];
+} uart_ring_t;
+
+/**
+ * @brief Copia até len bytes de data para o buffer (lado do produtor)
+ *
+ * @return Número de bytes copiados; os restantes são contados em dropped
+ */
+size_t uart_ring_put(uart_ring_t *r, const uint8_t *data, size_t len);
+
+/**
+ * @brief Retira até max bytes do buffer para out (lado do consumidor)
+ *
+ * @return Número de bytes retirados (0 se o buffer está vazio)
+ */
+size_t uart_ring_get(uart_ring_t *r, uint8_t *out, size_t max);
+
+#endif /* UART_RING_H */
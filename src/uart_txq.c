@@ -0,0 +1,82 @@
+/**
+ * @file uart_txq.c
+ * @brief Fila de envio da UART e política com os blocos esgotados (ver uart_txq.h)
+ */
+
+ #include "uart_txq.h"
+ 
+ /** Posição do i-ésimo frame a contar da cabeça */
+ #define UART_TXQ_SLOT(q, i) (((q)->tail + (i)) % UART_TXQ_LEN)
+ 
+ bool uart_txq_push(uart_txq_t *q, uint8_t *buf, size_t len, bool tlm)
+ {
+     uart_txq_ent_t *e = &q->q[UART_TXQ_SLOT(q, q->count)];
+ 
+     e->buf = buf;
+     e->len = len;
+     e->tlm = tlm;
+     q->count++;
+     if (q->count > q->hwm) {
+         q->hwm = q->count;
+     }
+     return q->count == 1U;
+ }
+ 
+ const uart_txq_ent_t *uart_txq_head(const uart_txq_t *q)
+ {
+     return (q->count == 0U) ? NULL : &q->q[q->tail];
+ }
+ 
+ uint8_t *uart_txq_pop(uart_txq_t *q)
+ {
+     uint8_t *buf;
+ 
+     if (q->count == 0U) {
+         return NULL;
+     }
+     buf = q->q[q->tail].buf;
+     q->tail = (q->tail + 1U) % UART_TXQ_LEN;
+     q->count--;
+     return buf;
+ }
+ 
+ uint8_t *uart_txq_evict(uart_txq_t *q)
+ {
+     /* A cabeça (i = 0) pode já estar a sair: só os frames atrás dela */
+     for (uint32_t i = 1U; i < q->count; i++) {
+         uint32_t slot = UART_TXQ_SLOT(q, i);
+         uint8_t *victim = q->q[slot].buf;
+ 
+         if (!q->q[slot].tlm) {
+             continue;
+         }
+         /* Os frames seguintes avançam uma posição: a ordem de envio mantém-se */
+         for (uint32_t j = i + 1U; j < q->count; j++) {
+             uint32_t next = UART_TXQ_SLOT(q, j);
+             q->q[slot] = q->q[next];
+             slot = next;
+         }
+         q->count--;
+         q->evicted++;
+         return victim;
+     }
+     return NULL;
+ }
+ 
+ uint8_t *uart_txq_make_room(uart_txq_t *q, bool tlm, bool drop_oldest)
+ {
+     uint8_t *blk = NULL;
+ 
+     if (!tlm || drop_oldest) {
+         blk = uart_txq_evict(q);
+     }
+     if ((blk == NULL) && tlm) {
+         q->dropped++;
+     }
+     return blk;
+ }
+ 
+ void uart_txq_reset_hwm(uart_txq_t *q)
+ {
+     q->hwm = q->count;
+ }
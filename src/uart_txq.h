@@ -0,0 +1,100 @@
+#ifndef UART_TXQ_H
+#define UART_TXQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file uart_txq.h
+ * @brief Fila de frames por enviar pela UART e política com os blocos esgotados
+ *
+ * @details
+ *   Os frames são montados em blocos de um pool (k_mem_slab em uartcomm.c) e
+ *   postos nesta fila pela ordem de envio. A cabeça é o frame que está a sair (o
+ *   callback de uart_tx() ou a ISR tira-a no fim); como há tantas posições como
+ *   blocos, a fila nunca enche.
+ *
+ *   Sem blocos livres, uart_txq_make_room() decide: uma resposta ou ACK tira da
+ *   fila o frame de telemetria mais antigo que ainda não começou a sair e fica com
+ *   o seu bloco, ou, se não houver, espera (nunca é descartada). A telemetria nova
+ *   faz o mesmo com drop_oldest; sem ele, ou sem telemetria em fila, é descartada.
+ *
+ *   A fila não tem lock próprio: quem a usa serializa todas as chamadas (em
+ *   uartcomm.c, uart_tx_lock), incluindo a leitura dos contadores. Não depende do
+ *   Zephyr (é testado no host).
+ */
+
+#if defined(CONFIG_UARTCOMM_TX_BUFS)
+#define UART_TXQ_LEN CONFIG_UARTCOMM_TX_BUFS
+#else
+#define UART_TXQ_LEN 8U   /**< Posições da fila (= blocos do pool) */
+#endif
+
+/**
+ * @brief Frame em fila
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t   len;
+    bool     tlm;   /* Telemetria: pode sair da fila antes de ser enviada */
+} uart_txq_ent_t;
+
+/**
+ * @brief Fila de envio: q[tail] é o frame em envio (se count > 0)
+ */
+typedef struct {
+    uart_txq_ent_t q[UART_TXQ_LEN];
+    uint32_t tail;
+    uint32_t count;
+    uint32_t hwm;       /* Maior count desde o arranque ou uart_txq_reset_hwm() */
+    uint32_t dropped;   /* Frames descartados (telemetria sem bloco ou erro do driver) */
+    uint32_t evicted;   /* Frames de telemetria tirados da fila para dar o bloco a outro */
+} uart_txq_t;
+
+/**
+ * @brief Põe o frame buf (len bytes) no fim da fila
+ *
+ * @return true se a fila estava vazia (o envio tem de ser arrancado)
+ */
+bool uart_txq_push(uart_txq_t *q, uint8_t *buf, size_t len, bool tlm);
+
+/**
+ * @brief Frame à cabeça da fila (o que está a sair), ou NULL com a fila vazia
+ */
+const uart_txq_ent_t *uart_txq_head(const uart_txq_t *q);
+
+/**
+ * @brief Tira a cabeça da fila (fim do envio)
+ *
+ * @return Bloco a libertar, ou NULL com a fila vazia
+ */
+uint8_t *uart_txq_pop(uart_txq_t *q);
+
+/**
+ * @brief Tira da fila o frame de telemetria mais antigo atrás da cabeça
+ *
+ * A cabeça nunca é tirada: pode já estar a sair. Conta em evicted.
+ *
+ * @return Bloco do frame tirado, ou NULL se não há telemetria por enviar
+ */
+uint8_t *uart_txq_evict(uart_txq_t *q);
+
+/**
+ * @brief Aplica a política de excesso a um frame novo que não encontrou bloco livre
+ *
+ * @param tlm          O frame novo é telemetria
+ * @param drop_oldest  A telemetria nova pode tirar da fila a mais antiga
+ *                     (CONFIG_UARTCOMM_TX_OVERFLOW_DROP_OLDEST)
+ * @return Bloco tirado a um frame de telemetria em fila, que passa para o frame
+ *         novo; ou NULL: telemetria descartada (contada em dropped), ou uma
+ *         resposta que tem de esperar por um bloco
+ */
+uint8_t *uart_txq_make_room(uart_txq_t *q, bool tlm, bool drop_oldest);
+
+/**
+ * @brief Recomeça o máximo de ocupação a partir da ocupação atual (#Q0!)
+ */
+void uart_txq_reset_hwm(uart_txq_t *q);
+
+#endif /* UART_TXQ_H */
@@ -3,8 +3,32 @@
  * @brief Módulo de comunicação UART: parser de frames e framing
  *
  * @details
- *   - Usa polling da UART (uart_poll_in/uart_poll_out) para receber bytes.
- *   - Implementa framing: “# <CMD> <DATA ASCII> <CS(3 dígitos)> !”
+ *   - Com CONFIG_UART_ASYNC_API usa a API assíncrona (DMA) nos dois sentidos:
+ *       • receção: os blocos recebidos vão para um buffer circular sem lock
+ *         (uart_ring.h) e acordam uart_task() com um semáforo;
+ *       • envio: o callback de fim de envio liberta o bloco e arranca o uart_tx()
+ *         do frame seguinte.
+ *   - Sem a API assíncrona (p.ex. native_sim com CONFIG_UART_INTERRUPT_DRIVEN), a
+ *     ISR esvazia a FIFO para o mesmo buffer circular e enche a FIFO de envio com
+ *     os frames em fila.
+ *   - Nos dois casos cada frame é montado num bloco de um k_mem_slab e posto numa
+ *     fila limitada (CONFIG_UARTCOMM_TX_BUFS): send_frame() retorna logo e
+ *     uart_task() volta a ler bytes enquanto a resposta sai. Com a fila cheia as
+ *     respostas e ACKs esperam (tirando da fila telemetria ainda por enviar) e a
+ *     telemetria é descartada conforme CONFIG_UARTCOMM_TX_OVERFLOW_*; #Q lê a
+ *     ocupação máxima da fila.
+ *   - Implementa framing: “# <CMD> <DATA ASCII> <CS(3 dígitos)> !”, validado byte a
+ *     byte por um parser incremental (uart_parser.h)
+ *   - Modo binário negociado com #N1!: frames COBS com CRC-16 e campos numéricos em
+ *     little-endian de largura fixa (uart_bin.h), com os mesmos comandos. Os handlers
+ *     leem e escrevem DATA com in_*()/out_*(), que seguem o modo do frame recebido
+ *   - Etiqueta de sequência opcional nos pedidos (#@sss<CMD>…!, uart_parser.h): todas
+ *     as respostas a um pedido etiquetado levam a mesma etiqueta, incluindo os ACK
+ *     ('s' também), e a telemetria nunca leva. O anfitrião pode assim manter uma
+ *     janela de pedidos em curso em vez de esperar por cada resposta; os pedidos
+ *     são tratados por ordem. A janela tem de caber no buffer circular de receção
+ *     (UART_RING_LEN bytes) e, para que uart_task() não pare à espera de blocos de
+ *     envio, não deve passar das posições da fila de envio (devolvidas por #Q!)
  *   - Verifica framing e checksum. Envia acknowledgment via send_ack() ou resposta de consulta.
  *   - Suporta os seguintes comandos:
  *       • #MxxxYYY! → set max_temp (3 dígitos); envia ACK 'o' ou 'i'
@@ -14,6 +38,20 @@
  *       • #r!       → get sampling_rate; envia #sXXXXYYY!
  *       • #E0!/#E1! → liga/desliga sistema; envia ACK 'o' ou 'i'
  *       • #S…!      → set parâmetros do controlador (stub); envia ACK 'o' ou 'i'
+ *       • #T!/#Tz!  → estatísticas de current_temp (mín./máx./média/variância/bandas)
+ *       • #Z!       → recomeça as estatísticas de current_temp
+ *       • #Q!/#Q0!  → ocupação da fila de envio (máximo, descartados) / recomeça o máximo
+ *       • #L…!      → estatísticas de contenção dos locks da RTDB, por domínio
+ *                     ('c' configuração, 'm' medição; CONFIG_RTDB_LOCK_STATS)
+ *       • #J…!      → leitura do diário de escritas da RTDB (CONFIG_RTDB_JOURNAL)
+ *       • #P…!      → perfis de configuração (guardar, editar, consultar, ativar)
+ *       • #B!       → repõe a configuração anterior à última ativação de perfil
+ *       • #N1!/N0   → passa ao modo binário / volta ao modo ASCII; ACK 'o' no modo antigo
+ *       • #K…!      → lote de sub-comandos executados por ordem; uma só resposta 'k'
+ *       • #Uddd!/#u! → subscreve a telemetria (uma amostra em cada ddd) / cancela;
+ *                     o firmware envia #v…! por cada amostra (CONFIG_UARTCOMM_TELEMETRY)
+ *       • #H…!      → janela do histórico de temperatura em chunks comprimidos com
+ *                     LZ4 e numerados (CONFIG_UARTCOMM_HIST_DUMP)
  *
  *   - Erros:
  *       • framing error → ACK com código 'f'
@@ -23,17 +61,77 @@
 
  #include "uartcomm.h"
  #include "rtdb.h"
+ #include "uart_ring.h"
+ #include "uart_parser.h"
+ #include "uart_bin.h"
+ #include "uart_txq.h"
+ #if defined(CONFIG_UARTCOMM_HIST_DUMP)
+ #include "uart_hist.h"
+ #include <lz4.h>
+ #endif
  #include <zephyr/kernel.h>
  #include <zephyr/device.h>
  #include <zephyr/drivers/uart.h>
  #include <zephyr/sys/printk.h>
- #include <stdlib.h>
  #include <stddef.h>
  #include <stdint.h>
  
  #define UART_STACK_SIZE 1024U  
  #define UART_PRIORITY   5U     /**< Prioridade da thread UART */
- #define UART_BUF_SIZE   64U    /**< Tamanho do buffer de receção de bytes */
+ #define UART_BUF_SIZE   64U    /**< DATA máxima de um frame enviado */
+ #define UART_RX_CHUNK   16U    /**< Bytes copiados de cada vez entre FIFO, buffer circular e parser */
+ /** '#' + '@' + seq + CMD + DATA + CS + '!' */
+ #define UART_FRAME_MAX  (1U + 1U + UART_SEQ_DIGITS + 1U + UART_BUF_SIZE + 3U + 1U)
+ #define UART_JOURNAL_PER_FRAME 2U  /**< Entradas do diário por resposta 'j' (8 + 2 × 28 = 64 carateres) */
+ #define UART_JOURNAL_PER_BIN_FRAME 4U  /**< O mesmo em binário (4 + 4 × 14 = 60 bytes) */
+ #define UART_TLM_STACK_SIZE 768U
+ #define UART_TLM_PRIORITY   6U     /**< Abaixo do sensor e da thread UART: é a telemetria que cede */
+ #define UART_TLM_DECIM_MAX  999U   /**< Maior decimação de #U (3 dígitos) */
+ 
+ _Static_assert(UART_BIN_FRAME_SEQ_MAX(UART_BUF_SIZE) <= UART_FRAME_MAX,
+                "um frame binário tem de caber num bloco de envio");
+ 
+ /**
+  * @brief DATA de uma resposta em montagem
+  *
+  * Os campos numéricos são escritos em decimal ASCII ou, se a resposta segue em
+  * binário, em little-endian de largura fixa; por isso os out_*() recebem as duas
+  * larguras.
+  */
+ typedef struct {
+     char   buf[UART_BUF_SIZE];
+     size_t pos;
+     bool   bin;
+ } uart_out_t;
+ 
+ /**
+  * @brief Leitura sequencial dos campos de DATA de um frame recebido (ASCII ou binário)
+  */
+ typedef struct {
+     const uart_frame_t *f;
+     size_t pos;
+     bool   ok;     /* false depois de um campo em falta ou inválido */
+ } uart_in_t;
+ 
+ /** Modo do protocolo: 0 = ASCII, 1 = binário (só handle_mode() altera) */
+ static atomic_t uart_bin_mode;
+ 
+ /** Etiqueta das respostas ao pedido em tratamento, ou UART_SEQ_NONE (só a thread da UART) */
+ static int uart_reply_seq = UART_SEQ_NONE;
+ 
+ /**
+  * @brief Lote (#K) em execução
+  *
+  * Enquanto on, os frames que os handlers enviam na thread da UART são acrescentados
+  * a o em vez de seguirem para a linha, e as leituras de C e r vêm de snap. Só a
+  * thread da UART lhe toca; é estático para não pesar na pilha.
+  */
+ static struct {
+     bool       on;
+     bool       full;    /* A última resposta não coube em o */
+     uart_out_t o;       /* DATA da resposta 'k' */
+     rtdb_t     snap;    /* Cópia da RTDB lida pelos sub-comandos */
+ } uart_batch;
  
  /**
   * @brief Calcula checksum (módulo-256) sobre os len primeiros bytes de buf
@@ -45,17 +143,70 @@
  static uint8_t calculate_checksum(const uint8_t *buf, size_t len);
  
  /**
-  * @brief Envia raw bytes pela UART usando polling
+  * @brief Reserva um bloco do pool de envio para montar um frame
+  *
+  * Sem blocos livres (todos em fila ou em envio), aplica uart_txq_make_room(): o
+  * frame de telemetria mais antigo ainda por enviar cede o seu bloco, sempre a uma
+  * resposta e a telemetria só com CONFIG_UARTCOMM_TX_OVERFLOW_DROP_OLDEST. Se não
+  * houver nenhum, uma resposta espera por um bloco (nunca é descartada) e a
+  * telemetria é descartada e contada.
+  *
+  * @param tlm  O frame é telemetria (descartável)
+  * @return Bloco de UART_TX_BLOCK bytes, ou NULL (só com tlm)
+  */
+ static uint8_t *uart_tx_alloc(bool tlm);
+ 
+ /**
+  * @brief Devolve ao pool o bloco de um frame enviado ou descartado (também em ISR)
+  *
+  * Se o dump do #H parou à espera de um bloco livre, acorda uart_task() para enviar
+  * o chunk seguinte.
+  */
+ static void uart_tx_free(uint8_t *buf);
+ 
+ /**
+  * @brief Põe um frame (bloco de uart_tx_alloc()) na fila de envio e retorna logo
+  *
+  * Se a UART estiver parada arranca já o envio; senão o frame segue quando o
+  * anterior terminar. O bloco é libertado no callback/ISR, no fim do envio.
+  *
+  * @param dev   Dispositivo UART
+  * @param buf   Bloco com o frame
+  * @param len   Bytes do frame
+  * @param tlm   O frame é telemetria (pode ser tirado da fila por uart_txq_evict())
+  */
+ static void uart_tx_submit(const struct device *dev, uint8_t *buf, size_t len, bool tlm);
+ 
+ #if defined(CONFIG_UART_ASYNC_API)
+ /**
+  * @brief Callback da API assíncrona (contexto de ISR)
+  *
+  *   - UART_TX_DONE/UART_TX_ABORTED → liberta o bloco enviado e arranca o seguinte
+  *   - UART_RX_RDY                  → copia os bytes para uart_rx_ring e acorda uart_task()
+  *   - UART_RX_BUF_REQUEST          → entrega o outro buffer de receção (double buffering)
+  *   - UART_RX_DISABLED             → volta a ligar a receção
+  *
+  * @param dev        Dispositivo UART
+  * @param evt        Evento
+  * @param user_data  Não utilizado
+  */
+ static void uart_async_cb(const struct device *dev, struct uart_event *evt, void *user_data);
+ #else
+ /**
+  * @brief Enche a FIFO de envio com os frames em fila (contexto de ISR)
+  *
+  * Continua o frame à cabeça da fila onde a FIFO o deixou; no fim de cada frame
+  * liberta o bloco. Com a fila vazia desliga a interrupção de envio.
   *
   * @param dev   Dispositivo UART
-  * @param data  Ponteiro para array de bytes
-  * @param len   Número de bytes a enviar
   */
- static void send_bytes(const struct device *dev, const uint8_t *data, size_t len);
+ static void uart_tx_fill(const struct device *dev);
+ #endif
  
  /**
   * @brief Constroi e envia um frame pela UART:
-  *        # <cmd> <data ASCII> <CS(3 dígitos)> !
+  *        # <cmd> <data ASCII> <CS(3 dígitos)> ! ou, no modo binário,
+  *        0x00 COBS(<cmd> <data> <CRC-16>) 0x00
   *
   * @param dev       Dispositivo UART
   * @param cmd       Carácter de comando (e.g. 'E', 'c', 'M', 'm', etc.)
@@ -64,6 +215,23 @@
   */
  static void send_frame(const struct device *dev, char cmd, const char *data, size_t data_len);
  
+ /**
+  * @brief Põe um frame na fila de envio (send_frame() sem o desvio para o lote)
+  *
+  * @param seq  Etiqueta do pedido a que responde (0..255), ou UART_SEQ_NONE
+  * @param tlm  Telemetria: descartável se a fila estiver cheia (uart_tx_alloc())
+  * @return false se o frame foi descartado
+  */
+ static bool send_frame_tx(const struct device *dev, int seq, char cmd, const char *data,
+                           size_t data_len, bool tlm);
+ 
+ /**
+  * @brief Acrescenta à resposta do lote o frame que um sub-comando enviaria
+  *
+  * Como <len><cmd><data>, com len = 1 + data_len; se não couber marca uart_batch.full.
+  */
+ static void uart_batch_put(char cmd, const char *data, size_t data_len);
+ 
  /**
   * @brief Envia um ACK simples pela UART: #E<code>!
   *
@@ -73,14 +241,352 @@
  static void send_ack(const struct device *dev, char code);
  
  /**
-  * @brief Trata um frame completo recebido em buf[0..len-1], onde buf[0]=='#' e buf[len-1]=='!'
+  * @brief Converte o resultado de rtdb_update() no código de ACK do protocolo
+  *
+  * @param st  Resultado da atualização da RTDB
+  * @return    'o' se aplicada, 'i' se rejeitada
+  */
+ static char status_to_ack(rtdb_status_t st);
+ 
+ /**
+  * @brief Escreve v em out com digits dígitos decimais (satura em 10^digits − 1)
+  */
+ static void put_dec(char *out, uint32_t v, size_t digits);
+ 
+ /**
+  * @brief Escreve v em out como sinal ('+'/'-') seguido de digits dígitos (saturados)
+  */
+ static void put_sdec(char *out, int32_t v, size_t digits);
+ 
+ /**
+  * @brief Começa uma resposta ao frame f, no modo (ASCII/binário) em que f chegou
+  */
+ static void out_init(uart_out_t *o, const uart_frame_t *f);
+ 
+ /**
+  * @brief Acrescenta um campo sem sinal: digits dígitos decimais (saturados) em ASCII,
+  *        os bytes bytes menos significativos de v em binário
+  */
+ static void out_u(uart_out_t *o, uint32_t v, size_t digits, size_t bytes);
+ 
+ /**
+  * @brief Acrescenta um campo com sinal: '+'/'-' e digits dígitos em ASCII, bytes
+  *        bytes em complemento para dois (saturado) em binário
+  */
+ static void out_s(uart_out_t *o, int32_t v, size_t digits, size_t bytes);
+ 
+ /**
+  * @brief Acrescenta um byte tal como está (letras de subcomando, nomes)
+  */
+ static void out_c(uart_out_t *o, char c);
+ 
+ /**
+  * @brief Envia a resposta o com o comando cmd
+  */
+ static void send_out(const struct device *dev, char cmd, const uart_out_t *o);
+ 
+ /**
+  * @brief Começa a ler os campos de DATA do frame f
+  */
+ static void in_init(uart_in_t *in, const uart_frame_t *f);
+ 
+ /**
+  * @brief Lê um campo sem sinal: digits dígitos decimais em ASCII, bytes bytes
+  *        little-endian em binário (campo em falta ou inválido → in->ok = false)
+  */
+ static uint32_t in_u(uart_in_t *in, size_t digits, size_t bytes);
+ 
+ /**
+  * @brief Lê um campo com sinal: '+'/'-' e digits dígitos em ASCII, bytes bytes
+  *        little-endian em complemento para dois em binário (o inverso de out_s())
+  */
+ static int32_t in_s(uart_in_t *in, size_t digits, size_t bytes);
+ 
+ /**
+  * @brief Lê um byte tal como está (campo em falta → in->ok = false)
+  */
+ static char in_c(uart_in_t *in);
+ 
+ /**
+  * @brief true se todos os campos lidos eram válidos e DATA acabou
+  */
+ static bool in_end(const uart_in_t *in);
+ 
+ /**
+  * @brief Trata o comando T (estatísticas de current_temp de uma zona)
+  *
+  *   - #T! / #Tz! → #t<z><n(6)><min(±3)><max(±3)><média(±5)><variância(6)><7 × tempo(5)>
+  *
+  *  Média em centésimas de °C, variância amostral em centésimas de °C², tempo em
+  *  segundos passado em cada banda de 1 °C do erro temp − setpoint, de ≤ −3 a ≥ +3
+  *  (rtdb_stats.h). Sem dígito de zona usa a zona 0; zona inexistente → ACK 'i'.
+  *
+  * @param dev       Dispositivo UART
+  * @param f         Frame recebido (DATA em f->data, f->data_len)
+  */
+ static void handle_temp_stats(const struct device *dev, const uart_frame_t *f);
+ 
+ /**
+  * @brief Trata o comando Q (fila de envio)
+  *
+  *   - #Q!  → #q<posições(2)><em fila(2)><máximo(2)><descartados(5)><retirados(5)>
+  *   - #Q0! → recomeça o máximo a partir da ocupação atual; ACK 'o'
+  *
+  *  máximo é a maior ocupação da fila desde o arranque ou o último #Q0! (a resposta
+  *  ocupa uma posição); descartados conta os frames de telemetria sem bloco livre e
+  *  os que o driver recusou, retirados os de telemetria tirados da fila para dar
+  *  lugar a uma resposta (ambos desde o arranque). Em binário 1 + 1 + 1 + 4 + 4.
+  *
+  * @param dev       Dispositivo UART
+  * @param f         Frame recebido (DATA em f->data, f->data_len)
+  */
+ static void handle_tx_stats(const struct device *dev, const uart_frame_t *f);
+ 
+ /**
+  * @brief Trata o comando P (perfis de configuração)
+  *
+  *   - #P!                              → #p<ativo ou '-'><RTDB_MAX_PROFILES × '0'/'1' (definido)>
+  *   - #P<n>!                           → ativa o perfil n; ACK 'o'/'i'
+  *   - #Ps<n><nome>!                    → guarda a configuração atual como perfil n (nome
+  *                                        até RTDB_PROFILE_NAME_LEN carateres); ACK 'o'/'i'
+  *   - #Pd<n><z><sp(±3)><max(±3)><min(±3)><rate(4)>! → redefine a zona z e o período
+  *                                        de amostragem do perfil n, validados; ACK 'o'/'i'
+  *   - #Pq<n><z>!                       → #p<n><z><sp(±3)><max(±3)><min(±3)><rate(4)><nome>
+  *
+  *  Editar um perfil não altera a configuração em uso; só #P<n>! a troca, de uma vez.
+  *
+  * @param dev       Dispositivo UART
+  * @param f         Frame recebido (DATA em f->data, f->data_len)
+  */
+ static void handle_profile(const struct device *dev, const uart_frame_t *f);
+ 
+ #if defined(CONFIG_RTDB_LOCK_STATS)
+ /**
+  * @brief Trata o comando L (estatísticas de contenção dos locks da RTDB)
+  *
+  *  d = 'c' (domínio de configuração) ou 'm' (domínio de medição):
+  *   - #L!     → #l<Nc><Nm>: número de threads com estatísticas em cada domínio
+  *   - #Ldn!   → #l<d><n><count(5)><wait_max_us(5)><hold_max_us(5)><nome da thread>
+  *   - #Ldnw!  → #l<d><n>w<12 × 4 dígitos>: histograma do tempo de espera
+  *   - #Ldnh!  → #l<d><n>h<12 × 4 dígitos>: histograma do tempo de posse
+  *   - #Lz!    → apaga as estatísticas; ACK 'o'
+  *
+  *  Bucket 0 conta < 64 ciclos, o bucket b conta [2^(b+5), 2^(b+6)) ciclos e o último
+  *  tudo o que exceder (rtdb_lockstat.h). Entrada inexistente → ACK 'i'.
+  *
+  * @param dev       Dispositivo UART
+  * @param f         Frame recebido (DATA em f->data, f->data_len)
+  */
+ static void handle_lock_stats(const struct device *dev, const uart_frame_t *f);
+ #endif
+ 
+ #if defined(CONFIG_RTDB_JOURNAL)
+ /**
+  * @brief Trata o comando J (diário de escritas da RTDB)
+  *
+  *   - #J!           → #j<head(8)><oldest(8)>: entradas disponíveis em [oldest, head)
+  *   - #J<idx(8)>!   → #j<i(8)><até UART_JOURNAL_PER_FRAME entradas de RTDB_JOURNAL_HEX_LEN>
+  *
+  *  Índices em hexadecimal. i é o índice da primeira entrada devolvida (≥ idx se as
+  *  anteriores já foram reescritas); as entradas seguintes são consecutivas. Sem
+  *  entradas: fim do diário (ou entrada ainda em escrita, a pedir de novo). O anfitrião
+  *  continua em i + número de entradas; tools/journal_replay.c lê estas respostas.
+  *
+  * @param dev       Dispositivo UART
+  * @param f         Frame recebido (DATA em f->data, f->data_len)
+  */
+ static void handle_journal(const struct device *dev, const uart_frame_t *f);
+ #endif
+ 
+ #if defined(CONFIG_UARTCOMM_HIST_DUMP)
+ /**
+  * @brief Trata o comando H (histórico de temperatura de uma janela)
+  *
+  *   - #H<z><t_from(10)><t_to(10)>!          → #h<seq(5)><t0(10)><n(3)><LZ4 em hexadecimal>…
+  *   - #H<z><t_from(10)><t_to(10)><skip(5)>! → o mesmo, sem as skip primeiras amostras
+  *
+  *  Envia um frame 'h' por chunk (uart_hist.h) com as amostras da zona z em
+  *  [t_from, t_to] (uptime em ms), e no fim um chunk com n = 0 e seq = número de
+  *  chunks. Em binário os campos ocupam 1 + 4 + 4 (+ 2) bytes no pedido e 2 + 4 + 1
+  *  na resposta, seguidos dos bytes LZ4. Se faltar um seq, o anfitrião pede a mesma
+  *  janela com skip = soma dos n recebidos até ao chunk em falta; a numeração
+  *  recomeça em 0 e o t0 do primeiro chunk confirma que a sequência continua. Zona
+  *  inexistente ou campos inválidos → ACK 'i'.
+  *
+  *  Aqui só se prepara o dump: os chunks seguem um a um em uart_hist_pump(), entre os
+  *  pedidos seguintes, que continuam a ser atendidos. Um #H novo substitui o dump em
+  *  curso; mudar de modo (#N) cancela-o.
+  *
+  * @param dev       Dispositivo UART
+  * @param f         Frame recebido (DATA em f->data, f->data_len)
+  */
+ static void handle_history(const struct device *dev, const uart_frame_t *f);
+ 
+ /**
+  * @brief true se há um dump do #H em curso e um bloco de envio livre para o chunk
+  *        seguinte (uart_task() não deve então dormir)
+  *
+  * Sem bloco livre marca a espera: o próximo uart_tx_free() acorda uart_task().
+  */
+ static bool uart_hist_ready(void);
+ 
+ /**
+  * @brief Envia o chunk seguinte do dump do #H em curso, se houver um bloco livre
+  *
+  * Chamada por uart_task() uma vez por passagem, depois de consumir os bytes
+  * recebidos: um dump longo nunca atrasa os outros pedidos mais do que um chunk.
+  *
+  * @param dev       Dispositivo UART
+  */
+ static void uart_hist_pump(const struct device *dev);
+ #endif
+ 
+ /** @brief #MxxxYYY! → set max_temp (3 dígitos); ACK 'o'/'i' */
+ static void handle_set_max_temp(const struct device *dev, const uart_frame_t *f);
+ 
+ /** @brief #mxxxYYY! → set min_temp (3 dígitos); ACK 'o'/'i' */
+ static void handle_set_min_temp(const struct device *dev, const uart_frame_t *f);
+ 
+ /** @brief #C! → #cXXXYYY! com current_temp (zona 0, limitada a 0..999) */
+ static void handle_get_current_temp(const struct device *dev, const uart_frame_t *f);
+ 
+ /** @brief #RxxxxYYY! → set sampling_rate (10..9999 ms); ACK 'o'/'i' */
+ static void handle_set_sampling_rate(const struct device *dev, const uart_frame_t *f);
+ 
+ /** @brief #r! → #sXXXXYYY! com sampling_rate */
+ static void handle_get_sampling_rate(const struct device *dev, const uart_frame_t *f);
+ 
+ /** @brief #E0! liga / #E1! desliga o sistema; ACK 'o'/'i' */
+ static void handle_system_on(const struct device *dev, const uart_frame_t *f);
+ 
+ /** @brief #S…! → parâmetros do controlador (stub); ACK 'o'/'i' */
+ static void handle_ctrl_params(const struct device *dev, const uart_frame_t *f);
+ 
+ /** @brief #Z! → recomeça as estatísticas de current_temp; ACK 'o' */
+ static void handle_stats_reset(const struct device *dev, const uart_frame_t *f);
+ 
+ /** @brief #B! → rollback da última ativação de perfil; ACK 'o'/'i' */
+ static void handle_rollback(const struct device *dev, const uart_frame_t *f);
+ 
+ /**
+  * @brief #N1! → modo binário; N0 (já em binário) → modo ASCII
+  *
+  * O ACK 'o' segue ainda no modo em que o pedido chegou; os bytes recebidos a seguir
+  * já são lidos no modo novo.
+  */
+ static void handle_mode(const struct device *dev, const uart_frame_t *f);
+ 
+ /**
+  * @brief Trata o comando K (lote de sub-comandos)
+  *
+  *   - #K<len(2)><CMD><DATA>…!  → #k<n(2)><len(2)><CMD><DATA>…
+  *
+  *  Cada sub-comando é um frame sem '#', checksum e '!' (o checksum do lote cobre-os),
+  *  precedido do seu comprimento (1 + DATA; em binário len e n ocupam um byte). Os
+  *  sub-comandos são executados por ordem e a resposta de cada um (frame de dados
+  *  ou ACK 'E', com o seu estado) segue na mesma ordem dentro de uma só resposta
+  *  'k': um sub-comando inválido dá 'Ei' no seu lugar e os seguintes correm na mesma.
+  *
+  *  As leituras (C, r) vêm de uma só cópia da RTDB tirada no início do lote, refeita
+  *  só depois de uma escrita aceite ('Eo') para que os sub-comandos seguintes a vejam.
+  *  K, N e H dentro de um lote são inválidos. Lote mal formado → ACK 'i' sem executar
+  *  nada. Se a resposta de um sub-comando já não couber em 'k', o lote pára antes
+  *  dele: n diz quantos foram executados e o anfitrião reenvia os restantes.
+  *
+  * @param dev       Dispositivo UART
+  * @param f         Frame recebido (DATA em f->data, f->data_len)
+  */
+ static void handle_batch(const struct device *dev, const uart_frame_t *f);
+ 
+ #if defined(CONFIG_UARTCOMM_TELEMETRY)
+ /**
+  * @brief Trata o comando U (subscrição de telemetria)
+  *
+  *   - #U<d(3)>!  → ACK 'o'; a partir daí, por cada d-ésima amostra de current_temp da
+  *                  zona 0, o firmware envia sem pedido
+  *                  #v<t(10)><temp(±3)><setpoint(±3)><heater(1)><perdidos(5)>
+  *
+  *  t é o uptime da amostra (ms); setpoint e heater são os do momento do envio.
+  *  perdidos conta, desde a subscrição, os frames 'v' devidos que não seguiram
+  *  (amostras reescritas no histórico antes de lidas, ou sem bloco de envio livre).
+  *  Em binário d ocupa 2 bytes e a resposta 4 + 2 + 2 + 1 + 4. d = 1 envia todas as
+  *  amostras; d = 0 ou acima de UART_TLM_DECIM_MAX → ACK 'i'. Uma subscrição nova
+  *  substitui a anterior e recomeça a contagem.
+  *
+  * @param dev       Dispositivo UART
+  * @param f         Frame recebido (DATA em f->data, f->data_len)
+  */
+ static void handle_telemetry_on(const struct device *dev, const uart_frame_t *f);
+ 
+ /** @brief #u! → cancela a subscrição de telemetria; ACK 'o' */
+ static void handle_telemetry_off(const struct device *dev, const uart_frame_t *f);
+ 
+ /**
+  * @brief Thread da telemetria: envia os frames 'v' da subscrição feita com #U
+  *
+  *   - Acorda com cada amostra (subscrição de RTDB_F_SAMPLE) e lê as amostras novas
+  *     do histórico (rtdb_history_follow_zone()): o sensor nunca espera por ela
+  *   - Põe cada frame na fila de envio sem esperar (send_frame_tx() com tlm); com o
+  *     anfitrião ou a linha lentos, os frames que não cabem, ou que uma resposta
+  *     tira da fila (uart_txq_evict()), são descartados e contados
+  *
+  * @param p1  Não utilizado
+  * @param p2  Não utilizado
+  * @param p3  Não utilizado
+  */
+ static void uart_tlm_task(void *p1, void *p2, void *p3);
+ #endif
+ 
+ /**
+  * @brief Handlers dos comandos do protocolo, ligados à tabela de uart_cmd.h
+  *
+  * Os comprimentos de DATA de cada comando estão na tabela (partilhada com os
+  * testes no host); aqui só se diz quem trata cada um.
+  */
+ static const struct {
+     char               cmd;
+     uart_cmd_handler_t handler;
+ } uart_cmd_handlers[] = {
+     { 'M', handle_set_max_temp },
+     { 'm', handle_set_min_temp },
+     { 'C', handle_get_current_temp },
+     { 'R', handle_set_sampling_rate },
+     { 'r', handle_get_sampling_rate },
+     { 'E', handle_system_on },
+     { 'S', handle_ctrl_params },
+     { 'T', handle_temp_stats },
+     { 'Q', handle_tx_stats },
+     { 'Z', handle_stats_reset },
+     { 'P', handle_profile },
+     { 'B', handle_rollback },
+     { 'N', handle_mode },
+     { 'K', handle_batch },
+ #if defined(CONFIG_UARTCOMM_HIST_DUMP)
+     { 'H', handle_history },
+ #endif
+ #if defined(CONFIG_UARTCOMM_TELEMETRY)
+     { 'U', handle_telemetry_on },
+     { 'u', handle_telemetry_off },
+ #endif
+ #if defined(CONFIG_RTDB_LOCK_STATS)
+     { 'L', handle_lock_stats },
+ #endif
+ #if defined(CONFIG_RTDB_JOURNAL)
+     { 'J', handle_journal },
+ #endif
+ };
+ 
+ /**
+  * @brief Trata um frame completo já validado no framing e decomposto pelo parser
   *
-  *  - CMD = buf[1]
-  *  - DATA = buf[2..(2+data_len-1)]
-  *  - CS_str = buf[len-4..len-2] (3 dígitos ASCII)
-  *  - data_len = len - 6   (descarta '#', CMD, CS(3), '!')
+  *  - CMD = f->cmd, DATA = f->data[0..f->data_len-1]
+  *  - checksum calculado (f->sum) e recebido (f->cs) já prontos: o tratamento não
+  *    volta a percorrer o frame (nos frames binários o CRC já foi verificado)
+  *  - campos numéricos de DATA inteira já convertidos em f->num (f->num_ok)
+  *  - o handler e o comprimento de DATA esperado vêm da tabela de uart_cmd.h,
+  *    indexada por CMD: o custo não depende do número de comandos
   *
-  *  Suporta:
+  *  Suporta (mais os registados com uart_cmd_register()):
   *   - 'M': #MxxxYYY!  → set max_temp
   *   - 'm': #mxxxYYY!  → set min_temp
   *   - 'C': #C!        → consulta current_temp
@@ -88,6 +594,20 @@
   *   - 'r': #r!        → get sampling_rate (4 dígitos)
   *   - 'E': #E0!/#E1!  → liga/desliga sistema
   *   - 'S': #S…!       → set parâmetros do controlador (stub)
+  *   - 'T': #T!/#Tz!   → estatísticas de current_temp (zona z)
+  *   - 'Z': #Z!        → recomeça as estatísticas de current_temp
+  *   - 'Q': #Q!/#Q0!   → ocupação da fila de envio / recomeça o máximo
+  *   - 'P': #P…!       → perfis de configuração
+  *   - 'B': #B!        → rollback da última ativação de perfil
+  *   - 'N': #N1!/N0    → modo binário / ASCII
+  *   - 'K': #K…!       → lote de sub-comandos
+  *   - 'U': #Uddd!     → subscreve a telemetria (CONFIG_UARTCOMM_TELEMETRY)
+  *   - 'u': #u!        → cancela a telemetria (CONFIG_UARTCOMM_TELEMETRY)
+  *   - 'H': #H…!       → histórico de temperatura em chunks LZ4 (CONFIG_UARTCOMM_HIST_DUMP)
+  *   - 'L': #L…!       → contenção dos locks da RTDB (CONFIG_RTDB_LOCK_STATS)
+  *   - 'J': #J…!       → diário de escritas da RTDB (CONFIG_RTDB_JOURNAL)
+  *
+  *  As respostas levam a etiqueta de f (uart_reply_seq, posta por uart_task()).
   *
   *  Em caso de:
   *   - framing error → envia send_ack(dev, 'f')
@@ -97,24 +617,49 @@
   *  Se houver mais de um erro (p.ex. checksum e inválido), envia ambos: primeiro 's', depois 'i'.
   *
   * @param dev   Dispositivo UART
-  * @param buf   Buffer que contém o frame completo
-  * @param len   Comprimento do frame (bytes)
+  * @param f     Frame recebido
+  */
+ static void handle_command(const struct device *dev, const uart_frame_t *f);
+ 
+ /**
+  * @brief Chama o handler de f->cmd depois de verificar o comprimento de DATA
+  *
+  * Checksum já verificado (handle_command()) ou coberto pelo lote (handle_batch()).
+  * Comando inexistente ou comprimento errado → ACK 'i'.
+  */
+ static void dispatch(const struct device *dev, const uart_frame_t *f);
+ 
+ /**
+  * @brief Envia os ACK de erro correspondentes a r (nada com UART_CMD_DONE)
   */
- static void handle_command(const struct device *dev, const uint8_t *buf, size_t len);
+ static void send_cmd_result(const struct device *dev, uart_cmd_result_t r);
  
+ #if !defined(CONFIG_UART_ASYNC_API)
  /**
-  * @brief Thread de polling na UART que enquadra bytes recebidos e chama handle_command()
+  * @brief ISR da UART: copia os bytes recebidos para uart_rx_ring e acorda uart_task(),
+  *        e continua o envio dos frames em fila (uart_tx_fill())
   *
-  *   - Lê bytes um a um via uart_poll_in()
-  *   - Implementa máquina de estados simples:
-  *       1) Ignora CR/LF fora de frame
-  *       2) Se recebe '!' sem ter visto '#' primeiro → framing error
-  *       3) Se recebe '#' dentro de frame não fechado → framing error no frame anterior
-  *       4) Se '#' e idx==0 → começa novo frame
-  *       5) Enquanto idx>0, acumula bytes até encontrar '!' ou encher buffer
-  *       6) Se encher buffer sem '!' → framing error
+  * Lê a FIFO até esvaziar (vários bytes por interrupção em rajadas); se o buffer
+  * circular estiver cheio os bytes em excesso são descartados e contados.
   *
-  *   - Se encontra '!' dentro de frame, chama handle_command(uart_dev, buf, idx)
+  * @param dev        Dispositivo UART
+  * @param user_data  Não utilizado
+  */
+ static void uart_rx_isr(const struct device *dev, void *user_data);
+ #endif
+ 
+ /**
+  * @brief Thread da UART que enquadra bytes recebidos e chama handle_command()
+  *
+  *   - Bloqueia em uart_rx_sem até haver bytes novos (callback assíncrono ou ISR) e
+  *     consome-os do buffer circular em blocos de UART_RX_CHUNK
+  *   - Entrega cada byte ao parser incremental (uart_parser.h), que valida o
+  *     framing, soma o checksum e converte DATA à medida que os bytes chegam
+  *   - Frame completo → handle_command(); erro de framing → ACK 'f'
+  *   - Com um frame a meio, acorda ao fim de CONFIG_UARTCOMM_FRAME_TIMEOUT_MS sem
+  *     bytes novos e descarta-o (ACK 'f')
+  *   - Com um dump do #H em curso envia um chunk por passagem (uart_hist_pump()) e
+  *     só dorme enquanto não houver bloco de envio livre
   *
   * @param p1  Não utilizado
   * @param p2  Não utilizado
@@ -122,17 +667,75 @@
   */
  static void uart_task(void *p1, void *p2, void *p3);
  
+ /** Bytes recebidos pela ISR e ainda não consumidos por uart_task() */
+ static uart_ring_t uart_rx_ring;
+ 
+ /** Receptor do modo binário (fora da pilha de uart_task()) */
+ static uart_bin_rx_t uart_bin_rx;
+ K_SEM_DEFINE(uart_rx_sem, 0, 1);
+ 
+ #define UART_TX_BLOCK      ((UART_FRAME_MAX + 3U) & ~3U)  /**< Bloco do pool (alinhado a 4) */
+ 
+ /** Blocos dos frames em fila ou em envio */
+ K_MEM_SLAB_DEFINE_STATIC(uart_tx_slab, UART_TX_BLOCK, CONFIG_UARTCOMM_TX_BUFS, 4);
+ 
+ /** Fila de envio, com os contadores de #Q; só acedida sob uart_tx_lock */
+ static uart_txq_t uart_txq;
+ static struct k_spinlock uart_tx_lock;
+ 
+ #if defined(CONFIG_UARTCOMM_HIST_DUMP)
+ /** 1 enquanto o dump do #H espera por um bloco de envio livre (ver uart_tx_free()) */
+ static atomic_t uart_hist_stalled;
+ #endif
+ 
+ #if defined(CONFIG_UARTCOMM_TX_OVERFLOW_DROP_OLDEST)
+ #define UART_TX_DROP_OLDEST true   /* A telemetria nova toma o lugar da mais antiga ainda em fila */
+ #else
+ #define UART_TX_DROP_OLDEST false
+ #endif
+ 
+ #if defined(CONFIG_UART_ASYNC_API)
+ #define UART_RX_DMA_LEN    32U    /**< Cada um dos dois buffers de receção por DMA */
+ #define UART_RX_TIMEOUT_US 200    /**< Inatividade na linha que entrega os bytes já recebidos */
+ 
+ static uint8_t uart_rx_dma[2][UART_RX_DMA_LEN];
+ static uint8_t uart_rx_next;       /**< Buffer a entregar no próximo UART_RX_BUF_REQUEST */
+ #else
+ static size_t uart_tx_off;         /**< Bytes do frame à cabeça já postos na FIFO (só a ISR) */
+ #endif
+ 
  K_THREAD_STACK_DEFINE(uart_stack, UART_STACK_SIZE); 
  static struct k_thread uart_thread_data;             
  
+ #if defined(CONFIG_UARTCOMM_TELEMETRY)
+ /**
+  * Subscrição de telemetria: (geração << 16) | decimação, decimação 0 = sem subscrição.
+  * Só a thread da UART escreve; a geração muda a cada #U/#u.
+  */
+ static atomic_t uart_tlm_cfg;
+ 
+ K_THREAD_STACK_DEFINE(uart_tlm_stack, UART_TLM_STACK_SIZE);
+ static struct k_thread uart_tlm_thread;
+ #endif
+ 
  /**
   * @brief Inicializa a comunicação UART criando a thread uart_task()
   */
  void uart_comm_init(void)
  {
+     for (size_t i = 0U; i < ARRAY_SIZE(uart_cmd_handlers); i++) {
+         (void)uart_cmd_bind(uart_cmd_handlers[i].cmd, uart_cmd_handlers[i].handler);
+     }
      k_thread_create(&uart_thread_data, uart_stack, UART_STACK_SIZE,
                      uart_task, NULL, NULL, NULL,
                      UART_PRIORITY, 0, K_NO_WAIT);
+     k_thread_name_set(&uart_thread_data, "uart");
+ #if defined(CONFIG_UARTCOMM_TELEMETRY)
+     k_thread_create(&uart_tlm_thread, uart_tlm_stack, UART_TLM_STACK_SIZE,
+                     uart_tlm_task, NULL, NULL, NULL,
+                     UART_TLM_PRIORITY, 0, K_NO_WAIT);
+     k_thread_name_set(&uart_tlm_thread, "uart_tlm");
+ #endif
  }
  
  static uint8_t calculate_checksum(const uint8_t *buf, size_t len)
@@ -144,308 +747,1227 @@
      return (uint8_t)(sum & 0xFFU);
  }
  
- static void send_bytes(const struct device *dev, const uint8_t *data, size_t len)
+ static uint8_t *uart_tx_alloc(bool tlm)
  {
-     for (size_t i = 0U; i < len; i++) {
-         uart_poll_out(dev, data[i]);
+     void *blk;
+ 
+     if (k_mem_slab_alloc(&uart_tx_slab, &blk, K_NO_WAIT) == 0) {
+         return blk;
+     }
+     /* O bloco de um frame tirado da fila passa logo para este, sem voltar ao pool */
+     k_spinlock_key_t key = k_spin_lock(&uart_tx_lock);
+     uint8_t *victim = uart_txq_make_room(&uart_txq, tlm, UART_TX_DROP_OLDEST);
+     k_spin_unlock(&uart_tx_lock, key);
+ 
+     if ((victim != NULL) || tlm) {
+         return victim;
+     }
+     /* Respostas e ACKs nunca se perdem: esperam que a linha liberte um bloco */
+     (void)k_mem_slab_alloc(&uart_tx_slab, &blk, K_FOREVER);
+     return blk;
+ }
+ 
+ static void uart_tx_free(uint8_t *buf)
+ {
+     k_mem_slab_free(&uart_tx_slab, buf);
+ #if defined(CONFIG_UARTCOMM_HIST_DUMP)
+     if (atomic_cas(&uart_hist_stalled, 1, 0)) {
+         k_sem_give(&uart_rx_sem);
+     }
+ #endif
+ }
+ 
+ #if defined(CONFIG_UART_ASYNC_API)
+ /**
+  * @brief Arranca o uart_tx() do frame à cabeça da fila (descarta os que o driver recusar)
+  */
+ static void uart_tx_kick(const struct device *dev)
+ {
+     for (;;) {
+         k_spinlock_key_t key = k_spin_lock(&uart_tx_lock);
+         const uart_txq_ent_t *head = uart_txq_head(&uart_txq);
+         if (head == NULL) {
+             k_spin_unlock(&uart_tx_lock, key);
+             return;
+         }
+         uint8_t *buf = head->buf;
+         size_t   len = head->len;
+         k_spin_unlock(&uart_tx_lock, key);
+ 
+         if (uart_tx(dev, buf, len, SYS_FOREVER_US) == 0) {
+             return;
+         }
+ 
+         key = k_spin_lock(&uart_tx_lock);
+         (void)uart_txq_pop(&uart_txq);
+         uart_txq.dropped++;
+         k_spin_unlock(&uart_tx_lock, key);
+         uart_tx_free(buf);
+     }
+ }
+ #endif
+ 
+ static void uart_tx_submit(const struct device *dev, uint8_t *buf, size_t len, bool tlm)
+ {
+     /* Há tantas posições na fila como blocos no pool: nunca enche */
+     k_spinlock_key_t key = k_spin_lock(&uart_tx_lock);
+     bool idle = uart_txq_push(&uart_txq, buf, len, tlm);
+     k_spin_unlock(&uart_tx_lock, key);
+ 
+ #if defined(CONFIG_UART_ASYNC_API)
+     if (idle) {
+         uart_tx_kick(dev);
+     }
+ #else
+     /* A ISR desliga a interrupção de envio quando a fila esvazia */
+     ARG_UNUSED(idle);
+     uart_irq_tx_enable(dev);
+ #endif
+ }
+ 
+ #if defined(CONFIG_UART_ASYNC_API)
+ static void uart_async_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+ {
+     ARG_UNUSED(user_data);
+ 
+     switch (evt->type) {
+     case UART_TX_DONE:
+     case UART_TX_ABORTED: {
+         k_spinlock_key_t key = k_spin_lock(&uart_tx_lock);
+         uint8_t *sent = uart_txq_pop(&uart_txq);
+         k_spin_unlock(&uart_tx_lock, key);
+         /* Liberta fora do lock: pode acordar uma thread à espera em uart_tx_alloc() */
+         uart_tx_free(sent);
+         uart_tx_kick(dev);
+         break;
+     }
+     case UART_RX_RDY:
+         (void)uart_ring_put(&uart_rx_ring, &evt->data.rx.buf[evt->data.rx.offset],
+                             evt->data.rx.len);
+         k_sem_give(&uart_rx_sem);
+         break;
+     case UART_RX_BUF_REQUEST:
+         (void)uart_rx_buf_rsp(dev, uart_rx_dma[uart_rx_next], UART_RX_DMA_LEN);
+         uart_rx_next ^= 1U;
+         break;
+     case UART_RX_DISABLED:
+         uart_rx_next = 1U;
+         (void)uart_rx_enable(dev, uart_rx_dma[0], UART_RX_DMA_LEN, UART_RX_TIMEOUT_US);
+         break;
+     default:
+         break;
+     }
+ }
+ #else
+ static void uart_tx_fill(const struct device *dev)
+ {
+     for (;;) {
+         k_spinlock_key_t key = k_spin_lock(&uart_tx_lock);
+         const uart_txq_ent_t *head = uart_txq_head(&uart_txq);
+         if (head == NULL) {
+             uart_irq_tx_disable(dev);
+             k_spin_unlock(&uart_tx_lock, key);
+             return;
+         }
+         uint8_t *buf = head->buf;
+         size_t   len = head->len;
+         k_spin_unlock(&uart_tx_lock, key);
+ 
+         if (uart_tx_off < len) {
+             int n = uart_fifo_fill(dev, &buf[uart_tx_off], (int)(len - uart_tx_off));
+             uart_tx_off += (n > 0) ? (size_t)n : 0U;
+             if (uart_tx_off < len) {
+                 return;   /* FIFO cheia: continua na próxima interrupção */
+             }
+         }
+ 
+         key = k_spin_lock(&uart_tx_lock);
+         (void)uart_txq_pop(&uart_txq);
+         k_spin_unlock(&uart_tx_lock, key);
+         uart_tx_off = 0U;
+         uart_tx_free(buf);
      }
  }
+ #endif
  
  static void send_frame(const struct device *dev, char cmd, const char *data, size_t data_len)
  {
-     /* 1 byte ('#') + 1 byte(cmd) + data_len + 3 bytes(checksum) + 1 byte('!') */
-     uint8_t frame[1U + 1U + UART_BUF_SIZE + 3U + 1U];
+     /* Sub-comando de um lote: a resposta vai para o frame 'k' */
+     if (uart_batch.on && (k_current_get() == &uart_thread_data)) {
+         uart_batch_put(cmd, data, data_len);
+         return;
+     }
+     /* Só as respostas da thread da UART são do pedido em tratamento */
+     int seq = (k_current_get() == &uart_thread_data) ? uart_reply_seq : UART_SEQ_NONE;
+     (void)send_frame_tx(dev, seq, cmd, data, data_len, false);
+ }
+ 
+ static bool send_frame_tx(const struct device *dev, int seq, char cmd, const char *data,
+                           size_t data_len, bool tlm)
+ {
+     /* 1 byte ('#') + [1 byte('@') + 3 bytes(seq)] + 1 byte(cmd) + data_len + 3 bytes(checksum) + 1 byte('!') */
+     uint8_t *frame = uart_tx_alloc(tlm);
+     if (frame == NULL) {
+         return false;
+     }
      size_t  pos = 0U;
  
+     if (uart_comm_binary()) {
+         pos = uart_bin_frame_seq(frame, seq, cmd, (const uint8_t *)data, data_len);
+         uart_tx_submit(dev, frame, pos, tlm);
+         return true;
+     }
      frame[pos++] = '#';
+     if (seq != UART_SEQ_NONE) {
+         frame[pos++] = UART_SEQ_MARK;
+         frame[pos++] = '0' + (uint8_t)((seq / 100) % 10);
+         frame[pos++] = '0' + (uint8_t)((seq / 10) % 10);
+         frame[pos++] = '0' + (uint8_t)(seq % 10);
+     }
      frame[pos++] = (uint8_t)cmd;
      for (size_t i = 0U; i < data_len; i++) {
          frame[pos++] = (uint8_t)data[i];
      }
-     /* Calcula checksum [CMD] + [DATA] */
-     uint8_t cs = calculate_checksum(&frame[1], 1U + data_len);
+     /* Calcula checksum [etiqueta] + [CMD] + [DATA] */
+     uint8_t cs = calculate_checksum(&frame[1], pos - 1U);
      /* Converte checksum para 3 dígitos ASCII */
      frame[pos++] = '0' + (uint8_t)((cs / 100U) % 10U);
      frame[pos++] = '0' + (uint8_t)((cs / 10U) % 10U);
      frame[pos++] = '0' + (uint8_t)(cs % 10U);
  
      frame[pos++] = '!';
-     send_bytes(dev, frame, pos);
+     uart_tx_submit(dev, frame, pos, tlm);
+     return true;
  }
  
- static void send_ack(const struct device *dev, char code)
+ static void uart_batch_put(char cmd, const char *data, size_t data_len)
  {
-     /* ACK genérico: #E<code>! */
-     send_frame(dev, 'E', &code, 1U);
- }
+     uart_out_t *o = &uart_batch.o;
+     size_t hdr = o->bin ? 1U : 2U;
  
- static void handle_command(const struct device *dev, const uint8_t *buf, size_t len)
- {
-     /* Tamanho mínimo = 6 bytes: # + CMD + CS(3) + ! */
-     if (len < 6U) {
-         send_ack(dev, 'f');  /* framing error */
+     if ((hdr + 1U + data_len) > (sizeof(o->buf) - o->pos)) {
+         uart_batch.full = true;
          return;
      }
-     /* Verifica '#' no início e '!' no fim */
-     if ((buf[0] != '#') || (buf[len - 1] != '!')) {
-         send_ack(dev, 'f');
-         return;
+     out_u(o, (uint32_t)(1U + data_len), 2U, 1U);
+     out_c(o, cmd);
+     for (size_t i = 0U; i < data_len; i++) {
+         out_c(o, data[i]);
      }
-     /* Extrai CMD */
-     char cmd = (char)buf[1];
+ }
+ 
+ static void send_ack(const struct device *dev, char code)
+ {
+     /* ACK genérico: #E<code>! */
+     send_frame(dev, 'E', &code, 1U);
+ }
+ 
+ static char status_to_ack(rtdb_status_t st)
+ {
+     return (st == RTDB_OK) ? 'o' : 'i';
+ }
+ 
+ static void put_dec(char *out, uint32_t v, size_t digits)
+ {
+     uint32_t max = 1U;
+     for (size_t i = 0U; i < digits; i++) {
+         max *= 10U;
+     }
+     if (v >= max) {
+         v = max - 1U;
+     }
+     for (size_t i = digits; i > 0U; i--) {
+         out[i - 1U] = (char)('0' + (v % 10U));
+         v /= 10U;
+     }
+ }
+ 
+ static void put_sdec(char *out, int32_t v, size_t digits)
+ {
+     out[0] = (v < 0) ? '-' : '+';
+     put_dec(&out[1], (v < 0) ? (uint32_t)(-(int64_t)v) : (uint32_t)v, digits);
+ }
+ 
+ /**
+  * @brief Lê digits dígitos decimais de in para *v (false se algum não for um dígito)
+  */
+ static bool get_dec(const uint8_t *in, size_t digits, uint32_t *v)
+ {
+     *v = 0U;
+     for (size_t i = 0U; i < digits; i++) {
+         if ((in[i] < '0') || (in[i] > '9')) {
+             return false;
+         }
+         *v = (*v * 10U) + (uint32_t)(in[i] - '0');
+     }
+     return true;
+ }
+ 
+ static void out_init(uart_out_t *o, const uart_frame_t *f)
+ {
+     o->pos = 0U;
+     o->bin = f->bin;
+ }
+ 
+ static void out_u(uart_out_t *o, uint32_t v, size_t digits, size_t bytes)
+ {
+     if (!o->bin) {
+         put_dec(&o->buf[o->pos], v, digits);
+         o->pos += digits;
+         return;
+     }
+     for (size_t i = 0U; i < bytes; i++) {
+         o->buf[o->pos++] = (char)(uint8_t)(v >> (8U * i));
+     }
+ }
+ 
+ static void out_s(uart_out_t *o, int32_t v, size_t digits, size_t bytes)
+ {
+     if (!o->bin) {
+         put_sdec(&o->buf[o->pos], v, digits);
+         o->pos += 1U + digits;
+         return;
+     }
+     if (bytes < 4U) {
+         int32_t lim = (int32_t)(1UL << ((8U * bytes) - 1U));
+         v = (v < -lim) ? -lim : ((v > (lim - 1)) ? (lim - 1) : v);
+     }
+     out_u(o, (uint32_t)v, digits, bytes);
+ }
+ 
+ static void out_c(uart_out_t *o, char c)
+ {
+     o->buf[o->pos++] = c;
+ }
+ 
+ static void send_out(const struct device *dev, char cmd, const uart_out_t *o)
+ {
+     send_frame(dev, cmd, o->buf, o->pos);
+ }
+ 
+ static void in_init(uart_in_t *in, const uart_frame_t *f)
+ {
+     in->f = f;
+     in->pos = 0U;
+     in->ok = true;
+ }
+ 
+ static uint32_t in_u(uart_in_t *in, size_t digits, size_t bytes)
+ {
+     const uint8_t *p = &in->f->data[in->pos];
+     size_t n = in->f->bin ? bytes : digits;
+     uint32_t v = 0U;
  
-     /* Extrai checksum recebido (3 dígitos ASCII) */
-     char cs_str[4] = {
-         (char)buf[len - 4],
-         (char)buf[len - 3],
-         (char)buf[len - 2],
-         '\0'
-     };
-     uint8_t cs_rcv = (uint8_t)atoi(cs_str);
+     if (!in->ok || (n > (in->f->data_len - in->pos))) {
+         in->ok = false;
+         return 0U;
+     }
+     in->pos += n;
+     if (!in->f->bin) {
+         in->ok = get_dec(p, digits, &v);
+         return v;
+     }
+     for (size_t i = 0U; i < bytes; i++) {
+         v |= (uint32_t)p[i] << (8U * i);
+     }
+     return v;
+ }
  
-     /* Determina tamanho de DATA */
-     size_t data_len = len - 6U;  /* retira '#', CMD, CS(3), '!' */
-     const uint8_t *data_ptr = &buf[2];
+ static int32_t in_s(uart_in_t *in, size_t digits, size_t bytes)
+ {
+     char sign = '+';
+     uint32_t v;
  
-     /* Verifica se o comando é reconhecido */
-     bool cmd_valido = (cmd == 'M') || (cmd == 'm') || (cmd == 'C') ||
-                       (cmd == 'R') || (cmd == 'r') || (cmd == 'E') || (cmd == 'S');
-     if (!cmd_valido) {
-         /* Comando desconhecido: compara checksum isolado de CMD */
-         uint8_t cs_cmd = (uint8_t)cmd;
-         if (cs_cmd != cs_rcv) {
-             send_ack(dev, 's');  /* checksum error */
-             send_ack(dev, 'i');  /* invalid command */
+     if (!in->f->bin) {
+         sign = in_c(in);
+         if ((sign != '+') && (sign != '-')) {
+             in->ok = false;
+         }
+     }
+     v = in_u(in, digits, bytes);
+     if (in->f->bin && (bytes < 4U)) {
+         /* Estende o sinal do byte mais significativo lido */
+         uint32_t m = 1UL << ((8U * bytes) - 1U);
+         return (int32_t)((v ^ m) - m);
+     }
+     return (sign == '-') ? -(int32_t)v : (int32_t)v;
+ }
+ 
+ static char in_c(uart_in_t *in)
+ {
+     if (!in->ok || (in->pos >= in->f->data_len)) {
+         in->ok = false;
+         return '\0';
+     }
+     return (char)in->f->data[in->pos++];
+ }
+ 
+ static bool in_end(const uart_in_t *in)
+ {
+     return in->ok && (in->pos == in->f->data_len);
+ }
+ 
+ #if defined(CONFIG_RTDB_JOURNAL)
+ 
+ static void put_hex32(char *out, uint32_t v)
+ {
+     static const char digits[] = "0123456789ABCDEF";
+     for (size_t i = 8U; i > 0U; i--) {
+         out[i - 1U] = digits[v & 0x0FU];
+         v >>= 4;
+     }
+ }
+ 
+ static bool get_hex32(const uint8_t *in, uint32_t *v)
+ {
+     *v = 0U;
+     for (size_t i = 0U; i < 8U; i++) {
+         char c = (char)in[i];
+         uint32_t d;
+         if ((c >= '0') && (c <= '9')) {
+             d = (uint32_t)(c - '0');
+         } else if ((c >= 'A') && (c <= 'F')) {
+             d = (uint32_t)(c - 'A') + 10U;
          } else {
-             send_ack(dev, 'i');  
+             return false;
          }
+         *v = (*v << 4) | d;
+     }
+     return true;
+ }
+ 
+ /**
+  * @brief Acrescenta um índice do diário: 8 dígitos hexadecimais em ASCII, 4 bytes em binário
+  */
+ static void out_x32(uart_out_t *o, uint32_t v)
+ {
+     if (o->bin) {
+         out_u(o, v, 0U, 4U);
+     } else {
+         put_hex32(&o->buf[o->pos], v);
+         o->pos += 8U;
+     }
+ }
+ 
+ static void handle_journal(const struct device *dev, const uart_frame_t *f)
+ {
+     uart_out_t o;
+     rtdb_jentry_t e;
+     uint32_t oldest;
+     uint32_t head = rtdb_journal_span(&oldest);
+     uint32_t idx;
+     size_t per = f->bin ? UART_JOURNAL_PER_BIN_FRAME : UART_JOURNAL_PER_FRAME;
+     size_t n = 0U;
+ 
+     out_init(&o, f);
+     if (f->data_len == 0U) {
+         out_x32(&o, head);
+         out_x32(&o, oldest);
+         send_out(dev, 'j', &o);
+         return;
+     }
+     if (f->bin && (f->data_len == 4U)) {
+         idx = f->num;
+     } else if (f->bin || (f->data_len != 8U) || !get_hex32(f->data, &idx)) {
+         send_ack(dev, 'i');
          return;
      }
  
-     /* Verifica checksum completo [CMD + DATA] */
-     uint8_t cs_calc = calculate_checksum((const uint8_t *)&buf[1], 1U + data_len);
-     if (cs_calc != cs_rcv) {
-         send_ack(dev, 's');  /* checksum error */
+     /* Salta entradas já reescritas (o índice devolvido diz onde o bloco começa) */
+     if ((int32_t)(idx - oldest) < 0) {
+         idx = oldest;
+     }
+     out_x32(&o, idx);
+     while ((n < per) && ((int32_t)(head - (idx + n)) > 0) && rtdb_journal_get(idx + n, &e)) {
+         /* Em binário a entrada segue serializada, sem a passar a hexadecimal */
+         if (o.bin) {
+             rtdb_journal_pack(&e, (uint8_t *)&o.buf[o.pos]);
+             o.pos += RTDB_JOURNAL_WIRE_LEN;
+         } else {
+             rtdb_journal_encode(&e, &o.buf[o.pos]);
+             o.pos += RTDB_JOURNAL_HEX_LEN;
+         }
+         n++;
+     }
+     send_out(dev, 'j', &o);
+ }
+ 
+ #endif
+ 
+ #if defined(CONFIG_UARTCOMM_HIST_DUMP)
+ #define UART_HIST_HDR_LEN     (5U + 10U + 3U)   /**< seq + t0 + n de 'h' em ASCII */
+ #define UART_HIST_HDR_BIN_LEN (2U + 4U + 1U)    /**< O mesmo em binário */
+ 
+ /**
+  * @brief Acrescenta len bytes: 2 carateres hexadecimais por byte em ASCII, tal como
+  *        estão em binário
+  */
+ static void out_blk(uart_out_t *o, const uint8_t *b, size_t len)
+ {
+     static const char digits[] = "0123456789ABCDEF";
+ 
+     for (size_t i = 0U; i < len; i++) {
+         if (o->bin) {
+             o->buf[o->pos++] = (char)b[i];
+         } else {
+             o->buf[o->pos++] = digits[b[i] >> 4];
+             o->buf[o->pos++] = digits[b[i] & 0x0FU];
+         }
+     }
+ }
+ 
+ /**
+  * @brief Compressor dos chunks (uart_hist_compress_t): bloco LZ4 sem moldura
+  */
+ static int uart_hist_lz4(const uint8_t *src, int src_len, uint8_t *dst, int cap)
+ {
+     /* Tabela de hash do LZ4 (16 KiB com LZ4_MEMORY_USAGE 14): estática, não cabe na pilha */
+     static LZ4_stream_t state;
+ 
+     return LZ4_compress_fast_extState(&state, (const char *)src, (char *)dst, src_len, cap, 1);
+ }
+ 
+ /**
+  * @brief Dump do #H em curso (só a thread da UART acede; fora da pilha, como uart_batch)
+  */
+ static struct {
+     uart_hist_t d;
+     bool        on;
+     bool        bin;   /* Modo do pedido: os chunks seguem nele */
+     int         seq;   /* Etiqueta do pedido, repetida em cada chunk */
+ } uart_hist_dump;
+ 
+ static void handle_history(const struct device *dev, const uart_frame_t *f)
+ {
+     rtdb_hist_iter_t it;
+     uart_in_t in;
+ 
+     in_init(&in, f);
+     uint32_t zone = in_u(&in, 1U, 1U);
+     uint32_t t_from = in_u(&in, 10U, 4U);
+     uint32_t t_to = in_u(&in, 10U, 4U);
+     uint32_t skip = (in.ok && (in.pos < f->data_len)) ? in_u(&in, 5U, 2U) : 0U;
+     if (!in_end(&in) || (zone >= RTDB_NUM_ZONES)) {
+         send_ack(dev, 'i');
          return;
      }
  
-     switch (cmd) {
-         case 'M': {  /* #MxxxYYY! → set max temperature */
-             if (data_len != 3U) {
-                 send_ack(dev, 'i');
-             } else {
-                 char tmp[4] = {
-                     (char)data_ptr[0],
-                     (char)data_ptr[1],
-                     (char)data_ptr[2],
-                     '\0'
-                 };
-                 int val = atoi(tmp);
-                 if (val < rtdb_get_min_temp()) {
-                     /* Não permitir max < min */
-                     send_ack(dev, 'i');
-                 } else {
-                     rtdb_set_max_temp((int16_t)val);
-                     printk("[UART] max_temp atualizado para %d°C\n", val);
-                     send_ack(dev, 'o');
-                 }
-             }
-             break;
+     rtdb_history_window_zone((uint8_t)zone, &it, t_from, t_to);
+     uart_hist_init(&uart_hist_dump.d, &it, uart_hist_lz4);
+     /* Retoma: as amostras já recebidas são lidas e postas de parte, sem compressão */
+     (void)uart_hist_skip(&uart_hist_dump.d, skip);
+     uart_hist_dump.bin = f->bin;
+     uart_hist_dump.seq = uart_reply_seq;
+     uart_hist_dump.on = true;
+ }
+ 
+ static bool uart_hist_ready(void)
+ {
+     if (!uart_hist_dump.on) {
+         return false;
+     }
+     /* Marca antes de ver o pool: um bloco libertado entretanto acorda na mesma */
+     atomic_set(&uart_hist_stalled, 1);
+     if (k_mem_slab_num_free_get(&uart_tx_slab) == 0U) {
+         return false;
+     }
+     atomic_set(&uart_hist_stalled, 0);
+     return true;
+ }
+ 
+ static void uart_hist_pump(const struct device *dev)
+ {
+     uint8_t blk[UART_BUF_SIZE - UART_HIST_HDR_BIN_LEN];
+     uart_hist_chunk_t c;
+     uart_out_t o;
+ 
+     if (!uart_hist_dump.on) {
+         return;
+     }
+     if (uart_hist_dump.bin != uart_comm_binary()) {
+         uart_hist_dump.on = false;   /* #N mudou o modo a meio */
+         return;
+     }
+     /* Sem bloco livre fica para quando a linha libertar um (a telemetria, que pode
+      * levar o último entre a verificação e o envio, cede-o: uart_txq_make_room()) */
+     if (k_mem_slab_num_free_get(&uart_tx_slab) == 0U) {
+         return;
+     }
+ 
+     size_t cap = uart_hist_dump.bin ? (UART_BUF_SIZE - UART_HIST_HDR_BIN_LEN)
+                                     : ((UART_BUF_SIZE - UART_HIST_HDR_LEN) / 2U);
+     if (!uart_hist_next(&uart_hist_dump.d, blk, cap, &c)) {
+         uart_hist_dump.on = false;
+         return;
+     }
+     if (c.n == 0U) {
+         uart_hist_dump.on = false;   /* Chunk de fim: o dump termina com ele */
+     }
+     o.pos = 0U;
+     o.bin = uart_hist_dump.bin;
+     out_u(&o, c.seq, 5U, 2U);
+     out_u(&o, c.t0, 10U, 4U);
+     out_u(&o, c.n, 3U, 1U);
+     out_blk(&o, blk, c.len);
+     (void)send_frame_tx(dev, uart_hist_dump.seq, 'h', o.buf, o.pos, false);
+ }
+ #endif
+ 
+ static void handle_profile(const struct device *dev, const uart_frame_t *f)
+ {
+     uart_in_t in;
+     uart_out_t o;
+     rtdb_profile_t prof;
+     uint32_t n;
+     uint32_t z;
+     char op;
+ 
+     in_init(&in, f);
+     out_init(&o, f);
+     if (f->data_len == 0U) {
+         int active = rtdb_profile_active();
+         if (active < 0) {
+             out_c(&o, o.bin ? (char)0xFF : '-');
+         } else {
+             out_u(&o, (uint32_t)active, 1U, 1U);
          }
-         case 'm': {  /* #mxxxYYY! → set min temperature */
-             if (data_len != 3U) {
-                 send_ack(dev, 'i');
-             } else {
-                 char tmp[4] = {
-                     (char)data_ptr[0],
-                     (char)data_ptr[1],
-                     (char)data_ptr[2],
-                     '\0'
-                 };
-                 int val = atoi(tmp);
-                 if (val > rtdb_get_max_temp()) {
-                     /* Não permitir min > max */
-                     send_ack(dev, 'i');
-                 } else {
-                     rtdb_set_min_temp((int16_t)val);
-                     printk("[UART] min_temp atualizado para %d°C\n", val);
-                     send_ack(dev, 'o');
-                 }
-             }
-             break;
+         for (uint8_t i = 0U; i < RTDB_MAX_PROFILES; i++) {
+             out_u(&o, rtdb_profile_get(i, &prof) ? 1U : 0U, 1U, 1U);
          }
-         case 'C': {  /* #C! → consulta current temperature */
-             int cur = rtdb_get_current_temp();
-             /* Limita a 0..999 para caber em 3 dígitos */
-             if (cur < 0) {
-                 cur = 0;
-             } else if (cur > 999) {
-                 cur = 999;
-             }
-             char out[4] = {
-                 (char)('0' + (cur / 100)),
-                 (char)('0' + ((cur / 10) % 10)),
-                 (char)('0' + (cur % 10)),
-                 '\0'
-             };
-             send_frame(dev, 'c', out, 3U);
-             break;
+         send_out(dev, 'p', &o);
+         return;
+     }
+     if (f->data_len == 1U) {
+         n = in_u(&in, 1U, 1U);
+         rtdb_status_t st = in.ok ? rtdb_profile_activate((uint8_t)n) : RTDB_EINVAL;
+         if (st == RTDB_OK) {
+             printk("[UART] perfil %u ativado\n", (unsigned)n);
          }
-         case 'R': {  /* #RxxxxYYY! → set samplingRate em ms (0000..9999) */
-             if (data_len != 4U) {
-                 send_ack(dev, 'i');
-             } else {
-                 char tmp[5] = {
-                     (char)data_ptr[0],
-                     (char)data_ptr[1],
-                     (char)data_ptr[2],
-                     (char)data_ptr[3],
-                     '\0'
-                 };
-                 int val = atoi(tmp);
-                 if (val < 10 || val > 9999) {
-                     send_ack(dev, 'i');
-                 } else {
-                     rtdb_set_sampling_rate((uint32_t)val);
-                     printk("[UART] sampling_rate atualizado para %d ms\n", val);
-                     send_ack(dev, 'o');
-                 }
-             }
-             break;
+         send_ack(dev, status_to_ack(st));
+         return;
+     }
+     op = in_c(&in);
+     n = in_u(&in, 1U, 1U);
+     if (!in.ok) {
+         send_ack(dev, 'i');
+         return;
+     }
+ 
+     if ((op == 's') && ((f->data_len - in.pos) <= RTDB_PROFILE_NAME_LEN)) {
+         char name[RTDB_PROFILE_NAME_LEN + 1U] = { 0 };
+         for (size_t i = in.pos; i < f->data_len; i++) {
+             name[i - in.pos] = (char)f->data[i];
          }
-         case 'r': {  /* #r! → get samplingRate (4 dígitos) */
-             if (data_len != 0U) {
-                 send_ack(dev, 'i');
-             } else {
-                 uint32_t sr = rtdb_get_sampling_rate();
-                 if (sr > 9999U) {
-                     sr = 9999U;
-                 }
-                 char out[5] = {
-                     (char)('0' + ((sr / 1000) % 10)),
-                     (char)('0' + ((sr / 100)  % 10)),
-                     (char)('0' + ((sr / 10)   % 10)),
-                     (char)('0' + (sr % 10)),
-                     '\0'
-                 };
-                 send_frame(dev, 's', out, 4U);
-             }
-             break;
+         send_ack(dev, status_to_ack(rtdb_profile_save((uint8_t)n, name)));
+     } else if (op == 'd') {
+         /* Limites e setpoint: sinal e 3 dígitos em ASCII, int16 em binário */
+         z = in_u(&in, 1U, 1U);
+         int32_t sp = in_s(&in, 3U, 2U);
+         int32_t max = in_s(&in, 3U, 2U);
+         int32_t min = in_s(&in, 3U, 2U);
+         uint32_t rate = in_u(&in, 4U, 4U);
+         if (!in_end(&in)) {
+             send_ack(dev, 'i');
+             return;
          }
-         case 'E': {  /* #E0! → liga sistema; #E1! → desliga sistema */
-             if (data_len != 1U) {
-                 send_ack(dev, 'i');
-             } else {
-                 char c = (char)data_ptr[0];
-                 if (c == '0') {
-                     rtdb_set_system_on(true);
-                     printk("[UART] Sistema ligado via comando #E0\n");
-                     send_ack(dev, 'o');
-                 } else if (c == '1') {
-                     rtdb_set_system_on(false);
-                     printk("[UART] Sistema desligado via comando #E1\n");
-                     send_ack(dev, 'o');
-                 } else {
-                     /* Payload diferente de '0' ou '1' → invalid */
-                     send_ack(dev, 'i');
-                 }
-             }
-             break;
+         rtdb_zone_t req = {
+             .setpoint = (int16_t)sp, .max_temp = (int16_t)max, .min_temp = (int16_t)min,
+             .sampling_rate_ms = rate,
+         };
+         send_ack(dev, status_to_ack(rtdb_profile_edit((uint8_t)n, (uint8_t)z,
+                                     RTDB_F_SETPOINT | RTDB_F_MAX_TEMP | RTDB_F_MIN_TEMP |
+                                     RTDB_F_SAMPLING_RATE, &req)));
+     } else if (op == 'q') {
+         z = in_u(&in, 1U, 1U);
+         if (!in_end(&in) || (z >= RTDB_NUM_ZONES) || !rtdb_profile_get((uint8_t)n, &prof)) {
+             send_ack(dev, 'i');
+             return;
+         }
+         out_u(&o, n, 1U, 1U);
+         out_u(&o, z, 1U, 1U);
+         out_s(&o, prof.cfg.setpoint[z], 3U, 2U);
+         out_s(&o, prof.cfg.max_temp[z], 3U, 2U);
+         out_s(&o, prof.cfg.min_temp[z], 3U, 2U);
+         out_u(&o, prof.cfg.sampling_rate_ms, 4U, 4U);
+         for (size_t i = 0U; prof.name[i] != '\0'; i++) {
+             out_c(&o, prof.name[i]);
+         }
+         send_out(dev, 'p', &o);
+     } else {
+         send_ack(dev, 'i');
+     }
+ }
+ 
+ static void handle_temp_stats(const struct device *dev, const uart_frame_t *f)
+ {
+     uart_in_t in;
+     uart_out_t o;
+     rtdb_stats_t st;
+     uint32_t zone = 0U;
+ 
+     in_init(&in, f);
+     if (f->data_len > 0U) {
+         zone = in_u(&in, 1U, 1U);
+     }
+     if (!in_end(&in) || (zone >= RTDB_NUM_ZONES)) {
+         send_ack(dev, 'i');
+         return;
+     }
+     rtdb_temp_stats_get((uint8_t)zone, &st);
+ 
+     out_init(&o, f);
+     out_u(&o, zone, 1U, 1U);
+     out_u(&o, st.n, 6U, 4U);
+     out_s(&o, (st.n != 0U) ? st.min : 0, 3U, 2U);
+     out_s(&o, (st.n != 0U) ? st.max : 0, 3U, 2U);
+     out_s(&o, rtdb_stats_mean_centi(&st), 5U, 4U);
+     out_u(&o, rtdb_stats_var_centi(&st), 6U, 4U);
+     for (size_t b = 0U; b < RTDB_STATS_BINS; b++) {
+         out_u(&o, st.band_ms[b] / 1000U, 5U, 4U);
+     }
+     send_out(dev, 't', &o);
+ }
+ 
+ static void handle_tx_stats(const struct device *dev, const uart_frame_t *f)
+ {
+     uart_in_t in;
+     uart_out_t o;
+ 
+     in_init(&in, f);
+     if (f->data_len > 0U) {
+         uint32_t op = in_u(&in, 1U, 1U);
+         if (!in_end(&in) || (op != 0U)) {
+             send_ack(dev, 'i');
+             return;
          }
-         case 'S': {  /* #Sxxx...xxxYYY! → set controller parameters */
-             if (data_len < 1U) {
-                 send_ack(dev, 'i');
-             } else {
-                 printk("[UART] parâmetros do controlador atualizados (DATA_len=%u)\n",
-                        (unsigned)data_len);
-                 send_ack(dev, 'o');
+         k_spinlock_key_t key = k_spin_lock(&uart_tx_lock);
+         uart_txq_reset_hwm(&uart_txq);
+         k_spin_unlock(&uart_tx_lock, key);
+         send_ack(dev, 'o');
+         return;
+     }
+ 
+     /* Ocupação e contadores lidos juntos, coerentes entre si */
+     k_spinlock_key_t key = k_spin_lock(&uart_tx_lock);
+     uint32_t used = uart_txq.count;
+     uint32_t hwm = uart_txq.hwm;
+     uint32_t dropped = uart_txq.dropped;
+     uint32_t evicted = uart_txq.evicted;
+     k_spin_unlock(&uart_tx_lock, key);
+ 
+     out_init(&o, f);
+     out_u(&o, CONFIG_UARTCOMM_TX_BUFS, 2U, 1U);
+     out_u(&o, used, 2U, 1U);
+     out_u(&o, hwm, 2U, 1U);
+     out_u(&o, dropped, 5U, 4U);
+     out_u(&o, evicted, 5U, 4U);
+     send_out(dev, 'q', &o);
+ }
+ 
+ #if defined(CONFIG_RTDB_LOCK_STATS)
+ 
+ static void handle_lock_stats(const struct device *dev, const uart_frame_t *f)
+ {
+     static const char dom_chr[RTDB_NUM_DOMAINS] = { [RTDB_DOM_CFG] = 'c', [RTDB_DOM_MEAS] = 'm' };
+     rtdb_lockstat_t st;
+     rtdb_domain_t dom;
+     uart_in_t in;
+     uart_out_t o;
+ 
+     in_init(&in, f);
+     out_init(&o, f);
+     if (f->data_len == 0U) {
+         /* Número de chamadores registados em cada domínio */
+         for (uint32_t d = 0U; d < RTDB_NUM_DOMAINS; d++) {
+             uint8_t n = 0U;
+             while ((n < RTDB_LOCKSTAT_MAX_CALLERS) &&
+                    (rtdb_lock_stats_get((rtdb_domain_t)d, n, &st) == 0)) {
+                 n++;
              }
-             break;
+             out_u(&o, n, 1U, 1U);
+         }
+         send_out(dev, 'l', &o);
+         return;
+     }
+     char d = in_c(&in);
+     if ((f->data_len == 1U) && (d == 'z')) {
+         rtdb_lock_stats_reset();
+         send_ack(dev, 'o');
+         return;
+     }
+     if (d == 'c') {
+         dom = RTDB_DOM_CFG;
+     } else if (d == 'm') {
+         dom = RTDB_DOM_MEAS;
+     } else {
+         send_ack(dev, 'i');
+         return;
+     }
+     uint32_t idx = in_u(&in, 1U, 1U);
+     char sub = (in.pos < f->data_len) ? in_c(&in) : '\0';
+     if (!in_end(&in) || (idx > 9U) || (rtdb_lock_stats_get(dom, (uint8_t)idx, &st) != 0)) {
+         send_ack(dev, 'i');
+         return;
+     }
+ 
+     out_c(&o, dom_chr[dom]);
+     out_u(&o, idx, 1U, 1U);
+     if (sub == '\0') {
+         /* Resumo: aquisições, pior espera e pior posse (µs), nome da thread */
+         const char *name = (st.caller == RTDB_LOCKSTAT_ISR) ? "isr"
+                            : k_thread_name_get((k_tid_t)st.caller);
+         out_u(&o, st.count, 5U, 4U);
+         out_u(&o, k_cyc_to_us_floor32(st.wait_max), 5U, 4U);
+         out_u(&o, k_cyc_to_us_floor32(st.hold_max), 5U, 4U);
+         for (size_t i = 0U; (name != NULL) && (name[i] != '\0') && (i < 8U); i++) {
+             out_c(&o, name[i]);
+         }
+     } else if ((sub == 'w') || (sub == 'h')) {
+         const uint32_t *hist = (sub == 'w') ? st.wait_hist : st.hold_hist;
+         out_c(&o, sub);
+         for (size_t b = 0U; b < RTDB_LOCKSTAT_BUCKETS; b++) {
+             out_u(&o, hist[b], 4U, 4U);
+         }
+     } else {
+         send_ack(dev, 'i');
+         return;
+     }
+     send_out(dev, 'l', &o);
+ }
+ #endif
+ 
+ static void handle_set_max_temp(const struct device *dev, const uart_frame_t *f)
+ {
+     if (!f->num_ok) {
+         send_ack(dev, 'i');
+         return;
+     }
+     /* Validação (max ≥ min) e escrita numa só operação atómica */
+     rtdb_zone_t req = { .max_temp = (int16_t)f->num };
+     rtdb_status_t st = rtdb_update(RTDB_F_MAX_TEMP, &req);
+     if (st == RTDB_OK) {
+         printk("[UART] max_temp atualizado para %d°C\n", req.max_temp);
+     }
+     send_ack(dev, status_to_ack(st));
+ }
+ 
+ static void handle_set_min_temp(const struct device *dev, const uart_frame_t *f)
+ {
+     if (!f->num_ok) {
+         send_ack(dev, 'i');
+         return;
+     }
+     /* Validação (min ≤ max) e escrita numa só operação atómica */
+     rtdb_zone_t req = { .min_temp = (int16_t)f->num };
+     rtdb_status_t st = rtdb_update(RTDB_F_MIN_TEMP, &req);
+     if (st == RTDB_OK) {
+         printk("[UART] min_temp atualizado para %d°C\n", req.min_temp);
+     }
+     send_ack(dev, status_to_ack(st));
+ }
+ 
+ static void handle_get_current_temp(const struct device *dev, const uart_frame_t *f)
+ {
+     int cur = uart_batch.on ? uart_batch.snap.current_temp[0] : rtdb_get_current_temp();
+     uart_out_t o;
+ 
+     out_init(&o, f);
+     if (o.bin) {
+         out_s(&o, cur, 3U, 2U);
+     } else {
+         /* Limita a 0..999 para caber em 3 dígitos (put_dec() satura em cima) */
+         out_u(&o, (cur < 0) ? 0U : (uint32_t)cur, 3U, 2U);
+     }
+     send_out(dev, 'c', &o);
+ }
+ 
+ static void handle_set_sampling_rate(const struct device *dev, const uart_frame_t *f)
+ {
+     int val = (int)f->num;
+     if (!f->num_ok || (val < 10) || (val > 9999)) {
+         send_ack(dev, 'i');
+         return;
+     }
+     rtdb_zone_t req = { .sampling_rate_ms = (uint32_t)val };
+     rtdb_status_t st = rtdb_update(RTDB_F_SAMPLING_RATE, &req);
+     if (st == RTDB_OK) {
+         printk("[UART] sampling_rate atualizado para %d ms\n", val);
+     }
+     send_ack(dev, status_to_ack(st));
+ }
+ 
+ static void handle_get_sampling_rate(const struct device *dev, const uart_frame_t *f)
+ {
+     uart_out_t o;
+ 
+     out_init(&o, f);
+     out_u(&o, uart_batch.on ? uart_batch.snap.sampling_rate_ms : rtdb_get_sampling_rate(),
+           4U, 4U);
+     send_out(dev, 's', &o);
+ }
+ 
+ static void handle_system_on(const struct device *dev, const uart_frame_t *f)
+ {
+     /* '0'/'1' em ASCII, 0/1 em binário */
+     if (f->num_ok && (f->num == 0U)) {
+         rtdb_set_system_on(true);
+         printk("[UART] Sistema ligado via comando #E0\n");
+         send_ack(dev, 'o');
+     } else if (f->num_ok && (f->num == 1U)) {
+         rtdb_set_system_on(false);
+         printk("[UART] Sistema desligado via comando #E1\n");
+         send_ack(dev, 'o');
+     } else {
+         /* Payload diferente de 0 ou 1 → invalid */
+         send_ack(dev, 'i');
+     }
+ }
+ 
+ static void handle_ctrl_params(const struct device *dev, const uart_frame_t *f)
+ {
+     if (f->data_len < 1U) {
+         send_ack(dev, 'i');
+         return;
+     }
+     printk("[UART] parâmetros do controlador atualizados (DATA_len=%u)\n",
+            (unsigned)f->data_len);
+     send_ack(dev, 'o');
+ }
+ 
+ static void handle_stats_reset(const struct device *dev, const uart_frame_t *f)
+ {
+     ARG_UNUSED(f);
+     rtdb_temp_stats_reset();
+     send_ack(dev, 'o');
+ }
+ 
+ static void handle_rollback(const struct device *dev, const uart_frame_t *f)
+ {
+     ARG_UNUSED(f);
+     send_ack(dev, status_to_ack(rtdb_profile_rollback()));
+ }
+ 
+ static void handle_mode(const struct device *dev, const uart_frame_t *f)
+ {
+     if (!f->num_ok || (f->num > 1U)) {
+         send_ack(dev, 'i');
+         return;
+     }
+     send_ack(dev, 'o');
+     atomic_set(&uart_bin_mode, (atomic_val_t)f->num);
+ }
+ 
+ static void handle_batch(const struct device *dev, const uart_frame_t *f)
+ {
+     static uart_frame_t sub;   /* Fora da pilha, como uart_batch */
+     size_t hdr = f->bin ? 1U : 2U;
+     size_t pos = 0U;
+     uint32_t n = 0U;
+     int r;
+ 
+     /* Valida o lote inteiro antes de executar qualquer sub-comando */
+     while ((r = uart_parser_sub(f, &pos, &sub)) > 0) {
+         n++;
+     }
+     if ((r < 0) || (n == 0U)) {
+         send_ack(dev, 'i');
+         return;
+     }
+ 
+     out_init(&uart_batch.o, f);
+     out_u(&uart_batch.o, 0U, 2U, 1U);   /* n, escrito no fim */
+     rtdb_snapshot(&uart_batch.snap);
+     uart_batch.on = true;
+     n = 0U;
+     pos = 0U;
+     while (uart_parser_sub(f, &pos, &sub) > 0) {
+         size_t mark = uart_batch.o.pos;
+         if ((sizeof(uart_batch.o.buf) - mark) < (hdr + 2U)) {
+             break;   /* Já nem um ACK cabe */
          }
-         default:
-             /* Nunca deve chegar aqui */
+         uart_batch.full = false;
+         if ((sub.cmd == 'K') || (sub.cmd == 'N') || (sub.cmd == 'H')) {
              send_ack(dev, 'i');
+         } else {
+             dispatch(dev, &sub);
+         }
+         if (uart_batch.full) {
+             uart_batch.o.pos = mark;
              break;
+         }
+         n++;
+         if ((uart_batch.o.pos > (mark + hdr + 1U)) && (uart_batch.o.buf[mark + hdr] == 'E') &&
+             (uart_batch.o.buf[mark + hdr + 1U] == 'o')) {
+             rtdb_snapshot(&uart_batch.snap);   /* Escrita aceite: os seguintes veem-na */
+         }
      }
+     uart_batch.on = false;
+ 
+     size_t end = uart_batch.o.pos;
+     uart_batch.o.pos = 0U;
+     out_u(&uart_batch.o, n, 2U, 1U);
+     uart_batch.o.pos = end;
+     send_out(dev, 'k', &uart_batch.o);
  }
  
- static void uart_task(void *p1, void *p2, void *p3)
+ #if defined(CONFIG_UARTCOMM_TELEMETRY)
+ /**
+  * @brief Muda a decimação da telemetria (0 = parada) e avança a geração
+  */
+ static void uart_tlm_set(uint32_t decim)
+ {
+     uint32_t gen = ((uint32_t)atomic_get(&uart_tlm_cfg) >> 16) + 1U;
+ 
+     atomic_set(&uart_tlm_cfg, (atomic_val_t)(((gen & 0xFFFFU) << 16) | decim));
+ }
+ 
+ static void handle_telemetry_on(const struct device *dev, const uart_frame_t *f)
  {
+     if (!f->num_ok || (f->num == 0U) || (f->num > UART_TLM_DECIM_MAX)) {
+         send_ack(dev, 'i');
+         return;
+     }
+     /* O ACK segue antes do primeiro 'v' */
+     send_ack(dev, 'o');
+     uart_tlm_set(f->num);
+ }
+ 
+ static void handle_telemetry_off(const struct device *dev, const uart_frame_t *f)
+ {
+     ARG_UNUSED(f);
+     uart_tlm_set(0U);
+     send_ack(dev, 'o');
+ }
+ 
+ /**
+  * @brief Frames de telemetria tirados da fila até agora (uart_txq.evicted sob o lock)
+  */
+ static uint32_t uart_tx_evicted(void)
+ {
+     k_spinlock_key_t key = k_spin_lock(&uart_tx_lock);
+     uint32_t n = uart_txq.evicted;
+ 
+     k_spin_unlock(&uart_tx_lock, key);
+     return n;
+ }
+ 
+ static void uart_tlm_task(void *p1, void *p2, void *p3)
+ {
+     static struct rtdb_sub sub;
+     const struct device *dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+     rtdb_hist_iter_t it;
+     rtdb_sample_t s;
+     uart_out_t o;
+     uint32_t cfg = 0U;
+     uint32_t lost = 0U;      /* Parte de it.lost já contada em n */
+     uint32_t n = 0U;         /* Amostras desde o último frame, perdidas incluídas */
+     uint32_t dropped = 0U;   /* Frames devidos que não seguiram, desde a subscrição */
+     uint32_t evicted = 0U;   /* Parte de uart_txq.evicted já contada em dropped */
+ 
      ARG_UNUSED(p1);
      ARG_UNUSED(p2);
      ARG_UNUSED(p3);
  
-     const struct device *uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
-     if (!device_is_ready(uart_dev)) {
-         printk("UART not ready\n");
+     if (!device_is_ready(dev) || (rtdb_subscribe(&sub, RTDB_F_SAMPLE) != 0)) {
+         printk("[UART] telemetria indisponível\n");
          return;
      }
- 
-     uint8_t buf[UART_BUF_SIZE];
-     size_t  idx = 0U;
-     uint8_t byte;
- 
      for (;;) {
-         if (uart_poll_in(uart_dev, &byte) == 0) {
+         (void)rtdb_wait(&sub, K_FOREVER);
  
-             if ((byte == '\r') || (byte == '\n')) {
-                 continue;  /* descarta CR/LF antes de começar/continuar um frame */
-             }
+         uint32_t cur = (uint32_t)atomic_get(&uart_tlm_cfg);
+         uint32_t decim = cur & 0xFFFFU;
+         if (decim == 0U) {
+             cfg = cur;
+             continue;
+         }
+         if (cur != cfg) {
+             /* Subscrição nova: começa na amostra mais recente, que segue já */
+             cfg = cur;
+             rtdb_history_follow_zone(0U, &it);
+             lost = 0U;
+             n = decim - 1U;
+             dropped = 0U;
+             evicted = uart_tx_evicted();
+         }
  
-             /* Se byte == '!' e idx == 0 → framing error imediato */
-             if ((byte == '!') && (idx == 0U)) {
-                 send_ack(uart_dev, 'f');
+         while (rtdb_history_next(&it, &s)) {
+             n += 1U + (it.lost - lost);
+             lost = it.lost;
+             if (n < decim) {
                  continue;
              }
+             /* Frames devidos em amostras reescritas antes de lidas: este segue no lugar do último */
+             dropped += (n / decim) - 1U;
+             n = 0U;
+             /* Frames já em fila que uma resposta tirou para ter bloco */
+             uint32_t now = uart_tx_evicted();
+             dropped += now - evicted;
+             evicted = now;
  
-             /* Se byte == '#' e idx > 0 → framing error no frame anterior */
-             if ((byte == '#') && (idx > 0U)) {
-                 send_ack(uart_dev, 'f');
-                 idx = 0U;
-                 buf[idx++] = '#';
-                 continue;
+             o.pos = 0U;
+             o.bin = uart_comm_binary();
+             out_u(&o, s.t_ms, 10U, 4U);
+             out_s(&o, s.temp, 3U, 2U);
+             out_s(&o, rtdb_get_setpoint(), 3U, 2U);
+             out_u(&o, rtdb_get_heater() ? 1U : 0U, 1U, 1U);
+             out_u(&o, dropped, 5U, 4U);
+             if (!send_frame_tx(dev, UART_SEQ_NONE, 'v', o.buf, o.pos, true)) {
+                 dropped++;
              }
+         }
+     }
+ }
+ #endif
  
-             /* Se ENTER no meio de frame (idx > 0) → framing error */
-             if (((byte == '\n') || (byte == '\r')) && (idx > 0U)) {
-                 send_ack(uart_dev, 'f');
-                 idx = 0U;
-                 continue;
-             }
+ bool uart_comm_binary(void)
+ {
+     return atomic_get(&uart_bin_mode) != 0;
+ }
  
-             /* Se for '#' e idx == 0 → começa novo frame */
-             if (byte == '#') {
-                 idx = 0U;
-                 buf[idx++] = byte;
-                 continue;
-             }
+ void uart_comm_send_frame(const struct device *dev, char cmd, const char *data, size_t data_len)
+ {
+     send_frame(dev, cmd, data, data_len);
+ }
  
-             /* Se dentro de um frame (idx > 0), acumula bytes até achar '!' ou encher buffer */
-             if (idx > 0U) {
-                 buf[idx++] = byte;
+ void uart_comm_send_ack(const struct device *dev, char code)
+ {
+     send_ack(dev, code);
+ }
  
-                 /* Se for '!' → fim de frame */
-                 if (byte == '!') {
-                     handle_command(uart_dev, buf, idx);
-                     idx = 0U;
-                     continue;
-                 }
+ static void handle_command(const struct device *dev, const uart_frame_t *f)
+ {
+     send_cmd_result(dev, uart_cmd_handle(dev, f));
+ }
  
-                 /* Se buffer encheu sem ver '!' → framing error */
-                 if (idx >= UART_BUF_SIZE) {
-                     send_ack(uart_dev, 'f');
-                     idx = 0U;
-                     continue;
-                 }
+ static void dispatch(const struct device *dev, const uart_frame_t *f)
+ {
+     send_cmd_result(dev, uart_cmd_dispatch(dev, f));
+ }
  
-                 /* Senão, continua a acumular bytes do frame */
-                 continue;
-             }
+ static void send_cmd_result(const struct device *dev, uart_cmd_result_t r)
+ {
+     if ((r == UART_CMD_CHECKSUM) || (r == UART_CMD_CHECKSUM_INVALID)) {
+         send_ack(dev, 's');  /* checksum error */
+     }
+     if ((r == UART_CMD_INVALID) || (r == UART_CMD_CHECKSUM_INVALID)) {
+         send_ack(dev, 'i');  /* invalid command */
+     }
+ }
  
-             /* 6) Qualquer outro byte fora de frame (idx==0 e não é nem '!' nem '#') → ignora */
+ #if !defined(CONFIG_UART_ASYNC_API)
+ static void uart_rx_isr(const struct device *dev, void *user_data)
+ {
+     uint8_t chunk[UART_RX_CHUNK];
+ 
+     ARG_UNUSED(user_data);
+     if (!uart_irq_update(dev)) {
+         return;
+     }
+     bool rx = false;
+     while (uart_irq_rx_ready(dev)) {
+         int n = uart_fifo_read(dev, chunk, sizeof(chunk));
+         if (n <= 0) {
+             break;
          }
+         (void)uart_ring_put(&uart_rx_ring, chunk, (size_t)n);
+         rx = true;
+     }
+     if (rx) {
+         k_sem_give(&uart_rx_sem);
+     }
+     if (uart_irq_tx_ready(dev)) {
+         uart_tx_fill(dev);
+     }
+ }
+ #endif
  
-         k_sleep(K_MSEC(10));
+ static void uart_task(void *p1, void *p2, void *p3)
+ {
+     ARG_UNUSED(p1);
+     ARG_UNUSED(p2);
+     ARG_UNUSED(p3);
+ 
+     const struct device *uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+     if (!device_is_ready(uart_dev)) {
+         printk("UART not ready\n");
+         return;
+     }
+ 
+     uart_parser_t parser;
+     uint8_t chunk[UART_RX_CHUNK];
+     size_t  n;
+     bool    bin = false;
+ 
+     uart_parser_init(&parser, CONFIG_UARTCOMM_FRAME_TIMEOUT_MS);
+     uart_bin_init(&uart_bin_rx, CONFIG_UARTCOMM_FRAME_TIMEOUT_MS);
+     rtdb_set_source(RTDB_SRC_UART);
+ #if defined(CONFIG_UART_ASYNC_API)
+     uart_callback_set(uart_dev, uart_async_cb, NULL);
+     uart_rx_next = 1U;
+     if (uart_rx_enable(uart_dev, uart_rx_dma[0], UART_RX_DMA_LEN, UART_RX_TIMEOUT_US) != 0) {
+         printk("UART RX not enabled\n");
+         return;
+     }
+ #else
+     uart_irq_callback_user_data_set(uart_dev, uart_rx_isr, NULL);
+     uart_irq_rx_enable(uart_dev);
+ #endif
+ 
+     for (;;) {
+         /* Dorme até haver bytes no buffer circular (ou até expirar um frame a meio) */
+         bool busy = bin ? uart_bin_busy(&uart_bin_rx) : uart_parser_busy(&parser);
+         k_timeout_t wait = (busy && (CONFIG_UARTCOMM_FRAME_TIMEOUT_MS > 0))
+                            ? K_MSEC(CONFIG_UARTCOMM_FRAME_TIMEOUT_MS) : K_FOREVER;
+ #if defined(CONFIG_UARTCOMM_HIST_DUMP)
+         if (uart_hist_ready()) {
+             wait = K_NO_WAIT;   /* Há um chunk do #H para enviar nesta passagem */
+         }
+ #endif
+         (void)k_sem_take(&uart_rx_sem, wait);
+ 
+         uint32_t now = k_uptime_get_32();
+         if (bin ? uart_bin_expire(&uart_bin_rx, now) : uart_parser_expire(&parser, now)) {
+             send_ack(uart_dev, 'f');  /* frame a meio sem bytes novos */
+         }
+ 
+         while ((n = uart_ring_get(&uart_rx_ring, chunk, sizeof(chunk))) > 0U) {
+             now = k_uptime_get_32();
+ 
+             for (size_t i = 0U; i < n; i++) {
+                 uart_parse_ev_t ev = bin ? uart_bin_feed(&uart_bin_rx, chunk[i], now)
+                                          : uart_parser_feed(&parser, chunk[i], now);
+                 switch (ev) {
+                     case UART_PARSE_FRAME: {
+                         const uart_frame_t *f = bin ? &uart_bin_rx.f : &parser.f;
+                         /* Todas as respostas a este pedido levam a sua etiqueta */
+                         uart_reply_seq = f->tagged ? (int)f->seq : UART_SEQ_NONE;
+                         handle_command(uart_dev, f);
+                         uart_reply_seq = UART_SEQ_NONE;
+                         if (uart_comm_binary() != bin) {
+                             /* #N mudou o modo: os bytes seguintes já são do modo novo */
+                             bin = !bin;
+                             uart_parser_init(&parser, CONFIG_UARTCOMM_FRAME_TIMEOUT_MS);
+                             uart_bin_init(&uart_bin_rx, CONFIG_UARTCOMM_FRAME_TIMEOUT_MS);
+                         }
+                         break;
+                     }
+                     case UART_PARSE_ERROR:
+                         send_ack(uart_dev, 'f');  /* framing error */
+                         break;
+                     case UART_PARSE_CHECKSUM:
+                         /* CRC errado (modo binário): a etiqueta é a que chegou */
+                         uart_reply_seq = uart_bin_rx.f.tagged ? (int)uart_bin_rx.f.seq : UART_SEQ_NONE;
+                         send_ack(uart_dev, 's');
+                         uart_reply_seq = UART_SEQ_NONE;
+                         break;
+                     default:
+                         break;
+                 }
+             }
+         }
+ #if defined(CONFIG_UARTCOMM_HIST_DUMP)
+         uart_hist_pump(uart_dev);
+ #endif
      }
  }
- 
\ No newline at end of file
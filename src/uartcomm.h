@@ -2,25 +2,55 @@
 #define UARTCOMM_H
 
 #include <zephyr/device.h>
+#include <errno.h>
+#include "uart_parser.h"
+#include "uart_cmd.h"
 
 /**
  * @file uartcomm.h
  * @brief Interface do módulo de comunicação UART (parser de comandos + framing)
  *
  * @details
- *   Este header exporta apenas a função uart_comm_init(), que inicia uma thread
- *   responsável por ler bytes da UART em modo polling, reconstituir frames do
- *   tipo “#<CMD><DATA><CS>!” e disparar o tratamento de cada comando.
+ *   Este header exporta a função uart_comm_init(), que inicia uma thread
+ *   responsável por receber bytes da UART (API assíncrona ou interrupção, via
+ *   buffer circular), reconstituir frames do tipo “#<CMD><DATA><CS>!” e disparar
+ *   o tratamento de cada comando.
+ *
+ *   Cada comando é uma entrada de uma tabela indexada pelo byte CMD (handler e
+ *   comprimento de DATA, uart_cmd.h); outros módulos podem acrescentar os seus
+ *   comandos com uart_cmd_register() e responder com
+ *   uart_comm_send_frame()/uart_comm_send_ack().
+ *
+ *   Depois de #N1! o protocolo passa ao modo binário (uart_bin.h): os mesmos
+ *   comandos em frames COBS com CRC-16, com os campos numéricos em little-endian.
+ *   Os handlers sabem em que modo chegou o frame por uart_frame_t.bin.
  */
 
 /**
  * @brief Inicializa a thread de comunicação UART
  *
- * Cria uma thread de prioridade 5 que roda uart_task(), fazendo polling da UART,
- * montando e validando frames, e chamando internamente handle_command() para processar
- * cada comando recebido.
+ * Cria uma thread de prioridade 5 que roda uart_task(), que liga a receção da
+ * UART e espera pelos bytes que o callback/ISR lhe entrega, montando e validando
+ * frames, e chamando internamente handle_command() para processar cada comando
+ * recebido.
  */
 void uart_comm_init(void);
 
+/**
+ * @brief true se o protocolo está no modo binário (negociado com #N1!)
+ */
+bool uart_comm_binary(void);
+
+/**
+ * @brief Envia o frame “#<cmd><data><CS>!”, ou o frame binário no modo binário
+ *        (para handlers registados)
+ */
+void uart_comm_send_frame(const struct device *dev, char cmd, const char *data, size_t data_len);
+
+/**
+ * @brief Envia o ACK “#E<code><CS>!” ('o', 'i', 's', 'f')
+ */
+void uart_comm_send_ack(const struct device *dev, char code);
+
 #endif /* UARTCOMM_H */
 
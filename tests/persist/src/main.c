@@ -0,0 +1,148 @@
+/**
+ * @file main.c
+ * @brief Testes da persistência da RTDB em flash (native_sim + simulador de flash)
+ *
+ * @details
+ *   Corre com: west build -b native_sim tests/persist -t run
+ *   (ou west twister -T tests/persist). Antes de rtdb_persist_init() são gravados
+ *   registos "rtdb/..." diretamente com o settings, como se viessem de um arranque
+ *   anterior; os testes verificam o restauro, a agregação das escritas na janela
+ *   CONFIG_RTDB_PERSIST_DELAY_MS e a regravação de registos inválidos.
+ *
+ *   Cada teste parte do mesmo estado (persist_before()): RTDB com os valores por
+ *   omissão, flash com os registos de persist_records() e rtdb_persist_init() acabada
+ *   de correr, por isso a ordem dos testes não importa.
+ */
+
+ #include <zephyr/ztest.h>
+ #include <zephyr/kernel.h>
+ #include <zephyr/settings/settings.h>
+ #include "rtdb.h"
+ #include "rtdb_persist.h"
+ 
+ /** Espera até o flush agendado ter corrido */
+ #define FLUSH_WAIT K_MSEC(CONFIG_RTDB_PERSIST_DELAY_MS + 100)
+ 
+ struct stored {
+     void   *buf;
+     size_t  len;
+     bool    found;
+ };
+ 
+ static int stored_cb(const char *key, size_t len, settings_read_cb read_cb, void *cb_arg,
+                      void *param)
+ {
+     struct stored *s = param;
+ 
+     ARG_UNUSED(key);
+     if (len == s->len) {
+         s->found = (read_cb(cb_arg, s->buf, len) == (ssize_t)len);
+     }
+     return 0;
+ }
+ 
+ /**
+  * @brief Lê da flash o registo name (len bytes) para buf
+  */
+ static bool stored_get(const char *name, void *buf, size_t len)
+ {
+     struct stored s = { buf, len, false };
+ 
+     zassert_ok(settings_load_subtree_direct(name, stored_cb, &s));
+     return s.found;
+ }
+ 
+ /**
+  * @brief Grava os registos "rtdb/..." de um arranque anterior fictício
+  */
+ static void persist_records(void)
+ {
+     const int16_t sp[RTDB_NUM_ZONES] = { 30, 31 };
+     const uint32_t rate = 500U;
+     const uint8_t bad = 0U;
+ 
+     zassert_ok(settings_save_one("rtdb/setpoint", sp, sizeof(sp)));
+     zassert_ok(settings_save_one("rtdb/sampling_rate_ms", &rate, sizeof(rate)));
+     /* Tamanho errado (p.ex. gravado com outro número de zonas): ignorado */
+     zassert_ok(settings_save_one("rtdb/max_temp", &bad, sizeof(bad)));
+ }
+ 
+ static void *persist_setup(void)
+ {
+     zassert_ok(settings_subsys_init());
+     return NULL;
+ }
+ 
+ static void persist_before(void *fixture)
+ {
+     const rtdb_t defaults = RTDB_DEFAULTS;
+ 
+     ARG_UNUSED(fixture);
+ 
+     /* Repõe a RTDB e alinha a flash com ela (o que o teste anterior deixou fica para trás) */
+     for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+         rtdb_zone_t v;
+ 
+         rtdb_schema_view(&defaults, z, &v);
+         zassert_ok(rtdb_update_zone(z, RTDB_PERSIST_MASK, &v));
+     }
+     zassert_ok(rtdb_persist_flush());
+ 
+     /* "Reinício": cancela o flush pendente e restaura os registos gravados */
+     persist_records();
+     zassert_ok(rtdb_persist_init());
+     k_sleep(FLUSH_WAIT);
+ }
+ 
+ ZTEST(rtdb_persist, test_1_restore)
+ {
+     zassert_equal(rtdb_get_setpoint_zone(0), 30);
+     zassert_equal(rtdb_get_setpoint_zone(1), 31);
+     zassert_equal(rtdb_get_sampling_rate(), 500U);
+     zassert_equal(rtdb_get_max_temp(), 80, "registo com tamanho errado não é aplicado");
+ }
+ 
+ ZTEST(rtdb_persist, test_2_coalesce)
+ {
+     int16_t sp[RTDB_NUM_ZONES];
+ 
+     rtdb_set_setpoint(32);
+     rtdb_set_setpoint(33);
+     rtdb_set_setpoint(34);
+ 
+     /* Ainda dentro da janela: a flash mantém o valor anterior */
+     zassert_true(stored_get("rtdb/setpoint", sp, sizeof(sp)));
+     zassert_equal(sp[0], 30);
+ 
+     k_sleep(FLUSH_WAIT);
+     zassert_true(stored_get("rtdb/setpoint", sp, sizeof(sp)));
+     zassert_equal(sp[0], 34);
+     zassert_equal(sp[1], 31);
+ }
+ 
+ ZTEST(rtdb_persist, test_3_flush_now)
+ {
+     uint32_t rate = 0U;
+ 
+     rtdb_set_sampling_rate(750U);
+     zassert_ok(rtdb_persist_flush());
+     zassert_true(stored_get("rtdb/sampling_rate_ms", &rate, sizeof(rate)));
+     zassert_equal(rate, 750U);
+ }
+ 
+ ZTEST(rtdb_persist, test_4_invalid_record_rewritten)
+ {
+     const int16_t min_bad[RTDB_NUM_ZONES] = { 90, 90 };  /* > setpoint e > max_temp */
+     int16_t min[RTDB_NUM_ZONES];
+ 
+     zassert_ok(settings_save_one("rtdb/min_temp", min_bad, sizeof(min_bad)));
+     zassert_ok(rtdb_persist_init());
+     zassert_equal(rtdb_get_min_temp(), 20);
+     zassert_equal(rtdb_get_setpoint(), 30, "zona rejeitada por inteiro");
+ 
+     k_sleep(FLUSH_WAIT);
+     zassert_true(stored_get("rtdb/min_temp", min, sizeof(min)));
+     zassert_equal(min[0], 20);
+ }
+ 
+ ZTEST_SUITE(rtdb_persist, NULL, persist_setup, persist_before, NULL, NULL);
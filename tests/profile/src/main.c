@@ -0,0 +1,195 @@
+/**
+ * @file main.c
+ * @brief Testes dos perfis de configuração da RTDB (native_sim)
+ *
+ * @details
+ *   Corre com: west build -b native_sim tests/profile -t run
+ *   (ou west twister -T tests/profile). Verificam a ativação, o rollback e a
+ *   edição de perfis: a configuração aplicada a todas as zonas, a troca entre a
+ *   configuração ativa e a substituída, quando rtdb_profile_active() deixa de
+ *   apontar para o perfil e a avaliação dos triggers das zonas 1.. na troca.
+ *
+ *   Cada teste parte do mesmo estado (profile_before()): RTDB com os valores por
+ *   omissão e nenhum perfil ativo, perfis 0 e 1 definidos como PROF0_* / PROF1_* e
+ *   os perfis 2 e 3 por definir, por isso a ordem dos testes não importa.
+ */
+
+ #include <zephyr/ztest.h>
+ #include <zephyr/kernel.h>
+ #include "rtdb.h"
+ 
+ /* Setpoints (zona 0, zona 1) e sampling_rate dos perfis 0 e 1 */
+ #define PROF0_SP0  30
+ #define PROF0_SP1  31
+ #define PROF0_RATE 500U
+ #define PROF1_SP0  35
+ #define PROF1_SP1  45
+ #define PROF1_RATE 250U
+ 
+ /** Dispara com setpoint > 40: só a zona 1 do perfil 1 o ultrapassa */
+ static struct rtdb_trigger sp_high = {
+     .field = RTDB_ID_SETPOINT,
+     .cond  = RTDB_TRIG_GT,
+     .arg   = 40,
+ };
+ 
+ /**
+  * @brief Redefine o perfil n a partir da configuração atual, com os setpoints e o
+  *        sampling_rate dados
+  */
+ static void profile_define(uint8_t n, int16_t sp0, int16_t sp1, uint32_t rate)
+ {
+     rtdb_zone_t v = { 0 };
+ 
+     zassert_ok(rtdb_profile_save(n, "teste"));
+     v.setpoint = sp0;
+     zassert_ok(rtdb_profile_edit(n, 0U, RTDB_F_SETPOINT, &v));
+     v.setpoint = sp1;
+     v.sampling_rate_ms = rate;
+     zassert_ok(rtdb_profile_edit(n, 1U, RTDB_F_SETPOINT | RTDB_F_SAMPLING_RATE, &v));
+ }
+ 
+ /**
+  * @brief Verifica os setpoints das duas zonas e o sampling_rate em uso
+  */
+ static void config_check(int16_t sp0, int16_t sp1, uint32_t rate)
+ {
+     zassert_equal(rtdb_get_setpoint_zone(0), sp0);
+     zassert_equal(rtdb_get_setpoint_zone(1), sp1);
+     zassert_equal(rtdb_get_sampling_rate(), rate);
+ }
+ 
+ static void *profile_setup(void)
+ {
+     zassert_ok(rtdb_trigger_register(&sp_high));
+     return NULL;
+ }
+ 
+ static void profile_before(void *fixture)
+ {
+     const rtdb_t defaults = RTDB_DEFAULTS;
+ 
+     ARG_UNUSED(fixture);
+ 
+     /* Repõe a configuração (e rearma o trigger de cada zona) */
+     for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+         rtdb_zone_t v;
+ 
+         rtdb_schema_view(&defaults, z, &v);
+         zassert_ok(rtdb_update_zone(z, RTDB_DOM_MASK_CFG, &v));
+     }
+     /* Uma escrita direta que muda um campo do perfil: nenhum perfil fica ativo */
+     rtdb_set_sampling_rate(defaults.sampling_rate_ms + 1U);
+     rtdb_set_sampling_rate(defaults.sampling_rate_ms);
+     zassert_equal(rtdb_profile_active(), -1);
+ 
+     profile_define(0U, PROF0_SP0, PROF0_SP1, PROF0_RATE);
+     profile_define(1U, PROF1_SP0, PROF1_SP1, PROF1_RATE);
+ }
+ 
+ ZTEST(rtdb_profile, test_rollback_swaps)
+ {
+     zassert_ok(rtdb_profile_activate(0U));
+     config_check(PROF0_SP0, PROF0_SP1, PROF0_RATE);
+     zassert_equal(rtdb_profile_active(), 0);
+ 
+     /* Volta à configuração substituída, sem perfil; outro rollback refaz a ativação */
+     zassert_ok(rtdb_profile_rollback());
+     config_check(26, 26, 1000U);
+     zassert_equal(rtdb_profile_active(), -1);
+     zassert_ok(rtdb_profile_rollback());
+     config_check(PROF0_SP0, PROF0_SP1, PROF0_RATE);
+     zassert_equal(rtdb_profile_active(), 0);
+ 
+     /* Entre dois perfis o rollback troca também o perfil ativo */
+     zassert_ok(rtdb_profile_activate(1U));
+     config_check(PROF1_SP0, PROF1_SP1, PROF1_RATE);
+     zassert_equal(rtdb_profile_active(), 1);
+     zassert_ok(rtdb_profile_rollback());
+     config_check(PROF0_SP0, PROF0_SP1, PROF0_RATE);
+     zassert_equal(rtdb_profile_active(), 0);
+     zassert_ok(rtdb_profile_rollback());
+     config_check(PROF1_SP0, PROF1_SP1, PROF1_RATE);
+     zassert_equal(rtdb_profile_active(), 1);
+ }
+ 
+ ZTEST(rtdb_profile, test_edit_active_profile)
+ {
+     rtdb_zone_t v = { 0 };
+     rtdb_profile_t p;
+ 
+     zassert_ok(rtdb_profile_activate(0U));
+ 
+     /* Editar outro perfil, ou o ativo sem mudar nada, mantém o perfil ativo */
+     v.setpoint = 33;
+     zassert_ok(rtdb_profile_edit(1U, 1U, RTDB_F_SETPOINT, &v));
+     zassert_equal(rtdb_profile_active(), 0);
+     v.setpoint = PROF0_SP1;
+     zassert_ok(rtdb_profile_edit(0U, 1U, RTDB_F_SETPOINT, &v));
+     zassert_equal(rtdb_profile_active(), 0);
+ 
+     /* Editar o ativo deixa de corresponder à configuração em uso, que não muda */
+     v.setpoint = 33;
+     zassert_ok(rtdb_profile_edit(0U, 1U, RTDB_F_SETPOINT, &v));
+     zassert_equal(rtdb_profile_active(), -1);
+     config_check(PROF0_SP0, PROF0_SP1, PROF0_RATE);
+ 
+     /* Edição inválida (setpoint acima de max_temp): rejeitada, perfil inalterado */
+     v.setpoint = 90;
+     zassert_equal(rtdb_profile_edit(0U, 1U, RTDB_F_SETPOINT, &v), RTDB_EINVAL);
+     zassert_true(rtdb_profile_get(0U, &p));
+     zassert_equal(p.cfg.setpoint[1], 33);
+ }
+ 
+ ZTEST(rtdb_profile, test_direct_write_clears_active)
+ {
+     /* Campo de zona escrito fora do perfil, noutra zona que não a 0 */
+     zassert_ok(rtdb_profile_activate(0U));
+     zassert_ok(rtdb_set_zone(1U, RTDB_ID_MAX_TEMP, 70));
+     zassert_equal(rtdb_profile_active(), -1);
+ 
+     /* Campo global pelo acessor tipado */
+     zassert_ok(rtdb_profile_activate(0U));
+     rtdb_set_sampling_rate(600U);
+     zassert_equal(rtdb_profile_active(), -1);
+ 
+     /* system_on não faz parte dos perfis: o perfil continua ativo */
+     zassert_ok(rtdb_profile_activate(0U));
+     rtdb_set_system_on(false);
+     zassert_equal(rtdb_profile_active(), 0);
+ }
+ 
+ ZTEST(rtdb_profile, test_activate_undefined)
+ {
+     rtdb_profile_t p;
+ 
+     zassert_ok(rtdb_profile_activate(0U));
+ 
+     /* Perfil por definir ou inexistente: nada muda, nem o que o rollback repõe */
+     zassert_false(rtdb_profile_get(3U, &p));
+     zassert_equal(rtdb_profile_activate(3U), RTDB_EINVAL);
+     zassert_equal(rtdb_profile_activate(RTDB_MAX_PROFILES), RTDB_EINVAL);
+     config_check(PROF0_SP0, PROF0_SP1, PROF0_RATE);
+     zassert_equal(rtdb_profile_active(), 0);
+ 
+     zassert_ok(rtdb_profile_rollback());
+     config_check(26, 26, 1000U);
+     zassert_equal(rtdb_profile_active(), -1);
+ }
+ 
+ ZTEST(rtdb_profile, test_triggers_other_zones)
+ {
+     zassert_false(rtdb_trigger_tripped(&sp_high, 0U));
+     zassert_false(rtdb_trigger_tripped(&sp_high, 1U));
+ 
+     /* O perfil 1 só leva a zona 1 acima do limiar */
+     zassert_ok(rtdb_profile_activate(1U));
+     zassert_false(rtdb_trigger_tripped(&sp_high, 0U));
+     zassert_true(rtdb_trigger_tripped(&sp_high, 1U));
+ 
+     /* O rollback rearma-o */
+     zassert_ok(rtdb_profile_rollback());
+     zassert_false(rtdb_trigger_tripped(&sp_high, 1U));
+ }
+ 
+ ZTEST_SUITE(rtdb_profile, NULL, profile_setup, profile_before, NULL, NULL);
@@ -1,6 +1,7 @@
 #include "unity.h"
 #include "controller_dummy.h"
 #include "rtdb_dummy.h"
+#include "ctrl_logic.h"
 
 /* Limpa antes de cada teste */
 void setUp(void) {
@@ -94,6 +95,16 @@ void test_controller_sequence(void) {
     TEST_ASSERT_FALSE(r);   // 60 > 50 
 }
 
+/* 7) Lógica partilhada por control_task e pelo replay do diário: histerese e proteções */
+void test_ctrl_logic_hysteresis(void) {
+    TEST_ASSERT_FALSE(ctrl_logic_step(true, false, 25, 24, true));    // ≤ sp-1
+    TEST_ASSERT_TRUE(ctrl_logic_step(true, false, 25, 26, false));    // ≥ sp+1
+    TEST_ASSERT_TRUE(ctrl_logic_step(true, false, 25, 25, true));     // banda: mantém
+    TEST_ASSERT_FALSE(ctrl_logic_step(true, false, 25, 25, false));
+    TEST_ASSERT_FALSE(ctrl_logic_step(false, false, 25, 30, true));   // sistema desligado
+    TEST_ASSERT_FALSE(ctrl_logic_step(true, true, 25, 30, true));     // proteção ativa
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_controller_system_off_always_off);
@@ -102,6 +113,7 @@ int main(void) {
     RUN_TEST(test_controller_turn_on_below_sp);
     RUN_TEST(test_controller_turn_off_above_or_equal_sp);
     RUN_TEST(test_controller_sequence);
+    RUN_TEST(test_ctrl_logic_hysteresis);
     return UNITY_END();
 }
 
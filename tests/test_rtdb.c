@@ -1,6 +1,12 @@
 #include "unity.h"
 #include "rtdb_dummy.h"
+#include "rtdb_history.h"
+#include "rtdb_lockstat.h"
+#include "rtdb_stats.h"
+#include "rtdb_journal.h"
+#include "rtdb_shm.h"
 #include <stdint.h>
+#include <string.h>
 
 /* 1) Zera o RTDB para valores default */
 void setUp(void) {
@@ -109,6 +115,472 @@ void test_set_sampling_rate_valid(void) {
     TEST_ASSERT_EQUAL_UINT32(10, rtdb_dummy_get_sampling_rate());
 }
 
+/* 13) Testa snapshot: cópia reflete todos os campos ao mesmo tempo */
+void test_snapshot_copies_all_fields(void) {
+    rtdb_dummy_set_system_on(false);
+    rtdb_dummy_set_setpoint(30);
+    rtdb_dummy_set_current_temp(27);
+    rtdb_dummy_set_sampling_rate(250);
+
+    rtdb_dummy_t snap;
+    rtdb_dummy_snapshot(&snap);
+    TEST_ASSERT_FALSE(snap.system_on);
+    TEST_ASSERT_EQUAL_INT16(30, snap.setpoint[0]);
+    TEST_ASSERT_EQUAL_INT16(27, snap.current_temp[0]);
+    TEST_ASSERT_EQUAL_INT16(80, snap.max_temp[0]);
+    TEST_ASSERT_EQUAL_INT16(20, snap.min_temp[0]);
+    TEST_ASSERT_EQUAL_UINT32(250, snap.sampling_rate_ms);
+
+    /* Alterações posteriores não afetam a cópia */
+    rtdb_dummy_set_setpoint(22);
+    TEST_ASSERT_EQUAL_INT16(30, snap.setpoint[0]);
+}
+
+/* 14) Testa update: vários campos aplicados de uma só vez */
+void test_update_multiple_fields(void) {
+    rtdb_zone_t req = { .setpoint = 40, .max_temp = 50, .min_temp = 30 };
+    TEST_ASSERT_EQUAL_INT(RTDB_OK,
+        rtdb_dummy_update(RTDB_F_SETPOINT | RTDB_F_MAX_TEMP | RTDB_F_MIN_TEMP, &req));
+    TEST_ASSERT_EQUAL_INT16(40, rtdb_dummy_get_setpoint());
+    TEST_ASSERT_EQUAL_INT16(50, rtdb_dummy_get_max_temp());
+    TEST_ASSERT_EQUAL_INT16(30, rtdb_dummy_get_min_temp());
+}
+
+/* 15) Testa update: invariante violada → nada muda */
+void test_update_rejects_invalid(void) {
+    rtdb_zone_t req = { .min_temp = 90 };   /* min > max (80) */
+    TEST_ASSERT_EQUAL_INT(RTDB_EINVAL, rtdb_dummy_update(RTDB_F_MIN_TEMP, &req));
+    TEST_ASSERT_EQUAL_INT16(20, rtdb_dummy_get_min_temp());
+
+    req.setpoint = 85;                       /* setpoint explícito fora de [min,max] */
+    TEST_ASSERT_EQUAL_INT(RTDB_EINVAL, rtdb_dummy_update(RTDB_F_SETPOINT, &req));
+    TEST_ASSERT_EQUAL_INT16(26, rtdb_dummy_get_setpoint());
+
+    req.sampling_rate_ms = 5;
+    TEST_ASSERT_EQUAL_INT(RTDB_EINVAL, rtdb_dummy_update(RTDB_F_SAMPLING_RATE, &req));
+    TEST_ASSERT_EQUAL_UINT32(1000, rtdb_dummy_get_sampling_rate());
+}
+
+/* 16) Testa update: setpoint implícito acompanha os novos limites */
+void test_update_clamps_implicit_setpoint(void) {
+    rtdb_zone_t req = { .max_temp = 24 };
+    TEST_ASSERT_EQUAL_INT(RTDB_OK, rtdb_dummy_update(RTDB_F_MAX_TEMP, &req));
+    TEST_ASSERT_EQUAL_INT16(24, rtdb_dummy_get_setpoint());
+}
+
+/* 17) Testa caminho genérico por identificador e regras de acesso da tabela */
+void test_generic_get_set(void) {
+    TEST_ASSERT_EQUAL_INT32(26, rtdb_dummy_get(RTDB_ID_SETPOINT));
+
+    TEST_ASSERT_EQUAL_INT(RTDB_OK, rtdb_dummy_set(RTDB_ID_SETPOINT, 30));
+    TEST_ASSERT_EQUAL_INT16(30, rtdb_dummy_get_setpoint());
+
+    /* Campo de medição (RTDB_RO) não é escrito pelo caminho genérico */
+    TEST_ASSERT_EQUAL_INT(RTDB_EACCES, rtdb_dummy_set(RTDB_ID_CURRENT_TEMP, 50));
+    TEST_ASSERT_EQUAL_INT16(0, rtdb_dummy_get_current_temp());
+
+    /* Fora dos limites da tabela → rejeitado (o setter tipado satura) */
+    TEST_ASSERT_EQUAL_INT(RTDB_EINVAL, rtdb_dummy_set(RTDB_ID_SAMPLING_RATE, 70000));
+    TEST_ASSERT_EQUAL_UINT32(1000, rtdb_dummy_get_sampling_rate());
+}
+
+/* 18) Testa histórico: janela temporal devolve só as amostras do intervalo, por ordem */
+void test_history_window(void) {
+    static rtdb_history_t h;
+    memset(&h, 0, sizeof(h));
+    for (uint32_t i = 0; i < 10; i++) {
+        rtdb_history_push(&h, 1000 + i * 100, (int16_t)(20 + i));
+    }
+
+    rtdb_hist_iter_t it;
+    rtdb_sample_t s;
+    rtdb_history_iter_init(&it, &h, 1250, 1500);
+
+    TEST_ASSERT_TRUE(rtdb_history_next(&it, &s));
+    TEST_ASSERT_EQUAL_UINT32(1300, s.t_ms);
+    TEST_ASSERT_EQUAL_INT16(23, s.temp);
+    TEST_ASSERT_TRUE(rtdb_history_next(&it, &s));
+    TEST_ASSERT_EQUAL_UINT32(1400, s.t_ms);
+    TEST_ASSERT_TRUE(rtdb_history_next(&it, &s));
+    TEST_ASSERT_EQUAL_UINT32(1500, s.t_ms);
+    TEST_ASSERT_FALSE(rtdb_history_next(&it, &s));
+}
+
+/* 19) Testa histórico: após dar a volta só restam as RTDB_HIST_LEN amostras mais recentes */
+void test_history_overwrite(void) {
+    static rtdb_history_t h;
+    memset(&h, 0, sizeof(h));
+    for (uint32_t i = 0; i < RTDB_HIST_LEN + 5; i++) {
+        rtdb_history_push(&h, i, (int16_t)i);
+    }
+
+    rtdb_hist_iter_t it;
+    rtdb_sample_t s;
+    uint32_t n = 0;
+    rtdb_history_iter_init(&it, &h, 0, UINT32_MAX / 2);
+    TEST_ASSERT_TRUE(rtdb_history_next(&it, &s));
+    TEST_ASSERT_EQUAL_UINT32(5, s.t_ms);
+    n++;
+    while (rtdb_history_next(&it, &s)) {
+        n++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(RTDB_HIST_LEN, n);
+    TEST_ASSERT_EQUAL_UINT32(RTDB_HIST_LEN + 4, s.t_ms);
+}
+
+/* 20) Testa zonas: cada zona tem os seus limites, setpoint e temperatura */
+void test_zones_are_independent(void) {
+    TEST_ASSERT_TRUE(RTDB_NUM_ZONES >= 2);
+
+    rtdb_zone_t req = { .max_temp = 40, .setpoint = 35 };
+    TEST_ASSERT_EQUAL_INT(RTDB_OK,
+        rtdb_dummy_update_zone(1, RTDB_F_MAX_TEMP | RTDB_F_SETPOINT, &req));
+    rtdb_dummy_set_current_temp_zone(1, 33);
+    rtdb_dummy_set_setpoint_zone(1, 50);          /* satura ao max_temp da zona 1 */
+
+    TEST_ASSERT_EQUAL_INT16(40, rtdb_dummy_get_setpoint_zone(1));
+    TEST_ASSERT_EQUAL_INT16(33, rtdb_dummy_get_current_temp_zone(1));
+
+    /* Zona 0 (acessores sem sufixo) inalterada */
+    TEST_ASSERT_EQUAL_INT16(26, rtdb_dummy_get_setpoint());
+    TEST_ASSERT_EQUAL_INT16(80, rtdb_dummy_get_max_temp());
+    TEST_ASSERT_EQUAL_INT16(0,  rtdb_dummy_get_current_temp());
+
+    rtdb_dummy_t snap;
+    rtdb_dummy_snapshot(&snap);
+    TEST_ASSERT_EQUAL_INT16(26, snap.setpoint[0]);
+    TEST_ASSERT_EQUAL_INT16(40, snap.setpoint[1]);
+}
+
+/* 21) Testa zonas: zona inexistente é rejeitada, campos globais são partilhados */
+void test_zone_out_of_range(void) {
+    rtdb_zone_t req = { .setpoint = 30 };
+    TEST_ASSERT_EQUAL_INT(RTDB_EINVAL,
+        rtdb_dummy_update_zone(RTDB_NUM_ZONES, RTDB_F_SETPOINT, &req));
+
+    req.sampling_rate_ms = 500;
+    TEST_ASSERT_EQUAL_INT(RTDB_OK, rtdb_dummy_update_zone(1, RTDB_F_SAMPLING_RATE, &req));
+    TEST_ASSERT_EQUAL_UINT32(500, rtdb_dummy_get_sampling_rate());
+}
+
+/* 22) Testa lockstat: buckets logarítmicos de ciclos */
+void test_lockstat_buckets(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, rtdb_lockstat_bucket(0));
+    TEST_ASSERT_EQUAL_UINT8(0, rtdb_lockstat_bucket(63));
+    TEST_ASSERT_EQUAL_UINT8(1, rtdb_lockstat_bucket(64));
+    TEST_ASSERT_EQUAL_UINT8(1, rtdb_lockstat_bucket(127));
+    TEST_ASSERT_EQUAL_UINT8(2, rtdb_lockstat_bucket(128));
+    TEST_ASSERT_EQUAL_UINT8(RTDB_LOCKSTAT_BUCKETS - 1, rtdb_lockstat_bucket(UINT32_MAX));
+}
+
+/* 23) Testa lockstat: uma entrada por chamador, a última partilhada quando a tabela enche */
+void test_lockstat_per_caller(void) {
+    static rtdb_lockstat_t tab[2];
+    static int a, b, c;
+    memset(tab, 0, sizeof(tab));
+
+    rtdb_lockstat_record(rtdb_lockstat_slot(tab, 2, &a), 10, 100);
+    rtdb_lockstat_record(rtdb_lockstat_slot(tab, 2, &b), 5000, 20);
+    rtdb_lockstat_record(rtdb_lockstat_slot(tab, 2, &a), 70, 30);
+    rtdb_lockstat_record(rtdb_lockstat_slot(tab, 2, &c), 1, 1);   /* tabela cheia → tab[1] */
+
+    TEST_ASSERT_EQUAL_PTR(&a, tab[0].caller);
+    TEST_ASSERT_EQUAL_UINT32(2, tab[0].count);
+    TEST_ASSERT_EQUAL_UINT32(70, tab[0].wait_max);
+    TEST_ASSERT_EQUAL_UINT32(100, tab[0].hold_max);
+    TEST_ASSERT_EQUAL_UINT32(1, tab[0].wait_hist[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, tab[0].wait_hist[1]);
+    TEST_ASSERT_EQUAL_UINT32(1, tab[0].hold_hist[1]);
+
+    TEST_ASSERT_EQUAL_PTR(&b, tab[1].caller);
+    TEST_ASSERT_EQUAL_UINT32(2, tab[1].count);
+    TEST_ASSERT_EQUAL_UINT32(5000, tab[1].wait_max);
+}
+
+/* 24) Testa toggle/step atómicos (botões): saturação sinalizada nos limites */
+void test_toggle_and_step(void) {
+    TEST_ASSERT_FALSE(rtdb_dummy_toggle_system_on());
+    TEST_ASSERT_TRUE(rtdb_dummy_toggle_system_on());
+
+    bool sat = true;
+    rtdb_dummy_set_max_temp(27);
+    TEST_ASSERT_EQUAL_INT16(27, rtdb_dummy_step_setpoint(+1, &sat));
+    TEST_ASSERT_FALSE(sat);
+    TEST_ASSERT_EQUAL_INT16(27, rtdb_dummy_step_setpoint(+1, &sat));
+    TEST_ASSERT_TRUE(sat);
+
+    rtdb_dummy_set_min_temp(26);
+    TEST_ASSERT_EQUAL_INT16(26, rtdb_dummy_step_setpoint(-1, &sat));
+    TEST_ASSERT_FALSE(sat);
+    TEST_ASSERT_EQUAL_INT16(26, rtdb_dummy_step_setpoint(-1, NULL));
+    TEST_ASSERT_EQUAL_INT16(26, rtdb_dummy_step_setpoint(-1, &sat));
+    TEST_ASSERT_TRUE(sat);
+}
+
+/* 25) Testa os domínios de lock: partição dos campos e cópia por domínio */
+void test_lock_domains(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, RTDB_DOM_MASK_CFG & RTDB_DOM_MASK_MEAS);
+    TEST_ASSERT_EQUAL_UINT32((1U << RTDB_NUM_FIELDS) - 1U, RTDB_DOM_MASK_CFG | RTDB_DOM_MASK_MEAS);
+    TEST_ASSERT_EQUAL_UINT32(RTDB_F_CURRENT_TEMP | RTDB_F_HEATER, RTDB_DOM_MASK_MEAS);
+    TEST_ASSERT_EQUAL(RTDB_DOM_CFG, RTDB_DOMAIN(RTDB_ID_SETPOINT));
+    TEST_ASSERT_EQUAL(RTDB_DOM_MEAS, RTDB_DOMAIN(RTDB_ID_CURRENT_TEMP));
+
+    rtdb_t src = RTDB_DEFAULTS;
+    rtdb_t dst = RTDB_DEFAULTS;
+    src.setpoint[0] = 30;
+    src.current_temp[1] = 42;
+    src.heater[1] = true;
+    rtdb_schema_copy_domain(&dst, &src, RTDB_DOM_MEAS);
+    TEST_ASSERT_EQUAL_INT16(42, dst.current_temp[1]);
+    TEST_ASSERT_TRUE(dst.heater[1]);
+    TEST_ASSERT_EQUAL_INT16(26, dst.setpoint[0]);
+    rtdb_schema_copy_domain(&dst, &src, RTDB_DOM_CFG);
+    TEST_ASSERT_EQUAL_INT16(30, dst.setpoint[0]);
+
+    /* Uma atualização só de configuração não reescreve campos de medição */
+    rtdb_zone_t req = { .max_temp = 40 };
+    uint32_t changed;
+    src.current_temp[0] = 55;
+    TEST_ASSERT_EQUAL(RTDB_OK, rtdb_schema_update(&src, 0, RTDB_F_MAX_TEMP, &req, &changed));
+    TEST_ASSERT_EQUAL_UINT32(RTDB_F_MAX_TEMP, changed);
+    TEST_ASSERT_EQUAL_INT16(55, src.current_temp[0]);
+
+    /* Campos RTDB_RO não passam pelo caminho genérico, nem misturados com RTDB_RW */
+    req.current_temp = 70;
+    req.max_temp = 50;
+    TEST_ASSERT_EQUAL(RTDB_EACCES,
+                      rtdb_schema_update(&src, 0, RTDB_F_CURRENT_TEMP, &req, &changed));
+    TEST_ASSERT_EQUAL(RTDB_EACCES,
+                      rtdb_schema_update(&src, 0, RTDB_F_MAX_TEMP | RTDB_F_HEATER, &req, &changed));
+    TEST_ASSERT_EQUAL_UINT32(0, changed);
+    TEST_ASSERT_EQUAL_INT16(55, src.current_temp[0]);
+    TEST_ASSERT_EQUAL_INT16(40, src.max_temp[0]);
+}
+
+/* 26) Testa o acesso por nome/blob usado pela persistência em flash */
+void test_schema_find_raw(void) {
+    rtdb_t db = RTDB_DEFAULTS;
+    size_t size;
+
+    TEST_ASSERT_EQUAL(RTDB_ID_SETPOINT, rtdb_schema_find("setpoint"));
+    TEST_ASSERT_EQUAL(RTDB_ID_SAMPLING_RATE, rtdb_schema_find("sampling_rate_ms"));
+    TEST_ASSERT_EQUAL(RTDB_NUM_FIELDS, rtdb_schema_find("nao_existe"));
+
+    TEST_ASSERT_EQUAL_PTR(&db.setpoint, rtdb_schema_raw(&db, RTDB_ID_SETPOINT, &size));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(int16_t) * RTDB_NUM_ZONES, size);
+    TEST_ASSERT_EQUAL_PTR(&db.sampling_rate_ms, rtdb_schema_raw(&db, RTDB_ID_SAMPLING_RATE, &size));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(uint32_t), size);
+    TEST_ASSERT_NULL(rtdb_schema_raw(&db, RTDB_NUM_FIELDS, &size));
+    TEST_ASSERT_EQUAL_UINT32(0, size);
+}
+
+/* 27) Testa as estatísticas incrementais: mín./máx., média e variância amostral */
+void test_stats_welford(void) {
+    rtdb_stats_t s;
+    const int16_t x[] = { 20, 22, 24, 26, 28 };  /* média 24, variância 10 */
+
+    rtdb_stats_reset(&s);
+    TEST_ASSERT_EQUAL_INT32(0, rtdb_stats_mean_centi(&s));
+    TEST_ASSERT_EQUAL_UINT32(0, rtdb_stats_var_centi(&s));
+
+    for (uint32_t i = 0; i < 5; i++) {
+        rtdb_stats_add(&s, x[i], 24, i * 1000U);
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, s.n);
+    TEST_ASSERT_EQUAL_INT16(20, s.min);
+    TEST_ASSERT_EQUAL_INT16(28, s.max);
+    TEST_ASSERT_EQUAL_INT32(2400, rtdb_stats_mean_centi(&s));
+    TEST_ASSERT_EQUAL_UINT32(1000, rtdb_stats_var_centi(&s));
+
+    /* Muitas amostras constantes: sem deriva da média nem variância espúria */
+    rtdb_stats_reset(&s);
+    for (uint32_t i = 0; i < 100000U; i++) {
+        rtdb_stats_add(&s, -7, 0, i);
+    }
+    TEST_ASSERT_EQUAL_INT32(-700, rtdb_stats_mean_centi(&s));
+    TEST_ASSERT_EQUAL_UINT32(0, rtdb_stats_var_centi(&s));
+}
+
+/* 28) Testa o tempo passado em cada banda em torno do setpoint */
+void test_stats_time_in_band(void) {
+    rtdb_stats_t s;
+
+    TEST_ASSERT_EQUAL_UINT8(0, rtdb_stats_bin(-50));
+    TEST_ASSERT_EQUAL_UINT8(RTDB_STATS_BAND_HALF, rtdb_stats_bin(0));
+    TEST_ASSERT_EQUAL_UINT8(RTDB_STATS_BINS - 1U, rtdb_stats_bin(4));
+
+    rtdb_stats_reset(&s);
+    rtdb_stats_add(&s, 26, 26, 0xFFFFF000U);   /* no setpoint durante 0x1000 ms (com wrap) */
+    rtdb_stats_add(&s, 27, 26, 0x00000000U);   /* +1 durante 500 ms */
+    rtdb_stats_add(&s, 10, 26, 500U);          /* ≤ -3 até à próxima amostra */
+    rtdb_stats_add(&s, 26, 26, 2500U);
+
+    TEST_ASSERT_EQUAL_UINT32(0x1000U, s.band_ms[RTDB_STATS_BAND_HALF]);
+    TEST_ASSERT_EQUAL_UINT32(500U, s.band_ms[RTDB_STATS_BAND_HALF + 1]);
+    TEST_ASSERT_EQUAL_UINT32(2000U, s.band_ms[0]);
+}
+
+/* 29) Testa as condições dos triggers e os campos que as podem alterar */
+void test_trigger_conditions(void) {
+    rtdb_t db = RTDB_DEFAULTS;
+
+    db.current_temp[1] = 81;
+    TEST_ASSERT_FALSE(rtdb_schema_cond(&db, 0, RTDB_ID_CURRENT_TEMP, RTDB_TRIG_GT_FIELD, RTDB_ID_MAX_TEMP));
+    TEST_ASSERT_TRUE(rtdb_schema_cond(&db, 1, RTDB_ID_CURRENT_TEMP, RTDB_TRIG_GT_FIELD, RTDB_ID_MAX_TEMP));
+    TEST_ASSERT_TRUE(rtdb_schema_cond(&db, 0, RTDB_ID_CURRENT_TEMP, RTDB_TRIG_LT_FIELD, RTDB_ID_MIN_TEMP));
+    TEST_ASSERT_TRUE(rtdb_schema_cond(&db, 1, RTDB_ID_CURRENT_TEMP, RTDB_TRIG_GT, 80));
+    TEST_ASSERT_FALSE(rtdb_schema_cond(&db, 1, RTDB_ID_CURRENT_TEMP, RTDB_TRIG_LT, 81));
+    TEST_ASSERT_FALSE(rtdb_schema_cond(&db, 1, RTDB_ID_CURRENT_TEMP, RTDB_TRIG_STALE, 1));
+    TEST_ASSERT_FALSE(rtdb_schema_cond(&db, RTDB_NUM_ZONES, RTDB_ID_CURRENT_TEMP, RTDB_TRIG_GT, -200));
+    TEST_ASSERT_FALSE(rtdb_schema_cond(&db, 0, RTDB_ID_CURRENT_TEMP, RTDB_TRIG_GT_FIELD, RTDB_NUM_FIELDS));
+
+    TEST_ASSERT_EQUAL_UINT32(RTDB_F_CURRENT_TEMP | RTDB_F_MAX_TEMP,
+        rtdb_schema_cond_watch(RTDB_ID_CURRENT_TEMP, RTDB_TRIG_GT_FIELD, RTDB_ID_MAX_TEMP));
+    TEST_ASSERT_EQUAL_UINT32(RTDB_F_CURRENT_TEMP,
+        rtdb_schema_cond_watch(RTDB_ID_CURRENT_TEMP, RTDB_TRIG_STALE, RTDB_ID_MAX_TEMP));
+}
+
+/* 30) Testa o diário: índices absolutos, volta do buffer e entradas reescritas */
+void test_journal_ring(void) {
+    static rtdb_journal_t j;
+    rtdb_jentry_t e = { .id = RTDB_ID_CURRENT_TEMP, .src = RTDB_SRC_SENSOR };
+    rtdb_jentry_t out;
+    memset(&j, 0, sizeof(j));
+
+    TEST_ASSERT_FALSE(rtdb_journal_read(&j, 0, &out));
+    for (uint32_t i = 0; i < RTDB_JOURNAL_LEN + 3; i++) {
+        e.t_ms = 100 * i;
+        e.val = (int32_t)i;
+        rtdb_journal_push(&j, &e);
+    }
+
+    uint32_t head = rtdb_journal_head(&j);
+    TEST_ASSERT_EQUAL_UINT32(RTDB_JOURNAL_LEN + 3, head);
+    TEST_ASSERT_EQUAL_UINT32(3, rtdb_journal_oldest(head));
+    TEST_ASSERT_FALSE(rtdb_journal_read(&j, 2, &out));   /* já reescrita */
+    TEST_ASSERT_TRUE(rtdb_journal_read(&j, 3, &out));
+    TEST_ASSERT_EQUAL_INT32(3, out.val);
+    TEST_ASSERT_TRUE(rtdb_journal_read(&j, head - 1, &out));
+    TEST_ASSERT_EQUAL_UINT32(100 * (head - 1), out.t_ms);
+    TEST_ASSERT_FALSE(rtdb_journal_read(&j, head, &out));
+}
+
+/* 31) Testa a codificação hexadecimal das entradas do diário (ida e volta) */
+void test_journal_encode_decode(void) {
+    rtdb_jentry_t e = { .t_ms = 0xDEADBEEFU, .id = RTDB_ID_SAMPLING_RATE, .zone = 1,
+                        .src = RTDB_SRC_UART, .old = -128, .val = 60000 };
+    rtdb_jentry_t d;
+    char hex[RTDB_JOURNAL_HEX_LEN + 1];
+
+    rtdb_journal_encode(&e, hex);
+    hex[RTDB_JOURNAL_HEX_LEN] = '\0';
+    TEST_ASSERT_EQUAL_INT(0, memcmp(hex, "EFBEADDE", 8));   /* t_ms little-endian */
+    TEST_ASSERT_TRUE(rtdb_journal_decode(hex, &d));
+    TEST_ASSERT_EQUAL_UINT32(e.t_ms, d.t_ms);
+    TEST_ASSERT_EQUAL_UINT8(e.id, d.id);
+    TEST_ASSERT_EQUAL_UINT8(e.zone, d.zone);
+    TEST_ASSERT_EQUAL_UINT8(e.src, d.src);
+    TEST_ASSERT_EQUAL_INT32(-128, d.old);
+    TEST_ASSERT_EQUAL_INT32(60000, d.val);
+
+    hex[5] = 'x';
+    TEST_ASSERT_FALSE(rtdb_journal_decode(hex, &d));
+}
+
+/* 32) Testa a vista partilhada: publicação por domínio, leitura e escrita em curso */
+void test_shm_publish_read(void) {
+    static rtdb_shm_t shm;
+    rtdb_stats_t stats[RTDB_NUM_ZONES];
+    rtdb_stats_t got[RTDB_NUM_ZONES];
+    rtdb_t db = RTDB_DEFAULTS;
+    rtdb_t out;
+
+    rtdb_shm_format(&shm, &db);
+    TEST_ASSERT_TRUE(rtdb_shm_valid(&shm, sizeof(shm)));
+    TEST_ASSERT_FALSE(rtdb_shm_valid(&shm, sizeof(shm) - 1));
+
+    for (uint32_t z = 0; z < RTDB_NUM_ZONES; z++) {
+        rtdb_stats_reset(&stats[z]);
+    }
+    rtdb_stats_add(&stats[1], 30, 26, 0);
+    db.current_temp[1] = 30;
+    db.setpoint[0] = 40;
+    rtdb_shm_publish(&shm, &db, stats, RTDB_DOM_MEAS);
+
+    TEST_ASSERT_TRUE(rtdb_shm_read(&shm, &out, got));
+    TEST_ASSERT_EQUAL_INT16(30, out.current_temp[1]);
+    TEST_ASSERT_EQUAL_INT16(26, out.setpoint[0]);   /* configuração ainda não publicada */
+    TEST_ASSERT_EQUAL_UINT32(1, got[1].n);
+    TEST_ASSERT_EQUAL_UINT32(0, shm.seq[RTDB_DOM_MEAS] & 1U);
+
+    rtdb_shm_publish(&shm, &db, stats, RTDB_DOM_CFG);
+    TEST_ASSERT_TRUE(rtdb_shm_read(&shm, &out, NULL));
+    TEST_ASSERT_EQUAL_INT16(40, out.setpoint[0]);
+
+    shm.seq[RTDB_DOM_CFG]++;   /* escritor parado a meio */
+    TEST_ASSERT_FALSE(rtdb_shm_read(&shm, &out, NULL));
+}
+
+/* 33) Testa a cópia e a comparação por máscara usadas pelos perfis de configuração */
+void test_schema_copy_diff(void) {
+    rtdb_t a = RTDB_DEFAULTS;
+    rtdb_t b = RTDB_DEFAULTS;
+
+    b.setpoint[1] = 40;
+    b.max_temp[0] = 70;
+    b.sampling_rate_ms = 250U;
+    b.current_temp[1] = 33;
+
+    TEST_ASSERT_EQUAL_UINT32(RTDB_F_MAX_TEMP | RTDB_F_SAMPLING_RATE,
+                             rtdb_schema_diff(&a, &b, 0, RTDB_DOM_MASK_CFG));
+    /* Campos globais só contam na zona 0 */
+    TEST_ASSERT_EQUAL_UINT32(RTDB_F_SETPOINT, rtdb_schema_diff(&a, &b, 1, RTDB_DOM_MASK_CFG));
+    TEST_ASSERT_EQUAL_UINT32(RTDB_F_CURRENT_TEMP, rtdb_schema_diff(&a, &b, 1, RTDB_F_CURRENT_TEMP));
+
+    rtdb_schema_copy_fields(&a, &b, RTDB_F_SETPOINT | RTDB_F_SAMPLING_RATE);
+    TEST_ASSERT_EQUAL_INT16(40, a.setpoint[1]);
+    TEST_ASSERT_EQUAL_UINT32(250U, a.sampling_rate_ms);
+    TEST_ASSERT_EQUAL_INT16(80, a.max_temp[0]);      /* Fora da máscara: inalterado */
+    TEST_ASSERT_EQUAL_INT16(0, a.current_temp[1]);
+    TEST_ASSERT_EQUAL_UINT32(RTDB_F_MAX_TEMP, rtdb_schema_diff(&a, &b, 0, RTDB_DOM_MASK_CFG));
+}
+
+/* 34) Testa o seguimento do histórico: começa na mais recente e conta as amostras perdidas */
+void test_history_follow(void) {
+    static rtdb_history_t h;
+    memset(&h, 0, sizeof(h));
+
+    rtdb_hist_iter_t it;
+    rtdb_sample_t s;
+    rtdb_history_follow(&it, &h);
+    TEST_ASSERT_FALSE(rtdb_history_next(&it, &s));   /* Vazio: espera pela primeira */
+
+    rtdb_history_push(&h, 100, 20);
+    rtdb_history_push(&h, 200, 21);
+    rtdb_history_follow(&it, &h);
+    TEST_ASSERT_TRUE(rtdb_history_next(&it, &s));
+    TEST_ASSERT_EQUAL_UINT32(200, s.t_ms);
+    TEST_ASSERT_FALSE(rtdb_history_next(&it, &s));
+
+    /* Sem fim de janela: cada amostra nova é devolvida, mesmo com t_ms a dar a volta */
+    rtdb_history_push(&h, UINT32_MAX, 22);
+    rtdb_history_push(&h, 5, 22);
+    TEST_ASSERT_TRUE(rtdb_history_next(&it, &s));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, s.t_ms);
+    TEST_ASSERT_TRUE(rtdb_history_next(&it, &s));
+    TEST_ASSERT_EQUAL_UINT32(5, s.t_ms);
+    TEST_ASSERT_FALSE(rtdb_history_next(&it, &s));
+    TEST_ASSERT_EQUAL_UINT32(0, it.lost);
+
+    /* Leitor atrasado: as reescritas são saltadas e contadas */
+    for (uint32_t i = 0; i < RTDB_HIST_LEN + 3; i++) {
+        rtdb_history_push(&h, 1000 + i, (int16_t)i);
+    }
+    TEST_ASSERT_TRUE(rtdb_history_next(&it, &s));
+    TEST_ASSERT_EQUAL_UINT32(1003, s.t_ms);
+    TEST_ASSERT_EQUAL_UINT32(3, it.lost);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_initial_system_on);
@@ -123,6 +595,28 @@ int main(void) {
     RUN_TEST(test_set_sampling_rate_below_min);
     RUN_TEST(test_set_sampling_rate_above_max);
     RUN_TEST(test_set_sampling_rate_valid);
+    RUN_TEST(test_snapshot_copies_all_fields);
+    RUN_TEST(test_update_multiple_fields);
+    RUN_TEST(test_update_rejects_invalid);
+    RUN_TEST(test_update_clamps_implicit_setpoint);
+    RUN_TEST(test_generic_get_set);
+    RUN_TEST(test_history_window);
+    RUN_TEST(test_history_overwrite);
+    RUN_TEST(test_zones_are_independent);
+    RUN_TEST(test_zone_out_of_range);
+    RUN_TEST(test_lockstat_buckets);
+    RUN_TEST(test_lockstat_per_caller);
+    RUN_TEST(test_toggle_and_step);
+    RUN_TEST(test_lock_domains);
+    RUN_TEST(test_schema_find_raw);
+    RUN_TEST(test_stats_welford);
+    RUN_TEST(test_stats_time_in_band);
+    RUN_TEST(test_trigger_conditions);
+    RUN_TEST(test_journal_ring);
+    RUN_TEST(test_journal_encode_decode);
+    RUN_TEST(test_shm_publish_read);
+    RUN_TEST(test_schema_copy_diff);
+    RUN_TEST(test_history_follow);
     return UNITY_END();
 }
 
@@ -1,6 +1,13 @@
 #include "unity.h"
 #include "uartcomm_dummy.h"
 #include "rtdb_dummy.h"
+#include "uart_ring.h"
+#include "uart_parser.h"
+#include "uart_bin.h"
+#include "uart_hist.h"
+#include "uart_cmd.h"
+#include "uart_txq.h"
+#include <errno.h>
 #include <string.h>
 
 /* Prototype para acessar o buffer de saída */
@@ -13,7 +20,7 @@ void setUp(void) {
 }
 
 void tearDown(void) {
- 
+
 }
 
 /* 1) Testa calculate_checksum() */
@@ -49,11 +56,11 @@ void test_handle_missing_exclamation(void) {
     TEST_ASSERT_EQUAL_STRING("#Ef171!", get_uart_test_output());
 }
 
-/* 5) Comando inválido + checksum correto → Ei */
+/* 5) Comando inválido + checksum correto (só de CMD, como no firmware) → Ei */
 void test_invalid_command_checksum_ok(void) {
     uint8_t buf[] = { '#','X',
                       '0','0','0',
-                      '2','3','2',
+                      '0','8','8',
                       '!' 
                     };
     handle_command(buf, sizeof(buf));
@@ -76,7 +83,7 @@ void test_query_current_temp(void) {
     rtdb_dummy_set_current_temp(42);
     uint8_t buf[] = {
         '#','C',
-        '2','1','7',
+        '0','6','7',
         '!'
     };
     handle_command(buf, sizeof(buf));
@@ -87,7 +94,7 @@ void test_query_current_temp(void) {
 void test_set_max_temp_bad_length(void) {
     uint8_t buf[] = { '#','M',
                       '1','2',      // só 2 bytes em vez de 3
-                      '0','0','0',
+                      '1','7','6',
                       '!'
                     };
     handle_command(buf, sizeof(buf));
@@ -117,7 +124,7 @@ void test_set_max_temp_ok(void) {
 void test_set_min_temp_bad_length(void) {
     uint8_t buf[] = { '#','m',
                       '0','5',      
-                      '0','0','0',
+                      '2','1','0',
                       '!'
                     };
     handle_command(buf, sizeof(buf));
@@ -146,7 +153,7 @@ void test_set_min_temp_ok(void) {
 void test_set_sampling_rate_bad_length(void) {
     uint8_t buf[] = { '#','R',
                       '1','2','3',  
-                      '0','0','0',
+                      '2','3','2',
                       '!'
                     };
     handle_command(buf, sizeof(buf));
@@ -156,7 +163,7 @@ void test_set_sampling_rate_bad_length(void) {
 /* 15) Comando “R”: set sampling_rate < 10 → Ei */
 void test_set_sampling_rate_below_min_uart(void) {
     char frame[16];
-    snprintf(frame, sizeof(frame), "#R0005231!");
+    snprintf(frame, sizeof(frame), "#R0005023!");
     handle_command((const uint8_t *)frame, strlen(frame));
     TEST_ASSERT_EQUAL_STRING("#Ei174!", get_uart_test_output());
 }
@@ -174,7 +181,7 @@ void test_set_sampling_rate_ok_uart(void) {
 void test_get_sampling_rate_bad_length(void) {
     uint8_t buf[] = { '#','r',
                       '0','1','2','3', 
-                      '0','0','0',
+                      '0','5','6',
                       '!'
                     };
     handle_command(buf, sizeof(buf));
@@ -226,6 +233,483 @@ void test_system_toggle_invalid_payload(void) {
     TEST_ASSERT_EQUAL_STRING("#Ei174!", get_uart_test_output());
 }
 
+/* 23) Buffer circular da receção: ordem, volta ao índice 0 e descarte quando cheio */
+void test_rx_ring_wrap_and_overflow(void) {
+    static uart_ring_t r;
+    uint8_t in[UART_RING_LEN];
+    uint8_t out[UART_RING_LEN];
+
+    for (size_t i = 0; i < UART_RING_LEN; i++) {
+        in[i] = (uint8_t)i;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, uart_ring_get(&r, out, sizeof(out)));
+
+    /* Avança os índices para o bloco seguinte passar pelo fim do buffer */
+    TEST_ASSERT_EQUAL_UINT32(10, uart_ring_put(&r, in, 10));
+    TEST_ASSERT_EQUAL_UINT32(10, uart_ring_get(&r, out, sizeof(out)));
+
+    TEST_ASSERT_EQUAL_UINT32(UART_RING_LEN, uart_ring_put(&r, in, UART_RING_LEN));
+    TEST_ASSERT_EQUAL_UINT32(0, uart_ring_put(&r, in, 3));
+    TEST_ASSERT_EQUAL_UINT32(3, r.dropped);
+
+    TEST_ASSERT_EQUAL_UINT32(5, uart_ring_get(&r, out, 5));
+    TEST_ASSERT_EQUAL_UINT8(4, out[4]);
+    TEST_ASSERT_EQUAL_UINT32(UART_RING_LEN - 5, uart_ring_get(&r, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_UINT8(5, out[0]);
+    TEST_ASSERT_EQUAL_UINT8(UART_RING_LEN - 1, out[UART_RING_LEN - 6]);
+    TEST_ASSERT_EQUAL_UINT32(0, uart_ring_get(&r, out, sizeof(out)));
+}
+
+/* Entrega str ao parser byte a byte; devolve o último evento diferente de NONE */
+static uart_parse_ev_t parser_feed_str(uart_parser_t *p, const char *str, uint32_t now) {
+    uart_parse_ev_t last = UART_PARSE_NONE;
+    for (; *str != '\0'; str++) {
+        uart_parse_ev_t ev = uart_parser_feed(p, (uint8_t)*str, now);
+        if (ev != UART_PARSE_NONE) {
+            last = ev;
+        }
+    }
+    return last;
+}
+
+/* 24) Parser incremental: checksum somado, DATA convertida e checksum recebido */
+void test_parser_frame_fields(void) {
+    uart_parser_t p;
+
+    uart_parser_init(&p, 0);
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, parser_feed_str(&p, "\r\n#R1000019!", 0));
+    TEST_ASSERT_EQUAL_INT('R', p.f.cmd);
+    TEST_ASSERT_EQUAL_UINT32(4, p.f.data_len);
+    TEST_ASSERT_EQUAL_UINT8(calculate_checksum((const uint8_t *)"R1000", 5), p.f.sum);
+    TEST_ASSERT_EQUAL_UINT16(19, p.f.cs);
+    TEST_ASSERT_TRUE(p.f.num_ok);
+    TEST_ASSERT_EQUAL_UINT32(1000, p.f.num);
+
+    /* Sem DATA e com DATA não numérica */
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, parser_feed_str(&p, "#C067!", 0));
+    TEST_ASSERT_EQUAL_UINT32(0, p.f.data_len);
+    TEST_ASSERT_FALSE(p.f.num_ok);
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, parser_feed_str(&p, "#Ps1ab12x!", 0));
+    TEST_ASSERT_FALSE(p.f.num_ok);
+    TEST_ASSERT_EQUAL_UINT16(UART_PARSER_CS_BAD, p.f.cs);
+}
+
+/* 25) Parser incremental: erros de framing, ressincronização em '#' e timeout */
+void test_parser_resync_and_timeout(void) {
+    uart_parser_t p;
+    char longf[UART_PARSER_FRAME_MAX + 1];
+
+    uart_parser_init(&p, 100);
+    TEST_ASSERT_EQUAL(UART_PARSE_ERROR, parser_feed_str(&p, "#C0!", 0));   /* curto */
+    TEST_ASSERT_EQUAL(UART_PARSE_ERROR, parser_feed_str(&p, "xx!", 0));    /* '!' fora de frame */
+
+    /* '#' a meio: erro no frame partido, o seguinte é aceite */
+    TEST_ASSERT_EQUAL(UART_PARSE_ERROR, parser_feed_str(&p, "#M03#", 0));
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, parser_feed_str(&p, "C067!", 0));
+    TEST_ASSERT_EQUAL_INT('C', p.f.cmd);
+
+    /* Frame demasiado longo */
+    memset(longf, '1', sizeof(longf));
+    longf[0] = '#';
+    longf[UART_PARSER_FRAME_MAX] = '\0';
+    TEST_ASSERT_EQUAL(UART_PARSE_ERROR, parser_feed_str(&p, longf, 0));
+    TEST_ASSERT_FALSE(uart_parser_busy(&p));
+
+    /* Frame a meio sem bytes novos durante mais de 100 ms */
+    TEST_ASSERT_EQUAL(UART_PARSE_NONE, parser_feed_str(&p, "#M0", 1000));
+    TEST_ASSERT_TRUE(uart_parser_busy(&p));
+    TEST_ASSERT_FALSE(uart_parser_expire(&p, 1100));
+    TEST_ASSERT_TRUE(uart_parser_expire(&p, 1101));
+    TEST_ASSERT_EQUAL(UART_PARSE_ERROR, parser_feed_str(&p, "30!", 1200));
+}
+
+/* 26) Modo binário: CRC-16/CCITT-FALSE e COBS (zeros e blocos de 254 bytes) */
+void test_bin_crc_and_cobs(void) {
+    static const uint8_t zeros[] = { 0x11, 0x00, 0x00, 0x22, 0x00 };
+    uint8_t in[300];
+    uint8_t enc[UART_BIN_COBS_MAX(300)];
+    uint8_t dec[300];
+    size_t n;
+    size_t m;
+
+    TEST_ASSERT_EQUAL_UINT16(0x29B1, uart_crc16(UART_CRC16_INIT, (const uint8_t *)"123456789", 9));
+    /* Em blocos dá o mesmo */
+    TEST_ASSERT_EQUAL_UINT16(0x29B1, uart_crc16(uart_crc16(UART_CRC16_INIT,
+                             (const uint8_t *)"1234", 4), (const uint8_t *)"56789", 5));
+
+    n = uart_cobs_encode(zeros, sizeof(zeros), enc);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(zeros) + 1, n);
+    TEST_ASSERT_EQUAL_UINT8(0x02, enc[0]);
+    TEST_ASSERT_NULL(memchr(enc, 0, n));
+    TEST_ASSERT_TRUE(uart_cobs_decode(enc, n, dec, &m));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(zeros), m);
+    TEST_ASSERT_EQUAL_MEMORY(zeros, dec, m);
+
+    /* 300 bytes sem zeros: um bloco cheio de 254 e o resto */
+    for (size_t i = 0; i < sizeof(in); i++) {
+        in[i] = (uint8_t)(1 + (i % 255));
+    }
+    n = uart_cobs_encode(in, sizeof(in), enc);
+    TEST_ASSERT_TRUE(n <= sizeof(enc));
+    TEST_ASSERT_EQUAL_UINT8(0xFF, enc[0]);
+    TEST_ASSERT_NULL(memchr(enc, 0, n));
+    TEST_ASSERT_TRUE(uart_cobs_decode(enc, n, dec, &m));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(in), m);
+    TEST_ASSERT_EQUAL_MEMORY(in, dec, m);
+
+    /* Bloco que passa do fim */
+    enc[0] = 9;
+    TEST_ASSERT_FALSE(uart_cobs_decode(enc, 4, dec, &m));
+}
+
+/* Entrega len bytes ao receptor binário; devolve o último evento diferente de NONE */
+static uart_parse_ev_t bin_feed_buf(uart_bin_rx_t *r, const uint8_t *buf, size_t len, uint32_t now) {
+    uart_parse_ev_t last = UART_PARSE_NONE;
+    for (size_t i = 0; i < len; i++) {
+        uart_parse_ev_t ev = uart_bin_feed(r, buf[i], now);
+        if (ev != UART_PARSE_NONE) {
+            last = ev;
+        }
+    }
+    return last;
+}
+
+/* 27) Modo binário: frame montado e recebido, CRC errado, lixo e timeout */
+void test_bin_frame_decode(void) {
+    static const uint8_t rate[] = { 0xE8, 0x03, 0x00, 0x00 };   /* 1000 em little-endian */
+    uint8_t frame[UART_BIN_FRAME_MAX(sizeof(rate))];
+    uart_bin_rx_t r;
+    size_t n;
+
+    uart_bin_init(&r, 100);
+    n = uart_bin_frame(frame, 'R', rate, sizeof(rate));
+    TEST_ASSERT_EQUAL_UINT32(UART_BIN_FRAME_MAX(sizeof(rate)), n);
+    TEST_ASSERT_EQUAL_UINT8(0, frame[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, frame[n - 1]);
+
+    /* Texto (p.ex. printk) antes do frame: descartado no 0x00 inicial */
+    TEST_ASSERT_EQUAL(UART_PARSE_NONE, bin_feed_buf(&r, (const uint8_t *)"[UART]", 6, 0));
+    TEST_ASSERT_EQUAL(UART_PARSE_ERROR, bin_feed_buf(&r, frame, 1, 0));
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, bin_feed_buf(&r, &frame[1], n - 1, 0));
+    TEST_ASSERT_TRUE(r.f.bin);
+    TEST_ASSERT_EQUAL_INT('R', r.f.cmd);
+    TEST_ASSERT_EQUAL_UINT32(4, r.f.data_len);
+    TEST_ASSERT_EQUAL_MEMORY(rate, r.f.data, 4);
+    TEST_ASSERT_TRUE(r.f.num_ok);
+    TEST_ASSERT_EQUAL_UINT32(1000, r.f.num);
+
+    /* Um bit trocado: o CRC apanha-o */
+    frame[2] ^= 0x10;
+    TEST_ASSERT_EQUAL(UART_PARSE_CHECKSUM, bin_feed_buf(&r, frame, n, 0));
+    frame[2] ^= 0x10;
+
+    /* Sem DATA */
+    n = uart_bin_frame(frame, 'C', NULL, 0);
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, bin_feed_buf(&r, frame, n, 0));
+    TEST_ASSERT_EQUAL_INT('C', r.f.cmd);
+    TEST_ASSERT_EQUAL_UINT32(0, r.f.data_len);
+    TEST_ASSERT_FALSE(r.f.num_ok);
+
+    /* Frame a meio sem bytes novos durante mais de 100 ms */
+    TEST_ASSERT_EQUAL(UART_PARSE_NONE, bin_feed_buf(&r, frame, 3, 1000));
+    TEST_ASSERT_TRUE(uart_bin_busy(&r));
+    TEST_ASSERT_FALSE(uart_bin_expire(&r, 1100));
+    TEST_ASSERT_TRUE(uart_bin_expire(&r, 1101));
+    TEST_ASSERT_FALSE(uart_bin_busy(&r));
+}
+
+/* 28) Lote (#K): sub-comandos extraídos por ordem em ASCII e binário, lote mal formado */
+void test_parser_batch_split(void) {
+    static const uint8_t bin_batch[] = { 1, 'C', 3, 'M', 0x50, 0x00, 2, 'E', 7 };
+    uart_parser_t p;
+    uart_frame_t batch;
+    uart_frame_t sub;
+    size_t pos = 0;
+
+    uart_parser_init(&p, 0);
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, parser_feed_str(&p, "#K01C04M08001r011!", 0));
+    TEST_ASSERT_EQUAL_INT(1, uart_parser_sub(&p.f, &pos, &sub));
+    TEST_ASSERT_EQUAL_INT('C', sub.cmd);
+    TEST_ASSERT_EQUAL_UINT32(0, sub.data_len);
+    TEST_ASSERT_EQUAL_INT(1, uart_parser_sub(&p.f, &pos, &sub));
+    TEST_ASSERT_EQUAL_INT('M', sub.cmd);
+    TEST_ASSERT_TRUE(sub.num_ok);
+    TEST_ASSERT_EQUAL_UINT32(80, sub.num);
+    TEST_ASSERT_EQUAL_UINT16(sub.sum, sub.cs);
+    TEST_ASSERT_FALSE(sub.bin);
+    TEST_ASSERT_EQUAL_INT(1, uart_parser_sub(&p.f, &pos, &sub));
+    TEST_ASSERT_EQUAL_INT('r', sub.cmd);
+    TEST_ASSERT_EQUAL_INT(0, uart_parser_sub(&p.f, &pos, &sub));
+
+    /* Comprimento que passa do fim de DATA */
+    pos = 0;
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, parser_feed_str(&p, "#K01C09M080061!", 0));
+    TEST_ASSERT_EQUAL_INT(1, uart_parser_sub(&p.f, &pos, &sub));
+    TEST_ASSERT_EQUAL_INT(-1, uart_parser_sub(&p.f, &pos, &sub));
+
+    /* Binário: len num byte, campos em little-endian */
+    memset(&batch, 0, sizeof(batch));
+    batch.cmd = 'K';
+    batch.bin = true;
+    memcpy(batch.data, bin_batch, sizeof(bin_batch));
+    batch.data_len = sizeof(bin_batch);
+    pos = 0;
+    TEST_ASSERT_EQUAL_INT(1, uart_parser_sub(&batch, &pos, &sub));
+    TEST_ASSERT_EQUAL_INT('C', sub.cmd);
+    TEST_ASSERT_EQUAL_INT(1, uart_parser_sub(&batch, &pos, &sub));
+    TEST_ASSERT_EQUAL_INT('M', sub.cmd);
+    TEST_ASSERT_TRUE(sub.bin);
+    TEST_ASSERT_EQUAL_UINT32(80, sub.num);
+    TEST_ASSERT_EQUAL_INT(1, uart_parser_sub(&batch, &pos, &sub));
+    TEST_ASSERT_EQUAL_UINT32(7, sub.num);
+    TEST_ASSERT_EQUAL_INT(0, uart_parser_sub(&batch, &pos, &sub));
+    batch.data[0] = 0;   /* len 0: nem CMD */
+    pos = 0;
+    TEST_ASSERT_EQUAL_INT(-1, uart_parser_sub(&batch, &pos, &sub));
+}
+
+/* Compressor de teste: copia (chunks de cap / UART_HIST_REC_LEN amostras) */
+static int hist_copy(const uint8_t *src, int src_len, uint8_t *dst, int cap) {
+    if (src_len > cap) {
+        return 0;
+    }
+    memcpy(dst, src, (size_t)src_len);
+    return src_len;
+}
+
+/* 29) Testa a divisão do histórico em chunks: tamanho, numeração, fim, ida e volta e retoma */
+void test_hist_chunks(void) {
+    static rtdb_history_t h;
+    static uart_hist_t d;
+    uint8_t blk[40];
+    rtdb_sample_t s[UART_HIST_MAX_N];
+    rtdb_hist_iter_t it;
+    uart_hist_chunk_t c;
+
+    memset(&h, 0, sizeof(h));
+    for (uint32_t i = 0; i < 50; i++) {
+        rtdb_history_push(&h, 1000 + i * 500, (int16_t)(20 - (int16_t)(i % 3)));
+    }
+    rtdb_history_iter_init(&it, &h, 0, 100000);
+    uart_hist_init(&d, &it, hist_copy);
+
+    /* 40 bytes = 10 amostras por chunk: seq 0..4 e depois o fim */
+    for (uint32_t k = 0; k < 5; k++) {
+        TEST_ASSERT_TRUE(uart_hist_next(&d, blk, sizeof(blk), &c));
+        TEST_ASSERT_EQUAL_UINT32(k, c.seq);
+        TEST_ASSERT_EQUAL_UINT32(10, c.n);
+        TEST_ASSERT_EQUAL_UINT32(40, c.len);
+        TEST_ASSERT_EQUAL_UINT32(1000 + k * 5000, c.t0);
+        if (k == 2) {
+            uart_hist_unpack(blk, c.n, c.t0, s);
+            TEST_ASSERT_EQUAL_UINT32(11000, s[0].t_ms);
+            TEST_ASSERT_EQUAL_UINT32(15500, s[9].t_ms);
+            TEST_ASSERT_EQUAL_INT16(18, s[0].temp);   /* i = 20 */
+            TEST_ASSERT_EQUAL_INT16(20, s[1].temp);   /* i = 21 */
+        }
+    }
+    TEST_ASSERT_TRUE(uart_hist_next(&d, blk, sizeof(blk), &c));
+    TEST_ASSERT_EQUAL_UINT32(5, c.seq);
+    TEST_ASSERT_EQUAL_UINT32(0, c.n);
+    TEST_ASSERT_FALSE(uart_hist_next(&d, blk, sizeof(blk), &c));
+
+    /* Espaço que não é múltiplo do registo: o chunk fica com as amostras que cabem */
+    rtdb_history_iter_init(&it, &h, 0, 100000);
+    uart_hist_init(&d, &it, hist_copy);
+    TEST_ASSERT_TRUE(uart_hist_next(&d, blk, 23, &c));
+    TEST_ASSERT_EQUAL_UINT32(5, c.n);
+    TEST_ASSERT_TRUE(uart_hist_next(&d, blk, 23, &c));
+    TEST_ASSERT_EQUAL_UINT32(1, c.seq);
+    TEST_ASSERT_EQUAL_UINT32(3500, c.t0);
+
+    /* Retoma depois de 20 amostras recebidas: numeração de novo em 0, t0 da amostra 20 */
+    rtdb_history_iter_init(&it, &h, 0, 100000);
+    uart_hist_init(&d, &it, hist_copy);
+    TEST_ASSERT_EQUAL_UINT32(20, uart_hist_skip(&d, 20));
+    TEST_ASSERT_TRUE(uart_hist_next(&d, blk, sizeof(blk), &c));
+    TEST_ASSERT_EQUAL_UINT32(0, c.seq);
+    TEST_ASSERT_EQUAL_UINT32(10, c.n);
+    TEST_ASSERT_EQUAL_UINT32(11000, c.t0);
+
+    /* Saltar mais do que a janela tem deixa só o chunk de fim */
+    rtdb_history_iter_init(&it, &h, 0, 100000);
+    uart_hist_init(&d, &it, hist_copy);
+    TEST_ASSERT_EQUAL_UINT32(50, uart_hist_skip(&d, 60));
+    TEST_ASSERT_TRUE(uart_hist_next(&d, blk, sizeof(blk), &c));
+    TEST_ASSERT_EQUAL_UINT32(0, c.n);
+    TEST_ASSERT_FALSE(uart_hist_next(&d, blk, sizeof(blk), &c));
+}
+
+/* 30) Etiqueta de sequência: ASCII (coberta pelo checksum, 000..255) e binário (CRC) */
+void test_parser_seq_tag(void) {
+    static const uint8_t rate[] = { 0xE8, 0x03, 0x00, 0x00 };
+    uint8_t frame[UART_BIN_FRAME_SEQ_MAX(sizeof(rate))];
+    uint8_t plain[UART_BIN_FRAME_MAX(sizeof(rate))];
+    uart_parser_t p;
+    uart_bin_rx_t r;
+    size_t n;
+
+    uart_parser_init(&p, 0);
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, parser_feed_str(&p, "#@007C026!", 0));
+    TEST_ASSERT_TRUE(p.f.tagged);
+    TEST_ASSERT_EQUAL_UINT8(7, p.f.seq);
+    TEST_ASSERT_EQUAL_INT('C', p.f.cmd);
+    TEST_ASSERT_EQUAL_UINT32(0, p.f.data_len);
+    TEST_ASSERT_EQUAL_UINT8(calculate_checksum((const uint8_t *)"@007C", 5), p.f.sum);
+    TEST_ASSERT_EQUAL_UINT16(26, p.f.cs);
+
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, parser_feed_str(&p, "#@255R1000239!", 0));
+    TEST_ASSERT_EQUAL_UINT8(255, p.f.seq);
+    TEST_ASSERT_EQUAL_UINT32(1000, p.f.num);
+    TEST_ASSERT_EQUAL_UINT16(p.f.sum, p.f.cs);
+
+    /* O frame seguinte sem etiqueta não herda a anterior */
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, parser_feed_str(&p, "#C067!", 0));
+    TEST_ASSERT_FALSE(p.f.tagged);
+
+    /* Etiqueta acima de 255, com um não-dígito, ou sem CMD: erro de framing */
+    TEST_ASSERT_EQUAL(UART_PARSE_ERROR, parser_feed_str(&p, "#@256", 0));
+    TEST_ASSERT_FALSE(uart_parser_busy(&p));
+    TEST_ASSERT_EQUAL(UART_PARSE_ERROR, parser_feed_str(&p, "#@0x", 0));
+    TEST_ASSERT_EQUAL(UART_PARSE_ERROR, parser_feed_str(&p, "#@012!", 0));
+
+    /* Binário: '@' + seq antes de CMD; sem etiqueta é o frame de uart_bin_frame() */
+    uart_bin_init(&r, 0);
+    n = uart_bin_frame_seq(frame, 200, 'R', rate, sizeof(rate));
+    TEST_ASSERT_EQUAL_UINT32(UART_BIN_FRAME_SEQ_MAX(sizeof(rate)), n);
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, bin_feed_buf(&r, frame, n, 0));
+    TEST_ASSERT_TRUE(r.f.tagged);
+    TEST_ASSERT_EQUAL_UINT8(200, r.f.seq);
+    TEST_ASSERT_EQUAL_INT('R', r.f.cmd);
+    TEST_ASSERT_EQUAL_UINT32(4, r.f.data_len);
+    TEST_ASSERT_EQUAL_UINT32(1000, r.f.num);
+
+    /* CRC errado: a etiqueta que chegou fica disponível para o ACK 's' */
+    frame[5] ^= 0x10;
+    TEST_ASSERT_EQUAL(UART_PARSE_CHECKSUM, bin_feed_buf(&r, frame, n, 0));
+    TEST_ASSERT_TRUE(r.f.tagged);
+    TEST_ASSERT_EQUAL_UINT8(200, r.f.seq);
+
+    n = uart_bin_frame_seq(frame, UART_SEQ_NONE, 'R', rate, sizeof(rate));
+    TEST_ASSERT_EQUAL_UINT32(uart_bin_frame(plain, 'R', rate, sizeof(rate)), n);
+    TEST_ASSERT_EQUAL_MEMORY(plain, frame, n);
+    TEST_ASSERT_EQUAL(UART_PARSE_FRAME, bin_feed_buf(&r, frame, n, 0));
+    TEST_ASSERT_FALSE(r.f.tagged);
+}
+
+static int custom_calls;
+
+static void custom_handler(const struct device *dev, const uart_frame_t *f) {
+    (void)dev;
+    (void)f;
+    custom_calls++;
+}
+
+/* 31) Tabela de despacho (a mesma do firmware): registo, comprimentos por modo e etiqueta */
+void test_cmd_table(void) {
+    uart_frame_t f = { 0 };
+
+    /* Letras do protocolo só aceitam uart_cmd_bind(); comandos novos, uart_cmd_register() */
+    TEST_ASSERT_EQUAL_INT(-EEXIST, uart_cmd_register('M', 3, 2, custom_handler));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, uart_cmd_bind('x', custom_handler));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, uart_cmd_register('x', UART_PARSER_DATA_MAX + 1, 0, custom_handler));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, uart_cmd_register('x', 0, 0, NULL));
+    TEST_ASSERT_EQUAL_INT(0, uart_cmd_register('x', 2, 1, custom_handler));
+    TEST_ASSERT_EQUAL_INT(-EEXIST, uart_cmd_register('x', 2, 1, custom_handler));
+
+    /* Comprimento de DATA verificado conforme o modo do frame */
+    custom_calls = 0;
+    f.cmd = 'x';
+    f.data_len = 2;
+    TEST_ASSERT_EQUAL(UART_CMD_DONE, uart_cmd_dispatch(NULL, &f));
+    f.bin = true;
+    TEST_ASSERT_EQUAL(UART_CMD_INVALID, uart_cmd_dispatch(NULL, &f));
+    f.data_len = 1;
+    TEST_ASSERT_EQUAL(UART_CMD_DONE, uart_cmd_dispatch(NULL, &f));
+    TEST_ASSERT_EQUAL_INT(2, custom_calls);
+
+    /* Comando do protocolo sem handler (funcionalidade não compilada) → 'i' */
+    f.cmd = 'J';
+    f.bin = false;
+    f.data_len = 0;
+    f.sum = 'J';
+    f.cs = 'J';
+    TEST_ASSERT_EQUAL(UART_CMD_INVALID, uart_cmd_handle(NULL, &f));
+
+    /* Desconhecido com etiqueta: o checksum isolado cobre '@', os 3 dígitos e CMD */
+    f.cmd = 'X';
+    f.tagged = true;
+    f.seq = 7;
+    f.cs = calculate_checksum((const uint8_t *)"@007X", 5);
+    TEST_ASSERT_EQUAL(UART_CMD_INVALID, uart_cmd_handle(NULL, &f));
+    f.cs = 'X';
+    TEST_ASSERT_EQUAL(UART_CMD_CHECKSUM_INVALID, uart_cmd_handle(NULL, &f));
+    f.bin = true;   /* CRC já verificado pelo receptor */
+    TEST_ASSERT_EQUAL(UART_CMD_INVALID, uart_cmd_handle(NULL, &f));
+
+    /* 'C' não leva DATA (comprimento da tabela, não do dummy) */
+    handle_command((const uint8_t *)"#C1116!", 7);
+    TEST_ASSERT_EQUAL_STRING("#Ei174!", get_uart_test_output());
+}
+
+/* 32) Fila de envio: ordem, máximo de ocupação, telemetria tirada da fila e ACKs nunca descartados */
+void test_tx_queue_overflow(void) {
+    static uart_txq_t q;
+    static uint8_t blk[UART_TXQ_LEN][4];
+    const uart_txq_ent_t *h;
+
+    memset(&q, 0, sizeof(q));
+    TEST_ASSERT_NULL(uart_txq_head(&q));
+    TEST_ASSERT_NULL(uart_txq_pop(&q));
+
+    /* Só o primeiro frame encontra a fila parada; a ordem de envio é a de entrada */
+    TEST_ASSERT_TRUE(uart_txq_push(&q, blk[0], 1, true));    /* tlm já a sair */
+    TEST_ASSERT_FALSE(uart_txq_push(&q, blk[1], 2, false));  /* resposta */
+    TEST_ASSERT_FALSE(uart_txq_push(&q, blk[2], 3, true));   /* tlm mais antiga atrás da cabeça */
+    TEST_ASSERT_FALSE(uart_txq_push(&q, blk[3], 4, true));
+    TEST_ASSERT_FALSE(uart_txq_push(&q, blk[4], 5, false));
+    TEST_ASSERT_EQUAL_UINT32(5, q.hwm);
+
+    /* Resposta sem bloco: fica com o da telemetria mais antiga por enviar (não a cabeça) */
+    TEST_ASSERT_EQUAL_PTR(blk[2], uart_txq_make_room(&q, false, false));
+    TEST_ASSERT_EQUAL_UINT32(4, q.count);
+    TEST_ASSERT_EQUAL_UINT32(1, q.evicted);
+    TEST_ASSERT_EQUAL_UINT32(0, q.dropped);
+
+    /* Telemetria nova: descartada (DROP_NEWEST) ou no lugar da mais antiga (DROP_OLDEST) */
+    TEST_ASSERT_NULL(uart_txq_make_room(&q, true, false));
+    TEST_ASSERT_EQUAL_UINT32(1, q.dropped);
+    TEST_ASSERT_EQUAL_PTR(blk[3], uart_txq_make_room(&q, true, true));
+    TEST_ASSERT_EQUAL_UINT32(2, q.evicted);
+
+    /* Sem telemetria atrás da cabeça: a resposta espera (NULL), nada é descartado */
+    TEST_ASSERT_NULL(uart_txq_make_room(&q, false, false));
+    TEST_ASSERT_EQUAL_UINT32(1, q.dropped);
+    TEST_ASSERT_NULL(uart_txq_make_room(&q, true, true));
+    TEST_ASSERT_EQUAL_UINT32(2, q.dropped);
+
+    /* O que ficou sai pela ordem original */
+    h = uart_txq_head(&q);
+    TEST_ASSERT_NOT_NULL(h);
+    TEST_ASSERT_EQUAL_PTR(blk[0], h->buf);
+    TEST_ASSERT_TRUE(h->tlm);
+    TEST_ASSERT_EQUAL_PTR(blk[0], uart_txq_pop(&q));
+    TEST_ASSERT_EQUAL_PTR(blk[1], uart_txq_pop(&q));
+    TEST_ASSERT_EQUAL_UINT32(5, uart_txq_head(&q)->len);
+    TEST_ASSERT_EQUAL_PTR(blk[4], uart_txq_pop(&q));
+    TEST_ASSERT_NULL(uart_txq_head(&q));
+
+    /* #Q0!: o máximo recomeça da ocupação atual; a fila dá a volta ao índice 0 */
+    uart_txq_reset_hwm(&q);
+    TEST_ASSERT_EQUAL_UINT32(0, q.hwm);
+    for (uint32_t i = 0; i < (3U * UART_TXQ_LEN); i++) {
+        TEST_ASSERT_TRUE(uart_txq_push(&q, blk[i % UART_TXQ_LEN], i, false));
+        TEST_ASSERT_EQUAL_UINT32(i, uart_txq_head(&q)->len);
+        TEST_ASSERT_EQUAL_PTR(blk[i % UART_TXQ_LEN], uart_txq_pop(&q));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, q.hwm);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_checksum_values);
@@ -250,6 +734,16 @@ int main(void) {
     RUN_TEST(test_system_on_via_uart);
     RUN_TEST(test_system_off_via_uart);
     RUN_TEST(test_system_toggle_invalid_payload);
+    RUN_TEST(test_rx_ring_wrap_and_overflow);
+    RUN_TEST(test_parser_frame_fields);
+    RUN_TEST(test_parser_resync_and_timeout);
+    RUN_TEST(test_bin_crc_and_cobs);
+    RUN_TEST(test_bin_frame_decode);
+    RUN_TEST(test_parser_batch_split);
+    RUN_TEST(test_hist_chunks);
+    RUN_TEST(test_parser_seq_tag);
+    RUN_TEST(test_cmd_table);
+    RUN_TEST(test_tx_queue_overflow);
     return UNITY_END();
 }
 
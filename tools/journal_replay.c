@@ -0,0 +1,224 @@
+/**
+ * @file journal_replay.c
+ * @brief Reproduz no anfitrião o diário de escritas da RTDB (comando #J)
+ *
+ * @details
+ *   Lê (de um ficheiro ou do stdin) as respostas #j<i><entradas>CCC! capturadas da
+ *   UART, ou linhas só com entradas de RTDB_JOURNAL_HEX_LEN carateres, e volta a
+ *   aplicar as entradas por ordem sobre uma RTDB com os valores por omissão. As
+ *   saídas do aquecedor não são copiadas do diário: são recalculadas com a mesma
+ *   lógica do firmware (ctrl_logic.h), incluindo as proteções por sobretemperatura
+ *   e por sensor parado, e comparadas com o que o firmware registou.
+ *
+ *   O tempo é o do diário (t_ms de cada entrada), não o do relógio: o replay é
+ *   determinístico e corre tão depressa quanto o CPU permitir.
+ *
+ *   Uso: journal_replay [-q] [ficheiro]
+ *     -q  só imprime o resumo (sem a linha temporal)
+ *
+ *   Compilar: make journal_replay
+ */
+
+#include "rtdb_schema.h"
+#include "rtdb_journal.h"
+#include "ctrl_logic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LINE_MAX_LEN 512U
+
+static const char *const src_name[RTDB_NUM_SRCS] = {
+    "?", "uart", "botao", "sensor", "ctrl", "flash", "isr"
+};
+
+/* Estado do replay */
+typedef struct {
+    rtdb_t   db;                          /* RTDB reconstruída */
+    bool     heater[RTDB_NUM_ZONES];      /* Decisão recalculada com ctrl_logic_step() */
+    bool     seen[RTDB_NUM_ZONES];        /* Zona já teve amostras de current_temp */
+    uint32_t last_sample[RTDB_NUM_ZONES]; /* t_ms da última amostra (proteção de sensor parado) */
+    bool     stale[RTDB_NUM_ZONES];       /* Sensor parado na zona */
+    uint32_t known[RTDB_NUM_ZONES];       /* RTDB_F_* já vistos no diário */
+    uint32_t next_idx;                    /* Próximo índice esperado (respostas repetidas) */
+    bool     have_idx;
+    uint32_t t_first;
+    uint32_t t_last;
+    uint32_t entries;
+    uint32_t gaps;                        /* Entradas cujo valor antigo não bate com o replay */
+    uint32_t diverge;                     /* Heater registado ≠ heater recalculado */
+    uint32_t switches;                    /* Mudanças do heater recalculado */
+    bool     quiet;
+} replay_t;
+
+/**
+ * @brief Recalcula o aquecedor da zona z e imprime a transição, se houver
+ */
+static void replay_control(replay_t *r, uint8_t z, uint32_t t_ms)
+{
+    bool protect = r->stale[z] || (r->db.current_temp[z] > r->db.max_temp[z]);
+    bool h = ctrl_logic_step(r->db.system_on, protect, r->db.setpoint[z],
+                             r->db.current_temp[z], r->heater[z]);
+
+    if (h != r->heater[z]) {
+        r->heater[z] = h;
+        r->switches++;
+        if (!r->quiet) {
+            printf("%10u ms  z%u heater=%u  (sp=%d cur=%d%s)\n", t_ms, z, h ? 1U : 0U,
+                   r->db.setpoint[z], r->db.current_temp[z],
+                   protect ? ", proteção" : "");
+        }
+    }
+}
+
+/**
+ * @brief Dispara a proteção de sensor parado das zonas cujo prazo terminou antes de t_ms
+ */
+static void replay_stale(replay_t *r, uint32_t t_ms)
+{
+    uint32_t timeout = CTRL_STALE_FACTOR * r->db.sampling_rate_ms;
+
+    for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+        uint32_t deadline = r->last_sample[z] + timeout;
+        if (r->seen[z] && !r->stale[z] && ((int32_t)(t_ms - deadline) > 0)) {
+            r->stale[z] = true;
+            if (!r->quiet) {
+                printf("%10u ms  z%u sensor parado\n", deadline, z);
+            }
+            replay_control(r, z, deadline);
+        }
+    }
+}
+
+/**
+ * @brief Aplica uma entrada do diário
+ */
+static void replay_entry(replay_t *r, uint32_t idx, bool has_idx, const rtdb_jentry_t *e)
+{
+    if (has_idx) {
+        if (r->have_idx && ((int32_t)(idx - r->next_idx) < 0)) {
+            return;   /* Já aplicada (pedido repetido) */
+        }
+        if (r->have_idx && (idx != r->next_idx)) {
+            printf("aviso: %u entradas perdidas antes de %u\n", idx - r->next_idx, idx);
+        }
+        r->next_idx = idx + 1U;
+        r->have_idx = true;
+    }
+    if ((e->id >= RTDB_NUM_FIELDS) || (e->zone >= RTDB_NUM_ZONES)) {
+        printf("aviso: entrada inválida (campo %u, zona %u)\n", e->id, e->zone);
+        return;
+    }
+
+    if (r->entries == 0U) {
+        r->t_first = e->t_ms;
+    }
+    r->entries++;
+    r->t_last = e->t_ms;
+    replay_stale(r, e->t_ms);
+
+    /* O diário pode começar a meio: o primeiro valor antigo de cada campo é o ponto de partida */
+    rtdb_field_t id = (rtdb_field_t)e->id;
+    if ((r->known[e->zone] & RTDB_F(id)) == 0U) {
+        r->known[e->zone] |= RTDB_F(id);
+        rtdb_schema_put(&r->db, e->zone, id, e->old);
+    } else if (rtdb_schema_get(&r->db, e->zone, id) != e->old) {
+        r->gaps++;
+    }
+
+    if (id == RTDB_ID_HEATER) {
+        /* Saída do firmware: comparada com a decisão recalculada, não aplicada */
+        if ((e->val != 0) != r->heater[e->zone]) {
+            r->diverge++;
+        }
+        rtdb_schema_put(&r->db, e->zone, id, e->val);
+        return;
+    }
+
+    rtdb_schema_put(&r->db, e->zone, id, e->val);
+    if (!r->quiet && (id != RTDB_ID_CURRENT_TEMP)) {
+        printf("%10u ms  z%u %s: %d -> %d (%s)\n", e->t_ms, e->zone, rtdb_field_info[id].name,
+               e->old, e->val, (e->src < RTDB_NUM_SRCS) ? src_name[e->src] : "?");
+    }
+
+    if (id == RTDB_ID_CURRENT_TEMP) {
+        r->seen[e->zone] = true;
+        r->stale[e->zone] = false;
+        r->last_sample[e->zone] = e->t_ms;
+    }
+    if (rtdb_field_info[id].zoned) {
+        replay_control(r, e->zone, e->t_ms);
+    } else {
+        for (uint8_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+            replay_control(r, z, e->t_ms);
+        }
+    }
+}
+
+/**
+ * @brief Interpreta uma linha: frame #j<i(8)><entradas>CCC! ou entradas soltas
+ */
+static void replay_line(replay_t *r, const char *line)
+{
+    size_t len = strcspn(line, "\r\n");
+    const char *p = line;
+    uint32_t idx = 0U;
+    bool has_idx = false;
+    rtdb_jentry_t e;
+
+    if ((len >= 2U) && (line[0] == '#')) {
+        /* #j + i(8) + n × entrada + CS(3) + '!' */
+        if ((line[1] != 'j') || (len < 14U) || (line[len - 1U] != '!') ||
+            (((len - 14U) % RTDB_JOURNAL_HEX_LEN) != 0U)) {
+            return;   /* Outros frames (p.ex. a resposta a #J!) */
+        }
+        char hdr[9];
+        memcpy(hdr, &line[2], 8U);
+        hdr[8] = '\0';
+        idx = (uint32_t)strtoul(hdr, NULL, 16);
+        has_idx = true;
+        p = &line[10];
+        len -= 14U;
+    }
+
+    for (size_t off = 0U; off + RTDB_JOURNAL_HEX_LEN <= len; off += RTDB_JOURNAL_HEX_LEN) {
+        if (!rtdb_journal_decode(&p[off], &e)) {
+            return;
+        }
+        replay_entry(r, idx, has_idx, &e);
+        idx++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static replay_t r = { .db = RTDB_DEFAULTS };
+    char line[LINE_MAX_LEN];
+    FILE *in = stdin;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            r.quiet = true;
+        } else if ((in = fopen(argv[i], "r")) == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+    }
+
+    clock_t c0 = clock();
+    while (fgets(line, sizeof(line), in) != NULL) {
+        replay_line(&r, line);
+    }
+    double wall_ms = 1000.0 * (double)(clock() - c0) / CLOCKS_PER_SEC;
+
+    uint32_t span_ms = r.t_last - r.t_first;
+    printf("entradas: %u, duração no diário: %u ms, replay: %.3f ms",
+           r.entries, span_ms, wall_ms);
+    if (wall_ms > 0.0) {
+        printf(" (%.0fx tempo real)", (double)span_ms / wall_ms);
+    }
+    printf("\nmudanças do aquecedor: %u, divergências face ao firmware: %u, "
+           "valores antigos inconsistentes: %u\n", r.switches, r.diverge, r.gaps);
+    return (r.gaps == 0U) ? 0 : 2;
+}
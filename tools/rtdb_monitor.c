@@ -0,0 +1,183 @@
+/**
+ * @file rtdb_monitor.c
+ * @brief Monitor externo da RTDB do firmware em native_sim (memória partilhada)
+ *
+ * @details
+ *   Mapeia só para leitura o objeto criado por rtdb_shm_init() (CONFIG_RTDB_SHM) e
+ *   lê o estado diretamente, sem UART e sem qualquer sincronização com as threads do
+ *   firmware além do seqlock de rtdb_shm.h.
+ *
+ *   Uso: rtdb_monitor [-p período_ms] [-n leituras] [-H janela_ms] [-b segundos] [nome]
+ *     -p  período entre linhas de estado (500 ms)
+ *     -n  termina ao fim de n linhas (0 = sem fim)
+ *     -H  imprime as amostras de current_temp dos últimos janela_ms de cada zona e sai
+ *     -b  lê tão depressa quanto possível durante o tempo indicado e imprime o ritmo
+ *     nome  objeto POSIX (por omissão /setr_rtdb, CONFIG_RTDB_SHM_NAME)
+ *
+ *   Compilar: make rtdb_monitor [RTDB_MON_ZONES=n], com n = CONFIG_RTDB_NUM_ZONES.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "rtdb_shm.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+}
+
+/**
+ * @brief Mapeia o objeto name só para leitura e valida o formato
+ */
+static const rtdb_shm_t *monitor_map(const char *name)
+{
+    struct stat st;
+    int fd = shm_open(name, O_RDONLY, 0);
+    void *p;
+
+    if (fd < 0) {
+        perror(name);
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0) {
+        perror("fstat");
+        close(fd);
+        return NULL;
+    }
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+    if (!rtdb_shm_valid(p, (size_t)st.st_size)) {
+        const rtdb_shm_t *s = p;
+        fprintf(stderr, "%s: formato incompatível (zonas %u, histórico %u; este monitor: %u, %u)\n",
+                name, ((size_t)st.st_size >= sizeof(*s)) ? s->num_zones : 0U,
+                ((size_t)st.st_size >= sizeof(*s)) ? s->hist_len : 0U,
+                (unsigned)RTDB_NUM_ZONES, (unsigned)RTDB_HIST_LEN);
+        return NULL;
+    }
+    return p;
+}
+
+static void monitor_print(const rtdb_shm_t *shm)
+{
+    rtdb_stats_t stats[RTDB_NUM_ZONES];
+    rtdb_t db;
+
+    if (!rtdb_shm_read(shm, &db, stats)) {
+        printf("(escrita em curso: leitura repetida demasiadas vezes)\n");
+        return;
+    }
+    printf("on=%u rate=%ums writes=%u", db.system_on ? 1U : 0U, db.sampling_rate_ms,
+           shm->writes);
+    for (uint32_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+        int32_t mean = rtdb_stats_mean_centi(&stats[z]);
+        printf(" | z%u sp=%d cur=%d [%d,%d] heater=%u n=%u média=%d.%02d", z,
+               db.setpoint[z], db.current_temp[z], db.min_temp[z], db.max_temp[z],
+               db.heater[z] ? 1U : 0U, stats[z].n, mean / 100, abs(mean % 100));
+    }
+    printf("\n");
+}
+
+static void monitor_history(const rtdb_shm_t *shm, uint32_t window_ms)
+{
+    for (uint32_t z = 0U; z < RTDB_NUM_ZONES; z++) {
+        const rtdb_history_t *h = &shm->hist[z];
+        uint32_t head = h->head;
+        rtdb_hist_iter_t it;
+        rtdb_sample_t s;
+
+        if (head == 0U) {
+            continue;
+        }
+        /* Fim da janela = última amostra publicada */
+        uint32_t t_last = h->slot[(head - 1U) & (RTDB_HIST_LEN - 1U)].s.t_ms;
+        rtdb_history_iter_init(&it, h, t_last - window_ms, t_last);
+        while (rtdb_history_next(&it, &s)) {
+            printf("z%u %10u ms %d\n", z, s.t_ms, s.temp);
+        }
+    }
+}
+
+static void monitor_bench(const rtdb_shm_t *shm, double seconds)
+{
+    rtdb_stats_t stats[RTDB_NUM_ZONES];
+    rtdb_t db;
+    uint32_t reads = 0U;
+    uint32_t fails = 0U;
+    uint32_t w0 = shm->writes;
+    double t0 = now_s();
+    double t;
+
+    do {
+        for (uint32_t i = 0U; i < 1000U; i++) {
+            if (rtdb_shm_read(shm, &db, stats)) {
+                reads++;
+            } else {
+                fails++;
+            }
+        }
+        t = now_s() - t0;
+    } while (t < seconds);
+
+    printf("%u leituras em %.2f s (%.0f/s, %.0f ns cada), %u falhadas, %u escritas do firmware\n",
+           reads, t, reads / t, (t * 1e9) / (reads + fails), fails, shm->writes - w0);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = "/setr_rtdb";
+    uint32_t period_ms = 500U;
+    uint32_t count = 0U;
+    uint32_t window_ms = 0U;
+    double bench_s = 0.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:n:H:b:")) != -1) {
+        switch (opt) {
+        case 'p': period_ms = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'n': count = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'H': window_ms = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'b': bench_s = strtod(optarg, NULL); break;
+        default:
+            fprintf(stderr, "uso: %s [-p ms] [-n linhas] [-H janela_ms] [-b s] [nome]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind < argc) {
+        name = argv[optind];
+    }
+
+    const rtdb_shm_t *shm = monitor_map(name);
+    if (shm == NULL) {
+        return 1;
+    }
+    if (window_ms != 0U) {
+        monitor_history(shm, window_ms);
+        return 0;
+    }
+    if (bench_s > 0.0) {
+        monitor_bench(shm, bench_s);
+        return 0;
+    }
+
+    for (uint32_t i = 0U; (count == 0U) || (i < count); i++) {
+        struct timespec ts = { period_ms / 1000U, (long)(period_ms % 1000U) * 1000000L };
+        monitor_print(shm);
+        fflush(stdout);
+        nanosleep(&ts, NULL);
+    }
+    return 0;
+}
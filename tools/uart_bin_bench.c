@@ -0,0 +1,253 @@
+/**
+ * @file uart_bin_bench.c
+ * @brief Comparação no anfitrião dos modos ASCII e binário (COBS + CRC-16) da UART
+ *
+ * @details
+ *   Para os pedidos e respostas mais usados monta os frames dos dois modos com os
+ *   campos que o firmware usa (dígitos decimais em ASCII, little-endian de largura
+ *   fixa em binário; o frame binário com uart_bin_frame(), o código do firmware) e
+ *   mostra:
+ *     - bytes na linha por troca (pedido + resposta) e a poupança do modo binário;
+ *     - trocas/s que a linha permite (8N1, pedido e resposta um após o outro) e
+ *       respostas/s em envio contínuo (telemetria);
+ *     - o custo de receção dos pedidos (o que o firmware recebe), medido no
+ *       anfitrião: ns por frame de uart_parser_feed() e de uart_bin_feed() (inclui
+ *       COBS e CRC), só para comparar os dois entre si.
+ *
+ *   O diário (#J) é comparado por 4 entradas: 2 trocas em ASCII (2 entradas em
+ *   hexadecimal por resposta) e 1 em binário (4 entradas de 14 bytes).
+ *
+ *   Uso: uart_bin_bench [-b baud] [-n repetições]
+ *     -b  ritmo da linha (115200)
+ *     -n  frames entregues a cada receptor na medição de CPU (1000000)
+ *
+ *   Compilar: make uart_bin_bench
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "uart_bin.h"
+#include "uart_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_FIELDS 16U
+#define BENCH_FRAME_MAX  (UART_BIN_FRAME_MAX(UART_PARSER_DATA_MAX) + 8U)
+
+typedef enum {
+    BENCH_U,     /* Sem sinal: digits dígitos / bytes bytes */
+    BENCH_S,     /* Com sinal: '+'/'-' e digits dígitos / bytes bytes */
+    BENCH_C,     /* Um byte tal como está */
+    BENCH_HEX    /* Bloco: digits carateres hexadecimais / bytes bytes */
+} bench_kind_t;
+
+typedef struct {
+    bench_kind_t kind;
+    int32_t      v;
+    uint8_t      digits;
+    uint8_t      bytes;
+} bench_field_t;
+
+typedef struct {
+    char          cmd;
+    size_t        n;
+    bench_field_t f[BENCH_MAX_FIELDS];
+} bench_msg_t;
+
+typedef struct {
+    const char        *name;
+    const bench_msg_t *req;
+    const bench_msg_t *resp_ascii;
+    const bench_msg_t *resp_bin;     /* NULL = o mesmo de resp_ascii */
+    uint32_t           ascii_reps;   /* Trocas ASCII para o mesmo trabalho que uma binária */
+} bench_xchg_t;
+
+#define U(v, d, b)  { BENCH_U, (v), (d), (b) }
+#define S(v, d, b)  { BENCH_S, (v), (d), (b) }
+#define C(c)        { BENCH_C, (c), 1, 1 }
+#define HEX(d, b)   { BENCH_HEX, 0x5A, (d), (b) }
+
+static const bench_msg_t req_m    = { 'M', 1, { U(80, 3, 2) } };
+static const bench_msg_t req_r    = { 'R', 1, { U(1000, 4, 4) } };
+static const bench_msg_t req_c    = { 'C', 0, { { 0 } } };
+static const bench_msg_t req_s    = { 'r', 0, { { 0 } } };
+static const bench_msg_t req_t    = { 'T', 1, { U(0, 1, 1) } };
+static const bench_msg_t req_j    = { 'J', 1, { HEX(8, 4) } };
+static const bench_msg_t resp_ack = { 'E', 1, { C('o') } };
+static const bench_msg_t resp_c   = { 'c', 1, { U(23, 3, 2) } };
+static const bench_msg_t resp_s   = { 's', 1, { U(1000, 4, 4) } };
+static const bench_msg_t resp_t   = { 't', 13, {
+    U(0, 1, 1), U(51234, 6, 4), S(18, 3, 2), S(27, 3, 2), S(2254, 5, 4), U(1530, 6, 4),
+    U(12, 5, 4), U(40, 5, 4), U(310, 5, 4), U(2200, 5, 4), U(280, 5, 4), U(35, 5, 4), U(3, 5, 4) } };
+static const bench_msg_t resp_j2  = { 'j', 3, { HEX(8, 4), HEX(28, 14), HEX(28, 14) } };
+static const bench_msg_t resp_j4  = { 'j', 5, {
+    HEX(8, 4), HEX(28, 14), HEX(28, 14), HEX(28, 14), HEX(28, 14) } };
+
+static const bench_xchg_t bench_xchgs[] = {
+    { "M max_temp",     &req_m, &resp_ack, NULL,     1U },
+    { "R sampling",     &req_r, &resp_ack, NULL,     1U },
+    { "C current_temp", &req_c, &resp_c,   NULL,     1U },
+    { "r sampling",     &req_s, &resp_s,   NULL,     1U },
+    { "T estatísticas", &req_t, &resp_t,   NULL,     1U },
+    { "J 4 entradas",   &req_j, &resp_j2,  &resp_j4, 2U },
+};
+#define BENCH_NUM_XCHGS (sizeof(bench_xchgs) / sizeof(bench_xchgs[0]))
+
+/**
+ * @brief DATA de m: em ASCII como os put_dec()/put_sdec() do firmware, em binário
+ *        como os out_u()/out_s()
+ */
+static size_t bench_data(const bench_msg_t *m, bool bin, uint8_t *out)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    size_t pos = 0U;
+
+    for (size_t i = 0U; i < m->n; i++) {
+        const bench_field_t *f = &m->f[i];
+        uint32_t v = (uint32_t)f->v;
+
+        if (f->kind == BENCH_C) {
+            out[pos++] = (uint8_t)f->v;
+        } else if (bin) {
+            for (uint8_t b = 0U; b < f->bytes; b++) {
+                out[pos++] = (f->kind == BENCH_HEX) ? (uint8_t)(v + b) : (uint8_t)(v >> (8U * b));
+            }
+        } else if (f->kind == BENCH_HEX) {
+            for (uint8_t d = 0U; d < f->digits; d++) {
+                out[pos++] = (uint8_t)hex[(v + d) & 0x0FU];
+            }
+        } else {
+            if (f->kind == BENCH_S) {
+                out[pos++] = (f->v < 0) ? '-' : '+';
+                v = (f->v < 0) ? (uint32_t)(-f->v) : v;
+            }
+            for (uint8_t d = f->digits; d > 0U; d--) {
+                out[pos + d - 1U] = (uint8_t)('0' + (v % 10U));
+                v /= 10U;
+            }
+            pos += f->digits;
+        }
+    }
+    return pos;
+}
+
+static size_t bench_frame(const bench_msg_t *m, bool bin, uint8_t *out)
+{
+    uint8_t data[UART_PARSER_DATA_MAX + 8U];
+    size_t len = bench_data(m, bin, data);
+    size_t pos = 0U;
+    unsigned sum = (uint8_t)m->cmd;
+
+    if (bin) {
+        return uart_bin_frame(out, m->cmd, data, len);
+    }
+    out[pos++] = '#';
+    out[pos++] = (uint8_t)m->cmd;
+    for (size_t i = 0U; i < len; i++) {
+        out[pos++] = data[i];
+        sum += data[i];
+    }
+    sum &= 0xFFU;
+    out[pos++] = (uint8_t)('0' + (sum / 100U));
+    out[pos++] = (uint8_t)('0' + ((sum / 10U) % 10U));
+    out[pos++] = (uint8_t)('0' + (sum % 10U));
+    out[pos++] = '!';
+    return pos;
+}
+
+static double bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1e9) + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief ns por frame de um receptor a receber iters frames (todos os pedidos em ciclo)
+ */
+static double bench_rx_cpu(bool bin, uint32_t iters)
+{
+    static uint8_t frames[BENCH_NUM_XCHGS][BENCH_FRAME_MAX];
+    size_t len[BENCH_NUM_XCHGS];
+    uart_parser_t p;
+    uart_bin_rx_t r;
+    uint32_t ok = 0U;
+    double t0;
+
+    for (size_t i = 0U; i < BENCH_NUM_XCHGS; i++) {
+        len[i] = bench_frame(bench_xchgs[i].req, bin, frames[i]);
+    }
+    uart_parser_init(&p, 0U);
+    uart_bin_init(&r, 0U);
+
+    t0 = bench_now_ns();
+    for (uint32_t k = 0U; k < iters; k++) {
+        const uint8_t *fr = frames[k % BENCH_NUM_XCHGS];
+        size_t n = len[k % BENCH_NUM_XCHGS];
+        for (size_t i = 0U; i < n; i++) {
+            uart_parse_ev_t ev = bin ? uart_bin_feed(&r, fr[i], 0U) : uart_parser_feed(&p, fr[i], 0U);
+            ok += (ev == UART_PARSE_FRAME) ? 1U : 0U;
+        }
+    }
+    double ns = (bench_now_ns() - t0) / (double)iters;
+    if (ok != iters) {
+        fprintf(stderr, "%s: %u de %u frames aceites\n", bin ? "binário" : "ASCII", ok, iters);
+    }
+    return ns;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t baud = 115200U;
+    uint32_t iters = 1000000U;
+    uint8_t buf[BENCH_FRAME_MAX];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:n:")) != -1) {
+        switch (opt) {
+        case 'b': baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'n': iters = (uint32_t)strtoul(optarg, NULL, 10); break;
+        default:
+            fprintf(stderr, "uso: %s [-b baud] [-n repetições]\n", argv[0]);
+            return 1;
+        }
+    }
+    if ((baud == 0U) || (iters == 0U)) {
+        fprintf(stderr, "parâmetros inválidos\n");
+        return 1;
+    }
+
+    const double bytes_s = (double)baud / 10.0;   /* 8N1 */
+    printf("%u baud (%.0f bytes/s); bytes por troca = pedido + resposta\n", baud, bytes_s);
+    printf("%-16s %13s %13s %8s %12s %12s %12s %12s\n", "troca", "ASCII (B)", "binário (B)",
+           "poupa", "ASCII tr/s", "bin tr/s", "ASCII resp/s", "bin resp/s");
+
+    for (size_t i = 0U; i < BENCH_NUM_XCHGS; i++) {
+        const bench_xchg_t *x = &bench_xchgs[i];
+        const bench_msg_t *rb = (x->resp_bin != NULL) ? x->resp_bin : x->resp_ascii;
+        size_t a_req = bench_frame(x->req, false, buf);
+        size_t a_resp = bench_frame(x->resp_ascii, false, buf);
+        size_t b_req = bench_frame(x->req, true, buf);
+        size_t b_resp = bench_frame(rb, true, buf);
+        double a = (double)(x->ascii_reps * (a_req + a_resp));
+        double b = (double)(b_req + b_resp);
+        char a_str[16];
+        char b_str[16];
+
+        snprintf(a_str, sizeof(a_str), "%zu+%zu%s", a_req, a_resp, (x->ascii_reps > 1U) ? " ×2" : "");
+        snprintf(b_str, sizeof(b_str), "%zu+%zu", b_req, b_resp);
+        printf("%-16s %13s %13s %7.1f%% %12.0f %12.0f %12.0f %12.0f\n", x->name, a_str, b_str,
+               100.0 * (1.0 - (b / a)), bytes_s / a, bytes_s / b,
+               bytes_s / (double)(x->ascii_reps * a_resp), bytes_s / (double)b_resp);
+    }
+
+    double a_ns = bench_rx_cpu(false, iters);
+    double b_ns = bench_rx_cpu(true, iters);
+    printf("\nreceção dos pedidos, medida no anfitrião (%u frames):\n", iters);
+    printf("  ASCII   (uart_parser_feed) %7.1f ns/frame\n", a_ns);
+    printf("  binário (uart_bin_feed)    %7.1f ns/frame\n", b_ns);
+    return 0;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file uart_rx_bench.c
+ * @brief Simulação no anfitrião da receção de comandos pela UART (frames/s a 115200 baud)
+ *
+ * @details
+ *   Compara, com o mesmo fluxo de frames válidos enviados seguidos pelo PC, as duas
+ *   formas de receção de uart_task():
+ *     - polling: uart_poll_in() + k_sleep(10 ms) sempre que não há byte pendente
+ *       (e depois de cada byte fora de frame), como antes;
+ *     - interrupção: a ISR copia a FIFO para o buffer circular de uart_ring.c (o
+ *       código do firmware) e a thread consome-o acordada por um semáforo.
+ *   Em ambos os casos a resposta a cada frame é enviada com uart_poll_out(), que
+ *   bloqueia a thread durante o tempo de linha da resposta.
+ *
+ *   A simulação avança em passos de 1 µs. Bytes que chegam com a FIFO do periférico
+ *   cheia (polling) ou com o buffer circular cheio (interrupção) perdem-se; frames
+ *   com bytes perdidos falham o framing/checksum e não contam.
+ *
+ *   Uso: uart_rx_bench [-b baud] [-f fifo] [-g intervalo_us] [-s segundos]
+ *     -b  ritmo da linha (115200)
+ *     -f  bytes da FIFO de receção do periférico (6, UART do nRF52840)
+ *     -g  pausa entre frames enviados pelo PC (0 = frames seguidos)
+ *     -s  tempo simulado (10 s)
+ *
+ *   Compilar: make uart_rx_bench
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "uart_ring.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_SLEEP_US   10000U   /* k_sleep(K_MSEC(10)) do ciclo de polling */
+#define BENCH_BYTE_US    2U       /* Custo de tratar um byte na thread */
+#define BENCH_FRAME_US   20U      /* Custo de handle_command() sem contar a resposta */
+#define BENCH_ACK_LEN    7U       /* "#Eo111!" */
+#define BENCH_FIFO_MAX   64U
+#define BENCH_BUF_SIZE   64U      /* UART_BUF_SIZE */
+
+/* Comandos enviados em ciclo (o checksum é acrescentado em bench_stream_init) */
+static const char *const bench_cmds[] = { "M030", "m020", "R1000", "E1", "M080", "R0500" };
+#define BENCH_NUM_CMDS (sizeof(bench_cmds) / sizeof(bench_cmds[0]))
+
+typedef struct {
+    char   frame[BENCH_NUM_CMDS][16];
+    size_t len[BENCH_NUM_CMDS];
+} bench_stream_t;
+
+typedef struct {
+    bool     irq;                      /* false = polling */
+    uint32_t fifo_depth;
+    uint8_t  fifo[BENCH_FIFO_MAX];     /* FIFO do periférico (modo polling) */
+    uint32_t fifo_n;
+    uint32_t fifo_r;
+    uart_ring_t ring;                  /* Modo interrupção */
+    uint8_t  buf[BENCH_BUF_SIZE];      /* Frame em montagem (uart_task) */
+    size_t   idx;
+    uint32_t frames_sent;
+    uint32_t frames_ok;
+    uint32_t lost;                     /* Bytes perdidos */
+} bench_t;
+
+static void bench_stream_init(bench_stream_t *s)
+{
+    for (size_t i = 0U; i < BENCH_NUM_CMDS; i++) {
+        unsigned sum = 0U;
+        for (const char *c = bench_cmds[i]; *c != '\0'; c++) {
+            sum += (unsigned char)*c;
+        }
+        s->len[i] = (size_t)snprintf(s->frame[i], sizeof(s->frame[i]), "#%s%03u!",
+                                     bench_cmds[i], sum & 0xFFU);
+    }
+}
+
+/**
+ * @brief Valida um frame completo como handle_command() (framing e checksum)
+ */
+static bool bench_frame_ok(const uint8_t *buf, size_t len)
+{
+    unsigned sum = 0U;
+    unsigned cs = 0U;
+
+    if ((len < 6U) || (buf[0] != '#') || (buf[len - 1U] != '!')) {
+        return false;
+    }
+    for (size_t i = 1U; i < len - 4U; i++) {
+        sum += buf[i];
+    }
+    for (size_t i = len - 4U; i < len - 1U; i++) {
+        if ((buf[i] < '0') || (buf[i] > '9')) {
+            return false;
+        }
+        cs = (cs * 10U) + (unsigned)(buf[i] - '0');
+    }
+    return cs == (sum & 0xFFU);
+}
+
+/**
+ * @brief Máquina de estados de uart_task() para um byte
+ *
+ * @param[out] idle  true se o ciclo de polling antigo dormia a seguir a este byte
+ * @return Tempo (µs) que a thread fica ocupada com o byte, incluindo a resposta
+ */
+static uint32_t bench_rx_byte(bench_t *b, uint8_t byte, uint32_t byte_us, bool *idle)
+{
+    uint32_t busy = BENCH_BYTE_US;
+    uint32_t ack_us = BENCH_FRAME_US + (BENCH_ACK_LEN * byte_us);
+
+    *idle = false;
+    if ((byte == '\r') || (byte == '\n')) {
+        return busy;
+    }
+    if ((byte == '!') && (b->idx == 0U)) {
+        return busy + ack_us;
+    }
+    if (byte == '#') {
+        if (b->idx > 0U) {
+            busy += ack_us;   /* framing error do frame anterior */
+        }
+        b->buf[0] = byte;
+        b->idx = 1U;
+        return busy;
+    }
+    if (b->idx == 0U) {
+        *idle = true;
+        return busy;
+    }
+    b->buf[b->idx++] = byte;
+    if (byte == '!') {
+        if (bench_frame_ok(b->buf, b->idx)) {
+            b->frames_ok++;
+        }
+        b->idx = 0U;
+        return busy + ack_us;
+    }
+    if (b->idx >= BENCH_BUF_SIZE) {
+        b->idx = 0U;
+        return busy + ack_us;
+    }
+    return busy;
+}
+
+static void bench_run(bench_t *b, const bench_stream_t *s, uint32_t baud, uint32_t gap_us,
+                      double seconds)
+{
+    const double byte_us = 10.0e6 / (double)baud;   /* 8N1: 10 bits por byte */
+    const uint64_t end = (uint64_t)(seconds * 1e6);
+    double next_rx = 0.0;
+    size_t frame = 0U;
+    size_t pos = 0U;
+    uint64_t busy_until = 0U;
+
+    for (uint64_t t = 0U; t < end; t++) {
+        /* Linha: bytes que acabaram de chegar ao periférico */
+        while (next_rx <= (double)t) {
+            uint8_t byte = (uint8_t)s->frame[frame][pos];
+            if (b->irq) {
+                b->lost += (uint32_t)(1U - uart_ring_put(&b->ring, &byte, 1U));
+            } else if (b->fifo_n < b->fifo_depth) {
+                b->fifo[(b->fifo_r + b->fifo_n) % b->fifo_depth] = byte;
+                b->fifo_n++;
+            } else {
+                b->lost++;   /* overrun */
+            }
+            next_rx += byte_us;
+            if (++pos == s->len[frame]) {
+                pos = 0U;
+                frame = (frame + 1U) % BENCH_NUM_CMDS;
+                b->frames_sent++;
+                next_rx += (double)gap_us;
+            }
+        }
+
+        /* Thread */
+        if (t < busy_until) {
+            continue;
+        }
+        uint8_t byte;
+        bool have;
+        if (b->irq) {
+            have = (uart_ring_get(&b->ring, &byte, 1U) == 1U);
+        } else {
+            have = (b->fifo_n > 0U);
+            if (have) {
+                byte = b->fifo[b->fifo_r];
+                b->fifo_r = (b->fifo_r + 1U) % b->fifo_depth;
+                b->fifo_n--;
+            }
+        }
+        if (!have) {
+            /* Polling dorme; com interrupção espera no semáforo (acorda no byte seguinte) */
+            busy_until = t + (b->irq ? 1U : BENCH_SLEEP_US);
+            continue;
+        }
+        bool idle;
+        busy_until = t + bench_rx_byte(b, byte, (uint32_t)(byte_us + 0.5), &idle);
+        if (idle && !b->irq) {
+            busy_until += BENCH_SLEEP_US;
+        }
+    }
+}
+
+static void bench_print(const char *name, const bench_t *b, double seconds)
+{
+    printf("%-12s enviados %8.1f frames/s  aceites %8.1f frames/s (%5.1f%%)  bytes perdidos %u\n",
+           name, b->frames_sent / seconds, b->frames_ok / seconds,
+           (b->frames_sent != 0U) ? (100.0 * b->frames_ok / b->frames_sent) : 0.0, b->lost);
+}
+
+int main(int argc, char **argv)
+{
+    static bench_t poll;
+    static bench_t irq;
+    bench_stream_t s;
+    uint32_t baud = 115200U;
+    uint32_t fifo = 6U;
+    uint32_t gap_us = 0U;
+    double seconds = 10.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:f:g:s:")) != -1) {
+        switch (opt) {
+        case 'b': baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'f': fifo = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'g': gap_us = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 's': seconds = strtod(optarg, NULL); break;
+        default:
+            fprintf(stderr, "uso: %s [-b baud] [-f fifo] [-g us] [-s segundos]\n", argv[0]);
+            return 1;
+        }
+    }
+    if ((baud == 0U) || (fifo == 0U) || (fifo > BENCH_FIFO_MAX) || (seconds <= 0.0)) {
+        fprintf(stderr, "parâmetros inválidos\n");
+        return 1;
+    }
+
+    bench_stream_init(&s);
+    poll.fifo_depth = fifo;
+    irq.irq = true;
+    bench_run(&poll, &s, baud, gap_us, seconds);
+    bench_run(&irq, &s, baud, gap_us, seconds);
+
+    printf("%u baud, FIFO %u bytes, buffer circular %u bytes, pausa %u us, %.1f s\n",
+           baud, fifo, (unsigned)UART_RING_LEN, gap_us, seconds);
+    bench_print("antes (poll)", &poll, seconds);
+    bench_print("depois (ISR)", &irq, seconds);
+    return 0;
+}
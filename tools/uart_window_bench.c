@@ -0,0 +1,378 @@
+/**
+ * @file uart_window_bench.c
+ * @brief Simulação no anfitrião de pedidos etiquetados em janela (#@sss…!) vs um a um
+ *
+ * @details
+ *   O anfitrião envia n pedidos com até w pedidos em curso e mede pedidos/s para
+ *   várias janelas; w = 1 é o pára-e-espera de antes, com frames sem
+ *   etiqueta. O modelo é o do firmware:
+ *     - linha 8N1 nos dois sentidos (full-duplex), cada sentido com os bytes seguidos;
+ *     - latência fixa em cada sentido (adaptador USB-série e sistema operativo do
+ *       anfitrião), que é o que o pára-e-espera paga duas vezes por pedido;
+ *     - uart_task() trata os pedidos por ordem, proc µs cada, e põe a resposta na
+ *       fila de envio sem esperar que a anterior saia.
+ *
+ *   Os frames são os verdadeiros: o "firmware" recebe cada pedido com
+ *   uart_parser_feed()/uart_bin_feed() (o código do firmware), responde com a mesma
+ *   etiqueta (uart_bin_frame_seq() em binário) e o anfitrião recebe a resposta com
+ *   outro receptor e associa-a ao pedido pela etiqueta. Com -e, uma fração dos
+ *   pedidos chega com um byte trocado: o firmware responde 's' com a etiqueta do
+ *   pedido e o anfitrião reenvia só esse, sem esperar pelos outros em curso.
+ *
+ *   Para cada janela mostra ainda se os pedidos em curso cabem no buffer circular
+ *   de receção (UART_RING_LEN) e na fila de envio (-q, CONFIG_UARTCOMM_TX_BUFS).
+ *
+ *   Uso: uart_window_bench [-b baud] [-l latência_us] [-p proc_us] [-n pedidos]
+ *                          [-e fração] [-q posições] [-B]
+ *     -b  ritmo da linha (115200)
+ *     -l  latência de cada sentido (1000 µs)
+ *     -p  tempo de tratamento de um pedido no firmware (50 µs)
+ *     -n  pedidos a completar por janela (10000)
+ *     -e  fração de pedidos com um byte trocado na linha (0)
+ *     -q  posições da fila de envio do firmware (8)
+ *     -B  modo binário (COBS + CRC-16) em vez de ASCII
+ *
+ *   Compilar: make uart_window_bench
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "uart_bin.h"
+#include "uart_parser.h"
+#include "uart_ring.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_WIN_MAX   64U    /* Janela máxima simulada (etiquetas únicas em curso) */
+#define BENCH_FRAME_MAX (UART_BIN_FRAME_SEQ_MAX(UART_PARSER_DATA_MAX) + 8U)
+
+/** Pedido da mistura e a resposta do firmware (DATA já no formato de cada modo) */
+typedef struct {
+    char          cmd;
+    const uint8_t *data;
+    size_t        len;
+    const uint8_t *bin;
+    size_t        bin_len;
+    char          resp;
+    const uint8_t *rdata;
+    size_t        rlen;
+    const uint8_t *rbin;
+    size_t        rbin_len;
+} bench_req_t;
+
+static const uint8_t m_bin[] = { 0x50, 0x00 };
+static const uint8_t s_bin[] = { 0xE8, 0x03, 0x00, 0x00 };
+static const uint8_t c_bin[] = { 0x17, 0x00 };
+
+static const bench_req_t bench_mix[] = {
+    { 'C', NULL, 0, NULL, 0, 'c', (const uint8_t *)"023", 3, c_bin, sizeof(c_bin) },
+    { 'M', (const uint8_t *)"080", 3, m_bin, sizeof(m_bin), 'E', (const uint8_t *)"o", 1,
+      (const uint8_t *)"o", 1 },
+    { 'r', NULL, 0, NULL, 0, 's', (const uint8_t *)"1000", 4, s_bin, sizeof(s_bin) },
+};
+#define BENCH_MIX_N (sizeof(bench_mix) / sizeof(bench_mix[0]))
+
+/** Um pedido em curso: a resposta chega a at_us */
+typedef struct {
+    double   at_us;
+    uint32_t id;           /* Índice do pedido (0..n−1) */
+    uint8_t  resp[BENCH_FRAME_MAX];
+    size_t   resp_len;
+} bench_flight_t;
+
+typedef struct {
+    bool     bin;
+    double   byte_us;
+    double   lat_us;
+    double   proc_us;
+    double   err;
+    /* Linhas e firmware */
+    double   host_tx_free;
+    double   fw_free;
+    double   fw_tx_free;
+    /* Receptores (firmware e anfitrião) */
+    uart_parser_t fw_p;
+    uart_bin_rx_t fw_b;
+    uart_parser_t host_p;
+    uart_bin_rx_t host_b;
+    /* Etiqueta de cada pedido em curso → índice do pedido (−1 = livre) */
+    int32_t  by_seq[256];
+    uint8_t  next_seq;
+    bool     tag;          /* Pedidos com etiqueta (w > 1) */
+    uint32_t resent;
+} bench_t;
+
+/**
+ * @brief Frame ASCII com etiqueta: '#' '@' sss CMD DATA CS(3) '!', checksum sobre tudo
+ *        entre '#' e CS (como send_frame_tx() no firmware)
+ */
+static size_t bench_ascii(uint8_t *out, int seq, char cmd, const uint8_t *data, size_t len)
+{
+    size_t pos = 0U;
+    unsigned sum = 0U;
+
+    out[pos++] = '#';
+    if (seq != UART_SEQ_NONE) {
+        out[pos++] = UART_SEQ_MARK;
+        out[pos++] = (uint8_t)('0' + ((seq / 100) % 10));
+        out[pos++] = (uint8_t)('0' + ((seq / 10) % 10));
+        out[pos++] = (uint8_t)('0' + (seq % 10));
+    }
+    out[pos++] = (uint8_t)cmd;
+    for (size_t i = 0U; i < len; i++) {
+        out[pos++] = data[i];
+    }
+    for (size_t i = 1U; i < pos; i++) {
+        sum += out[i];
+    }
+    sum &= 0xFFU;
+    out[pos++] = (uint8_t)('0' + (sum / 100U));
+    out[pos++] = (uint8_t)('0' + ((sum / 10U) % 10U));
+    out[pos++] = (uint8_t)('0' + (sum % 10U));
+    out[pos++] = '!';
+    return pos;
+}
+
+/**
+ * @brief Frame binário do pedido q com CMD trocado na linha: o CRC é o do pedido
+ *        original, pelo que o receptor o recebe com CRC errado
+ */
+static size_t bench_bin_bad(uint8_t *out, int seq, const bench_req_t *q)
+{
+    uint8_t raw[UART_BIN_SEQ_LEN + 1U + UART_PARSER_DATA_MAX + UART_BIN_CRC_LEN];
+    size_t len = 0U;
+
+    if (seq != UART_SEQ_NONE) {
+        raw[len++] = UART_SEQ_MARK;
+        raw[len++] = (uint8_t)seq;
+    }
+    size_t at = len;
+    raw[len++] = (uint8_t)q->cmd;
+    memcpy(&raw[len], q->bin, q->bin_len);
+    len += q->bin_len;
+    uint16_t crc = uart_crc16(UART_CRC16_INIT, raw, len);
+    raw[len++] = (uint8_t)(crc & 0xFFU);
+    raw[len++] = (uint8_t)(crc >> 8);
+    raw[at] ^= 0x01U;
+
+    out[0] = 0U;
+    size_t n = 1U + uart_cobs_encode(raw, len, &out[1]);
+    out[n++] = 0U;
+    return n;
+}
+
+static size_t bench_frame(const bench_t *b, uint8_t *out, int seq, char cmd, const uint8_t *data,
+                          size_t len, const uint8_t *bdata, size_t blen)
+{
+    return b->bin ? uart_bin_frame_seq(out, seq, cmd, bdata, blen)
+                  : bench_ascii(out, seq, cmd, data, len);
+}
+
+/**
+ * @brief Entrega len bytes a um receptor; devolve o último evento diferente de NONE
+ *        e o frame em *f
+ */
+static uart_parse_ev_t bench_rx(bool bin, uart_parser_t *p, uart_bin_rx_t *r, const uint8_t *buf,
+                                size_t len, const uart_frame_t **f)
+{
+    uart_parse_ev_t last = UART_PARSE_NONE;
+
+    for (size_t i = 0U; i < len; i++) {
+        uart_parse_ev_t ev = bin ? uart_bin_feed(r, buf[i], 0U) : uart_parser_feed(p, buf[i], 0U);
+        if (ev != UART_PARSE_NONE) {
+            last = ev;
+        }
+    }
+    *f = bin ? &r->f : &p->f;
+    if ((last == UART_PARSE_FRAME) && !bin && ((uint16_t)(*f)->sum != (*f)->cs)) {
+        last = UART_PARSE_CHECKSUM;   /* No firmware é handle_command() que compara */
+    }
+    return last;
+}
+
+/**
+ * @brief Envia o pedido id a partir de now_us e calcula quando chega a resposta
+ *
+ * @return Bytes do pedido (para o total na linha)
+ */
+static size_t bench_send(bench_t *b, uint32_t id, double now_us, bench_flight_t *fl)
+{
+    const bench_req_t *q = &bench_mix[id % BENCH_MIX_N];
+    uint8_t req[BENCH_FRAME_MAX];
+    const uart_frame_t *f;
+    uint8_t seq = b->tag ? b->next_seq : 0U;
+
+    /* Etiqueta livre seguinte (há sempre: janela < 256); sem etiqueta fica na posição 0 */
+    while (b->tag && (b->by_seq[seq] >= 0)) {
+        seq++;
+    }
+    b->next_seq = (uint8_t)(seq + 1U);
+    b->by_seq[seq] = (int32_t)id;
+    int tseq = b->tag ? (int)seq : UART_SEQ_NONE;
+
+    /* Com -e, CMD chega trocado (nunca a etiqueta nem o framing) */
+    size_t n;
+    if ((b->err > 0.0) && (((double)rand() / (double)RAND_MAX) < b->err)) {
+        if (b->bin) {
+            n = bench_bin_bad(req, tseq, q);
+        } else {
+            n = bench_frame(b, req, tseq, q->cmd, q->data, q->len, q->bin, q->bin_len);
+            req[b->tag ? (2U + UART_SEQ_DIGITS) : 1U] ^= 0x01U;
+        }
+    } else {
+        n = bench_frame(b, req, tseq, q->cmd, q->data, q->len, q->bin, q->bin_len);
+    }
+    double start = (now_us > b->host_tx_free) ? now_us : b->host_tx_free;
+    b->host_tx_free = start + ((double)n * b->byte_us);
+
+    /* Firmware: recebe, trata por ordem e põe a resposta na fila de envio */
+    double fw_start = b->host_tx_free + b->lat_us;
+    fw_start = (fw_start > b->fw_free) ? fw_start : b->fw_free;
+    b->fw_free = fw_start + b->proc_us;
+
+    uart_parse_ev_t ev = bench_rx(b->bin, &b->fw_p, &b->fw_b, req, n, &f);
+    int rseq = f->tagged ? (int)f->seq : UART_SEQ_NONE;
+    if (ev == UART_PARSE_FRAME) {
+        fl->resp_len = bench_frame(b, fl->resp, rseq, q->resp, q->rdata, q->rlen, q->rbin, q->rbin_len);
+    } else {
+        static const uint8_t ack_s = 's';
+        fl->resp_len = bench_frame(b, fl->resp, rseq, 'E', &ack_s, 1U, &ack_s, 1U);
+    }
+
+    double tx = (b->fw_free > b->fw_tx_free) ? b->fw_free : b->fw_tx_free;
+    b->fw_tx_free = tx + ((double)fl->resp_len * b->byte_us);
+    fl->at_us = b->fw_tx_free + b->lat_us;
+    fl->id = id;
+    return n;
+}
+
+/**
+ * @brief Simula n pedidos com janela w; devolve o tempo total (µs)
+ *
+ * @param[out] req_max  Maior pedido (bytes)
+ * @param[out] sent     Bytes enviados pelo anfitrião, reenvios incluídos
+ */
+static double bench_run(bench_t *b, uint32_t w, uint32_t n, size_t *req_max, size_t *sent)
+{
+    static bench_flight_t ring[BENCH_WIN_MAX];
+    static uint32_t retry[BENCH_WIN_MAX];   /* Pedidos a reenviar ('s') */
+    uint32_t head = 0U;
+    uint32_t count = 0U;
+    uint32_t n_retry = 0U;
+    uint32_t next = 0U;
+    uint32_t done = 0U;
+    double now = 0.0;
+
+    b->host_tx_free = 0.0;
+    b->fw_free = 0.0;
+    b->fw_tx_free = 0.0;
+    b->next_seq = 0U;
+    b->tag = (w > 1U);
+    b->resent = 0U;
+    memset(b->by_seq, 0xFF, sizeof(b->by_seq));
+    uart_parser_init(&b->fw_p, 0U);
+    uart_parser_init(&b->host_p, 0U);
+    uart_bin_init(&b->fw_b, 0U);
+    uart_bin_init(&b->host_b, 0U);
+    *req_max = 0U;
+    *sent = 0U;
+
+    while (done < n) {
+        /* Enche a janela: primeiro os reenvios, depois pedidos novos */
+        while ((count < w) && ((n_retry > 0U) || (next < n))) {
+            uint32_t id = (n_retry > 0U) ? retry[--n_retry] : next++;
+            size_t len = bench_send(b, id, now, &ring[(head + count) % BENCH_WIN_MAX]);
+            *req_max = (len > *req_max) ? len : *req_max;
+            *sent += len;
+            count++;
+        }
+
+        /* Resposta seguinte (a linha e o firmware são FIFO: chegam pela ordem de envio) */
+        bench_flight_t *fl = &ring[head];
+        const uart_frame_t *f;
+        head = (head + 1U) % BENCH_WIN_MAX;
+        count--;
+        now = (fl->at_us > now) ? fl->at_us : now;
+
+        /* Associa a resposta ao pedido pela etiqueta (sem etiqueta só há um em curso) */
+        uart_parse_ev_t ev = bench_rx(b->bin, &b->host_p, &b->host_b, fl->resp, fl->resp_len, &f);
+        uint8_t seq = f->tagged ? f->seq : 0U;
+        if ((ev != UART_PARSE_FRAME) || (f->tagged != b->tag) || (b->by_seq[seq] < 0)) {
+            fprintf(stderr, "resposta sem pedido associado\n");
+            exit(1);
+        }
+        uint32_t id = (uint32_t)b->by_seq[seq];
+        b->by_seq[seq] = -1;
+        if (id != fl->id) {
+            fprintf(stderr, "etiqueta %u associada ao pedido errado\n", seq);
+            exit(1);
+        }
+        if ((f->cmd == 'E') && (f->data_len == 1U) && (f->data[0] == 's')) {
+            retry[n_retry++] = id;
+            b->resent++;
+        } else {
+            done++;
+        }
+    }
+    return now;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t wins[] = { 1U, 2U, 4U, 8U, 16U, 32U };
+    bench_t b;
+    uint32_t baud = 115200U;
+    uint32_t n = 10000U;
+    uint32_t tx_bufs = 8U;
+    int opt;
+
+    memset(&b, 0, sizeof(b));
+    b.lat_us = 1000.0;
+    b.proc_us = 50.0;
+    while ((opt = getopt(argc, argv, "b:l:p:n:e:q:B")) != -1) {
+        switch (opt) {
+        case 'b': baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'l': b.lat_us = strtod(optarg, NULL); break;
+        case 'p': b.proc_us = strtod(optarg, NULL); break;
+        case 'n': n = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'e': b.err = strtod(optarg, NULL); break;
+        case 'q': tx_bufs = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'B': b.bin = true; break;
+        default:
+            fprintf(stderr, "uso: %s [-b baud] [-l latência_us] [-p proc_us] [-n pedidos] "
+                    "[-e fração] [-q posições] [-B]\n", argv[0]);
+            return 1;
+        }
+    }
+    if ((baud == 0U) || (n == 0U) || (b.lat_us < 0.0) || (b.proc_us < 0.0) ||
+        (b.err < 0.0) || (b.err >= 1.0)) {
+        fprintf(stderr, "parâmetros inválidos\n");
+        return 1;
+    }
+    b.byte_us = 10.0e6 / (double)baud;   /* 8N1 */
+    srand(1U);
+
+    printf("%s, %u baud, latência %.0f µs por sentido, %.0f µs por pedido no firmware, "
+           "%.1f%% pedidos corrompidos\n", b.bin ? "binário" : "ASCII", baud, b.lat_us,
+           b.proc_us, 100.0 * b.err);
+    printf("%7s %12s %9s %10s %10s %8s %8s\n", "janela", "pedidos/s", "× w=1", "reenvios",
+           "linha →", "anel", "fila tx");
+
+    double base = 0.0;
+    for (size_t i = 0U; i < (sizeof(wins) / sizeof(wins[0])); i++) {
+        size_t req_max;
+        size_t sent;
+        double t = bench_run(&b, wins[i], n, &req_max, &sent);
+        double rate = (double)n / (t / 1e6);
+        double busy = (double)sent * b.byte_us;
+
+        base = (i == 0U) ? rate : base;
+        printf("%7u %12.0f %8.2fx %10u %9.0f%% %8s %8s\n", wins[i], rate, rate / base, b.resent,
+               100.0 * busy / t, ((wins[i] * req_max) <= UART_RING_LEN) ? "cabe" : "NÃO",
+               (wins[i] <= tx_bufs) ? "cabe" : "espera");
+    }
+    return 0;
+}